@@ -1,6 +1,17 @@
 ﻿#include "Application.h"
 #include "webgpu/webgpu.hpp"  
 #include "FileManagement.h"
+#include "ProgressiveMesh.h"
+#include "TextureCooker.h"
+#include "Ktx2.h"
+#include "BlockCompression.h"
+#include "SpecularPrefilter.h"
+#include "BrdfLut.h"
+#include "EnvironmentMap.h"
+#include "GpuReadback.h"
+#include "GpuShProjector.h"
+#include "ChannelPacking.h"
+#include "Parallel.h"
 #include "webgpu-utils.h"
 #include "stb_image.h"       
 
@@ -9,7 +20,16 @@
 #include <cassert>
 #include <vector>
 #include <array>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <limits>
 #include <filesystem>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 // Other libraries
 #include <GLFW/glfw3.h>
@@ -108,7 +128,13 @@ bool Application::Initialize() {
     DeviceDescriptor deviceDesc = {};
     deviceDesc.nextInChain = nullptr;
     deviceDesc.label = "My Device"; // anything works here, that's your call
-    deviceDesc.requiredFeatureCount = 0; // we do not require any specific feature
+    // block compressed textures stay compressed in VRAM where the adapter can sample them
+    std::vector<WGPUFeatureName> requiredFeatures;
+    textureCompressionBC = adapter.hasFeature(FeatureName::TextureCompressionBC);
+    if (textureCompressionBC) requiredFeatures.push_back(WGPUFeatureName_TextureCompressionBC);
+    std::cout << "texture-compression-bc: " << (textureCompressionBC ? "yes" : "no, BC textures are decoded on the CPU") << std::endl;
+    deviceDesc.requiredFeatureCount = requiredFeatures.size();
+    deviceDesc.requiredFeatures = requiredFeatures.data();
     deviceDesc.requiredLimits = nullptr; // we do not require any specific limit
     deviceDesc.defaultQueue.nextInChain = nullptr;
     deviceDesc.defaultQueue.label = "The default queue";
@@ -154,8 +180,8 @@ bool Application::Initialize() {
     config.viewFormatCount = 0;
     config.viewFormats = nullptr;
     config.device = device;
-    // presentation: first in, first out
-    config.presentMode = PresentMode::Fifo;
+    // presentation: first in, first out (unless benchmarking)
+    config.presentMode = GetPresentMode();
     // transparency 
     config.alphaMode = CompositeAlphaMode::Auto;
 
@@ -165,36 +191,66 @@ bool Application::Initialize() {
      //adapter.release();
 
     depthTextureFormat = TextureFormat::Depth24Plus;
-    InitializePipeline();
-
+    // direct glTF uploads are done here, other meshes are loaded in the background and set up in MainLoop
     InitializeBuffers();
+
     InitializeDepthTexture();
 
-    Texture colorTexture = getObjTexture("../files/wahoo.bmp", device, &colorTextureView);
+    if (gpuMipmaps && !gpuMipGenerator.initialize(device)) {
+        std::cerr << "GPU mipmaps unavailable, building them on the CPU" << std::endl;
+    }
+
+    Texture colorTexture = getObjTexture("../files/wahoo.bmp", device, &colorTextureView, true);
     if (!colorTexture) {
         std::cerr << "Could not load obj texture!" << std::endl;
     }
 
-	Texture cubemapTexture = InitializeCubeMapTexture("../files/venice_sunset", & cubemapTextureView);
-    if (!cubemapTexture) {
+	cubemap = InitializeCubeMapTexture(environmentPath, & cubemapTextureView);
+    if (!cubemap) {
         std::cerr << "Could not load cubemap texture" << std::endl;
     }
+    else {
+        InitializeSpecularEnvironment();
+        InitializeIrradiance();
+    }
+    InitializeBrdfLut();
 
-    InitializeBindGroups(); // after buffers are created and passed
+    if (!meshStreamer.isStarted()) InitializeMeshResources();
 
     return true;
 }
 
 void Application::Terminate() {
-
-
-    // indexBuffer.release();
-    vertexBuffer.release();
+    // finishes a cache that is being built
+    meshStreamer.stop();
+
+    // mesh buffers and pipelines may not exist yet if the window was closed while loading
+    if (indexBuffer) indexBuffer.release();
+    if (meshletCount > 0) {
+        meshletBuffer.release();
+        culledIndexBuffer.release();
+        drawArgsBuffer.release();
+        lodSelectionBuffer.release();
+        if (cullBindGroup) cullBindGroup.release();
+        cullBindGroupLayout.release();
+        cullPipeline.release();
+    }
+    if (instanceBuffer) instanceBuffer.release();
+    if (instanceMaterialBuffer) instanceMaterialBuffer.release();
+    if (positionBuffer) positionBuffer.release();
+    if (vertexBuffer) vertexBuffer.release();
+    if (tangentBuffer) tangentBuffer.release();
     uniformBuffer.release();
-    layout.release();
-    bindGroupLayout.release();
-    bindGroup.release();
-    pipeline.release();
+    if (depthPipeline) {
+        depthLayout.release();
+        depthPipeline.release();
+    }
+    if (pipeline) {
+        layout.release();
+        bindGroupLayout.release();
+        bindGroup.release();
+        pipeline.release();
+    }
 
     depthTextureView.release();
     depthTexture.destroy();
@@ -202,6 +258,33 @@ void Application::Terminate() {
 
     colorTextureView.release();
 
+    for (BindGroup& materialBindGroup : materialBindGroups) materialBindGroup.release();
+    if (materialBuffer) materialBuffer.release();
+    if (materialBindGroupLayout) materialBindGroupLayout.release();
+    for (auto& entry : materialTextures) {
+        entry.second.view.release();
+        entry.second.texture.destroy();
+        entry.second.texture.release();
+    }
+    for (MaterialTexture* solid : { &whiteTexture, &flatNormalTexture }) {
+        if (!solid->texture) continue;
+        solid->view.release();
+        solid->texture.destroy();
+        solid->texture.release();
+    }
+
+    gpuMipGenerator.release();
+    if (specularTexture) {
+        specularTextureView.release();
+        specularTexture.destroy();
+        specularTexture.release();
+    }
+    if (brdfLutTexture) {
+        brdfLutTextureView.release();
+        brdfLutTexture.destroy();
+        brdfLutTexture.release();
+    }
+
     adapter.release();
     surface.unconfigure();
     queue.release();
@@ -215,6 +298,9 @@ void Application::MainLoop() {
 
     glfwPollEvents();
 
+    // set up the mesh once it is loaded, then upload its next pages
+    UpdateMeshStreaming();
+
     //update uniforms
     float t = static_cast<float>(glfwGetTime());
     queue.writeBuffer(uniformBuffer, offsetof(Uniforms, time), &t, sizeof(float)); // offset for mvp
@@ -270,14 +356,88 @@ void Application::MainLoop() {
 
     renderPassDesc.timestampWrites = nullptr;
 
+    // nothing to draw until the first page is uploaded: the frame is only cleared
+    const bool drawMesh = residentPages > 0;
+    if (drawMesh) UpdateLodSelection();
+
+    // cluster culling: reset the per-submesh index counts, then compact the visible meshlets of the selected LODs.
+    // It tests the meshlets against a single model matrix: instances are drawn without it
+    const bool cullMeshlets = meshletCount > 0 && instances.size() == 1;
+    if (drawMesh && cullMeshlets) {
+        queue.writeBuffer(drawArgsBuffer, 0, drawArgsReset.data(), drawArgsReset.size() * sizeof(uint32_t));
+        queue.writeBuffer(lodSelectionBuffer, 0, lodSelection.data(), lodSelection.size() * sizeof(uint32_t));
+
+        ComputePassDescriptor computePassDesc;
+        computePassDesc.timestampWrites = nullptr;
+        ComputePassEncoder computePass = encoder.beginComputePass(computePassDesc);
+        computePass.setPipeline(cullPipeline);
+        computePass.setBindGroup(0, cullBindGroup, 0, nullptr);
+        computePass.dispatchWorkgroups((meshletCount + 63) / 64, 1, 1); // @workgroup_size(64)
+        computePass.end();
+        computePass.release();
+    }
+
+    // every submesh at its selected LOD, material bind groups only for the shading pass
+    auto drawSubmeshes = [&](RenderPassEncoder& pass, bool bindMaterials) {
+        // submeshes are sorted by material: every material bind group is set once
+        int32_t boundMaterial = -2;
+        auto bindMaterial = [&](int32_t materialId) {
+            if (!bindMaterials || materialId == boundMaterial) return;
+            pass.setBindGroup(1, materialBindGroups[materialId + 1], 0, nullptr);
+            boundMaterial = materialId;
+        };
+        if (cullMeshlets) {
+            pass.setIndexBuffer(culledIndexBuffer, IndexFormat::Uint32, 0, culledIndexBuffer.getSize());
+            for (uint32_t s = 0; s < submeshes.size(); ++s) {
+                bindMaterial(submeshes[s].materialId);
+                pass.drawIndexedIndirect(drawArgsBuffer, s * 5 * sizeof(uint32_t));
+            }
+        }
+        else {
+            pass.setIndexBuffer(indexBuffer, indexFormat, 0, indexBuffer.getSize());
+            for (uint32_t s = 0; s < submeshes.size(); ++s) {
+                const Submesh& submesh = submeshes[s];
+                bindMaterial(submesh.materialId);
+                const uint32_t instanceCount = static_cast<uint32_t>(instances.size());
+                if (lodSelection[s] == 0) {
+                    pass.drawIndexed(submesh.indexCount, instanceCount, submesh.indexOffset, submesh.baseVertex, 0);
+                }
+                else {
+                    const SubmeshLod& lod = submeshLods[submesh.lodOffset + lodSelection[s] - 1];
+                    pass.drawIndexed(lod.indexCount, instanceCount, lod.indexOffset, submesh.baseVertex, 0);
+                }
+            }
+        }
+    };
+
+    // depth prepass: only the position stream is fetched, the shading pass then loads the depth buffer
+    if (drawMesh && depthPipeline) {
+        RenderPassDescriptor depthPassDesc = {};
+        depthPassDesc.label = "Depth prepass";
+        depthPassDesc.colorAttachmentCount = 0;
+        depthPassDesc.colorAttachments = nullptr;
+        depthPassDesc.depthStencilAttachment = &depthStencilAttachment;
+        depthPassDesc.timestampWrites = nullptr;
+        RenderPassEncoder depthPass = encoder.beginRenderPass(depthPassDesc);
+        depthPass.setPipeline(depthPipeline);
+        depthPass.setVertexBuffer(0, vertexStreams[0].buffer, vertexStreams[0].offset, vertexStreams[0].size);
+        depthPass.setBindGroup(0, bindGroup, 0, nullptr);
+        drawSubmeshes(depthPass, false);
+        depthPass.end();
+        depthPass.release();
+        depthStencilAttachment.depthLoadOp = LoadOp::Load;
+    }
+
     // get access to commands for rendering (pass the descriptor)
     RenderPassEncoder renderPass = encoder.beginRenderPass(renderPassDesc);
-    renderPass.setPipeline(pipeline);
-    renderPass.setVertexBuffer(0, vertexBuffer, 0, vertexBuffer.getSize());
-    // renderPass.setIndexBuffer(indexBuffer, IndexFormat::Uint16, 0, indexBuffer.getSize());
-    renderPass.setBindGroup(0, bindGroup, 0, nullptr);
-    // renderPass.drawIndexed(indexCount, 1, 0, 0, 0);
-    renderPass.draw(indexCount, 1, 0, 0);
+    if (drawMesh) {
+        renderPass.setPipeline(pipeline);
+        for (uint32_t i = 0; i < vertexStreams.size(); ++i) {
+            renderPass.setVertexBuffer(i, vertexStreams[i].buffer, vertexStreams[i].offset, vertexStreams[i].size);
+        }
+        renderPass.setBindGroup(0, bindGroup, 0, nullptr);
+        drawSubmeshes(renderPass, true);
+    }
     renderPass.end();
     renderPass.release();
 
@@ -296,6 +456,19 @@ void Application::MainLoop() {
     // release at end
     targetView.release();
 
+    // instancing benchmark: average frame time every 2 seconds
+    if (benchmarkInstanceCount > 0 && drawMesh) {
+        const double now = glfwGetTime();
+        if (benchmarkFrames++ == 0) {
+            benchmarkStart = now;
+        }
+        else if (now - benchmarkStart >= 2.0) {
+            std::cout << instances.size() << " instances: " << (now - benchmarkStart) * 1000.0 / (benchmarkFrames - 1)
+                      << " ms / frame" << std::endl;
+            benchmarkFrames = 0;
+        }
+    }
+
 #ifndef __EMSCRIPTEN__
     surface.present();
 #endif
@@ -361,50 +534,51 @@ void Application::InitializePipeline() {
 
     // 0. Vertex pipeline state
     VertexState vertexState;
-    // vertexBufferLayout
-    VertexBufferLayout vertexBufferLayout;
-    vertexBufferLayout.arrayStride = sizeof(VertexAttr);
-    vertexBufferLayout.stepMode = VertexStepMode::Vertex;
-    // position attribute
-    VertexAttribute positionAttrib;
-    positionAttrib.shaderLocation = 0;
-    positionAttrib.format = VertexFormat::Float32x3;
-    positionAttrib.offset = 0;
-    //color attribute
-    VertexAttribute colorAttrib;
-    colorAttrib.shaderLocation = 1;
-    colorAttrib.format = VertexFormat::Float32x3;
-    colorAttrib.offset = offsetof(VertexAttr, color);
-
-    //normal attribute
-    VertexAttribute normalAttrib;
-    normalAttrib.shaderLocation = 2;
-    normalAttrib.format = VertexFormat::Float32x3; //vec3
-    normalAttrib.offset = offsetof(VertexAttr, normal);
-    // uv attribute
-    VertexAttribute uvAttrib;
-    uvAttrib.shaderLocation = 3;
-    uvAttrib.format = VertexFormat::Float32x2;
-    uvAttrib.offset = offsetof(VertexAttr, uv);
-
-    // pass position & color attr to vertexBufferLayout
-    std::vector<VertexAttribute> vertexAttributes(4);
-    vertexAttributes[0] = positionAttrib;
-    vertexAttributes[1] = colorAttrib;
-    vertexAttributes[2] = normalAttrib;
-    vertexAttributes[3] = uvAttrib;
-    vertexBufferLayout.attributeCount = vertexAttributes.size();
-    vertexBufferLayout.attributes = vertexAttributes.data();
-
-    //// pass vertexBufferLayout to pipelineDesc
-    vertexState.bufferCount = 1;
-    vertexState.buffers = &vertexBufferLayout;
+    // one vertexBufferLayout per stream, built from the layouts the mesh was uploaded with
+    std::vector<VertexBufferLayout> vertexBufferLayouts(vertexStreams.size());
+    std::vector<std::vector<VertexAttribute>> vertexAttributes(vertexStreams.size());
+
+    bool hasColor = false;
+    bool octahedralNormals = false;
+    for (size_t s = 0; s < vertexStreams.size(); ++s) {
+        const VertexLayoutDesc& vertexLayout = vertexStreams[s].layout;
+        std::vector<VertexAttribute>& attributes = vertexAttributes[s];
+        attributes.resize(vertexLayout.elementCount);
+        for (uint32_t i = 0; i < vertexLayout.elementCount; ++i) {
+            const VertexElement& element = vertexLayout.elements[i];
+            attributes[i].shaderLocation = element.location;
+            attributes[i].offset = element.offset;
+            switch (element.format) {
+            case VertexElementFormat::Float32x2: attributes[i].format = VertexFormat::Float32x2; break;
+            case VertexElementFormat::Float32x3: attributes[i].format = VertexFormat::Float32x3; break;
+            case VertexElementFormat::Unorm16x4: attributes[i].format = VertexFormat::Unorm16x4; break;
+            case VertexElementFormat::Snorm16x2: attributes[i].format = VertexFormat::Snorm16x2; break;
+            case VertexElementFormat::Float16x2: attributes[i].format = VertexFormat::Float16x2; break;
+            case VertexElementFormat::Unorm8x4: attributes[i].format = VertexFormat::Unorm8x4; break;
+            case VertexElementFormat::Snorm16x4: attributes[i].format = VertexFormat::Snorm16x4; break;
+            }
+            if (element.location == 1) hasColor = true;
+            if (element.location == 2 && element.format == VertexElementFormat::Snorm16x2) octahedralNormals = true;
+        }
+        vertexBufferLayouts[s].arrayStride = vertexLayout.stride;
+        vertexBufferLayouts[s].stepMode = VertexStepMode::Vertex;
+        vertexBufferLayouts[s].attributeCount = attributes.size();
+        vertexBufferLayouts[s].attributes = attributes.data();
+    }
+
+    //// pass vertexBufferLayouts to pipelineDesc
+    vertexState.bufferCount = vertexBufferLayouts.size();
+    vertexState.buffers = vertexBufferLayouts.data();
 
     // shader contains: shader module, entry point
     vertexState.module = shaderModule;
-    vertexState.entryPoint = "vs_main";
-    vertexState.constantCount = 0;
-    vertexState.constants = nullptr;
+    vertexState.entryPoint = hasColor ? "vs_main" : "vs_main_nocolor";
+    // pipeline-overridable constant: decode octahedral normals in the vertex shader
+    ConstantEntry octNormalsConstant;
+    octNormalsConstant.key = "OCT_NORMALS";
+    octNormalsConstant.value = octahedralNormals ? 1.0 : 0.0;
+    vertexState.constantCount = 1;
+    vertexState.constants = &octNormalsConstant;
 
     pipelineDesc.vertex = vertexState;
 
@@ -418,8 +592,13 @@ void Application::InitializePipeline() {
     FragmentState fragmentState;
     fragmentState.module = shaderModule;
     fragmentState.entryPoint = "fs_main";
-    fragmentState.constantCount = 0;
-    fragmentState.constants = nullptr;
+    // mip level of the bound environment at roughness 1
+    ConstantEntry specularLodConstant;
+    specularLodConstant.key = "SPECULAR_MAX_LOD";
+    specularLodConstant.value = specularTexture ? SpecularPrefilter::LevelCount - 1
+        : cubemap ? cubemap.getMipLevelCount() - 1 : 0;
+    fragmentState.constantCount = 1;
+    fragmentState.constants = &specularLodConstant;
     // configure blending stage
     BlendState blendState;
     // rgb = a_s * rgb_s + (1 - a_s) * rgb_d
@@ -441,9 +620,12 @@ void Application::InitializePipeline() {
     pipelineDesc.fragment = &fragmentState;
 
     // 3. Stencil/depth state
+    // with a depth prepass only the closest surface passes, and the depth buffer is already written
+    const bool positionStream = vertexStreams[0].layout.elementCount == 1 && vertexStreams[0].layout.elements[0].location == 0;
+    const bool usePrepass = depthPrepass && positionStream;
     DepthStencilState depthStencilState = Default;
-    depthStencilState.depthCompare = CompareFunction::LessEqual;
-    depthStencilState.depthWriteEnabled = true;
+    depthStencilState.depthCompare = usePrepass ? CompareFunction::Equal : CompareFunction::LessEqual;
+    depthStencilState.depthWriteEnabled = !usePrepass;
     depthStencilState.format = depthTextureFormat;
     depthStencilState.stencilReadMask = 0;
     depthStencilState.stencilWriteMask = 0;
@@ -458,7 +640,7 @@ void Application::InitializePipeline() {
 
     // define pipeline layout (describe pipeline resources)
     // Uniforms Binding Layout
-    std::vector<BindGroupLayoutEntry> bindingLayoutEntries(4, Default); // Default sets buffer, sampler, etc. to undefined
+    std::vector<BindGroupLayoutEntry> bindingLayoutEntries(6, Default); // Default sets buffer, sampler, etc. to undefined
 
     // 0. Uniforms
     BindGroupLayoutEntry& bindingLayout = bindingLayoutEntries[0];
@@ -467,35 +649,70 @@ void Application::InitializePipeline() {
     bindingLayout.buffer.type = BufferBindingType::Uniform; // 1. undefined -> BUFFER
     bindingLayout.buffer.minBindingSize = sizeof(Uniforms); 
 
-    // 1. Texture Binding Layout
-    BindGroupLayoutEntry& textureBindingLayout = bindingLayoutEntries[1];
-    textureBindingLayout.binding = 1;
-    textureBindingLayout.visibility = ShaderStage::Fragment;
-	textureBindingLayout.texture.sampleType = TextureSampleType::Float;// 1. undefined -> TEXTURE
-    textureBindingLayout.texture.viewDimension = TextureViewDimension::_2D; 
+    // 1. material textures moved to group 1
 
     // 2. Sampler
-    BindGroupLayoutEntry& samplerBindingLayout = bindingLayoutEntries[2];
+    BindGroupLayoutEntry& samplerBindingLayout = bindingLayoutEntries[1];
     samplerBindingLayout.binding = 2;
     samplerBindingLayout.visibility = ShaderStage::Fragment;
     samplerBindingLayout.sampler.type = SamplerBindingType::Filtering;
 
 	// 3. Cube-map Texture Binding Layout
-	BindGroupLayoutEntry& cubemapBindingLayout = bindingLayoutEntries[3];
+	BindGroupLayoutEntry& cubemapBindingLayout = bindingLayoutEntries[2];
 	cubemapBindingLayout.binding = 3;
 	cubemapBindingLayout.visibility = ShaderStage::Fragment;
 	cubemapBindingLayout.texture.sampleType = TextureSampleType::Float;
 	cubemapBindingLayout.texture.viewDimension = TextureViewDimension::Cube;
 
+    // 4. Instance transforms
+    BindGroupLayoutEntry& instanceBindingLayout = bindingLayoutEntries[3];
+    instanceBindingLayout.binding = 4;
+    instanceBindingLayout.visibility = ShaderStage::Vertex;
+    instanceBindingLayout.buffer.type = BufferBindingType::ReadOnlyStorage;
+    instanceBindingLayout.buffer.minBindingSize = sizeof(InstanceData);
+
+    // 5. Instance materials
+    BindGroupLayoutEntry& instanceMaterialBindingLayout = bindingLayoutEntries[4];
+    instanceMaterialBindingLayout.binding = 5;
+    instanceMaterialBindingLayout.visibility = ShaderStage::Fragment;
+    instanceMaterialBindingLayout.buffer.type = BufferBindingType::ReadOnlyStorage;
+    instanceMaterialBindingLayout.buffer.minBindingSize = sizeof(MaterialUniforms);
+
+    // 6. BRDF LUT
+    BindGroupLayoutEntry& brdfLutBindingLayout = bindingLayoutEntries[5];
+    brdfLutBindingLayout.binding = 6;
+    brdfLutBindingLayout.visibility = ShaderStage::Fragment;
+    brdfLutBindingLayout.texture.sampleType = TextureSampleType::Float;
+    brdfLutBindingLayout.texture.viewDimension = TextureViewDimension::_2D;
+
     // Binding group of binding layout
     BindGroupLayoutDescriptor bindGroupLayoutDesc{};
     bindGroupLayoutDesc.entryCount = (uint32_t)bindingLayoutEntries.size();
     bindGroupLayoutDesc.entries = bindingLayoutEntries.data();
     bindGroupLayout = device.createBindGroupLayout(bindGroupLayoutDesc);
+
+    // Material Binding Layout (group 1): MaterialUniforms, diffuse, normal, ORM
+    std::vector<BindGroupLayoutEntry> materialLayoutEntries(4, Default);
+    materialLayoutEntries[0].binding = 0;
+    materialLayoutEntries[0].visibility = ShaderStage::Fragment;
+    materialLayoutEntries[0].buffer.type = BufferBindingType::Uniform;
+    materialLayoutEntries[0].buffer.minBindingSize = sizeof(MaterialUniforms);
+    for (uint32_t i = 1; i < 4; ++i) {
+        materialLayoutEntries[i].binding = i;
+        materialLayoutEntries[i].visibility = ShaderStage::Fragment;
+        materialLayoutEntries[i].texture.sampleType = TextureSampleType::Float;
+        materialLayoutEntries[i].texture.viewDimension = TextureViewDimension::_2D;
+    }
+    BindGroupLayoutDescriptor materialLayoutDesc{};
+    materialLayoutDesc.entryCount = (uint32_t)materialLayoutEntries.size();
+    materialLayoutDesc.entries = materialLayoutEntries.data();
+    materialBindGroupLayout = device.createBindGroupLayout(materialLayoutDesc);
+
     // layout descriptor
+    std::array<WGPUBindGroupLayout, 2> bindGroupLayouts = { bindGroupLayout, materialBindGroupLayout };
     PipelineLayoutDescriptor layoutDesc{};
-    layoutDesc.bindGroupLayoutCount = 1;
-    layoutDesc.bindGroupLayouts = (WGPUBindGroupLayout*)&bindGroupLayout;
+    layoutDesc.bindGroupLayoutCount = (uint32_t)bindGroupLayouts.size();
+    layoutDesc.bindGroupLayouts = bindGroupLayouts.data();
     layout = device.createPipelineLayout(layoutDesc);
 
     // ask backend to figure out the layout itself by inspecting the shader
@@ -503,6 +720,33 @@ void Application::InitializePipeline() {
 
     pipeline = device.createRenderPipeline(pipelineDesc);
 
+    // 4. Depth prepass: same positions (@invariant in the shader) from slot 0 only, no fragment stage
+    if (usePrepass) {
+        WGPUBindGroupLayout depthBindGroupLayout = bindGroupLayout;
+        PipelineLayoutDescriptor depthLayoutDesc{};
+        depthLayoutDesc.bindGroupLayoutCount = 1;
+        depthLayoutDesc.bindGroupLayouts = &depthBindGroupLayout;
+        depthLayout = device.createPipelineLayout(depthLayoutDesc);
+
+        RenderPipelineDescriptor depthPipelineDesc;
+        depthPipelineDesc.label = "Depth prepass";
+        depthPipelineDesc.vertex.module = shaderModule;
+        depthPipelineDesc.vertex.entryPoint = "vs_depth";
+        depthPipelineDesc.vertex.constantCount = 0;
+        depthPipelineDesc.vertex.constants = nullptr;
+        depthPipelineDesc.vertex.bufferCount = 1;
+        depthPipelineDesc.vertex.buffers = &vertexBufferLayouts[0];
+        depthPipelineDesc.primitive = pipelineDesc.primitive;
+        depthPipelineDesc.fragment = nullptr;
+        DepthStencilState depthOnlyState = depthStencilState;
+        depthOnlyState.depthCompare = CompareFunction::Less;
+        depthOnlyState.depthWriteEnabled = true;
+        depthPipelineDesc.depthStencil = &depthOnlyState;
+        depthPipelineDesc.multisample = pipelineDesc.multisample;
+        depthPipelineDesc.layout = depthLayout;
+        depthPipeline = device.createRenderPipeline(depthPipelineDesc);
+    }
+
     shaderModule.release();
 }
 
@@ -512,8 +756,10 @@ RequiredLimits Application::GetRequiredLimits(Adapter adapter) const {
     adapter.getLimits(&supportedLimits);
 
     RequiredLimits requiredLimits = Default;
-    requiredLimits.limits.maxVertexAttributes = 4; // pos col nor uv
-    requiredLimits.limits.maxVertexBuffers = 1;
+    requiredLimits.limits.maxVertexAttributes = 5; // pos col nor uv tangent
+    // position stream + attribute stream + tangent stream (the depth prepass binds slot 0 only),
+    // glTF: position, normal, uv, tangent
+    requiredLimits.limits.maxVertexBuffers = 4;
     // requiredLimits.limits.maxBufferSize = 150000 * sizeof(VertexAttr);
     // requiredLimits.limits.maxVertexBufferArrayStride = 6 * sizeof(float);
     // requiredLimits.limits.maxInterStageShaderComponents = 3; // 3f for color, doesn't count built-in components like position
@@ -527,20 +773,47 @@ RequiredLimits Application::GetRequiredLimits(Adapter adapter) const {
     requiredLimits.limits.maxTextureArrayLayers = 1;
 
     // for uniforms
-    requiredLimits.limits.maxBindGroups = 1;
-    requiredLimits.limits.maxUniformBuffersPerShaderStage = 1;
+    requiredLimits.limits.maxBindGroups = 2; // frame, material
+    requiredLimits.limits.maxUniformBuffersPerShaderStage = 2;
     requiredLimits.limits.maxUniformBufferBindingSize = sizeof(Uniforms);
 
+    // cluster culling: meshlets, source indices, culled indices, draw args, LOD selection
+    // (the vertex and fragment stages read one each: instances, instance materials)
+    requiredLimits.limits.maxStorageBuffersPerShaderStage = 5;
+    requiredLimits.limits.maxStorageBufferBindingSize = supportedLimits.limits.maxStorageBufferBindingSize;
+    requiredLimits.limits.maxBufferSize = supportedLimits.limits.maxBufferSize;
+    requiredLimits.limits.maxComputeWorkgroupSizeX = 64;
+    requiredLimits.limits.maxComputeInvocationsPerWorkgroup = 64;
+    requiredLimits.limits.maxComputeWorkgroupsPerDimension = supportedLimits.limits.maxComputeWorkgroupsPerDimension;
+
     // textures
-    requiredLimits.limits.maxSampledTexturesPerShaderStage = 1;
+    requiredLimits.limits.maxSampledTexturesPerShaderStage = 5; // cubemap, BRDF LUT, diffuse, normal, ORM
     requiredLimits.limits.maxSamplersPerShaderStage = 1;
 
     requiredLimits.limits.maxTextureDimension1D = 2048;
-    requiredLimits.limits.maxTextureDimension2D = 2048;
+    // material maps of the loaded assets can be larger than 2048
+    requiredLimits.limits.maxTextureDimension2D = supportedLimits.limits.maxTextureDimension2D;
 
     return requiredLimits;
 }
 
+PresentMode Application::GetPresentMode() {
+#ifndef __EMSCRIPTEN__
+    // the instancing benchmark measures frame times above the refresh rate if it can
+    if (benchmarkInstanceCount > 0) {
+        SurfaceCapabilities capabilities;
+        surface.getCapabilities(adapter, &capabilities);
+        bool immediate = false;
+        for (size_t i = 0; i < capabilities.presentModeCount; ++i) {
+            immediate = immediate || capabilities.presentModes[i] == PresentMode::Immediate;
+        }
+        capabilities.freeMembers();
+        if (immediate) return PresentMode::Immediate;
+    }
+#endif
+    return PresentMode::Fifo;
+}
+
 void Application::InitializeSurface()
 {
     int width, height;
@@ -561,8 +834,8 @@ void Application::InitializeSurface()
     config.viewFormatCount = 0;
     config.viewFormats = nullptr;
     config.device = device;
-    // presentation: first in, first out
-    config.presentMode = PresentMode::Fifo;
+    // presentation: first in, first out (unless benchmarking)
+    config.presentMode = GetPresentMode();
     // transparency 
     config.alphaMode = CompositeAlphaMode::Auto;
 
@@ -571,26 +844,24 @@ void Application::InitializeSurface()
 
 void Application::InitializeBuffers() {
 
-    std::vector<VertexAttr> verticesList;
-    bool success = FileManagement::getObjGeometry("../files/sphere.obj", verticesList);
-    //bool success = FileManagement::getObjGeometry("../files/wahoo.obj", verticesList);
-    if (!success) {
-        std::cerr << "Could not load geometry!" << std::endl;
-        exit(1);
-    }
-
-    indexCount = static_cast<uint32_t>(verticesList.size());
+    const std::filesystem::path meshPath = "../files/sphere.obj";
+    //const std::filesystem::path meshPath = "../files/wahoo.obj";
+    //const std::filesystem::path meshPath = "../files/sneakers.glb";
+    const bool isGltf = meshPath.extension() == ".gltf" || meshPath.extension() == ".glb";
 
-    // VERTEX BUFFER
-    BufferDescriptor bufferDesc;
-    bufferDesc.label = "Vertex Buffer";
-    bufferDesc.usage = BufferUsage::CopyDst | BufferUsage::Vertex;
-    bufferDesc.size = verticesList.size() * sizeof(VertexAttr);
-    bufferDesc.size = (bufferDesc.size + 3) & ~3; // align to 4 bytes
-    bufferDesc.mappedAtCreation = false;
+    // glTF buffers that already have a vertex layout we can bind are uploaded from the mapped file
+    GltfModel gltf;
+    const bool direct = isGltf && GltfLoader::load(meshPath, gltf) && GltfLoader::isDirectlyDrawable(gltf);
 
-    vertexBuffer = device.createBuffer(bufferDesc);
-    queue.writeBuffer(vertexBuffer, 0, verticesList.data(), bufferDesc.size);
+    if (direct) {
+        std::cout << "Uploading " << meshPath << " without conversion" << std::endl;
+        InitializeGltfBuffers(gltf);
+        residentPages = 1;
+    }
+    else {
+        // cache mapped (or built) on a thread, drawn from its coarsest LODs as soon as the first page is uploaded
+        meshStreamer.start(meshPath, vertexFormat);
+    }
 
     // UNIFORM BUFFER
     BufferDescriptor uniformBufferDesc;
@@ -608,7 +879,8 @@ void Application::InitializeBuffers() {
     viewCamera.getViewMatrix(uniforms.viewMatrix);
     viewCamera.getProjMatrix(uniforms.projMatrix);
     
-    uniforms.modelMatrix = glm::rotate(glm::mat4(1.0f), glm::radians(45.0f), glm::vec3(0, 1, 0));
+    modelMatrix = glm::rotate(glm::mat4(1.0f), glm::radians(45.0f), glm::vec3(0, 1, 0)) * meshTransform;
+    uniforms.modelMatrix = modelMatrix;
     /*uniforms.modelMatrix =
         glm::scale(
             glm::rotate(glm::mat4(1.0f),
@@ -617,9 +889,310 @@ void Application::InitializeBuffers() {
             glm::vec3(0.05f));*/
 	uniforms.modelInvTranspose = glm::inverseTranspose(uniforms.modelMatrix);
 	uniforms.cameraPos = viewCamera.getPosition();
+    uniforms.positionOffset = positionOffset;
+    uniforms.positionScale = positionScale;
+    // constant ambient until the environment is projected: irradiance / pi of 0.03
+    for (glm::vec4& coefficient : uniforms.shIrradiance) coefficient = glm::vec4(0.0f);
+    uniforms.shIrradiance[0] = glm::vec4(glm::vec3(0.03f / 0.282095f), 0.0f);
     queue.writeBuffer(uniformBuffer, 0, &uniforms, sizeof(Uniforms));
 }
 
+void Application::InitializeMeshResources() {
+    // the pipeline's vertex layout depends on how the mesh was packed
+    InitializePipeline();
+    InitializeMaterials(); // after colorTextureView, the default diffuse map
+    InitializeInstances();
+    InitializeBindGroups(); // after the pipeline's bind group layout and the instance buffers
+    InitializeCullPipeline(); // after the uniform buffer and the meshlet buffers
+    lodSelection.assign(submeshes.size(), 0);
+
+    queue.writeBuffer(uniformBuffer, offsetof(Uniforms, positionOffset), &positionOffset, sizeof(glm::vec3));
+    queue.writeBuffer(uniformBuffer, offsetof(Uniforms, positionScale), &positionScale, sizeof(glm::vec3));
+}
+
+void Application::InitializeMeshBuffers(uint64_t vertexBytes, uint32_t vertexStride, const GpuUpload::ChunkWriter& writeVertices,
+                                        uint64_t indexBytes, const GpuUpload::ChunkWriter& writeIndices,
+                                        IndexFormat format, uint32_t count) {
+    indexCount = count;
+    indexFormat = format;
+
+    // VERTEX BUFFER: written in place through mappedAtCreation, GpuUpload::ChunkSize at a time
+    vertexBuffer = GpuUpload::createBuffer(device, "Vertex Buffer", BufferUsage::CopyDst | BufferUsage::Vertex,
+        vertexBytes, vertexStride, writeVertices);
+
+    // INDEX BUFFER
+    indexBuffer = GpuUpload::createBuffer(device, "Index Buffer",
+        BufferUsage::CopyDst | BufferUsage::Index | BufferUsage::Storage, // read by cull.wgsl
+        indexBytes, 4, writeIndices);
+}
+
+void Application::InitializeGltfBuffers(const GltfModel& model) {
+    // one stream per attribute, every primitive's accessor is copied from the mapped file into its slice
+    const uint32_t locations[3] = { 0, 2, 3 };
+    const VertexElementFormat formats[3] = { VertexElementFormat::Float32x3, VertexElementFormat::Float32x3, VertexElementFormat::Float32x2 };
+    const uint32_t indexSize = model.primitives[0].indices.getElementSize();
+
+    uint64_t vertexCount = 0;
+    uint64_t indexBytes = 0;
+    submeshes.clear();
+    for (const GltfPrimitive& primitive : model.primitives) {
+        Submesh submesh;
+        submesh.indexOffset = static_cast<uint32_t>(indexBytes / indexSize);
+        submesh.indexCount = primitive.indices.count;
+        submesh.materialId = primitive.materialId;
+        submesh.baseVertex = static_cast<uint32_t>(vertexCount);
+        submeshes.push_back(submesh);
+        vertexCount += primitive.position.count;
+        indexBytes += uint64_t(primitive.indices.count) * indexSize;
+    }
+
+    vertexStreams.clear();
+    uint64_t vertexBytes = 0;
+    for (int s = 0; s < 3; ++s) {
+        VertexStream stream;
+        stream.layout.elementCount = 1;
+        stream.layout.elements[0] = { locations[s], formats[s], 0 };
+        stream.layout.stride = VertexQuantization::getFormatSize(formats[s]);
+        stream.offset = vertexBytes;
+        stream.size = vertexCount * stream.layout.stride;
+        vertexStreams.push_back(stream);
+        vertexBytes += stream.size;
+    }
+
+    // accessor byte ranges -> their place in the buffers
+    std::vector<GpuUpload::Range> vertexRanges;
+    std::vector<GpuUpload::Range> indexRanges;
+    glm::vec3 boundsMin(std::numeric_limits<float>::max());
+    glm::vec3 boundsMax(-std::numeric_limits<float>::max());
+    for (size_t p = 0; p < model.primitives.size(); ++p) {
+        const GltfPrimitive& primitive = model.primitives[p];
+        const Submesh& submesh = submeshes[p];
+        const GltfAccessor* attributes[3] = { &primitive.position, &primitive.normal, &primitive.uv };
+        for (int s = 0; s < 3; ++s) {
+            const uint64_t stride = vertexStreams[s].layout.stride;
+            vertexRanges.push_back({ vertexStreams[s].offset + submesh.baseVertex * stride,
+                attributes[s]->data, uint64_t(primitive.position.count) * stride });
+        }
+        indexRanges.push_back({ uint64_t(submesh.indexOffset) * indexSize,
+            primitive.indices.data, uint64_t(submesh.indexCount) * indexSize });
+
+        // accessor min / max are required for positions, scan the data if an exporter left them out
+        if (primitive.position.hasBounds) {
+            boundsMin = glm::min(boundsMin, glm::vec3(primitive.position.min[0], primitive.position.min[1], primitive.position.min[2]));
+            boundsMax = glm::max(boundsMax, glm::vec3(primitive.position.max[0], primitive.position.max[1], primitive.position.max[2]));
+        }
+        else {
+            for (uint32_t i = 0; i < primitive.position.count; ++i) {
+                const glm::vec3 position(primitive.position.getFloat(i, 0), primitive.position.getFloat(i, 1), primitive.position.getFloat(i, 2));
+                boundsMin = glm::min(boundsMin, position);
+                boundsMax = glm::max(boundsMax, position);
+            }
+        }
+    }
+
+    const uint32_t count = static_cast<uint32_t>(indexBytes / indexSize);
+    InitializeMeshBuffers(vertexBytes, 4, GpuUpload::copyRanges(std::move(vertexRanges)),
+        indexBytes, GpuUpload::copyRanges(std::move(indexRanges)),
+        indexSize == 2 ? IndexFormat::Uint16 : IndexFormat::Uint32, count);
+    for (VertexStream& stream : vertexStreams) stream.buffer = vertexBuffer;
+    InitializeTangentStream(false);
+
+    // shared by all primitives (GltfLoader::isDirectlyDrawable), applied through the model matrix
+    meshTransform = model.primitives[0].transform;
+    positionOffset = glm::vec3(0.0f);
+    positionScale = glm::vec3(1.0f);
+    submeshLods.clear();
+    materials = model.materials;
+    boundsCenter = (boundsMin + boundsMax) * 0.5f;
+    boundsRadius = glm::length(boundsMax - boundsMin) * 0.5f;
+    // no meshlets: drawn per submesh without culling
+    InitializeMeshletBuffers(nullptr, 0);
+}
+
+void Application::InitializeStreamedMesh() {
+    const MeshStreamer::Mesh& mesh = meshStreamer.getMesh();
+    meshPages = mesh.pages;
+
+    // position stream + interleaved attributes + tangents, bound up to the uploaded size
+    vertexStreams = { { mesh.positionLayout, 0, 0 }, { mesh.layout, 0, 0 } };
+    InitializeTangentStream(mesh.tangentData != nullptr);
+    positionOffset = mesh.positionOffset;
+    positionScale = mesh.positionScale;
+    indexCount = mesh.indexCount;
+    indexFormat = mesh.indexSize == 2 ? IndexFormat::Uint16 : IndexFormat::Uint32;
+    submeshes = mesh.submeshes;
+    submeshLods = mesh.lods;
+    materials = mesh.materials;
+    boundsCenter = (mesh.boundsMin + mesh.boundsMax) * 0.5f;
+    boundsRadius = glm::length(mesh.boundsMax - mesh.boundsMin) * 0.5f;
+    // meshlets of every page: the cull pass only reads the levels UpdateLodSelection allows
+    InitializeMeshletBuffers(mesh.meshlets, mesh.meshletCount);
+    InitializeMeshResources();
+}
+
+void Application::InitializeTangentStream(bool perVertex) {
+    // the last slot, location 4. Meshes without tangents bind one zero tangent that every vertex reads
+    // (arrayStride 0), the shader then builds the frame from screen space derivatives
+    VertexStream stream;
+    stream.layout.elementCount = 1;
+    stream.layout.elements[0] = { 4, VertexElementFormat::Snorm16x4, 0 };
+    stream.layout.stride = perVertex ? VertexQuantization::getFormatSize(VertexElementFormat::Snorm16x4) : 0;
+    if (!perVertex) {
+        const int16_t zeroTangent[4] = {};
+        BufferDescriptor bufferDesc;
+        bufferDesc.label = "Zero Tangent Buffer";
+        bufferDesc.usage = BufferUsage::CopyDst | BufferUsage::Vertex;
+        bufferDesc.size = sizeof(zeroTangent);
+        bufferDesc.mappedAtCreation = false;
+        tangentBuffer = device.createBuffer(bufferDesc);
+        queue.writeBuffer(tangentBuffer, 0, zeroTangent, sizeof(zeroTangent));
+        stream.buffer = tangentBuffer;
+        stream.size = sizeof(zeroTangent);
+    }
+    vertexStreams.push_back(stream);
+}
+
+void Application::InitializeMeshletBuffers(const Meshlet* meshlets, uint32_t count) {
+    meshletCount = count;
+    if (meshletCount == 0) return; // drawn without culling
+
+    // MESHLET BUFFER
+    BufferDescriptor meshletBufferDesc;
+    meshletBufferDesc.label = "Meshlet Buffer";
+    meshletBufferDesc.usage = BufferUsage::CopyDst | BufferUsage::Storage;
+    meshletBufferDesc.size = uint64_t(meshletCount) * sizeof(Meshlet);
+    meshletBufferDesc.mappedAtCreation = false;
+    meshletBuffer = device.createBuffer(meshletBufferDesc);
+    queue.writeBuffer(meshletBuffer, 0, meshlets, meshletBufferDesc.size);
+
+    // CULLED INDEX BUFFER: written by the cull pass, every submesh keeps its index range
+    BufferDescriptor culledIndexBufferDesc;
+    culledIndexBufferDesc.label = "Culled Index Buffer";
+    culledIndexBufferDesc.usage = BufferUsage::Index | BufferUsage::Storage;
+    culledIndexBufferDesc.size = uint64_t(indexCount) * sizeof(uint32_t);
+    culledIndexBufferDesc.mappedAtCreation = false;
+    culledIndexBuffer = device.createBuffer(culledIndexBufferDesc);
+
+    // DRAW ARGS: indexCount, instanceCount, firstIndex, baseVertex, firstInstance
+    drawArgsReset.assign(submeshes.size() * 5, 0);
+    for (uint32_t s = 0; s < submeshes.size(); ++s) {
+        drawArgsReset[5 * s + 1] = 1;
+        drawArgsReset[5 * s + 2] = submeshes[s].indexOffset;
+        drawArgsReset[5 * s + 3] = submeshes[s].baseVertex;
+    }
+
+    BufferDescriptor drawArgsBufferDesc;
+    drawArgsBufferDesc.label = "Draw Args Buffer";
+    drawArgsBufferDesc.usage = BufferUsage::CopyDst | BufferUsage::Storage | BufferUsage::Indirect;
+    drawArgsBufferDesc.size = drawArgsReset.size() * sizeof(uint32_t);
+    drawArgsBufferDesc.mappedAtCreation = false;
+    drawArgsBuffer = device.createBuffer(drawArgsBufferDesc);
+
+    // LOD SELECTION: level per submesh, meshlets of other levels are skipped
+    BufferDescriptor lodSelectionBufferDesc;
+    lodSelectionBufferDesc.label = "LOD Selection Buffer";
+    lodSelectionBufferDesc.usage = BufferUsage::CopyDst | BufferUsage::Storage;
+    lodSelectionBufferDesc.size = submeshes.size() * sizeof(uint32_t);
+    lodSelectionBufferDesc.mappedAtCreation = false;
+    lodSelectionBuffer = device.createBuffer(lodSelectionBufferDesc);
+}
+
+void Application::InitializeCullPipeline() {
+    if (meshletCount == 0) return;
+
+    ShaderModule cullModule = FileManagement::loadShaderModule("../files/cull.wgsl", device);
+    if (!cullModule) {
+        std::cerr << "Cull shader module creation failed!" << std::endl;
+        meshletCount = 0; // fall back to drawing everything
+        return;
+    }
+
+    std::vector<BindGroupLayoutEntry> cullLayoutEntries(6, Default);
+    // 0. Uniforms
+    cullLayoutEntries[0].binding = 0;
+    cullLayoutEntries[0].visibility = ShaderStage::Compute;
+    cullLayoutEntries[0].buffer.type = BufferBindingType::Uniform;
+    cullLayoutEntries[0].buffer.minBindingSize = sizeof(Uniforms);
+    // 1. meshlets, 2. source indices
+    cullLayoutEntries[1].binding = 1;
+    cullLayoutEntries[1].visibility = ShaderStage::Compute;
+    cullLayoutEntries[1].buffer.type = BufferBindingType::ReadOnlyStorage;
+    cullLayoutEntries[2].binding = 2;
+    cullLayoutEntries[2].visibility = ShaderStage::Compute;
+    cullLayoutEntries[2].buffer.type = BufferBindingType::ReadOnlyStorage;
+    // 3. culled indices, 4. draw args
+    cullLayoutEntries[3].binding = 3;
+    cullLayoutEntries[3].visibility = ShaderStage::Compute;
+    cullLayoutEntries[3].buffer.type = BufferBindingType::Storage;
+    cullLayoutEntries[4].binding = 4;
+    cullLayoutEntries[4].visibility = ShaderStage::Compute;
+    cullLayoutEntries[4].buffer.type = BufferBindingType::Storage;
+    // 5. LOD selection
+    cullLayoutEntries[5].binding = 5;
+    cullLayoutEntries[5].visibility = ShaderStage::Compute;
+    cullLayoutEntries[5].buffer.type = BufferBindingType::ReadOnlyStorage;
+
+    BindGroupLayoutDescriptor cullLayoutDesc{};
+    cullLayoutDesc.entryCount = (uint32_t)cullLayoutEntries.size();
+    cullLayoutDesc.entries = cullLayoutEntries.data();
+    cullBindGroupLayout = device.createBindGroupLayout(cullLayoutDesc);
+
+    PipelineLayoutDescriptor pipelineLayoutDesc{};
+    pipelineLayoutDesc.bindGroupLayoutCount = 1;
+    pipelineLayoutDesc.bindGroupLayouts = (WGPUBindGroupLayout*)&cullBindGroupLayout;
+    PipelineLayout cullPipelineLayout = device.createPipelineLayout(pipelineLayoutDesc);
+
+    // the source indices may be packed u16 pairs
+    ConstantEntry indexU16Constant;
+    indexU16Constant.key = "INDEX_U16";
+    indexU16Constant.value = indexFormat == IndexFormat::Uint16 ? 1.0 : 0.0;
+
+    ComputePipelineDescriptor cullPipelineDesc;
+    cullPipelineDesc.label = "Cull Pipeline";
+    cullPipelineDesc.layout = cullPipelineLayout;
+    cullPipelineDesc.compute.module = cullModule;
+    cullPipelineDesc.compute.entryPoint = "cs_cull";
+    cullPipelineDesc.compute.constantCount = 1;
+    cullPipelineDesc.compute.constants = &indexU16Constant;
+    cullPipeline = device.createComputePipeline(cullPipelineDesc);
+
+    cullPipelineLayout.release();
+    cullModule.release();
+
+    // streamed meshes get their index buffer with the first page
+    if (indexBuffer) InitializeCullBindGroup();
+}
+
+void Application::InitializeCullBindGroup() {
+    if (meshletCount == 0) return;
+    if (cullBindGroup) cullBindGroup.release();
+
+    std::vector<BindGroupEntry> cullEntries(6);
+    cullEntries[0].binding = 0;
+    cullEntries[0].buffer = uniformBuffer;
+    cullEntries[0].size = sizeof(Uniforms);
+    cullEntries[1].binding = 1;
+    cullEntries[1].buffer = meshletBuffer;
+    cullEntries[1].size = meshletBuffer.getSize();
+    cullEntries[2].binding = 2;
+    cullEntries[2].buffer = indexBuffer;
+    cullEntries[2].size = indexBuffer.getSize();
+    cullEntries[3].binding = 3;
+    cullEntries[3].buffer = culledIndexBuffer;
+    cullEntries[3].size = culledIndexBuffer.getSize();
+    cullEntries[4].binding = 4;
+    cullEntries[4].buffer = drawArgsBuffer;
+    cullEntries[4].size = drawArgsBuffer.getSize();
+    cullEntries[5].binding = 5;
+    cullEntries[5].buffer = lodSelectionBuffer;
+    cullEntries[5].size = lodSelectionBuffer.getSize();
+
+    BindGroupDescriptor cullBindGroupDesc{};
+    cullBindGroupDesc.layout = cullBindGroupLayout;
+    cullBindGroupDesc.entryCount = (uint32_t)cullEntries.size();
+    cullBindGroupDesc.entries = cullEntries.data();
+    cullBindGroup = device.createBindGroup(cullBindGroupDesc);
+}
 
 void Application::InitializeBindGroups() {
     // UNIFORM
@@ -629,11 +1202,6 @@ void Application::InitializeBindGroups() {
     binding.offset = 0;
     binding.size = sizeof(Uniforms);
 
-    // OBJ COLOR TEXTURE
-    BindGroupEntry textureBinding{}; // TODO: other specidications?????
-    textureBinding.binding = 1;
-    textureBinding.textureView = colorTextureView;
-
     // SAMPLER
     BindGroupEntry samplerBinding{};
     samplerBinding.binding = 2;
@@ -642,13 +1210,33 @@ void Application::InitializeBindGroups() {
     // CUBE-MAP TEXTURE
 	BindGroupEntry cubemapBinding{};
 	cubemapBinding.binding = 3;
-	cubemapBinding.textureView = cubemapTextureView;
-
-    std::vector<BindGroupEntry> bindingEntries(4);
+	cubemapBinding.textureView = specularTexture ? specularTextureView : cubemapTextureView;
+
+    // INSTANCES
+    BindGroupEntry instanceBinding{};
+    instanceBinding.binding = 4;
+    instanceBinding.buffer = instanceBuffer;
+    instanceBinding.offset = 0;
+    instanceBinding.size = instanceBuffer.getSize();
+    BindGroupEntry instanceMaterialBinding{};
+    instanceMaterialBinding.binding = 5;
+    instanceMaterialBinding.buffer = instanceMaterialBuffer;
+    instanceMaterialBinding.offset = 0;
+    instanceMaterialBinding.size = instanceMaterialBuffer.getSize();
+
+    // BRDF LUT
+    BindGroupEntry brdfLutBinding{};
+    brdfLutBinding.binding = 6;
+    brdfLutBinding.textureView = brdfLutTextureView;
+
+    // OBJ textures: per material, see InitializeMaterials
+    std::vector<BindGroupEntry> bindingEntries(6);
     bindingEntries[0] = binding;
-    bindingEntries[1] = textureBinding;
-    bindingEntries[2] = samplerBinding;
-	bindingEntries[3] = cubemapBinding;
+    bindingEntries[1] = samplerBinding;
+	bindingEntries[2] = cubemapBinding;
+    bindingEntries[3] = instanceBinding;
+    bindingEntries[4] = instanceMaterialBinding;
+    bindingEntries[5] = brdfLutBinding;
     BindGroupDescriptor bindGroupDesc{};
     bindGroupDesc.layout = bindGroupLayout; // defined in layer pipeline
     bindGroupDesc.entryCount = (uint32_t)bindingEntries.size();
@@ -656,6 +1244,280 @@ void Application::InitializeBindGroups() {
     bindGroup = device.createBindGroup(bindGroupDesc);
 }
 
+void Application::InitializeInstances() {
+    instances.clear();
+    instanceLodBounds.clear();
+    std::vector<MaterialUniforms> instanceMaterials;
+    auto addInstance = [&](const glm::mat4x4& model, uint32_t materialIndex) {
+        InstanceData instance;
+        instance.modelMatrix = model;
+        instance.modelInvTranspose = glm::inverseTranspose(model);
+        instance.materialIndex = materialIndex;
+        instances.push_back(instance);
+        const float scale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) });
+        instanceLodBounds.push_back(glm::vec4(glm::vec3(model * glm::vec4(boundsCenter, 1.0f)), scale));
+    };
+
+    if (benchmarkInstanceCount == 0) {
+        addInstance(modelMatrix, NoInstanceMaterial);
+        instanceMaterials.push_back({ glm::vec4(1.0f), 1.0f, 0.0f, {} }); // unused, bindings cannot be empty
+    }
+    else {
+        // roughness along x, metallic along y
+        const uint32_t materialSteps = 10;
+        for (uint32_t m = 0; m < materialSteps * materialSteps; ++m) {
+            MaterialUniforms material = {};
+            material.baseColor = glm::vec4(0.9f, 0.4f, 0.2f, 1.0f);
+            material.roughness = (static_cast<float>(m % materialSteps) + 0.5f) / materialSteps;
+            material.metallic = static_cast<float>(m / materialSteps) / (materialSteps - 1);
+            instanceMaterials.push_back(material);
+        }
+
+        // cube of side 2 around the origin, meshes scaled to fit their cell
+        const uint32_t side = static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<double>(benchmarkInstanceCount))));
+        const float spacing = 2.0f / side;
+        const float scale = boundsRadius > 0.0f ? 0.4f * spacing / boundsRadius : 1.0f;
+        for (uint32_t i = 0; i < benchmarkInstanceCount; ++i) {
+            const uint32_t x = i % side;
+            const uint32_t y = (i / side) % side;
+            const uint32_t z = i / (side * side);
+            const glm::vec3 position = glm::vec3(x, y, z) * spacing - glm::vec3(1.0f - 0.5f * spacing);
+            const glm::mat4x4 model = glm::translate(glm::mat4x4(1.0f), position) *
+                glm::scale(glm::mat4x4(1.0f), glm::vec3(scale)) * glm::translate(glm::mat4x4(1.0f), -boundsCenter);
+            addInstance(model, (x % materialSteps) + materialSteps * (y % materialSteps));
+        }
+        std::cout << "Instancing benchmark: " << instances.size() << " instances" << std::endl;
+    }
+
+    BufferDescriptor instanceBufferDesc;
+    instanceBufferDesc.label = "Instance Buffer";
+    instanceBufferDesc.usage = BufferUsage::CopyDst | BufferUsage::Storage;
+    instanceBufferDesc.size = instances.size() * sizeof(InstanceData);
+    instanceBufferDesc.mappedAtCreation = false;
+    instanceBuffer = device.createBuffer(instanceBufferDesc);
+    queue.writeBuffer(instanceBuffer, 0, instances.data(), instanceBufferDesc.size);
+
+    BufferDescriptor instanceMaterialBufferDesc;
+    instanceMaterialBufferDesc.label = "Instance Material Buffer";
+    instanceMaterialBufferDesc.usage = BufferUsage::CopyDst | BufferUsage::Storage;
+    instanceMaterialBufferDesc.size = instanceMaterials.size() * sizeof(MaterialUniforms);
+    instanceMaterialBufferDesc.mappedAtCreation = false;
+    instanceMaterialBuffer = device.createBuffer(instanceMaterialBufferDesc);
+    queue.writeBuffer(instanceMaterialBuffer, 0, instanceMaterials.data(), instanceMaterialBufferDesc.size);
+}
+
+void Application::InitializeMaterials() {
+    const uint8_t white[4] = { 255, 255, 255, 255 };
+    const uint8_t flatNormal[4] = { 128, 128, 255, 255 }; // tangent space +z
+    whiteTexture = getSolidTexture(white);
+    flatNormalTexture = getSolidTexture(flatNormal);
+
+    // unknown ids draw with the default material
+    for (Submesh& submesh : submeshes) {
+        if (submesh.materialId < -1 || submesh.materialId >= (int32_t)materials.size()) submesh.materialId = -1;
+    }
+
+    // one uniform block per bind group, at the device's uniform offset alignment
+    SupportedLimits deviceLimits;
+    device.getLimits(&deviceLimits);
+    const uint64_t alignment = deviceLimits.limits.minUniformBufferOffsetAlignment;
+    const uint64_t stride = (sizeof(MaterialUniforms) + alignment - 1) / alignment * alignment;
+    const size_t groupCount = materials.size() + 1;
+
+    std::vector<uint8_t> uniformData(groupCount * stride, 0);
+    std::vector<TextureView> ormViews(groupCount, whiteTexture.view); // the channels they are read from go into the uniforms
+    for (size_t i = 0; i < groupCount; ++i) {
+        MaterialUniforms uniforms{};
+        uniforms.baseColor = glm::vec4(1.0f);
+        uniforms.roughness = 0.5f;
+        uniforms.metallic = 0.0f;
+        uniforms.occlusionChannel = MaterialUniforms::NoChannel;
+        uniforms.roughnessChannel = MaterialUniforms::NoChannel;
+        uniforms.metallicChannel = MaterialUniforms::NoChannel;
+        if (i > 0) {
+            const MeshMaterial& material = materials[i - 1];
+            uniforms.baseColor = glm::vec4(material.diffuse, 1.0f);
+            uniforms.roughness = material.roughness;
+            uniforms.metallic = material.metallic;
+            ormViews[i] = getOrmTexture(material, uniforms);
+        }
+        std::memcpy(uniformData.data() + i * stride, &uniforms, sizeof(uniforms));
+    }
+
+    BufferDescriptor materialBufferDesc;
+    materialBufferDesc.label = "Material Buffer";
+    materialBufferDesc.usage = BufferUsage::CopyDst | BufferUsage::Uniform;
+    materialBufferDesc.size = uniformData.size();
+    materialBufferDesc.mappedAtCreation = false;
+    materialBuffer = device.createBuffer(materialBufferDesc);
+    queue.writeBuffer(materialBuffer, 0, uniformData.data(), uniformData.size());
+
+    materialBindGroups.resize(groupCount);
+    for (size_t i = 0; i < groupCount; ++i) {
+        // the default material keeps the old OBJ texture
+        TextureView diffuse = colorTextureView ? colorTextureView : whiteTexture.view;
+        TextureView normal = flatNormalTexture.view;
+        if (i > 0) {
+            const MeshMaterial& material = materials[i - 1];
+            diffuse = getMaterialTexture(material.diffuseTexture, whiteTexture.view, true);
+            normal = getMaterialTexture(material.normalTexture, flatNormalTexture.view, false);
+        }
+
+        std::vector<BindGroupEntry> entries(4);
+        entries[0].binding = 0;
+        entries[0].buffer = materialBuffer;
+        entries[0].offset = i * stride;
+        entries[0].size = sizeof(MaterialUniforms);
+        entries[1].binding = 1;
+        entries[1].textureView = diffuse;
+        entries[2].binding = 2;
+        entries[2].textureView = normal;
+        entries[3].binding = 3;
+        entries[3].textureView = ormViews[i];
+
+        BindGroupDescriptor materialBindGroupDesc{};
+        materialBindGroupDesc.layout = materialBindGroupLayout;
+        materialBindGroupDesc.entryCount = (uint32_t)entries.size();
+        materialBindGroupDesc.entries = entries.data();
+        materialBindGroups[i] = device.createBindGroup(materialBindGroupDesc);
+    }
+    std::cout << "Materials: " << materials.size() << ", textures: " << materialTextures.size() << std::endl;
+}
+
+TextureView Application::getMaterialTexture(const std::string& path, TextureView fallback, bool srgb) {
+    if (path.empty()) return fallback;
+
+    auto it = materialTextures.find(path);
+    if (it == materialTextures.end()) {
+        // failed loads are remembered too, as null entries
+        MaterialTexture loaded;
+        loaded.texture = getObjTexture(path, device, &loaded.view, srgb);
+        if (!loaded.texture) {
+            std::cerr << "Could not load material texture " << path << std::endl;
+        }
+        it = materialTextures.emplace(path, loaded).first;
+    }
+    return it->second.texture ? it->second.view : fallback;
+}
+
+// channels of a texture as the shader samples them
+static uint32_t getChannelCount(TextureFormat format) {
+    switch (format) {
+    case TextureFormat::R8Unorm: return 1;
+    case TextureFormat::RG8Unorm:
+    case TextureFormat::BC5RGUnorm: return 2;
+    default: return 4;
+    }
+}
+
+TextureView Application::getOrmTexture(const MeshMaterial& material, MaterialUniforms& uniforms) {
+    const std::string* maps[3] = { &material.occlusionTexture, &material.roughnessTexture, &material.metallicTexture };
+    uint32_t* channels[3] = { &uniforms.occlusionChannel, &uniforms.roughnessChannel, &uniforms.metallicChannel };
+    std::vector<std::string> paths; // distinct, glTF often has one image for all three
+    for (const std::string* map : maps) {
+        if (!map->empty() && std::find(paths.begin(), paths.end(), *map) == paths.end()) paths.push_back(*map);
+    }
+    if (paths.empty()) return whiteTexture.view;
+
+    std::map<std::string, MaterialTexture>::iterator it;
+    if (paths.size() == 1) {
+        getMaterialTexture(paths[0], whiteTexture.view, false);
+        it = materialTextures.find(paths[0]);
+    }
+    else {
+        const std::string key = "orm:" + material.occlusionTexture + "|" + material.roughnessTexture + "|" + material.metallicTexture;
+        it = materialTextures.find(key);
+        if (it == materialTextures.end()) it = materialTextures.emplace(key, packOrmTexture(material)).first;
+    }
+    if (!it->second.texture) return whiteTexture.view;
+
+    // packed textures have every map at its ORM channel
+    const uint32_t channelCount = paths.size() == 1 ? getChannelCount(it->second.texture.getFormat()) : 4;
+    for (uint32_t m = 0; m < 3; ++m) {
+        if (!maps[m]->empty()) *channels[m] = ChannelPacking::getMapChannel(channelCount, m);
+    }
+    return it->second.view;
+}
+
+Application::MaterialTexture Application::packOrmTexture(const MeshMaterial& material) {
+    // every source decoded once with the channels it has, maps of another size than the first are left out
+    struct DecodedMap {
+        std::string path;
+        uint8_t* data;
+        int channels;
+    };
+    std::vector<DecodedMap> decoded;
+    const std::string* maps[3] = { &material.occlusionTexture, &material.roughnessTexture, &material.metallicTexture };
+    ChannelSource sources[4] = {};
+    int width = 0, height = 0;
+    for (uint32_t m = 0; m < 3; ++m) {
+        if (maps[m]->empty()) continue;
+        auto it = std::find_if(decoded.begin(), decoded.end(), [&](const DecodedMap& map) { return map.path == *maps[m]; });
+        if (it == decoded.end()) {
+            int mapWidth, mapHeight, channels;
+            uint8_t* data = stbi_load(maps[m]->c_str(), &mapWidth, &mapHeight, &channels, 0);
+            if (data != nullptr && width > 0 && (mapWidth != width || mapHeight != height)) {
+                std::cerr << "ORM map " << *maps[m] << " is " << mapWidth << "x" << mapHeight << ", not " << width << "x" << height << std::endl;
+                stbi_image_free(data);
+                data = nullptr;
+            }
+            if (data == nullptr) {
+                std::cerr << "Could not load material texture " << *maps[m] << std::endl;
+            }
+            else if (width == 0) {
+                width = mapWidth;
+                height = mapHeight;
+            }
+            decoded.push_back({ *maps[m], data, channels });
+            it = decoded.end() - 1;
+        }
+        if (it->data != nullptr) {
+            sources[m] = { it->data, (uint32_t)it->channels, ChannelPacking::getMapChannel((uint32_t)it->channels, m) };
+        }
+    }
+
+    MaterialTexture packed;
+    if (width > 0) {
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<uint8_t> rgba(size_t(width) * height * 4);
+        ChannelPacking::pack(sources, 4, size_t(width) * height, rgba.data());
+        packed.texture = createImageTexture(rgba.data(), (uint32_t)width, (uint32_t)height, 4, false, &packed.view);
+        std::cout << "Packed ORM texture of " << decoded.size() << " maps, " << width << "x" << height << " in "
+            << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0 << " ms" << std::endl;
+    }
+    for (const DecodedMap& map : decoded) stbi_image_free(map.data);
+    return packed;
+}
+
+Application::MaterialTexture Application::getSolidTexture(const uint8_t rgba[4]) {
+    TextureDescriptor textureDesc;
+    textureDesc.dimension = TextureDimension::_2D;
+    textureDesc.format = TextureFormat::RGBA8Unorm;
+    textureDesc.mipLevelCount = 1;
+    textureDesc.sampleCount = 1;
+    textureDesc.size = { 1, 1, 1 };
+    textureDesc.usage = TextureUsage::TextureBinding | TextureUsage::CopyDst;
+    textureDesc.viewFormatCount = 0;
+    textureDesc.viewFormats = nullptr;
+
+    MaterialTexture solid;
+    solid.texture = device.createTexture(textureDesc);
+
+    ImageCopyTexture destination;
+    destination.texture = solid.texture;
+    destination.mipLevel = 0;
+    destination.origin = { 0, 0, 0 };
+    destination.aspect = TextureAspect::All;
+    TextureDataLayout source;
+    source.offset = 0;
+    source.bytesPerRow = 4;
+    source.rowsPerImage = 1;
+    queue.writeTexture(destination, rgba, 4, source, textureDesc.size);
+
+    solid.view = solid.texture.createView();
+    return solid;
+}
+
 void Application::InitializeDepthTexture()
 {
     int width, height;
@@ -693,7 +1555,7 @@ void Application::InitializeDepthTexture()
     samplerDesc.minFilter = FilterMode::Linear;
     samplerDesc.mipmapFilter = MipmapFilterMode::Linear;
     samplerDesc.lodMinClamp = 0.0f;
-    samplerDesc.lodMaxClamp = 1.0f;
+    samplerDesc.lodMaxClamp = 32.0f; // every level of the cooked mip chains
     samplerDesc.compare = CompareFunction::Undefined;
     samplerDesc.maxAnisotropy = 1;
     sampler = device.createSampler(samplerDesc);
@@ -701,70 +1563,149 @@ void Application::InitializeDepthTexture()
 
 
 Texture Application::InitializeCubeMapTexture(const std::filesystem::path& basePath, TextureView* CMtextureView) {
-    // address to 6 images (TODO: hard-coded) + STBI Loading
-    const char* cubemapPaths[] = {
-        "posx.png",
-        "negx.png",
-        "posy.png",
-        "negy.png",
-        "posz.png",
-        "negz.png",
-    };
-    Extent3D cubemapSize = { 0, 0, 6 };
-    std::array<uint8_t*, 6> cubemapData;
-
-    for (uint32_t layer = 0; layer < 6; ++layer) {
-
-        auto fullPath = basePath / cubemapPaths[layer];
-        int width, height, channels;
-		cubemapData[layer] = stbi_load(fullPath.string().c_str(), &width, &height, &channels, 4); // 4 rgba
+    environmentProjection = ShProjection();
+    environmentProjected = false;
+    if (TextureCooker::isEnvironment(basePath)) return getEnvironmentTexture(basePath, CMtextureView);
+
+    // cooked by AssetCooker: all 6 faces with their mips in one file
+    if (TextureCooker::isCookedUpToDate(basePath)) {
+        Texture cooked = getCookedTexture(TextureCooker::getCookedPath(basePath), CMtextureView, true);
+        if (cooked) return cooked;
+    }
 
-        if (layer == 0) {
-            cubemapSize.width = (uint32_t)width;
-            cubemapSize.height = (uint32_t)height;
+    // faces decoded concurrently; each one is uploaded here as soon as it is ready and freed right after
+    struct DecodedFace {
+        uint32_t layer;
+        uint8_t* data;
+        int width;
+        int height;
+        double decodeSeconds;
+    };
+    const char* const* cubemapPaths = TextureCooker::CubeFaceNames;
+    const auto loadStart = std::chrono::steady_clock::now();
+    std::mutex faceMutex;
+    std::condition_variable faceDecoded;
+    std::vector<DecodedFace> decodedFaces; // waiting for upload
+    std::atomic<uint32_t> nextLayer{ 0 };
+    auto decodeFaces = [&]() {
+        for (uint32_t layer = nextLayer++; layer < 6; layer = nextLayer++) {
+            const auto decodeStart = std::chrono::steady_clock::now();
+            DecodedFace face = { layer, nullptr, 0, 0, 0.0 };
+            int channels;
+            // color: grayscale faces are expanded too, there is no 3 channel format
+            face.data = stbi_load((basePath / cubemapPaths[layer]).string().c_str(), &face.width, &face.height, &channels, 4); // 4 rgba
+            face.decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - decodeStart).count();
+            std::lock_guard<std::mutex> lock(faceMutex);
+            decodedFaces.push_back(face);
+            faceDecoded.notify_one();
         }
-		if (cubemapData[layer] == nullptr) {
-            for (uint32_t i = 0; i < layer; ++i) {
-                stbi_image_free(cubemapData[i]);
-            }
-			std::cerr << "Could not load  cube texture " << cubemapPaths[layer] << std::endl;
-			return nullptr;
-		}
+    };
+    // no threads on one core (or Emscripten): decoded in order, then uploaded
+    const unsigned workerCount = std::min(6u, Parallel::getThreadCount());
+    std::vector<std::thread> workers;
+    if (workerCount > 1) {
+        for (unsigned w = 0; w < workerCount; ++w) workers.emplace_back(decodeFaces);
+    }
+    else {
+        decodeFaces();
     }
 
-	// create texture descriptor
-	unsigned int size = cubemapSize.width; // assume square
+    Texture cubeTexture = nullptr;
     TextureDescriptor textureDesc;
-	textureDesc.dimension = TextureDimension::_2D; // case A: 2d texture * 6 layers STORAGE
-    textureDesc.format = WGPUTextureFormat_RGBA8Unorm;
-    textureDesc.mipLevelCount = 1;
-    textureDesc.sampleCount = 1;
-    textureDesc.size = { size, size, 6 };
-    textureDesc.usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst; // shader binding & copy from CPU
-    textureDesc.viewFormatCount = 0; // no alternate formats for texture view
-    textureDesc.viewFormats = nullptr;
-
-	Texture cubeTexture = device.createTexture(textureDesc);
-
-	ImageCopyTexture destination;
-	destination.texture = cubeTexture;
-	destination.mipLevel = 0;
-	destination.origin = { 0, 0, 0 };
-	destination.aspect = TextureAspect::All;
+    uint32_t size = 0; // faces are square
+    uint32_t levelCount = 1;
+    const bool mipsOnGpu = gpuMipGenerator.isInitialized();
+    // sampled as sRGB, through a view of the RGBA8Unorm texture the mipmap compute shader writes
+    const TextureFormat viewFormat = TextureFormat::RGBA8UnormSrgb;
+    bool failed = false;
+    for (uint32_t received = 0; received < 6; ++received) {
+        DecodedFace face;
+        {
+            std::unique_lock<std::mutex> lock(faceMutex);
+            faceDecoded.wait(lock, [&]() { return !decodedFaces.empty(); });
+            face = decodedFaces.front();
+            decodedFaces.erase(decodedFaces.begin());
+        }
+        // after a failure the remaining faces are only freed
+        if (face.data == nullptr) {
+            std::cerr << "Could not load  cube texture " << cubemapPaths[face.layer] << std::endl;
+            failed = true;
+        }
+        else if (!cubeTexture && !failed) {
+            size = (uint32_t)face.width;
+            levelCount = MipGenerator::getLevelCount(size, size);
+            textureDesc.dimension = TextureDimension::_2D; // case A: 2d texture * 6 layers STORAGE
+            textureDesc.format = mipsOnGpu ? TextureFormat::RGBA8Unorm : viewFormat;
+            textureDesc.mipLevelCount = levelCount;
+            textureDesc.sampleCount = 1;
+            textureDesc.size = { size, size, 6 };
+            textureDesc.usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst; // shader binding & copy from CPU
+            if (mipsOnGpu) textureDesc.usage |= WGPUTextureUsage_StorageBinding; // written by the mipmap compute shader
+            textureDesc.viewFormatCount = mipsOnGpu ? 1 : 0;
+            textureDesc.viewFormats = (WGPUTextureFormat*)&viewFormat;
+            cubeTexture = device.createTexture(textureDesc);
+        }
+        if (face.data != nullptr && ((uint32_t)face.width != size || (uint32_t)face.height != size)) {
+            std::cerr << "Cube faces must be square and of one size: " << cubemapPaths[face.layer] << std::endl;
+            failed = true;
+        }
+        if (failed) {
+            stbi_image_free(face.data);
+            continue;
+        }
 
-	TextureDataLayout source;
-	source.offset = 0;
-	source.bytesPerRow = 4 * size; // 4 bytes per pixel
-	source.rowsPerImage = size;
-        
+        // send to GPU: the base level, and the mips too if they are filtered on the CPU
+        const auto uploadStart = std::chrono::steady_clock::now();
+        ImageCopyTexture destination;
+        destination.texture = cubeTexture;
+        destination.mipLevel = 0;
+        destination.origin = { 0, 0, face.layer };
+        destination.aspect = TextureAspect::All;
+        TextureDataLayout source;
+        source.offset = 0;
+        source.bytesPerRow = 4 * size; // 4 bytes per pixel
+        source.rowsPerImage = size;
+        if (mipsOnGpu) {
+            queue.writeTexture(destination, face.data, (size_t)(4 * size * size), source, { size, size, 1 });
+        }
+        else {
+            MipOptions mipOptions;
+            mipOptions.filter = mipFilter;
+            mipOptions.srgb = true;
+            std::vector<std::vector<uint8_t>> levels;
+            MipGenerator::generate(face.data, size, size, levels, mipOptions);
+            for (uint32_t level = 0; level < levelCount; ++level) {
+                const uint32_t levelSize = MipGenerator::getLevelSize(size, level);
+                destination.mipLevel = level;
+                source.bytesPerRow = 4 * levelSize;
+                source.rowsPerImage = levelSize;
+                queue.writeTexture(destination, levels[level].data(), levels[level].size(), source, { levelSize, levelSize, 1 });
+            }
+        }
+        const double uploadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - uploadStart).count();
+
+        // diffuse lighting, while the later faces still decode
+        const auto projectStart = std::chrono::steady_clock::now();
+        if (!gpuIrradiance) SphericalHarmonics::projectFace(face.layer, face.data, size, environmentProjection);
+        stbi_image_free(face.data);
+        const double projectSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - projectStart).count();
+        std::cout << "Cube face " << cubemapPaths[face.layer] << ": decode " << face.decodeSeconds * 1000.0
+            << " ms, upload " << uploadSeconds * 1000.0 << " ms, SH projection " << projectSeconds * 1000.0 << " ms" << std::endl;
+    }
+    for (std::thread& worker : workers) worker.join();
 
-    // send to GPU
-    Extent3D singleLayerSize = { size, size, 1 };
-    for (uint32_t layer = 0; layer < 6; ++layer) {  
-        destination.origin = { 0, 0, layer };
-        queue.writeTexture(destination, cubemapData[layer], (size_t)(4 * size * size), source, singleLayerSize); // TODO singleLayerSize
-		stbi_image_free(cubemapData[layer]);
+    if (failed) {
+        if (cubeTexture) {
+            cubeTexture.destroy();
+            cubeTexture.release();
+        }
+        return nullptr;
     }
+    if (mipsOnGpu) gpuMipGenerator.generate(queue, cubeTexture, true);
+    environmentProjected = !gpuIrradiance;
+    std::cout << "Cubemap " << basePath << " loaded in "
+        << std::chrono::duration<double>(std::chrono::steady_clock::now() - loadStart).count() * 1000.0 << " ms on "
+        << workerCount << " decode thread(s)" << std::endl;
 
     // create texture view
     if (CMtextureView) { // check if pointer was provided
@@ -774,9 +1715,9 @@ Texture Application::InitializeCubeMapTexture(const std::filesystem::path& baseP
         textureViewDesc.baseArrayLayer = 0;
         textureViewDesc.arrayLayerCount = 6;
         textureViewDesc.baseMipLevel = 0;
-        textureViewDesc.mipLevelCount = 1;
+        textureViewDesc.mipLevelCount = levelCount;
         textureViewDesc.dimension = TextureViewDimension::Cube; // case B: CUBE is how the shader should INTERPRET texture
-        textureViewDesc.format = textureDesc.format;
+        textureViewDesc.format = viewFormat;
 
         *CMtextureView = cubeTexture.createView(textureViewDesc);
     }
@@ -784,40 +1725,99 @@ Texture Application::InitializeCubeMapTexture(const std::filesystem::path& baseP
     return cubeTexture;
 }
 
-Texture Application::getObjTexture(const std::filesystem::path& path, Device device, TextureView* textureView)
+Texture Application::getObjTexture(const std::filesystem::path& path, Device device, TextureView* textureView, bool srgb)
 {
+    // cooked by AssetCooker: mip chain included, no decoding
+    if (TextureCooker::isCookedUpToDate(path)) {
+        Texture cooked = getCookedTexture(TextureCooker::getCookedPath(path), textureView, srgb);
+        if (cooked) return cooked;
+    }
 
+    // grayscale data (roughness, metallic, occlusion, height maps) keeps its 1 or 2 channels. Color and
+    // 3 channel images become RGBA8: there is no 3 channel format
     int width, height, channels;
-    unsigned char* data = stbi_load(path.string().c_str(), &width, &height, &channels, 4); // 4 rgba
+    if (!stbi_info(path.string().c_str(), &width, &height, &channels)) return nullptr;
+    const uint32_t channelCount = srgb || channels > 2 ? 4 : (uint32_t)channels;
+    unsigned char* data = stbi_load(path.string().c_str(), &width, &height, &channels, (int)channelCount);
 
     if (nullptr == data) return nullptr;
 
+    Texture colorTexture = createImageTexture(data, (uint32_t)width, (uint32_t)height, channelCount, srgb, textureView);
+    stbi_image_free(data);
+    return colorTexture;
+}
+
+Texture Application::createImageTexture(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channelCount, bool srgb, TextureView* textureView)
+{
+    // mip chain (the cooked files have theirs already): filtered on the GPU once the base level is
+    // uploaded, or here with the rows in parallel. The compute shader only writes RGBA8Unorm: 1 and 2
+    // channel images are filtered here, as RGBA8
+    const uint32_t levelCount = MipGenerator::getLevelCount(width, height);
+    const bool mipsOnGpu = gpuMipGenerator.isInitialized() && channelCount == 4;
+    const size_t pixelCount = size_t(width) * height;
+    std::vector<std::vector<uint8_t>> levels;
+    if (mipsOnGpu) {
+        levels.emplace_back(pixels, pixels + pixelCount * 4);
+    }
+    else {
+        MipOptions mipOptions;
+        mipOptions.filter = mipFilter;
+        mipOptions.srgb = srgb;
+        if (channelCount == 4) {
+            MipGenerator::generate(pixels, width, height, levels, mipOptions);
+        }
+        else {
+            const ChannelSource expand[4] = { { pixels, channelCount, 0 }, { channelCount > 1 ? pixels : nullptr, channelCount, 1 }, {}, {} };
+            std::vector<uint8_t> rgba(pixelCount * 4);
+            ChannelPacking::pack(expand, 4, pixelCount, rgba.data());
+            MipGenerator::generate(rgba.data(), width, height, levels, mipOptions);
+            std::vector<uint8_t> compact;
+            for (std::vector<uint8_t>& level : levels) {
+                const ChannelSource extract[2] = { { level.data(), 4, 0 }, { level.data(), 4, 1 } };
+                compact.resize(level.size() / 4 * channelCount);
+                ChannelPacking::pack(extract, channelCount, level.size() / 4, compact.data());
+                level.swap(compact);
+            }
+        }
+    }
+
+    // color is sampled as sRGB. The mipmap compute shader can't write sRGB formats: its textures are
+    // RGBA8Unorm, viewed as RGBA8UnormSrgb
+    const TextureFormat format = channelCount == 1 ? TextureFormat::R8Unorm : channelCount == 2 ? TextureFormat::RG8Unorm
+        : srgb && !mipsOnGpu ? TextureFormat::RGBA8UnormSrgb : TextureFormat::RGBA8Unorm;
+    const TextureFormat viewFormat = srgb ? TextureFormat::RGBA8UnormSrgb : format;
 
     // create texture descriptor
     TextureDescriptor textureDesc;
     textureDesc.dimension = TextureDimension::_2D;
-    textureDesc.format = WGPUTextureFormat_RGBA8Unorm; // unsigned, normalized 0-1
-    textureDesc.mipLevelCount = 1;
+    textureDesc.format = format;
+    textureDesc.mipLevelCount = levelCount;
     textureDesc.sampleCount = 1;
-    textureDesc.size = { (unsigned int)width, (unsigned int)height, 1 };
+    textureDesc.size = { width, height, 1 };
     textureDesc.usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst; // shader binding & copy from CPU
-    textureDesc.viewFormatCount = 0; // no alternate formats for texture view
-    textureDesc.viewFormats = nullptr;
+    if (mipsOnGpu) textureDesc.usage |= WGPUTextureUsage_StorageBinding; // written by the mipmap compute shader
+    textureDesc.viewFormatCount = viewFormat != format ? 1 : 0;
+    textureDesc.viewFormats = (WGPUTextureFormat*)&viewFormat;
 
     Texture colorTexture = device.createTexture(textureDesc);
 
     ImageCopyTexture destination;
     destination.texture = colorTexture;
-    destination.mipLevel = 0;
     destination.origin = { 0, 0, 0 };
     destination.aspect = TextureAspect::All;
-    TextureDataLayout source;
-    source.offset = 0;
-    source.bytesPerRow = 4 * textureDesc.size.width;
-    source.rowsPerImage = textureDesc.size.height;
 
-    queue.writeTexture(destination, data, width * height * 4, source, textureDesc.size);
-    // TODO mipmapping
+    // one write per level present
+    for (uint32_t level = 0; level < levels.size(); ++level) {
+        const uint32_t levelWidth = MipGenerator::getLevelSize(textureDesc.size.width, level);
+        const uint32_t levelHeight = MipGenerator::getLevelSize(textureDesc.size.height, level);
+        destination.mipLevel = level;
+        TextureDataLayout source;
+        source.offset = 0;
+        source.bytesPerRow = channelCount * levelWidth;
+        source.rowsPerImage = levelHeight;
+        queue.writeTexture(destination, levels[level].data(), levels[level].size(), source, { levelWidth, levelHeight, 1 });
+    }
+    if (mipsOnGpu) gpuMipGenerator.generate(queue, colorTexture, srgb);
 
 
     // LOADING MY OWN TEXTURE INSTEAD -------------------------------------------------------
@@ -841,9 +1841,6 @@ Texture Application::getObjTexture(const std::filesystem::path& path, Device dev
     // queue.writeTexture(destination, pixels.data(), pixels.size(), source, textureDesc.size);
     // ----------------------------------------------------------------------------------------------
 
-    // release
-    stbi_image_free(data);
-
     if (textureView) {
         // texture view
         TextureViewDescriptor textureViewDesc;
@@ -851,9 +1848,9 @@ Texture Application::getObjTexture(const std::filesystem::path& path, Device dev
         textureViewDesc.baseArrayLayer = 0;
         textureViewDesc.arrayLayerCount = 1;
         textureViewDesc.baseMipLevel = 0;
-        textureViewDesc.mipLevelCount = 1;
+        textureViewDesc.mipLevelCount = levelCount;
         textureViewDesc.dimension = TextureViewDimension::_2D;
-        textureViewDesc.format = textureDesc.format;
+        textureViewDesc.format = viewFormat;
 
         *textureView = colorTexture.createView(textureViewDesc);
     }
@@ -861,6 +1858,399 @@ Texture Application::getObjTexture(const std::filesystem::path& path, Device dev
     return colorTexture;
 }
 
+void Application::InitializeSpecularEnvironment()
+{
+    // cache files are named after the environment contents, a changed environment gets a new one
+    uint64_t sourceHash = 0;
+    const bool hashed = TextureCooker::hashSource(environmentPath, sourceHash);
+    const uint32_t convertedSize = TextureCooker::isEnvironment(environmentPath) ? environmentSize : 0;
+    const std::filesystem::path cachePath = SpecularPrefilter::getCachePath(environmentPath, sourceHash, convertedSize);
+    Ktx2Texture prefiltered;
+    if (hashed && Ktx2::read(cachePath, prefiltered) && prefiltered.vkFormat == Ktx2::FormatRGBA16Float && prefiltered.faceCount == 6
+        && prefiltered.width == SpecularPrefilter::FaceSize && prefiltered.levels.size() == SpecularPrefilter::LevelCount) {
+        specularTexture = createKtx2Texture(prefiltered, cachePath, &specularTextureView);
+        if (specularTexture) {
+            std::cout << "Loaded prefiltered environment " << cachePath << std::endl;
+            return;
+        }
+    }
+
+    // once per environment: no need to keep the pipeline around
+    SpecularPrefilter prefilter;
+    if (!prefilter.initialize(device)) {
+        std::cerr << "Specular prefilter unavailable, reflections sample the cubemap mips" << std::endl;
+        return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    specularTexture = prefilter.generate(queue, cubemapTextureView);
+    prefilter.release();
+
+    TextureViewDescriptor textureViewDesc;
+    textureViewDesc.aspect = TextureAspect::All;
+    textureViewDesc.baseArrayLayer = 0;
+    textureViewDesc.arrayLayerCount = 6;
+    textureViewDesc.baseMipLevel = 0;
+    textureViewDesc.mipLevelCount = SpecularPrefilter::LevelCount;
+    textureViewDesc.dimension = TextureViewDimension::Cube;
+    textureViewDesc.format = TextureFormat::RGBA16Float;
+    specularTextureView = specularTexture.createView(textureViewDesc);
+
+    // read back for the cache file (waits for the GPU)
+    prefiltered = Ktx2Texture();
+    prefiltered.vkFormat = Ktx2::FormatRGBA16Float;
+    prefiltered.width = SpecularPrefilter::FaceSize;
+    prefiltered.height = SpecularPrefilter::FaceSize;
+    prefiltered.faceCount = 6;
+    if (!hashed || !GpuReadback::readTexture(device, queue, specularTexture, Ktx2::getBlockBytes(prefiltered.vkFormat), prefiltered.levels)) return;
+    std::cout << "Prefiltered environment in "
+        << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0 << " ms" << std::endl;
+    if (!Ktx2::write(cachePath, prefiltered)) std::cerr << "Could not write " << cachePath << std::endl;
+}
+
+void Application::InitializeIrradiance()
+{
+    if (!environmentProjected) {
+        const auto start = std::chrono::steady_clock::now();
+        GpuShProjector projector;
+        // 8-bit cubemaps hold sRGB color: the RGBA8Unorm ones (GPU mips) are read through their sRGB view
+        const TextureFormat viewFormat = cubemap.getFormat() == TextureFormat::RGBA8Unorm ? TextureFormat::RGBA8UnormSrgb : cubemap.getFormat();
+        environmentProjected = projector.initialize(device) && projector.project(queue, cubemap, viewFormat, environmentProjection);
+        projector.release();
+        if (!environmentProjected) {
+            std::cerr << "Could not project " << environmentPath << " to spherical harmonics, the ambient stays constant" << std::endl;
+            return;
+        }
+        std::cout << "Projected environment to spherical harmonics on the GPU in "
+            << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0 << " ms" << std::endl;
+    }
+
+    glm::vec3 coefficients[SphericalHarmonics::CoefficientCount];
+    SphericalHarmonics::getCoefficients(environmentProjection, coefficients);
+    SphericalHarmonics::convolveIrradiance(coefficients);
+    glm::vec4 shIrradiance[SphericalHarmonics::CoefficientCount];
+    for (uint32_t k = 0; k < SphericalHarmonics::CoefficientCount; ++k) shIrradiance[k] = glm::vec4(coefficients[k], 0.0f);
+    queue.writeBuffer(uniformBuffer, offsetof(Uniforms, shIrradiance), shIrradiance, sizeof(shIrradiance));
+}
+
+void Application::InitializeBrdfLut()
+{
+    const std::filesystem::path cachePath = BrdfLut::getCachePath("../files");
+    Ktx2Texture table;
+    if (Ktx2::read(cachePath, table) && table.vkFormat == Ktx2::FormatRG16Float && table.faceCount == 1
+        && table.width == BrdfLut::Size && table.height == BrdfLut::Size && table.levels.size() == 1) {
+        brdfLutTexture = createKtx2Texture(table, cachePath, &brdfLutTextureView);
+        if (brdfLutTexture) {
+            std::cout << "Loaded BRDF LUT " << cachePath << std::endl;
+            return;
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    table = Ktx2Texture();
+    table.vkFormat = Ktx2::FormatRG16Float;
+    table.width = BrdfLut::Size;
+    table.height = BrdfLut::Size;
+    // once: no need to keep the pipeline around
+    BrdfLut generator;
+    if (generator.initialize(device)) {
+        brdfLutTexture = generator.generate(queue);
+        generator.release();
+
+        TextureViewDescriptor textureViewDesc;
+        textureViewDesc.aspect = TextureAspect::All;
+        textureViewDesc.baseArrayLayer = 0;
+        textureViewDesc.arrayLayerCount = 1;
+        textureViewDesc.baseMipLevel = 0;
+        textureViewDesc.mipLevelCount = 1;
+        textureViewDesc.dimension = TextureViewDimension::_2D;
+        textureViewDesc.format = TextureFormat::RG16Float;
+        brdfLutTextureView = brdfLutTexture.createView(textureViewDesc);
+
+        // read back for the cache file (waits for the GPU)
+        if (!GpuReadback::readTexture(device, queue, brdfLutTexture, Ktx2::getBlockBytes(table.vkFormat), table.levels)) return;
+        std::cout << "Integrated BRDF LUT on the GPU in "
+            << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0 << " ms" << std::endl;
+    }
+    else {
+        std::cerr << "BRDF LUT shader unavailable, integrating it on the CPU" << std::endl;
+        std::vector<float> rg;
+        EnvironmentMap::integrateBrdf(BrdfLut::Size, BrdfLut::SampleCount, rg);
+        table.levels.assign(1, std::vector<uint8_t>(rg.size() * sizeof(uint16_t)));
+        for (size_t i = 0; i < rg.size(); ++i) {
+            const uint16_t half = glm::packHalf1x16(rg[i]);
+            std::memcpy(table.levels[0].data() + i * sizeof(uint16_t), &half, sizeof(half));
+        }
+        brdfLutTexture = createKtx2Texture(table, cachePath, &brdfLutTextureView);
+        if (!brdfLutTexture) return;
+        std::cout << "Integrated BRDF LUT on the CPU in "
+            << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0 << " ms" << std::endl;
+    }
+    if (!Ktx2::write(cachePath, table)) std::cerr << "Could not write " << cachePath << std::endl;
+}
+
+Texture Application::getEnvironmentTexture(const std::filesystem::path& hdrPath, TextureView* textureView)
+{
+    const std::filesystem::path cookedPath = TextureCooker::getCookedPath(hdrPath);
+    Ktx2Texture converted;
+    std::vector<float> radiance; // float faces of level 0 when converted now
+    if (TextureCooker::isCookedUpToDate(hdrPath) && Ktx2::read(cookedPath, converted)
+        && converted.vkFormat == Ktx2::FormatRGBA16Float && converted.faceCount == 6 && converted.width == environmentSize) {
+        std::cout << "Loaded environment " << cookedPath << std::endl;
+    }
+    else {
+        // converted once, later launches read the file
+        const auto start = std::chrono::steady_clock::now();
+        converted = Ktx2Texture();
+        if (!TextureCooker::convertEnvironment(hdrPath, environmentSize, converted, gpuIrradiance ? nullptr : &radiance)) return nullptr;
+        std::cout << "Converted environment " << hdrPath << " to " << environmentSize << "x" << environmentSize << " faces in "
+            << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0 << " ms" << std::endl;
+        if (!Ktx2::write(cookedPath, converted)) std::cerr << "Could not write " << cookedPath << std::endl;
+    }
+
+    // diffuse lighting from the faces of level 0: float if just converted, float16 from a cooked file
+    if (!gpuIrradiance) {
+        const auto start = std::chrono::steady_clock::now();
+        const uint64_t faceBytes = Ktx2::getLevelBytes(converted.vkFormat, converted.width, converted.height, 0);
+        const size_t faceValues = size_t(converted.width) * converted.height * 4;
+        for (uint32_t face = 0; face < 6; ++face) {
+            if (!radiance.empty()) {
+                SphericalHarmonics::projectFace(face, radiance.data() + face * faceValues, converted.width, environmentProjection);
+                continue;
+            }
+            const uint16_t* texels = reinterpret_cast<const uint16_t*>(converted.levels[0].data() + face * faceBytes);
+            SphericalHarmonics::projectFace(face, texels, converted.width, environmentProjection);
+        }
+        environmentProjected = true;
+        std::cout << "Projected environment to spherical harmonics in "
+            << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0 << " ms" << std::endl;
+    }
+    return createKtx2Texture(converted, cookedPath, textureView);
+}
+
+Texture Application::getCookedTexture(const std::filesystem::path& cookedPath, TextureView* textureView, bool srgb)
+{
+    Ktx2Texture cooked;
+    if (!Ktx2::read(cookedPath, cooked)) return nullptr;
+    return createKtx2Texture(cooked, cookedPath, textureView, srgb);
+}
+
+Texture Application::createKtx2Texture(const Ktx2Texture& cooked, const std::filesystem::path& cookedPath, TextureView* textureView, bool srgb)
+{
+    // sampled as sRGB when used as color: an srgb vkFormat only says the mips were filtered in linear light
+    TextureFormat format = TextureFormat::Undefined;
+    BcFormat bcFormat = BcFormat::BC7;
+    switch (cooked.vkFormat) {
+    case Ktx2::FormatRGBA8Unorm:
+    case Ktx2::FormatRGBA8Srgb: format = srgb ? TextureFormat::RGBA8UnormSrgb : TextureFormat::RGBA8Unorm; break;
+    case Ktx2::FormatRG16Float: format = TextureFormat::RG16Float; break;
+    case Ktx2::FormatRGBA16Float: format = TextureFormat::RGBA16Float; break;
+    case Ktx2::FormatBC1Unorm:
+    case Ktx2::FormatBC1Srgb: format = srgb ? TextureFormat::BC1RGBAUnormSrgb : TextureFormat::BC1RGBAUnorm; bcFormat = BcFormat::BC1; break;
+    case Ktx2::FormatBC3Unorm:
+    case Ktx2::FormatBC3Srgb: format = srgb ? TextureFormat::BC3RGBAUnormSrgb : TextureFormat::BC3RGBAUnorm; bcFormat = BcFormat::BC3; break;
+    case Ktx2::FormatBC5Unorm: format = TextureFormat::BC5RGUnorm; bcFormat = BcFormat::BC5; break;
+    case Ktx2::FormatBC7Unorm:
+    case Ktx2::FormatBC7Srgb: format = srgb ? TextureFormat::BC7RGBAUnormSrgb : TextureFormat::BC7RGBAUnorm; break;
+    default:
+        std::cerr << "Unsupported cooked texture format " << cooked.vkFormat << " in " << cookedPath << std::endl;
+        return nullptr;
+    }
+    const uint32_t levelCount = static_cast<uint32_t>(cooked.levels.size());
+
+    // without texture-compression-bc: decoded level by level (every face at once), uploaded as RGBA8
+    const bool compressed = Ktx2::getBlockSize(cooked.vkFormat) > 1;
+    const bool decode = compressed && !textureCompressionBC;
+    if (decode) {
+        format = srgb ? TextureFormat::RGBA8UnormSrgb : TextureFormat::RGBA8Unorm;
+    }
+
+    TextureDescriptor textureDesc;
+    textureDesc.dimension = TextureDimension::_2D;
+    textureDesc.format = format;
+    textureDesc.mipLevelCount = levelCount;
+    textureDesc.sampleCount = 1;
+    textureDesc.size = { cooked.width, cooked.height, cooked.faceCount };
+    textureDesc.usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst;
+    textureDesc.viewFormatCount = 0;
+    textureDesc.viewFormats = nullptr;
+    Texture texture = device.createTexture(textureDesc);
+
+    // one write per level, every face at once
+    ImageCopyTexture destination;
+    destination.texture = texture;
+    destination.origin = { 0, 0, 0 };
+    destination.aspect = TextureAspect::All;
+    std::vector<uint8_t> decoded;
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        const uint32_t width = std::max(1u, cooked.width >> level);
+        const uint32_t height = std::max(1u, cooked.height >> level);
+        destination.mipLevel = level;
+        TextureDataLayout source;
+        source.offset = 0;
+        if (compressed && !decode) {
+            // whole 4x4 blocks: the copy covers the physical size of the small mips
+            const uint32_t blocksWide = (width + 3) / 4;
+            const uint32_t blocksHigh = (height + 3) / 4;
+            source.bytesPerRow = blocksWide * BlockCompression::getBlockBytes(bcFormat);
+            source.rowsPerImage = blocksHigh;
+            queue.writeTexture(destination, cooked.levels[level].data(), cooked.levels[level].size(), source, { 4 * blocksWide, 4 * blocksHigh, cooked.faceCount });
+            continue;
+        }
+
+        const uint8_t* data = cooked.levels[level].data();
+        size_t size = cooked.levels[level].size();
+        if (decode) {
+            const uint64_t faceBytes = Ktx2::getLevelBytes(cooked.vkFormat, cooked.width, cooked.height, level);
+            decoded.resize(size_t(width) * height * 4 * cooked.faceCount);
+            for (uint32_t face = 0; face < cooked.faceCount; ++face) {
+                if (!BlockCompression::decode(bcFormat, data + face * faceBytes, width, height, decoded.data() + size_t(face) * width * height * 4)) {
+                    std::cerr << "Could not decode " << cookedPath << ", level " << level << std::endl;
+                }
+            }
+            data = decoded.data();
+            size = decoded.size();
+        }
+        source.bytesPerRow = (decode ? 4 : Ktx2::getBlockBytes(cooked.vkFormat)) * width;
+        source.rowsPerImage = height;
+        queue.writeTexture(destination, data, size, source, { width, height, cooked.faceCount });
+    }
+
+    if (textureView) {
+        TextureViewDescriptor textureViewDesc;
+        textureViewDesc.aspect = TextureAspect::All;
+        textureViewDesc.baseArrayLayer = 0;
+        textureViewDesc.arrayLayerCount = cooked.faceCount;
+        textureViewDesc.baseMipLevel = 0;
+        textureViewDesc.mipLevelCount = levelCount;
+        textureViewDesc.dimension = cooked.faceCount == 6 ? TextureViewDimension::Cube : TextureViewDimension::_2D;
+        textureViewDesc.format = textureDesc.format;
+        *textureView = texture.createView(textureViewDesc);
+    }
+    return texture;
+}
+
+void Application::UpdateLodSelection() {
+    glm::mat4x4 viewMatrix;
+    viewCamera.getViewMatrix(viewMatrix);
+    glm::mat4x4 projMatrix;
+    viewCamera.getProjMatrix(projMatrix);
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+
+    // every instance is drawn at the same level: the one the closest instance needs
+    float pixelsPerUnit = 0.0f;
+    for (const glm::vec4& bounds : instanceLodBounds) {
+        // nearest point of the bounding sphere in view space (camera looks down -z)
+        const glm::vec3 center = glm::vec3(viewMatrix * glm::vec4(glm::vec3(bounds), 1.0f));
+        const float scale = bounds.w;
+        const float distance = std::max(-center.z - boundsRadius * scale, 1e-4f);
+        // projMatrix[1][1] = cot(fovy / 2): object space length at that distance -> pixels
+        pixelsPerUnit = std::max(pixelsPerUnit, scale * projMatrix[1][1] * 0.5f * static_cast<float>(height) / distance);
+    }
+
+    // coarsest level whose error stays below lodPixelError on screen
+    for (uint32_t s = 0; s < submeshes.size(); ++s) {
+        const Submesh& submesh = submeshes[s];
+        uint32_t level = 0;
+        while (level < submesh.lodCount && submeshLods[submesh.lodOffset + level].error * pixelsPerUnit <= lodPixelError) {
+            level++;
+        }
+        // not finer than what is uploaded
+        lodSelection[s] = std::max(level, ProgressiveMesh::getFinestLevel(submesh, residentPages));
+    }
+}
+
+void Application::UpdateMeshStreaming() {
+    if (!meshStreamer.isStarted() || meshLoadFailed) return;
+    if (meshStreamer.hasFailed()) {
+        // the streamer has logged why. Like a missing texture: the frame is still cleared and the app closes normally
+        std::cerr << "No mesh to draw" << std::endl;
+        meshLoadFailed = true;
+        return;
+    }
+    if (!meshStreamer.isReady()) return;
+    if (meshPages.empty()) InitializeStreamedMesh();
+
+    const MeshStreamer::Mesh& mesh = meshStreamer.getMesh();
+    uint64_t budget = StreamingBudget;
+    auto upload = [&](Buffer& buffer, const uint8_t* data, uint64_t& uploaded, uint64_t end) {
+        const uint64_t size = std::min(end - uploaded, budget);
+        if (size == 0) return;
+        queue.writeBuffer(buffer, uploaded, data + uploaded, size);
+        uploaded += size;
+        budget -= size;
+    };
+
+    // pages in order, only those the streamer has read in; a page is drawn once all of it is uploaded
+    const uint32_t loadedPages = meshStreamer.getLoadedPageCount();
+    while (budget > 0 && residentPages < meshPages.size() && residentPages < loadedPages) {
+        const MeshPage& page = meshPages[residentPages];
+        // ends padded to 4 bytes for writeBuffer, the source data are padded as well
+        const uint64_t positionEnd = (uint64_t(page.vertexCount) * mesh.positionLayout.stride + 3) & ~uint64_t(3);
+        const uint64_t vertexEnd = (uint64_t(page.vertexCount) * mesh.layout.stride + 3) & ~uint64_t(3);
+        const uint64_t tangentEnd = mesh.tangentData ? uint64_t(page.vertexCount) * vertexStreams[2].layout.stride : 0;
+        const uint64_t indexEnd = (uint64_t(page.indexCount) * mesh.indexSize + 3) & ~uint64_t(3);
+
+        // grown to the end of the page: pages about double in size, so are the buffers
+        GrowMeshBuffer(positionBuffer, positionEnd, uploadedPositionBytes, BufferUsage::Vertex, "Position Buffer");
+        GrowMeshBuffer(vertexBuffer, vertexEnd, uploadedVertexBytes, BufferUsage::Vertex, "Vertex Buffer");
+        vertexStreams[0].buffer = positionBuffer;
+        vertexStreams[0].size = positionBuffer.getSize();
+        vertexStreams[1].buffer = vertexBuffer;
+        vertexStreams[1].size = vertexBuffer.getSize();
+        if (mesh.tangentData) {
+            GrowMeshBuffer(tangentBuffer, tangentEnd, uploadedTangentBytes, BufferUsage::Vertex, "Tangent Buffer");
+            vertexStreams[2].buffer = tangentBuffer;
+            vertexStreams[2].size = tangentBuffer.getSize();
+        }
+        if (GrowMeshBuffer(indexBuffer, indexEnd, uploadedIndexBytes,
+                           BufferUsage::Index | BufferUsage::Storage, "Index Buffer")) { // read by cull.wgsl
+            InitializeCullBindGroup();
+        }
+
+        upload(positionBuffer, mesh.positionData, uploadedPositionBytes, positionEnd);
+        upload(vertexBuffer, mesh.vertexData, uploadedVertexBytes, vertexEnd);
+        upload(tangentBuffer, mesh.tangentData, uploadedTangentBytes, tangentEnd);
+        upload(indexBuffer, mesh.indexData, uploadedIndexBytes, indexEnd);
+        if (uploadedPositionBytes < positionEnd || uploadedVertexBytes < vertexEnd || uploadedTangentBytes < tangentEnd ||
+            uploadedIndexBytes < indexEnd) break;
+
+        residentPages++;
+        if (residentPages == 1 || residentPages == meshPages.size()) {
+            std::cout << "Mesh page " << residentPages << " / " << meshPages.size() << " uploaded after "
+                      << static_cast<int>(glfwGetTime() * 1000.0) << " ms" << std::endl;
+        }
+    }
+}
+
+bool Application::GrowMeshBuffer(Buffer& buffer, uint64_t size, uint64_t usedBytes, BufferUsageFlags usage, const char* label) {
+    if (buffer && buffer.getSize() >= size) return false;
+
+    BufferDescriptor bufferDesc;
+    bufferDesc.label = label;
+    bufferDesc.usage = usage | BufferUsage::CopyDst | BufferUsage::CopySrc;
+    bufferDesc.size = size;
+    bufferDesc.mappedAtCreation = false;
+    Buffer grown = device.createBuffer(bufferDesc);
+
+    // the uploaded part is copied on the GPU, not uploaded again
+    if (buffer && usedBytes > 0) {
+        CommandEncoderDescriptor encoderDesc = {};
+        encoderDesc.label = "buffer growth encoder";
+        CommandEncoder encoder = device.createCommandEncoder(encoderDesc);
+        encoder.copyBufferToBuffer(buffer, 0, grown, 0, usedBytes);
+        CommandBufferDescriptor cmdBufferDescriptor = {};
+        cmdBufferDescriptor.label = "Buffer growth";
+        CommandBuffer command = encoder.finish(cmdBufferDescriptor);
+        encoder.release();
+        queue.submit(1, &command);
+        command.release();
+    }
+    if (buffer) buffer.release();
+    buffer = grown;
+    return true;
+}
+
 void Application::reSizeScreen()
 {
     // terminate depth texture & surface
@@ -889,6 +2279,9 @@ void Application::updateViewMatrix() {
         &viewMatrix,
         sizeof(Uniforms::viewMatrix)
     );
+    // culling and LOD selection need the matching camera position
+    glm::vec3 cameraPos = viewCamera.getPosition();
+    queue.writeBuffer(uniformBuffer, offsetof(Uniforms, cameraPos), &cameraPos, sizeof(Uniforms::cameraPos));
 }
 
 
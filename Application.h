@@ -1,11 +1,22 @@
 ﻿#pragma once
 #include "webgpu/webgpu.hpp" 
 #include "VertexAttr.h"
+#include "VertexQuantization.h"
+#include "MeshData.h"
+#include "GltfLoader.h"
+#include "GpuUpload.h"
+#include "MeshStreamer.h"
+#include "MipGenerator.h"
+#include "GpuMipGenerator.h"
+#include "TextureCooker.h"
+#include "SphericalHarmonics.h"
 #include "Camera.h"
 
 #include <GLFW/glfw3.h>
 #include <glm/ext.hpp>
 #include <vector>
+#include <map>
+#include <string>
 #include <filesystem>
 
 using namespace wgpu;
@@ -16,6 +27,13 @@ public:
     void Terminate();
     void MainLoop();
     bool IsRunning();
+    // before Initialize: draws instanceCount copies of the mesh in a grid, with a roughness x metallic
+    // grid of materials, and reports the frame time
+    void SetInstanceBenchmark(uint32_t instanceCount) { benchmarkInstanceCount = instanceCount; }
+    // before Initialize: cubemap folder (posx.png ..) or HDR panorama (.hdr, converted to faceSize faces once)
+    void SetEnvironment(const std::filesystem::path& path, uint32_t faceSize) { environmentPath = path; environmentSize = faceSize; }
+    // before Initialize: diffuse environment lighting projected by a compute pass instead of while the faces load
+    void SetGpuIrradiance(bool enabled) { gpuIrradiance = enabled; }
 
 private:
     GLFWwindow* window;
@@ -25,6 +43,10 @@ private:
     Surface surface;
     std::unique_ptr<ErrorCallback> uncapturedErrorCallbackHandle; // TODO
     RenderPipeline pipeline;
+    // depth prepass: positions only, the shading pass then runs once per pixel (depthCompare Equal)
+    bool depthPrepass = true;
+    RenderPipeline depthPipeline;
+    PipelineLayout depthLayout; // group 0 only
     TextureFormat surfaceFormat = TextureFormat::Undefined;
 
     // uniform bindings
@@ -33,8 +55,10 @@ private:
     PipelineLayout layout;
 
     // buffers
+    Buffer positionBuffer; // position stream of streamed meshes, glTF streams all live in vertexBuffer
     Buffer vertexBuffer;
-    // Buffer indexBuffer;
+    Buffer tangentBuffer;  // tangent stream, or the single zero tangent of meshes without (see InitializeTangentStream)
+    Buffer indexBuffer;
     Buffer uniformBuffer;
 
     struct Uniforms {
@@ -46,9 +70,112 @@ private:
         float padding[3]; // padding: time + pad = 16 bytes for alignment!
         glm::vec3 cameraPos;
 		float padding1; // cameraPos + pad1 = 16 bytes for alignment!
+        glm::vec3 positionOffset; // dequantization of stored vertex positions
+        float padding2;
+        glm::vec3 positionScale;
+        float padding3;
+        glm::vec4 shIrradiance[9]; // rgb: SphericalHarmonics::convolveIrradiance coefficients of the environment
     };
 
+    // GPU cluster culling (files/cull.wgsl): visible meshlets are compacted into culledIndexBuffer
+    ComputePipeline cullPipeline;
+    BindGroupLayout cullBindGroupLayout;
+    BindGroup cullBindGroup;
+    Buffer meshletBuffer;
+    Buffer culledIndexBuffer;
+    Buffer drawArgsBuffer; // one DrawIndexedIndirect per submesh
+    std::vector<uint32_t> drawArgsReset; // written every frame before culling: indexCount = 0
+    uint32_t meshletCount = 0;
+
+    // LODs: one level per submesh picked every frame from the projected error
+    std::vector<Submesh> submeshes;
+    std::vector<SubmeshLod> submeshLods;
+    std::vector<uint32_t> lodSelection; // 0: full resolution
+    Buffer lodSelectionBuffer;          // lodSelection for cull.wgsl
+    float lodPixelError = 1.0f;         // allowed screen space error
+    glm::vec3 boundsCenter = glm::vec3(0.0f); // object space bounding sphere of the mesh
+    float boundsRadius = 0.0f;
+    glm::mat4x4 modelMatrix = glm::mat4x4(1.0f);
+
+    // materials (group 1): one bind group per material, draws are sorted by material
+    struct MaterialUniforms {
+        static constexpr uint32_t NoChannel = 4; // the map is missing: 1
+        glm::vec4 baseColor; // multiplies the diffuse texture
+        float roughness;     // multiplies the roughness map
+        float metallic;      // multiplies the metallic map
+        // channel of the ORM texture each map is read from: r, g, b of packed and RGBA maps, r of a
+        // grayscale map loaded as R8Unorm (ChannelPacking::getMapChannel)
+        uint32_t occlusionChannel;
+        uint32_t roughnessChannel;
+        uint32_t metallicChannel;
+        uint32_t padding[3];
+    };
+    struct MaterialTexture {
+        Texture texture;
+        TextureView view;
+    };
+    BindGroupLayout materialBindGroupLayout;
+    std::vector<MeshMaterial> materials;
+    std::vector<BindGroup> materialBindGroups; // [0]: default material (materialId -1), [i + 1]: materials[i]
+    Buffer materialBuffer;                     // MaterialUniforms of all bind groups, uniform offset aligned
+    std::map<std::string, MaterialTexture> materialTextures; // loaded once per path
+    MaterialTexture whiteTexture;              // missing diffuse / ORM maps
+    MaterialTexture flatNormalTexture;         // missing normal maps
+    // mip chains of uncooked textures, built at load time: on the GPU from the uploaded base level
+    // (box filter), or on the CPU with mipFilter if gpuMipmaps is off or the compute pipeline failed
+    bool gpuMipmaps = true;
+    GpuMipGenerator gpuMipGenerator;
+    MipFilter mipFilter = MipFilter::Kaiser;
+    // adapter supports texture-compression-bc: cooked BC textures are uploaded as they are, otherwise
+    // decoded to RGBA8 on the CPU (BlockCompression::decode)
+    bool textureCompressionBC = false;
+
+    // instances (group 0, bindings 4 and 5): read by the vertex shader through instance_index,
+    // so one draw per submesh covers all of them
+    struct InstanceData {
+        glm::mat4x4 modelMatrix;
+        glm::mat4x4 modelInvTranspose;
+        uint32_t materialIndex; // into instanceMaterialBuffer, NoInstanceMaterial: the submesh material
+        float padding[3];
+    };
+    static constexpr uint32_t NoInstanceMaterial = 0xFFFFFFFF;
+    uint32_t benchmarkInstanceCount = 0; // 0: the mesh once, with modelMatrix
+    std::vector<InstanceData> instances;
+    std::vector<glm::vec4> instanceLodBounds; // world space center (xyz) and scale (w) per instance
+    Buffer instanceBuffer;
+    Buffer instanceMaterialBuffer; // MaterialUniforms, tightly packed
+    uint32_t benchmarkFrames = 0;
+    double benchmarkStart = 0.0;
+
     uint32_t indexCount = 0;
+    IndexFormat indexFormat = IndexFormat::Uint32; // Uint16 when the mesh has <= 65535 vertices
+
+    // vertex encoding: compact by default, VertexFormatOptions::full() for plain floats
+    VertexFormatOptions vertexFormat;
+    // range of a vertex buffer bound to one vertex buffer slot
+    struct VertexStream {
+        VertexLayoutDesc layout;
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        Buffer buffer;
+    };
+    // layouts of the uploaded vertices, read by InitializePipeline. Slot 0 holds positions only
+    // (all the depth prepass binds), the other slots the remaining attributes
+    std::vector<VertexStream> vertexStreams;
+    glm::mat4x4 meshTransform = glm::mat4x4(1.0f); // node transform of a directly uploaded glTF
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+    glm::vec3 positionScale = glm::vec3(1.0f);
+
+    // progressive loading: drawn from the coarsest LODs while the finer pages are uploaded, StreamingBudget bytes per frame
+    static constexpr uint64_t StreamingBudget = 8ull << 20;
+    MeshStreamer meshStreamer;     // not started for glTFs uploaded directly
+    bool meshLoadFailed = false;   // reported once, the window stays up without a mesh
+    std::vector<MeshPage> meshPages;
+    uint32_t residentPages = 0;    // pages fully uploaded, see ProgressiveMesh::getFinestLevel
+    uint64_t uploadedPositionBytes = 0;
+    uint64_t uploadedVertexBytes = 0;
+    uint64_t uploadedTangentBytes = 0;
+    uint64_t uploadedIndexBytes = 0;
 
     //depth setup
     Texture depthTexture;
@@ -60,6 +187,22 @@ private:
 
     Texture cubemap;
 	TextureView cubemapTextureView;
+    std::filesystem::path environmentPath = "../files/venice_sunset";
+    uint32_t environmentSize = TextureCooker::DefaultEnvironmentSize; // face size of .hdr environments
+    // GGX prefiltered environment (SpecularPrefilter), bound instead of the cubemap: loaded from its cache
+    // file, or generated and written there once. Without it the cubemap mips stand in for the roughness levels
+    Texture specularTexture;
+    TextureView specularTextureView;
+    // diffuse environment lighting: the faces are projected to spherical harmonics on the CPU as they load
+    // (decoded PNGs, HDR halfs). Cooked cubemaps, whose texels are never decoded, and gpuIrradiance go
+    // through GpuShProjector instead
+    bool gpuIrradiance = false;
+    ShProjection environmentProjection;
+    bool environmentProjected = false; // environmentProjection covers all 6 faces
+    // split sum scale / bias of F0 by (NdotV, roughness) (BrdfLut): loaded from its cache file, or generated
+    // and written there once
+    Texture brdfLutTexture;
+    TextureView brdfLutTextureView;
 
     Camera viewCamera;
 
@@ -68,12 +211,49 @@ private:
     TextureView GetNextSurfaceTextureView();
     void InitializePipeline();
     RequiredLimits GetRequiredLimits(Adapter adapter) const;
+    PresentMode GetPresentMode();
     void InitializeSurface();
     void InitializeBuffers();
+    void InitializeMeshBuffers(uint64_t vertexBytes, uint32_t vertexStride, const GpuUpload::ChunkWriter& writeVertices,
+                               uint64_t indexBytes, const GpuUpload::ChunkWriter& writeIndices,
+                               IndexFormat format, uint32_t count);
+    void InitializeGltfBuffers(const GltfModel& model);
+    void InitializeMeshletBuffers(const Meshlet* meshlets, uint32_t count);
+    void InitializeCullPipeline();
+    void InitializeCullBindGroup(); // again whenever the index buffer grows
+    void InitializeStreamedMesh();
+    void InitializeTangentStream(bool perVertex);
+    void InitializeMeshResources(); // pipeline, materials and bind groups, once the vertex layout is known
+    void InitializeInstances(); // after the mesh bounds are known
     void InitializeBindGroups();
+    void InitializeMaterials();
+    TextureView getMaterialTexture(const std::string& path, TextureView fallback, bool srgb);
+    // occlusion, roughness and metallic maps of a material in one texture, its channels into uniforms:
+    // a single map is used as it is, separate maps are packed into one RGBA8 texture once
+    TextureView getOrmTexture(const MeshMaterial& material, MaterialUniforms& uniforms);
+    MaterialTexture packOrmTexture(const MeshMaterial& material);
+    MaterialTexture getSolidTexture(const uint8_t rgba[4]);
     void InitializeDepthTexture();
     Texture InitializeCubeMapTexture(const std::filesystem::path& basePath, TextureView* textureView = nullptr);
-    Texture getObjTexture(const std::filesystem::path& path, Device device, TextureView* textureView = nullptr);
+    void InitializeSpecularEnvironment(); // after the cubemap
+    void InitializeIrradiance();          // after the cubemap: shIrradiance
+    void InitializeBrdfLut();
+    // RGBA16Float cubemap of a .hdr panorama, from its converted file unless that is missing, stale or of another size
+    Texture getEnvironmentTexture(const std::filesystem::path& hdrPath, TextureView* textureView = nullptr);
+    // srgb: color data, sampled as sRGB and its mips filtered in linear space. Other 1 and 2 channel images
+    // are loaded as R8Unorm / RG8Unorm, everything else as RGBA8
+    Texture getObjTexture(const std::filesystem::path& path, Device device, TextureView* textureView = nullptr, bool srgb = false);
+    // channelCount 1, 2 or 4 (srgb: 4) interleaved 8-bit channels, mips built here or on the GPU
+    Texture createImageTexture(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channelCount, bool srgb, TextureView* textureView);
+    // KTX2 written by TextureCooker, all mips, RGBA8 / BC / RGBA16Float; nullptr if unreadable.
+    // srgb: the 8-bit and BC formats are created as their sRGB variants
+    Texture getCookedTexture(const std::filesystem::path& cookedPath, TextureView* textureView = nullptr, bool srgb = false);
+    Texture createKtx2Texture(const Ktx2Texture& cooked, const std::filesystem::path& cookedPath, TextureView* textureView = nullptr, bool srgb = false);
+
+    void UpdateLodSelection();
+    void UpdateMeshStreaming();
+    // grows buffer to at least size bytes, keeping its first usedBytes; true if it was replaced
+    bool GrowMeshBuffer(Buffer& buffer, uint64_t size, uint64_t usedBytes, BufferUsageFlags usage, const char* label);
 
     void reSizeScreen();
     // camera methods
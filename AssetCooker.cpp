@@ -0,0 +1,187 @@
+// Offline asset cooker, no window or GPU needed:
+//   AssetCooker [-j threads] [--force] [--full-vertices] [--max-memory 2G] [--format auto|rgba8|bc1|bc3|bc5|bc7]
+//               [--cube-size 512] [--color-space auto|srgb|linear] [--mip-filter kaiser|box] <asset or folder>...
+// meshes (.obj .gltf .glb)          -> <mesh>.meshcache  indexed, optimized, LODs, meshlets, quantized (MeshCooker)
+// OBJs too large for --max-memory   -> <mesh>.meshcache  out-of-core, quantized only (ObjConverter)
+// images (.png .jpg .bmp .tga ...)  -> <image>.ktx2      BC7 / BC5 (normal maps) + mip chain (TextureCooker)
+// cubemap folders (posx.png ..)     -> <folder>.ktx2     6 faces + mip chains
+// HDR panoramas (.hdr)              -> <image>.ktx2      RGBA16Float cubemap of --cube-size faces + mip chains
+// --max-memory is per job (-j runs several). Mips are filtered in linear light for sRGB images: auto treats
+// every image as sRGB but normal, roughness, metallic and occlusion maps (by name), cubemaps are sRGB
+// unless --color-space linear.
+// Other folders are searched recursively. The app loads the cooked files whenever they are present and
+// up to date, so a build machine can cook every asset ahead of time; up-to-date outputs are skipped.
+#define TINYOBJLOADER_IMPLEMENTATION
+#define STB_IMAGE_IMPLEMENTATION
+#include "tiny_obj_loader.h"
+#include "stb_image.h"
+#include "MeshCache.h"
+#include "MeshCooker.h"
+#include "ObjConverter.h"
+#include "TextureCooker.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct CookJob {
+    enum class Kind { Mesh, Texture, Cubemap, Environment };
+    Kind kind;
+    std::filesystem::path path;
+};
+
+static const char* getKindName(CookJob::Kind kind) {
+    switch (kind) {
+    case CookJob::Kind::Mesh: return "mesh";
+    case CookJob::Kind::Texture: return "texture";
+    case CookJob::Kind::Cubemap: return "cubemap";
+    case CookJob::Kind::Environment: return "environment";
+    }
+    return "";
+}
+
+static bool isExtension(const std::filesystem::path& path, std::initializer_list<const char*> extensions) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    for (const char* candidate : extensions) {
+        if (extension == candidate) return true;
+    }
+    return false;
+}
+
+// files are cooked by extension, folders are cubemaps or searched recursively
+static void collectJobs(const std::filesystem::path& path, std::vector<CookJob>& jobs) {
+    std::error_code ec;
+    if (std::filesystem::is_directory(path, ec)) {
+        if (TextureCooker::isCubemapFolder(path)) {
+            jobs.push_back({ CookJob::Kind::Cubemap, path });
+            return;
+        }
+        std::vector<std::filesystem::path> children;
+        for (const auto& entry : std::filesystem::directory_iterator(path, ec)) children.push_back(entry.path());
+        std::sort(children.begin(), children.end());
+        for (const std::filesystem::path& child : children) collectJobs(child, jobs);
+    }
+    else if (isExtension(path, { ".obj", ".gltf", ".glb" })) {
+        jobs.push_back({ CookJob::Kind::Mesh, path });
+    }
+    else if (isExtension(path, { ".png", ".jpg", ".jpeg", ".bmp", ".tga" })) {
+        jobs.push_back({ CookJob::Kind::Texture, path });
+    }
+    else if (TextureCooker::isEnvironment(path)) {
+        jobs.push_back({ CookJob::Kind::Environment, path });
+    }
+}
+
+int main(int argc, char** argv) {
+    unsigned threadCount = Parallel::getThreadCount();
+    bool force = false;
+    VertexFormatOptions vertexFormat; // what the app loads caches with
+    uint64_t maxMemory = ObjConverter::DefaultMaxMemory;
+    TextureCookOptions textureOptions;
+    uint32_t environmentSize = TextureCooker::DefaultEnvironmentSize; // what the app converts to
+    std::vector<CookJob> jobs;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) threadCount = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--force") force = true;
+        else if (arg == "--full-vertices") vertexFormat = VertexFormatOptions::full();
+        else if (arg == "--cube-size" && i + 1 < argc) environmentSize = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--max-memory" && i + 1 < argc) {
+            maxMemory = ObjConverter::parseMemorySize(argv[++i]);
+            if (maxMemory == 0) {
+                std::cerr << "Invalid memory size " << argv[i] << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--format" && i + 1 < argc) {
+            if (!TextureCooker::parseFormat(argv[++i], textureOptions.format)) {
+                std::cerr << "Unknown texture format " << argv[i] << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--color-space" && i + 1 < argc) {
+            if (!TextureCooker::parseColorSpace(argv[++i], textureOptions.colorSpace)) {
+                std::cerr << "Unknown color space " << argv[i] << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--mip-filter" && i + 1 < argc) {
+            if (!TextureCooker::parseMipFilter(argv[++i], textureOptions.mipFilter)) {
+                std::cerr << "Unknown mip filter " << argv[i] << std::endl;
+                return 1;
+            }
+        }
+        else collectJobs(arg, jobs);
+    }
+    if (jobs.empty()) {
+        std::cerr << "usage: AssetCooker [-j threads] [--force] [--full-vertices] [--max-memory 2G] [--format auto|rgba8|bc1|bc3|bc5|bc7] "
+                     "[--cube-size 512] [--color-space auto|srgb|linear] [--mip-filter kaiser|box] <asset or folder>..." << std::endl;
+        return 1;
+    }
+
+    // the cookers log their own steps, this adds one line per finished job
+    const auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> nextJob{ 0 };
+    std::atomic<size_t> failed{ 0 };
+    std::atomic<size_t> skipped{ 0 };
+    size_t finished = 0;
+    std::mutex reportMutex;
+
+    auto worker = [&]() {
+        for (size_t j = nextJob++; j < jobs.size(); j = nextJob++) {
+            const CookJob& job = jobs[j];
+            const auto jobStart = std::chrono::steady_clock::now();
+
+            bool upToDate = false;
+            bool success = true;
+            if (job.kind == CookJob::Kind::Mesh) {
+                const std::filesystem::path cachePath = MeshCache::getCachePath(job.path);
+                MeshCache cache;
+                upToDate = !force && cache.open(cachePath, job.path, vertexFormat);
+                cache.close(); // unmapped before it is rewritten
+                if (!upToDate) {
+                    success = ObjConverter::needsConversion(job.path, maxMemory)
+                        ? ObjConverter::convert(job.path, cachePath, vertexFormat, maxMemory)
+                        : MeshCooker::cook(job.path, vertexFormat);
+                }
+            }
+            else {
+                upToDate = !force && TextureCooker::isCookedUpToDate(job.path);
+                if (!upToDate) {
+                    if (job.kind == CookJob::Kind::Environment) success = TextureCooker::cookEnvironment(job.path, environmentSize);
+                    else if (job.kind == CookJob::Kind::Cubemap) success = TextureCooker::cookCubemap(job.path, textureOptions);
+                    else success = TextureCooker::cookTexture(job.path, textureOptions);
+                }
+            }
+            if (!success) failed++;
+            if (upToDate) skipped++;
+
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - jobStart).count();
+            std::lock_guard<std::mutex> lock(reportMutex);
+            finished++;
+            std::cout << "[" << finished << "/" << jobs.size() << "] " << getKindName(job.kind) << " " << job.path.string()
+                      << (!success ? " FAILED" : upToDate ? " up to date" : " cooked") << " (" << seconds << " s)" << std::endl;
+        }
+    };
+
+    // one asset per thread, the mesh passes run their own parallel loops inside
+    threadCount = std::min<unsigned>(threadCount, static_cast<unsigned>(jobs.size()));
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < threadCount; ++t) threads.emplace_back(worker);
+    worker();
+    for (std::thread& thread : threads) thread.join();
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Cooked " << jobs.size() - skipped - failed << " assets, " << skipped << " up to date, "
+              << failed << " failed in " << seconds << " s on " << threadCount << " threads" << std::endl;
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,595 @@
+// CPU-side benchmarks, built with -DBUILD_BENCHMARKS=ON
+//   Benchmarks obj [triangleCount] [path]   parallel OBJ parser vs. tinyobj
+//   Benchmarks cache [triangleCount]        warm mesh cache opens next to a scan sized OBJ, untouched and touched
+//   Benchmarks normals [triangleCount]      smooth normals + tangents of a scan sized grid
+//   Benchmarks mips [size]...                mip chains of 4k and 8k RGBA8 images, per filter
+//   Benchmarks bc [size]...                  BC1 / BC3 / BC5 / BC7 encode + decode of 4k images, with PSNR
+//   Benchmarks ggx [faceSize] [sampleCount]  GGX prefiltered specular cube of an HDR sky (CPU reference)
+//   Benchmarks sh [faceSize]                 spherical harmonics projection of 4k cube faces
+//   Benchmarks brdf [size] [sampleCount]     split sum BRDF table (CPU fallback of BrdfLut)
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "ObjParser.h"
+#include "MeshCache.h"
+#include "MeshNormals.h"
+#include "MipGenerator.h"
+#include "BlockCompression.h"
+#include "EnvironmentMap.h"
+#include "SphericalHarmonics.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <glm/geometric.hpp>
+#include <glm/trigonometric.hpp>
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// OBJ BENCHMARK --------------------------------------------------------------------------------
+
+// wavy grid with positions, uvs and normals, written as triangles
+static bool writeSyntheticObj(const std::filesystem::path& path, size_t triangleCount) {
+    const size_t quads = (triangleCount + 1) / 2;
+    const size_t n = static_cast<size_t>(std::ceil(std::sqrt(double(quads)))) + 1; // vertices per side
+
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) return false;
+
+    std::vector<char> buffer(1 << 20);
+    size_t used = 0;
+    auto flush = [&]() {
+        out.write(buffer.data(), used);
+        used = 0;
+    };
+    auto print = [&](const char* format, auto... args) {
+        if (used + 256 > buffer.size()) flush();
+        used += std::snprintf(buffer.data() + used, 256, format, args...);
+    };
+
+    print("# synthetic grid, %zu x %zu vertices\n", n, n);
+    for (size_t y = 0; y < n; ++y) {
+        for (size_t x = 0; x < n; ++x) {
+            float u = float(x) / float(n - 1);
+            float v = float(y) / float(n - 1);
+            float h = 0.05f * std::sin(u * 40.0f) * std::cos(v * 40.0f);
+            print("v %.6f %.6f %.6f\n", u * 2.0f - 1.0f, h, v * 2.0f - 1.0f);
+            print("vt %.6f %.6f\n", u, v);
+            print("vn %.4f %.4f %.4f\n", -h, 1.0f, h * 0.5f);
+        }
+    }
+    size_t written = 0;
+    for (size_t y = 0; y + 1 < n && written < triangleCount; ++y) {
+        for (size_t x = 0; x + 1 < n && written < triangleCount; ++x) {
+            size_t a = y * n + x + 1; // obj indices are 1 based
+            size_t b = a + 1;
+            size_t c = a + n;
+            size_t d = c + 1;
+            print("f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", a, a, a, c, c, c, b, b, b);
+            if (++written < triangleCount) {
+                print("f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", b, b, b, c, c, c, d, d, d);
+                ++written;
+            }
+        }
+    }
+    flush();
+    return bool(out);
+}
+
+static bool sameFloats(const std::vector<float>& a, const std::vector<float>& b) {
+    return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0);
+}
+
+static int benchObj(int argc, char** argv) {
+    const size_t triangleCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10000000;
+    const std::filesystem::path path = argc > 3 ? argv[3] : "bench_synthetic.obj";
+
+    if (!std::filesystem::exists(path)) {
+        std::cout << "Writing " << path << " (" << triangleCount << " triangles)..." << std::endl;
+        if (!writeSyntheticObj(path, triangleCount)) {
+            std::cerr << "Could not write " << path << std::endl;
+            return 1;
+        }
+    }
+    std::cout << path << ": " << std::filesystem::file_size(path) / (1024.0 * 1024.0) << " MB" << std::endl;
+
+    // tinyobj (single thread, istream)
+    auto start = std::chrono::steady_clock::now();
+    tinyobj::ObjReader reader;
+    if (!reader.ParseFromFile(path.string(), tinyobj::ObjReaderConfig())) {
+        std::cerr << "tinyobj: " << reader.Error() << std::endl;
+        return 1;
+    }
+    const double tinyobjTime = secondsSince(start);
+    std::cout << "tinyobj:            " << tinyobjTime << " s" << std::endl;
+
+    std::vector<tinyobj::index_t> reference;
+    for (const auto& shape : reader.GetShapes()) {
+        reference.insert(reference.end(), shape.mesh.indices.begin(), shape.mesh.indices.end());
+    }
+
+    const unsigned hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; ; threads = std::min(threads * 2, hardwareThreads)) {
+        start = std::chrono::steady_clock::now();
+        ObjGeometry geometry;
+        if (!ObjParser::parse(path, geometry, threads)) {
+            std::cerr << "ObjParser failed" << std::endl;
+            return 1;
+        }
+        const double parallelTime = secondsSince(start);
+
+        const tinyobj::attrib_t& a = reader.GetAttrib();
+        bool match = sameFloats(a.vertices, geometry.attrib.vertices)
+            && sameFloats(a.colors, geometry.attrib.colors)
+            && sameFloats(a.normals, geometry.attrib.normals)
+            && sameFloats(a.texcoords, geometry.attrib.texcoords)
+            && reference.size() == geometry.indices.size();
+        for (size_t i = 0; match && i < reference.size(); ++i) {
+            match = reference[i].vertex_index == geometry.indices[i].vertex_index
+                && reference[i].normal_index == geometry.indices[i].normal_index
+                && reference[i].texcoord_index == geometry.indices[i].texcoord_index;
+        }
+
+        std::cout << "ObjParser " << threads << " thread(s): " << parallelTime << " s ("
+            << tinyobjTime / parallelTime << "x) " << (match ? "output matches" : "OUTPUT DIFFERS") << std::endl;
+        if (!match) return 1;
+        if (threads == hardwareThreads) break;
+    }
+    return 0;
+}
+
+// MESH CACHE BENCHMARK -------------------------------------------------------------------------
+
+static int benchCache(int argc, char** argv) {
+    const size_t triangleCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10000000;
+    const std::filesystem::path path = "bench_cache.obj";
+    const std::filesystem::path cachePath = MeshCache::getCachePath(path);
+
+    std::cout << "Writing " << path << " (" << triangleCount << " triangles)..." << std::endl;
+    if (!writeSyntheticObj(path, triangleCount)) {
+        std::cerr << "Could not write " << path << std::endl;
+        return 1;
+    }
+    std::cout << path << ": " << std::filesystem::file_size(path) / (1024.0 * 1024.0) << " MB" << std::endl;
+
+    // only the source stamp is checked against the OBJ, a single triangle keeps the cache small
+    MeshData mesh;
+    mesh.vertices.resize(3, VertexAttr{ glm::vec3(0.0f), glm::vec3(1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(0.0f) });
+    mesh.vertices[1].position.x = 1.0f;
+    mesh.vertices[2].position.z = 1.0f;
+    mesh.indices = { 0, 1, 2 };
+    mesh.submeshes.resize(1);
+    mesh.submeshes[0].indexCount = 3;
+    mesh.boundsMax = glm::vec3(1.0f, 0.0f, 1.0f);
+    const VertexFormatOptions options;
+    PackedVertices packed;
+    VertexQuantization::pack(mesh, options, packed);
+    if (!MeshCache::write(cachePath, path, mesh, packed)) {
+        std::cerr << "Could not write " << cachePath << std::endl;
+        return 1;
+    }
+
+    auto timeOpen = [&](const char* label) {
+        auto start = std::chrono::steady_clock::now();
+        MeshCache cache;
+        const bool opened = cache.open(cachePath, path, options);
+        std::cout << label << secondsSince(start) * 1000.0 << " ms" << (opened ? "" : " (stale)") << std::endl;
+        return opened;
+    };
+    bool match = timeOpen("untouched:      ");
+
+    // same contents, new mtime (touch, copy, checkout): hashed once, the new mtime is stored
+    std::filesystem::file_time_type touchedTime = std::filesystem::last_write_time(path) + std::chrono::seconds(1);
+    std::filesystem::last_write_time(path, touchedTime);
+    match = timeOpen("touched:        ") && match;
+
+    // the next open must trust the stored mtime: a same size edit with the mtime put back is only seen by a hash
+    {
+        std::fstream edit(path, std::ios::binary | std::ios::in | std::ios::out);
+        edit.seekp(2);
+        edit.put('S'); // "# synthetic" -> "# Synthetic"
+    }
+    std::filesystem::last_write_time(path, touchedTime);
+    match = timeOpen("touched, again: ") && match;
+
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    std::filesystem::remove(cachePath, ec);
+    if (!match) {
+        std::cout << "SOURCE HASHED AGAIN" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// NORMALS BENCHMARK ----------------------------------------------------------------------------
+
+static int benchNormals(int argc, char** argv) {
+    const size_t triangleCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10000000;
+    const size_t n = static_cast<size_t>(std::ceil(std::sqrt(double((triangleCount + 1) / 2)))) + 1;
+
+    // same wavy grid as the OBJ benchmark, without normals
+    MeshData mesh;
+    mesh.vertices.resize(n * n);
+    for (size_t y = 0; y < n; ++y) {
+        for (size_t x = 0; x < n; ++x) {
+            const float u = float(x) / float(n - 1);
+            const float v = float(y) / float(n - 1);
+            const float h = 0.05f * std::sin(u * 40.0f) * std::cos(v * 40.0f);
+            VertexAttr& vertex = mesh.vertices[y * n + x];
+            vertex.position = glm::vec3(u * 2.0f - 1.0f, h, v * 2.0f - 1.0f);
+            vertex.color = glm::vec3(1.0f);
+            vertex.normal = glm::vec3(0.0f);
+            vertex.uv = glm::vec2(u, v);
+        }
+    }
+    for (size_t y = 0; y + 1 < n; ++y) {
+        for (size_t x = 0; x + 1 < n; ++x) {
+            const uint32_t a = uint32_t(y * n + x), b = a + 1, c = uint32_t(a + n), d = c + 1;
+            mesh.indices.insert(mesh.indices.end(), { a, c, b, b, c, d });
+        }
+    }
+    std::cout << "grid: " << mesh.indices.size() / 3 << " triangles, " << mesh.vertices.size() << " vertices, "
+        << Parallel::getThreadCount() << " thread(s)" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    MeshNormals::generateNormals(mesh);
+    const double normalTime = secondsSince(start);
+    start = std::chrono::steady_clock::now();
+    MeshNormals::generateTangents(mesh);
+    const double tangentTime = secondsSince(start);
+
+    // analytic normal of the height field
+    double maxError = 0.0;
+    for (size_t i = 0; i < mesh.vertices.size(); i += 97) {
+        const VertexAttr& vertex = mesh.vertices[i];
+        const float u = vertex.uv.x, v = vertex.uv.y;
+        const float dhdx = 0.05f * 40.0f * std::cos(u * 40.0f) * std::cos(v * 40.0f) * 0.5f;
+        const float dhdz = -0.05f * 40.0f * std::sin(u * 40.0f) * std::sin(v * 40.0f) * 0.5f;
+        const glm::vec3 expected = glm::normalize(glm::vec3(-dhdx, 1.0f, -dhdz));
+        maxError = std::max(maxError, double(std::acos(std::min(1.0f, glm::dot(expected, vertex.normal)))));
+    }
+    std::cout << "normals:  " << normalTime << " s (max error " << glm::degrees(maxError) << " deg)" << std::endl;
+    std::cout << "tangents: " << tangentTime << " s" << std::endl;
+    return 0;
+}
+
+// MIP BENCHMARK --------------------------------------------------------------------------------
+
+// previous MipGenerator: scalar 2x2 box filter on one thread
+static void generateReferenceMips(const uint8_t* rgba, uint32_t width, uint32_t height, std::vector<std::vector<uint8_t>>& levels) {
+    const uint32_t levelCount = MipGenerator::getLevelCount(width, height);
+    levels.resize(levelCount);
+    levels[0].assign(rgba, rgba + size_t(width) * height * 4);
+    for (uint32_t level = 1; level < levelCount; ++level) {
+        const uint32_t srcWidth = MipGenerator::getLevelSize(width, level - 1);
+        const uint32_t srcHeight = MipGenerator::getLevelSize(height, level - 1);
+        const uint32_t dstWidth = MipGenerator::getLevelSize(width, level);
+        const uint32_t dstHeight = MipGenerator::getLevelSize(height, level);
+        const uint8_t* src = levels[level - 1].data();
+        levels[level].resize(size_t(dstWidth) * dstHeight * 4);
+        for (uint32_t y = 0; y < dstHeight; ++y) {
+            const uint8_t* row0 = src + size_t(std::min(2 * y, srcHeight - 1)) * srcWidth * 4;
+            const uint8_t* row1 = src + size_t(std::min(2 * y + 1, srcHeight - 1)) * srcWidth * 4;
+            uint8_t* out = levels[level].data() + size_t(y) * dstWidth * 4;
+            for (uint32_t x = 0; x < dstWidth; ++x) {
+                const uint32_t x0 = std::min(2 * x, srcWidth - 1) * 4;
+                const uint32_t x1 = std::min(2 * x + 1, srcWidth - 1) * 4;
+                for (uint32_t c = 0; c < 4; ++c) {
+                    out[4 * x + c] = static_cast<uint8_t>((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+                }
+            }
+        }
+    }
+}
+
+static int benchMips(int argc, char** argv) {
+    std::vector<uint32_t> sizes;
+    for (int i = 2; i < argc; ++i) sizes.push_back(static_cast<uint32_t>(std::strtoul(argv[i], nullptr, 10)));
+    if (sizes.empty()) sizes = { 4096, 8192 };
+
+    for (uint32_t size : sizes) {
+        // zone plate (aliases visibly when filtered badly) with a gradient alpha
+        std::vector<uint8_t> image(size_t(size) * size * 4);
+        for (uint32_t y = 0; y < size; ++y) {
+            for (uint32_t x = 0; x < size; ++x) {
+                const float u = float(x) / size - 0.5f, v = float(y) / size - 0.5f;
+                const float ring = 0.5f + 0.5f * std::cos(4000.0f * (u * u + v * v));
+                uint8_t* p = &image[(size_t(y) * size + x) * 4];
+                p[0] = static_cast<uint8_t>(255.0f * ring);
+                p[1] = static_cast<uint8_t>(255.0f * (1.0f - ring));
+                p[2] = static_cast<uint8_t>(x * 255 / size);
+                p[3] = static_cast<uint8_t>(y * 255 / size);
+            }
+        }
+        std::cout << size << " x " << size << ", " << MipGenerator::getLevelCount(size, size) << " levels, "
+            << Parallel::getThreadCount() << " thread(s)" << std::endl;
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::vector<uint8_t>> reference;
+        generateReferenceMips(image.data(), size, size, reference);
+        const double referenceTime = secondsSince(start);
+        std::cout << "  reference box (scalar, 1 thread): " << referenceTime << " s" << std::endl;
+
+        const struct { const char* name; MipOptions options; } runs[] = {
+            { "box", { MipFilter::Box, false } },
+            { "box srgb", { MipFilter::Box, true } },
+            { "kaiser", { MipFilter::Kaiser, false } },
+            { "kaiser srgb", { MipFilter::Kaiser, true } },
+        };
+        for (const auto& run : runs) {
+            start = std::chrono::steady_clock::now();
+            std::vector<std::vector<uint8_t>> levels;
+            MipGenerator::generate(image.data(), size, size, levels, run.options);
+            const double time = secondsSince(start);
+
+            // the box filter of linear data is exact
+            std::cout << "  " << run.name << ": " << time << " s (" << referenceTime / time << "x)";
+            if (run.options.filter == MipFilter::Box && !run.options.srgb) {
+                int maxDifference = 0;
+                for (size_t level = 0; level < levels.size(); ++level) {
+                    for (size_t i = 0; i < levels[level].size(); ++i) {
+                        maxDifference = std::max(maxDifference, std::abs(int(levels[level][i]) - int(reference[level][i])));
+                    }
+                }
+                std::cout << " max difference to the reference " << maxDifference;
+                if (maxDifference > 0) {
+                    std::cout << std::endl << "OUTPUT DIFFERS" << std::endl;
+                    return 1;
+                }
+            }
+            std::cout << std::endl;
+        }
+    }
+    return 0;
+}
+
+// BLOCK COMPRESSION BENCHMARK ------------------------------------------------------------------
+
+static int benchBlockCompression(int argc, char** argv) {
+    std::vector<uint32_t> sizes;
+    for (int i = 2; i < argc; ++i) sizes.push_back(static_cast<uint32_t>(std::strtoul(argv[i], nullptr, 10)));
+    if (sizes.empty()) sizes = { 4096 };
+
+    for (uint32_t size : sizes) {
+        // smooth color fields with fine detail on top, roughly photo like
+        std::vector<uint8_t> image(size_t(size) * size * 4);
+        for (uint32_t y = 0; y < size; ++y) {
+            for (uint32_t x = 0; x < size; ++x) {
+                const float u = float(x) / size, v = float(y) / size;
+                const float detail = 20.0f * std::sin(0.7f * x) * std::cos(0.5f * y);
+                uint8_t* p = &image[(size_t(y) * size + x) * 4];
+                p[0] = static_cast<uint8_t>(std::clamp(127.5f + 100.0f * std::sin(6.0f * u + 2.0f * v) + detail, 0.0f, 255.0f));
+                p[1] = static_cast<uint8_t>(std::clamp(127.5f + 100.0f * std::cos(5.0f * v - 3.0f * u) + detail, 0.0f, 255.0f));
+                p[2] = static_cast<uint8_t>(std::clamp(255.0f * u * v + detail, 0.0f, 255.0f));
+                p[3] = static_cast<uint8_t>(255.0f * (0.5f + 0.5f * std::sin(9.0f * u)));
+            }
+        }
+        const double megapixels = double(size) * size / 1e6;
+        std::cout << size << " x " << size << ", " << Parallel::getThreadCount() << " thread(s)" << std::endl;
+
+        const struct { const char* name; BcFormat format; int channels; } runs[] = {
+            { "bc1", BcFormat::BC1, 3 },
+            { "bc3", BcFormat::BC3, 4 },
+            { "bc5", BcFormat::BC5, 2 },
+            { "bc7", BcFormat::BC7, 4 },
+        };
+        for (const auto& run : runs) {
+            std::vector<uint8_t> blocks(BlockCompression::getImageBytes(run.format, size, size));
+            auto start = std::chrono::steady_clock::now();
+            BlockCompression::encode(run.format, image.data(), size, size, blocks.data());
+            const double encodeTime = secondsSince(start);
+
+            std::vector<uint8_t> decoded(image.size());
+            start = std::chrono::steady_clock::now();
+            if (!BlockCompression::decode(run.format, blocks.data(), size, size, decoded.data())) {
+                std::cout << "DECODE FAILED" << std::endl;
+                return 1;
+            }
+            const double decodeTime = secondsSince(start);
+
+            // over the channels the format keeps
+            double squaredError = 0.0;
+            for (size_t i = 0; i < image.size(); i += 4) {
+                for (int c = 0; c < run.channels; ++c) {
+                    const double d = double(decoded[i + c]) - double(image[i + c]);
+                    squaredError += d * d;
+                }
+            }
+            const double mse = squaredError / (double(size) * size * run.channels);
+            const double psnr = mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+            std::cout << "  " << run.name << ": encode " << encodeTime << " s (" << megapixels / encodeTime << " MP/s), decode "
+                << decodeTime << " s, " << image.size() / blocks.size() << ":1, PSNR " << psnr << " dB" << std::endl;
+        }
+    }
+    return 0;
+}
+
+// GGX PREFILTER BENCHMARK ----------------------------------------------------------------------
+
+static int benchPrefilter(int argc, char** argv) {
+    const uint32_t faceSize = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 512;
+    const uint32_t sampleCount = argc > 3 ? static_cast<uint32_t>(std::strtoul(argv[3], nullptr, 10)) : 128;
+    // SpecularPrefilter settings
+    const uint32_t outSize = 128;
+    const uint32_t levelCount = 6;
+
+    // sky gradient with a small sun 1000x brighter: what filtered importance sampling has to keep smooth
+    const glm::vec3 sun = glm::normalize(glm::vec3(0.3f, 0.5f, -0.8f));
+    std::vector<float> faces(size_t(6) * faceSize * faceSize * 4);
+    for (uint32_t face = 0; face < 6; ++face) {
+        for (uint32_t y = 0; y < faceSize; ++y) {
+            for (uint32_t x = 0; x < faceSize; ++x) {
+                const glm::vec3 d = glm::normalize(EnvironmentMap::getFaceDirection(face, 2.0f * (x + 0.5f) / faceSize - 1.0f, 2.0f * (y + 0.5f) / faceSize - 1.0f));
+                const float sky = 0.2f + 0.8f * std::max(d.y, 0.0f);
+                const float radiance = glm::dot(d, sun) > 0.9995f ? 1000.0f : sky;
+                float* p = &faces[((size_t(face) * faceSize + y) * faceSize + x) * 4];
+                p[0] = radiance;
+                p[1] = radiance;
+                p[2] = radiance * 1.2f;
+                p[3] = 1.0f;
+            }
+        }
+    }
+    std::vector<std::vector<float>> levels;
+    EnvironmentMap::generateMips(faces, faceSize, levels);
+    std::cout << "environment " << faceSize << " x " << faceSize << " -> " << outSize << " x " << outSize << ", " << levelCount
+        << " levels, " << sampleCount << " samples, " << Parallel::getThreadCount() << " thread(s)" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::vector<float>> prefiltered;
+    EnvironmentMap::prefilterSpecular(levels, faceSize, outSize, levelCount, sampleCount, prefiltered);
+    std::cout << "  prefilter: " << secondsSince(start) << " s" << std::endl;
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        const float peak = EnvironmentMap::sampleCube(prefiltered, outSize, sun, float(level)).r;
+        std::cout << "  roughness " << float(level) / (levelCount - 1) << ": radiance toward the sun " << peak << std::endl;
+    }
+
+    // a uniform environment has to come out unchanged at every roughness
+    std::vector<std::vector<float>> uniformLevels;
+    EnvironmentMap::generateMips(std::vector<float>(faces.size(), 1.0f), faceSize, uniformLevels);
+    std::vector<std::vector<float>> uniformPrefiltered;
+    EnvironmentMap::prefilterSpecular(uniformLevels, faceSize, outSize, levelCount, sampleCount, uniformPrefiltered);
+    float maxError = 0.0f;
+    for (const std::vector<float>& level : uniformPrefiltered) {
+        for (float value : level) maxError = std::max(maxError, std::abs(value - 1.0f));
+    }
+    std::cout << "  uniform environment max error " << maxError << std::endl;
+    if (maxError > 1e-3f) {
+        std::cout << "OUTPUT DIFFERS" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// SPHERICAL HARMONICS BENCHMARK ----------------------------------------------------------------
+
+static int benchSphericalHarmonics(int argc, char** argv) {
+    const uint32_t faceSize = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 4096;
+    std::cout << "6 faces of " << faceSize << " x " << faceSize << ", " << Parallel::getThreadCount() << " thread(s)" << std::endl;
+
+    // radiance 1 + y: exactly representable, coefficients 4 pi Y0 and 4 pi / 3 Y1, the others 0
+    const float pi = 3.14159265358979f;
+    const glm::vec3 expected[9] = { glm::vec3(4.0f * pi * 0.282095f), glm::vec3(4.0f * pi / 3.0f * 0.488603f) };
+
+    // one face at a time, a full 4k float cube would not fit everywhere
+    std::vector<float> face(size_t(faceSize) * faceSize * 4);
+    double projectTime = 0.0, referenceTime = 0.0;
+    ShProjection projection;
+    double referenceSums[9][3] = {};
+    double referenceWeight = 0.0;
+    for (uint32_t f = 0; f < 6; ++f) {
+        for (uint32_t y = 0; y < faceSize; ++y) {
+            for (uint32_t x = 0; x < faceSize; ++x) {
+                const glm::vec3 d = glm::normalize(EnvironmentMap::getFaceDirection(f, 2.0f * (x + 0.5f) / faceSize - 1.0f, 2.0f * (y + 0.5f) / faceSize - 1.0f));
+                float* p = &face[(size_t(y) * faceSize + x) * 4];
+                p[0] = p[1] = p[2] = 1.0f + d.y;
+                p[3] = 1.0f;
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        SphericalHarmonics::projectFace(f, face.data(), faceSize, projection);
+        projectTime += secondsSince(start);
+
+        // scalar, 1 thread, double sums
+        start = std::chrono::steady_clock::now();
+        for (uint32_t y = 0; y < faceSize; ++y) {
+            for (uint32_t x = 0; x < faceSize; ++x) {
+                const float u = 2.0f * (x + 0.5f) / faceSize - 1.0f, v = 2.0f * (y + 0.5f) / faceSize - 1.0f;
+                const glm::vec3 d = EnvironmentMap::getFaceDirection(f, u, v);
+                const double r2 = 1.0 + double(u) * u + double(v) * v;
+                const double weight = 4.0 / (double(faceSize) * faceSize * r2 * std::sqrt(r2));
+                float basis[9];
+                SphericalHarmonics::getBasis(glm::normalize(d), basis);
+                const float* p = &face[(size_t(y) * faceSize + x) * 4];
+                for (int k = 0; k < 9; ++k) {
+                    for (int c = 0; c < 3; ++c) referenceSums[k][c] += basis[k] * p[c] * weight;
+                }
+                referenceWeight += weight;
+            }
+        }
+        referenceTime += secondsSince(start);
+    }
+
+    glm::vec3 coefficients[9];
+    SphericalHarmonics::getCoefficients(projection, coefficients);
+    float referenceError = 0.0f, analyticError = 0.0f;
+    for (int k = 0; k < 9; ++k) {
+        for (int c = 0; c < 3; ++c) {
+            const float reference = float(referenceSums[k][c] * 4.0 * pi / referenceWeight);
+            referenceError = std::max(referenceError, std::abs(coefficients[k][c] - reference));
+            analyticError = std::max(analyticError, std::abs(coefficients[k][c] - expected[k][c]));
+        }
+    }
+    const double megatexels = 6.0 * faceSize * faceSize / 1e6;
+    std::cout << "  reference (scalar, 1 thread): " << referenceTime << " s" << std::endl;
+    std::cout << "  projection: " << projectTime << " s (" << megatexels / projectTime << " Mtexels/s, "
+        << referenceTime / projectTime << "x)" << std::endl;
+    std::cout << "  max coefficient difference to the reference " << referenceError << ", to the exact projection " << analyticError << std::endl;
+    if (referenceError > 1e-3f || analyticError > 1e-2f) {
+        std::cout << "OUTPUT DIFFERS" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// BRDF LUT BENCHMARK ---------------------------------------------------------------------------
+
+static int benchBrdf(int argc, char** argv) {
+    // BrdfLut settings
+    const uint32_t size = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 128;
+    const uint32_t sampleCount = argc > 3 ? static_cast<uint32_t>(std::strtoul(argv[3], nullptr, 10)) : 1024;
+    std::cout << size << " x " << size << ", " << sampleCount << " samples, " << Parallel::getThreadCount() << " thread(s)" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<float> rg;
+    EnvironmentMap::integrateBrdf(size, sampleCount, rg);
+    std::cout << "  integrate: " << secondsSince(start) << " s" << std::endl;
+    for (uint32_t y : { 0u, size / 2, size - 1 }) {
+        const float* texel = &rg[(size_t(y) * size + size / 2) * 2];
+        std::cout << "  roughness " << (y + 0.5f) / size << ", NdotV " << (size / 2 + 0.5f) / size
+            << ": scale " << texel[0] << ", bias " << texel[1] << std::endl;
+    }
+
+    // a white F0 reflects everything on smooth surfaces, and nothing reflects more than it receives
+    float smoothError = 0.0f, maxReflectance = 0.0f;
+    for (uint32_t x = size / 4; x < size; ++x) smoothError = std::max(smoothError, std::abs(rg[x * 2] + rg[x * 2 + 1] - 1.0f));
+    for (size_t i = 0; i < rg.size(); i += 2) maxReflectance = std::max(maxReflectance, rg[i] + rg[i + 1]);
+    std::cout << "  smooth white reflectance max error " << smoothError << ", max reflectance " << maxReflectance << std::endl;
+    if (smoothError > 0.02f || maxReflectance > 1.01f) {
+        std::cout << "OUTPUT DIFFERS" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    const std::string name = argc > 1 ? argv[1] : "";
+    if (name == "obj") return benchObj(argc, argv);
+    if (name == "cache") return benchCache(argc, argv);
+    if (name == "normals") return benchNormals(argc, argv);
+    if (name == "mips") return benchMips(argc, argv);
+    if (name == "bc") return benchBlockCompression(argc, argv);
+    if (name == "ggx") return benchPrefilter(argc, argv);
+    if (name == "sh") return benchSphericalHarmonics(argc, argv);
+    if (name == "brdf") return benchBrdf(argc, argv);
+
+    std::cout << "usage: Benchmarks obj [triangleCount] [path]" << std::endl;
+    std::cout << "       Benchmarks cache [triangleCount]" << std::endl;
+    std::cout << "       Benchmarks normals [triangleCount]" << std::endl;
+    std::cout << "       Benchmarks mips [size]..." << std::endl;
+    std::cout << "       Benchmarks bc [size]..." << std::endl;
+    std::cout << "       Benchmarks ggx [faceSize] [sampleCount]" << std::endl;
+    std::cout << "       Benchmarks sh [faceSize]" << std::endl;
+    std::cout << "       Benchmarks brdf [size] [sampleCount]" << std::endl;
+    return name.empty() ? 0 : 1;
+}
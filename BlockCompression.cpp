@@ -0,0 +1,525 @@
+#include "BlockCompression.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define BLOCK_COMPRESSION_SSE2
+#  include <emmintrin.h>
+#endif
+
+namespace {
+
+    // blocks per thread below which threads don't pay off
+    const size_t MinRangeBlocks = 1024;
+
+    // BC7 4-bit index interpolation weights (out of 64)
+    const int Bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    // the 16 pixels of a block, one array per channel
+    struct Block {
+        float channels[4][16];
+    };
+
+    void loadBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t bx, uint32_t by, Block& block) {
+        for (uint32_t y = 0; y < 4; ++y) {
+            const uint32_t py = std::min(by * 4 + y, height - 1);
+            for (uint32_t x = 0; x < 4; ++x) {
+                const uint32_t px = std::min(bx * 4 + x, width - 1);
+                const uint8_t* p = rgba + (size_t(py) * width + px) * 4;
+                for (int c = 0; c < 4; ++c) block.channels[c][y * 4 + x] = p[c];
+            }
+        }
+    }
+
+    void storeBlock(const uint8_t pixels[16][4], uint32_t width, uint32_t height, uint32_t bx, uint32_t by, uint8_t* rgba) {
+        for (uint32_t y = 0; y < 4 && by * 4 + y < height; ++y) {
+            for (uint32_t x = 0; x < 4 && bx * 4 + x < width; ++x) {
+                std::memcpy(rgba + ((size_t(by) * 4 + y) * width + bx * 4 + x) * 4, pixels[y * 4 + x], 4);
+            }
+        }
+    }
+
+    // nearest palette entry of every pixel over ChannelCount channels, returns the summed squared error
+    template <int ChannelCount>
+    float selectIndices(const float* const channels[ChannelCount], const float palette[][4], int paletteSize, uint8_t indices[16]) {
+#ifdef BLOCK_COMPRESSION_SSE2
+        __m128 total = _mm_setzero_ps();
+        for (int i = 0; i < 16; i += 4) {
+            __m128 pixel[ChannelCount];
+            for (int c = 0; c < ChannelCount; ++c) pixel[c] = _mm_loadu_ps(channels[c] + i);
+            __m128 bestError = _mm_set1_ps(std::numeric_limits<float>::max());
+            __m128 bestIndex = _mm_setzero_ps();
+            for (int e = 0; e < paletteSize; ++e) {
+                __m128 error = _mm_setzero_ps();
+                for (int c = 0; c < ChannelCount; ++c) {
+                    const __m128 d = _mm_sub_ps(pixel[c], _mm_set1_ps(palette[e][c]));
+                    error = _mm_add_ps(error, _mm_mul_ps(d, d));
+                }
+                // ties keep the lower index
+                const __m128 better = _mm_cmplt_ps(error, bestError);
+                bestError = _mm_min_ps(error, bestError);
+                bestIndex = _mm_or_ps(_mm_and_ps(better, _mm_set1_ps(float(e))), _mm_andnot_ps(better, bestIndex));
+            }
+            float index[4];
+            _mm_storeu_ps(index, bestIndex);
+            for (int k = 0; k < 4; ++k) indices[i + k] = static_cast<uint8_t>(index[k]);
+            total = _mm_add_ps(total, bestError);
+        }
+        float sums[4];
+        _mm_storeu_ps(sums, total);
+        return sums[0] + sums[1] + sums[2] + sums[3];
+#else
+        float total = 0.0f;
+        for (int i = 0; i < 16; ++i) {
+            float bestError = std::numeric_limits<float>::max();
+            for (int e = 0; e < paletteSize; ++e) {
+                float error = 0.0f;
+                for (int c = 0; c < ChannelCount; ++c) {
+                    const float d = channels[c][i] - palette[e][c];
+                    error += d * d;
+                }
+                if (error < bestError) {
+                    bestError = error;
+                    indices[i] = static_cast<uint8_t>(e);
+                }
+            }
+            total += bestError;
+        }
+        return total;
+#endif
+    }
+
+    // mean and principal axis (power iteration on the covariance) of the first N channels
+    template <int N>
+    void getPrincipalAxis(const Block& block, float mean[N], float axis[N]) {
+        for (int c = 0; c < N; ++c) {
+            mean[c] = 0.0f;
+            for (int i = 0; i < 16; ++i) mean[c] += block.channels[c][i];
+            mean[c] /= 16.0f;
+        }
+        float covariance[N][N] = {};
+        for (int i = 0; i < 16; ++i) {
+            for (int a = 0; a < N; ++a) {
+                for (int b = 0; b < N; ++b) {
+                    covariance[a][b] += (block.channels[a][i] - mean[a]) * (block.channels[b][i] - mean[b]);
+                }
+            }
+        }
+
+        // start from the row of the largest variance, zero for flat blocks
+        int largest = 0;
+        for (int c = 1; c < N; ++c) {
+            if (covariance[c][c] > covariance[largest][largest]) largest = c;
+        }
+        for (int c = 0; c < N; ++c) axis[c] = covariance[largest][c];
+        for (int iteration = 0; iteration < 8; ++iteration) {
+            float next[N] = {};
+            float scale = 0.0f;
+            for (int a = 0; a < N; ++a) {
+                for (int b = 0; b < N; ++b) next[a] += covariance[a][b] * axis[b];
+                scale = std::max(scale, std::abs(next[a]));
+            }
+            if (scale <= 0.0f) break;
+            for (int c = 0; c < N; ++c) axis[c] = next[c] / scale;
+        }
+        float length = 0.0f;
+        for (int c = 0; c < N; ++c) length += axis[c] * axis[c];
+        length = std::sqrt(length);
+        for (int c = 0; c < N; ++c) axis[c] = length > 0.0f ? axis[c] / length : 0.0f;
+    }
+
+    // the extremes of the block along its principal axis
+    template <int N>
+    void getAxisEndpoints(const Block& block, float start[N], float end[N]) {
+        float mean[N], axis[N];
+        getPrincipalAxis<N>(block, mean, axis);
+        float tMin = 0.0f, tMax = 0.0f;
+        for (int i = 0; i < 16; ++i) {
+            float t = 0.0f;
+            for (int c = 0; c < N; ++c) t += (block.channels[c][i] - mean[c]) * axis[c];
+            tMin = std::min(tMin, t);
+            tMax = std::max(tMax, t);
+        }
+        for (int c = 0; c < N; ++c) {
+            start[c] = std::clamp(mean[c] + axis[c] * tMax, 0.0f, 255.0f);
+            end[c] = std::clamp(mean[c] + axis[c] * tMin, 0.0f, 255.0f);
+        }
+    }
+
+    // Endpoints minimizing sum |w_i * start + (1 - w_i) * end - p_i|^2 for fixed indices (weight[index]
+    // of start). Returns false if the indices don't determine them (one palette entry used).
+    template <int N>
+    bool solveEndpoints(const Block& block, const uint8_t indices[16], const float* weight, float start[N], float end[N]) {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ap[N] = {}, bp[N] = {};
+        for (int i = 0; i < 16; ++i) {
+            const float a = weight[indices[i]];
+            const float b = 1.0f - a;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (int c = 0; c < N; ++c) {
+                ap[c] += a * block.channels[c][i];
+                bp[c] += b * block.channels[c][i];
+            }
+        }
+        const float determinant = aa * bb - ab * ab;
+        if (std::abs(determinant) < 1e-6f) return false;
+        for (int c = 0; c < N; ++c) {
+            start[c] = std::clamp((bb * ap[c] - ab * bp[c]) / determinant, 0.0f, 255.0f);
+            end[c] = std::clamp((aa * bp[c] - ab * ap[c]) / determinant, 0.0f, 255.0f);
+        }
+        return true;
+    }
+
+    // BC1 COLOR ------------------------------------------------------------------------------------
+
+    uint16_t packRgb565(const float color[3]) {
+        const int r = std::clamp(static_cast<int>(std::lround(color[0] * 31.0f / 255.0f)), 0, 31);
+        const int g = std::clamp(static_cast<int>(std::lround(color[1] * 63.0f / 255.0f)), 0, 63);
+        const int b = std::clamp(static_cast<int>(std::lround(color[2] * 31.0f / 255.0f)), 0, 31);
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    void unpackRgb565(uint16_t packed, int color[3]) {
+        const int r = packed >> 11, g = (packed >> 5) & 63, b = packed & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    // c0 > c1 (or BC3): 4 colors, else 3 colors and transparent black
+    void getColorPalette(uint16_t c0, uint16_t c1, bool fourColors, uint8_t palette[4][4]) {
+        int a[3], b[3];
+        unpackRgb565(c0, a);
+        unpackRgb565(c1, b);
+        for (int c = 0; c < 3; ++c) {
+            palette[0][c] = static_cast<uint8_t>(a[c]);
+            palette[1][c] = static_cast<uint8_t>(b[c]);
+            palette[2][c] = static_cast<uint8_t>(fourColors ? (2 * a[c] + b[c]) / 3 : (a[c] + b[c]) / 2);
+            palette[3][c] = static_cast<uint8_t>(fourColors ? (a[c] + 2 * b[c]) / 3 : 0);
+        }
+        palette[0][3] = palette[1][3] = palette[2][3] = 255;
+        palette[3][3] = fourColors ? 255 : 0;
+    }
+
+    // indices of the 4 color palette of c0 > c1 (swapped if needed), returns the squared error
+    float fitColorEndpoints(const Block& block, uint16_t& c0, uint16_t& c1, uint8_t indices[16]) {
+        const float* const channels[3] = { block.channels[0], block.channels[1], block.channels[2] };
+        if (c0 < c1) std::swap(c0, c1);
+        uint8_t bytes[4][4];
+        getColorPalette(c0, c1, true, bytes);
+        float palette[4][4];
+        for (int e = 0; e < 4; ++e) {
+            for (int c = 0; c < 4; ++c) palette[e][c] = bytes[e][c];
+        }
+        // equal endpoints: the 3 color mode would make index 3 transparent
+        return selectIndices<3>(channels, palette, c0 == c1 ? 1 : 4, indices);
+    }
+
+    void encodeColorBlock(const Block& block, uint8_t* out) {
+        float start[3], end[3];
+        getAxisEndpoints<3>(block, start, end);
+        uint16_t c0 = packRgb565(start), c1 = packRgb565(end);
+        uint8_t indices[16];
+        float error = fitColorEndpoints(block, c0, c1, indices);
+
+        const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+        if (error > 0.0f && solveEndpoints<3>(block, indices, weights, start, end)) {
+            uint16_t refined0 = packRgb565(start), refined1 = packRgb565(end);
+            uint8_t refinedIndices[16];
+            const float refinedError = fitColorEndpoints(block, refined0, refined1, refinedIndices);
+            if (refinedError < error) {
+                c0 = refined0;
+                c1 = refined1;
+                std::memcpy(indices, refinedIndices, 16);
+            }
+        }
+
+        uint32_t bits = 0;
+        for (int i = 0; i < 16; ++i) bits |= uint32_t(indices[i]) << (2 * i);
+        std::memcpy(out, &c0, 2);
+        std::memcpy(out + 2, &c1, 2);
+        std::memcpy(out + 4, &bits, 4);
+    }
+
+    void decodeColorBlock(const uint8_t* in, bool alwaysFourColors, uint8_t pixels[16][4]) {
+        uint16_t c0, c1;
+        uint32_t bits;
+        std::memcpy(&c0, in, 2);
+        std::memcpy(&c1, in + 2, 2);
+        std::memcpy(&bits, in + 4, 4);
+        uint8_t palette[4][4];
+        getColorPalette(c0, c1, alwaysFourColors || c0 > c1, palette);
+        for (int i = 0; i < 16; ++i) {
+            const uint8_t* color = palette[(bits >> (2 * i)) & 3];
+            // BC3 keeps the alpha of its own block
+            std::memcpy(pixels[i], color, alwaysFourColors ? 3 : 4);
+        }
+    }
+
+    // BC4 SINGLE CHANNEL (BC3 alpha, BC5 red / green) ----------------------------------------------
+
+    // a0 > a1: 8 values, else 6 values, 0 and 255
+    void getAlphaPalette(int a0, int a1, int palette[8]) {
+        palette[0] = a0;
+        palette[1] = a1;
+        if (a0 > a1) {
+            for (int k = 2; k < 8; ++k) palette[k] = ((8 - k) * a0 + (k - 1) * a1 + 3) / 7;
+        }
+        else {
+            for (int k = 2; k < 6; ++k) palette[k] = ((6 - k) * a0 + (k - 1) * a1 + 2) / 5;
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    float fitAlphaEndpoints(const float* values, int a0, int a1, uint8_t indices[16]) {
+        int bytes[8];
+        getAlphaPalette(a0, a1, bytes);
+        float palette[8][4] = {};
+        for (int e = 0; e < 8; ++e) palette[e][0] = static_cast<float>(bytes[e]);
+        const float* const channels[1] = { values };
+        return selectIndices<1>(channels, palette, 8, indices);
+    }
+
+    void encodeAlphaBlock(const float* values, uint8_t* out) {
+        const float low = *std::min_element(values, values + 16);
+        const float high = *std::max_element(values, values + 16);
+        int a0 = static_cast<int>(std::lround(high)), a1 = static_cast<int>(std::lround(low));
+        uint8_t indices[16] = {};
+        if (a0 > a1) {
+            float error = fitAlphaEndpoints(values, a0, a1, indices);
+
+            // 8 value mode weights of a0
+            float weights[8] = { 1.0f, 0.0f };
+            for (int k = 2; k < 8; ++k) weights[k] = (8 - k) / 7.0f;
+            Block block;
+            std::memcpy(block.channels[0], values, sizeof(block.channels[0]));
+            float start, end;
+            if (error > 0.0f && solveEndpoints<1>(block, indices, weights, &start, &end)) {
+                const int refined0 = static_cast<int>(std::lround(start)), refined1 = static_cast<int>(std::lround(end));
+                uint8_t refinedIndices[16];
+                if (refined0 > refined1 && fitAlphaEndpoints(values, refined0, refined1, refinedIndices) < error) {
+                    a0 = refined0;
+                    a1 = refined1;
+                    std::memcpy(indices, refinedIndices, 16);
+                }
+            }
+        }
+
+        uint64_t bits = 0;
+        for (int i = 0; i < 16; ++i) bits |= uint64_t(indices[i]) << (3 * i);
+        out[0] = static_cast<uint8_t>(a0);
+        out[1] = static_cast<uint8_t>(a1);
+        for (int b = 0; b < 6; ++b) out[2 + b] = static_cast<uint8_t>(bits >> (8 * b));
+    }
+
+    void decodeAlphaBlock(const uint8_t* in, int channel, uint8_t pixels[16][4]) {
+        int palette[8];
+        getAlphaPalette(in[0], in[1], palette);
+        uint64_t bits = 0;
+        for (int b = 0; b < 6; ++b) bits |= uint64_t(in[2 + b]) << (8 * b);
+        for (int i = 0; i < 16; ++i) pixels[i][channel] = static_cast<uint8_t>(palette[(bits >> (3 * i)) & 7]);
+    }
+
+    // BC7 MODE 6 -----------------------------------------------------------------------------------
+
+    // LSB first, as BC7 blocks are laid out
+    struct BitWriter {
+        uint8_t* out;
+        uint32_t position = 0;
+        void write(uint32_t value, uint32_t bitCount) {
+            for (uint32_t b = 0; b < bitCount; ++b, ++position) {
+                if ((value >> b) & 1) out[position >> 3] |= static_cast<uint8_t>(1 << (position & 7));
+            }
+        }
+    };
+
+    struct BitReader {
+        const uint8_t* in;
+        uint32_t position = 0;
+        uint32_t read(uint32_t bitCount) {
+            uint32_t value = 0;
+            for (uint32_t b = 0; b < bitCount; ++b, ++position) value |= uint32_t((in[position >> 3] >> (position & 7)) & 1) << b;
+            return value;
+        }
+    };
+
+    // 7 bits per channel + a shared p-bit: the p-bit giving the smaller error
+    struct Bc7Endpoint {
+        int values[4]; // 7 bits
+        int pBit;
+        int get(int channel) const { return (values[channel] << 1) | pBit; }
+    };
+
+    Bc7Endpoint quantizeBc7Endpoint(const float color[4]) {
+        Bc7Endpoint best = {};
+        float bestError = std::numeric_limits<float>::max();
+        for (int pBit = 0; pBit < 2; ++pBit) {
+            Bc7Endpoint endpoint = {};
+            endpoint.pBit = pBit;
+            float error = 0.0f;
+            for (int c = 0; c < 4; ++c) {
+                endpoint.values[c] = std::clamp(static_cast<int>(std::lround((color[c] - pBit) * 0.5f)), 0, 127);
+                const float d = endpoint.get(c) - color[c];
+                error += d * d;
+            }
+            if (error < bestError) {
+                bestError = error;
+                best = endpoint;
+            }
+        }
+        return best;
+    }
+
+    void getBc7Palette(const Bc7Endpoint& e0, const Bc7Endpoint& e1, float palette[16][4]) {
+        for (int k = 0; k < 16; ++k) {
+            for (int c = 0; c < 4; ++c) {
+                palette[k][c] = static_cast<float>(((64 - Bc7Weights[k]) * e0.get(c) + Bc7Weights[k] * e1.get(c) + 32) >> 6);
+            }
+        }
+    }
+
+    float fitBc7Endpoints(const Block& block, const Bc7Endpoint& e0, const Bc7Endpoint& e1, uint8_t indices[16]) {
+        float palette[16][4];
+        getBc7Palette(e0, e1, palette);
+        const float* const channels[4] = { block.channels[0], block.channels[1], block.channels[2], block.channels[3] };
+        return selectIndices<4>(channels, palette, 16, indices);
+    }
+
+    void encodeBc7Block(const Block& block, uint8_t* out) {
+        float start[4], end[4];
+        getAxisEndpoints<4>(block, start, end);
+        Bc7Endpoint e0 = quantizeBc7Endpoint(start), e1 = quantizeBc7Endpoint(end);
+        uint8_t indices[16];
+        float error = fitBc7Endpoints(block, e0, e1, indices);
+
+        float weights[16];
+        for (int k = 0; k < 16; ++k) weights[k] = (64 - Bc7Weights[k]) / 64.0f;
+        if (error > 0.0f && solveEndpoints<4>(block, indices, weights, start, end)) {
+            const Bc7Endpoint refined0 = quantizeBc7Endpoint(start), refined1 = quantizeBc7Endpoint(end);
+            uint8_t refinedIndices[16];
+            const float refinedError = fitBc7Endpoints(block, refined0, refined1, refinedIndices);
+            if (refinedError < error) {
+                e0 = refined0;
+                e1 = refined1;
+                std::memcpy(indices, refinedIndices, 16);
+            }
+        }
+
+        // the anchor index (pixel 0) is stored without its top bit
+        if (indices[0] & 8) {
+            std::swap(e0, e1);
+            for (int i = 0; i < 16; ++i) indices[i] = static_cast<uint8_t>(15 - indices[i]);
+        }
+
+        std::memset(out, 0, 16);
+        BitWriter writer{ out };
+        writer.write(1 << 6, 7); // mode 6
+        for (int c = 0; c < 4; ++c) {
+            writer.write(static_cast<uint32_t>(e0.values[c]), 7);
+            writer.write(static_cast<uint32_t>(e1.values[c]), 7);
+        }
+        writer.write(static_cast<uint32_t>(e0.pBit), 1);
+        writer.write(static_cast<uint32_t>(e1.pBit), 1);
+        for (int i = 0; i < 16; ++i) writer.write(indices[i], i == 0 ? 3 : 4);
+    }
+
+    bool decodeBc7Block(const uint8_t* in, uint8_t pixels[16][4]) {
+        BitReader reader{ in };
+        if (reader.read(7) != (1 << 6)) return false;
+        Bc7Endpoint e0 = {}, e1 = {};
+        for (int c = 0; c < 4; ++c) {
+            e0.values[c] = static_cast<int>(reader.read(7));
+            e1.values[c] = static_cast<int>(reader.read(7));
+        }
+        e0.pBit = static_cast<int>(reader.read(1));
+        e1.pBit = static_cast<int>(reader.read(1));
+        float palette[16][4];
+        getBc7Palette(e0, e1, palette);
+        for (int i = 0; i < 16; ++i) {
+            const uint32_t index = reader.read(i == 0 ? 3 : 4);
+            for (int c = 0; c < 4; ++c) pixels[i][c] = static_cast<uint8_t>(palette[index][c]);
+        }
+        return true;
+    }
+}
+
+void BlockCompression::encode(BcFormat format, const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* blocks) {
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+    const uint32_t blockBytes = getBlockBytes(format);
+
+    Parallel::forRanges(blocksY, std::max<size_t>(1, MinRangeBlocks / blocksX), [&](size_t begin, size_t end) {
+        Block block;
+        for (size_t by = begin; by < end; ++by) {
+            for (uint32_t bx = 0; bx < blocksX; ++bx) {
+                loadBlock(rgba, width, height, bx, static_cast<uint32_t>(by), block);
+                uint8_t* out = blocks + (by * blocksX + bx) * blockBytes;
+                switch (format) {
+                case BcFormat::BC1:
+                    encodeColorBlock(block, out);
+                    break;
+                case BcFormat::BC3:
+                    encodeAlphaBlock(block.channels[3], out);
+                    encodeColorBlock(block, out + 8);
+                    break;
+                case BcFormat::BC5:
+                    encodeAlphaBlock(block.channels[0], out);
+                    encodeAlphaBlock(block.channels[1], out + 8);
+                    break;
+                case BcFormat::BC7:
+                    encodeBc7Block(block, out);
+                    break;
+                }
+            }
+        }
+    });
+}
+
+bool BlockCompression::decode(BcFormat format, const uint8_t* blocks, uint32_t width, uint32_t height, uint8_t* rgba) {
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+    const uint32_t blockBytes = getBlockBytes(format);
+    std::atomic<bool> supported{ true };
+
+    Parallel::forRanges(blocksY, std::max<size_t>(1, MinRangeBlocks / blocksX), [&](size_t begin, size_t end) {
+        uint8_t pixels[16][4];
+        for (size_t by = begin; by < end; ++by) {
+            for (uint32_t bx = 0; bx < blocksX; ++bx) {
+                const uint8_t* in = blocks + (by * blocksX + bx) * blockBytes;
+                switch (format) {
+                case BcFormat::BC1:
+                    decodeColorBlock(in, false, pixels);
+                    break;
+                case BcFormat::BC3:
+                    decodeAlphaBlock(in, 3, pixels);
+                    decodeColorBlock(in + 8, true, pixels);
+                    break;
+                case BcFormat::BC5:
+                    for (int i = 0; i < 16; ++i) {
+                        pixels[i][2] = 0;
+                        pixels[i][3] = 255;
+                    }
+                    decodeAlphaBlock(in, 0, pixels);
+                    decodeAlphaBlock(in + 8, 1, pixels);
+                    break;
+                case BcFormat::BC7:
+                    if (!decodeBc7Block(in, pixels)) {
+                        supported.store(false, std::memory_order_relaxed);
+                        std::memset(pixels, 0, sizeof(pixels));
+                    }
+                    break;
+                }
+                storeBlock(pixels, width, height, bx, static_cast<uint32_t>(by), rgba);
+            }
+        }
+    });
+    return supported.load();
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+
+enum class BcFormat {
+    BC1, // rgb, 8 bytes per 4x4 block (alpha ignored)
+    BC3, // rgb + interpolated alpha, 16 bytes
+    BC5, // two channels (rg, e.g. normal maps), 16 bytes
+    BC7  // rgba, 16 bytes, encoded in mode 6 (one subset, 4-bit indices)
+};
+
+// CPU block compression of RGBA8 images to BC1 / BC3 / BC5 / BC7, and decoding back to RGBA8 for
+// adapters without texture-compression-bc. Block rows run in parallel (Parallel::forRanges); the
+// nearest palette entries of a block's 16 pixels are found 4 pixels per SSE2 register where available.
+// Endpoints: principal axis of the block, then one least squares refinement.
+class BlockCompression
+{
+public:
+    static uint32_t getBlockBytes(BcFormat format) { return format == BcFormat::BC1 ? 8 : 16; }
+    static uint64_t getImageBytes(BcFormat format, uint32_t width, uint32_t height) {
+        return uint64_t((width + 3) / 4) * ((height + 3) / 4) * getBlockBytes(format);
+    }
+
+    // blocks in row order; partial blocks at the right / bottom edge repeat the last column / row
+    static void encode(BcFormat format, const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* blocks);
+
+    // BC5 decodes to (r, g, 0, 255). Fails on BC7 blocks of modes other than 6 (not written by encode)
+    static bool decode(BcFormat format, const uint8_t* blocks, uint32_t width, uint32_t height, uint8_t* rgba);
+};
@@ -0,0 +1,143 @@
+#include "BrdfLut.h"
+#include "FileManagement.h"
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace wgpu;
+
+bool BrdfLut::initialize(Device targetDevice) {
+    device = targetDevice;
+    ShaderModule module = FileManagement::loadShaderModule("../files/brdflut.wgsl", device);
+    if (!module) {
+        std::cerr << "BRDF LUT shader module creation failed!" << std::endl;
+        return false;
+    }
+
+    // 0. the table, packed half pairs (storage textures can't be RG16Float)
+    std::vector<BindGroupLayoutEntry> layoutEntries(1, Default);
+    layoutEntries[0].binding = 0;
+    layoutEntries[0].visibility = ShaderStage::Compute;
+    layoutEntries[0].buffer.type = BufferBindingType::Storage;
+    layoutEntries[0].buffer.minBindingSize = uint64_t(Size) * Size * sizeof(uint32_t);
+
+    BindGroupLayoutDescriptor layoutDesc{};
+    layoutDesc.entryCount = (uint32_t)layoutEntries.size();
+    layoutDesc.entries = layoutEntries.data();
+    bindGroupLayout = device.createBindGroupLayout(layoutDesc);
+
+    PipelineLayoutDescriptor pipelineLayoutDesc{};
+    pipelineLayoutDesc.bindGroupLayoutCount = 1;
+    pipelineLayoutDesc.bindGroupLayouts = (WGPUBindGroupLayout*)&bindGroupLayout;
+    PipelineLayout pipelineLayout = device.createPipelineLayout(pipelineLayoutDesc);
+
+    std::vector<ConstantEntry> constants(2);
+    constants[0].key = "SIZE";
+    constants[0].value = Size;
+    constants[1].key = "SAMPLE_COUNT";
+    constants[1].value = SampleCount;
+
+    ComputePipelineDescriptor pipelineDesc;
+    pipelineDesc.label = "BRDF LUT Pipeline";
+    pipelineDesc.layout = pipelineLayout;
+    pipelineDesc.compute.module = module;
+    pipelineDesc.compute.entryPoint = "cs_integrate";
+    pipelineDesc.compute.constantCount = (uint32_t)constants.size();
+    pipelineDesc.compute.constants = constants.data();
+    pipeline = device.createComputePipeline(pipelineDesc);
+
+    pipelineLayout.release();
+    module.release();
+    return true;
+}
+
+void BrdfLut::release() {
+    if (!pipeline) return;
+    pipeline.release();
+    bindGroupLayout.release();
+    pipeline = nullptr;
+}
+
+Texture BrdfLut::generate(Queue queue) {
+    if (!pipeline) return nullptr;
+
+    BufferDescriptor bufferDesc;
+    bufferDesc.label = "BRDF LUT";
+    bufferDesc.usage = BufferUsage::Storage | BufferUsage::CopySrc;
+    bufferDesc.size = uint64_t(Size) * Size * sizeof(uint32_t);
+    bufferDesc.mappedAtCreation = false;
+    Buffer buffer = device.createBuffer(bufferDesc);
+
+    TextureDescriptor textureDesc;
+    textureDesc.label = "BRDF LUT";
+    textureDesc.dimension = TextureDimension::_2D;
+    textureDesc.format = TextureFormat::RG16Float;
+    textureDesc.mipLevelCount = 1;
+    textureDesc.sampleCount = 1;
+    textureDesc.size = { Size, Size, 1 };
+    textureDesc.usage = TextureUsage::TextureBinding | TextureUsage::CopyDst | TextureUsage::CopySrc;
+    textureDesc.viewFormatCount = 0;
+    textureDesc.viewFormats = nullptr;
+    Texture texture = device.createTexture(textureDesc);
+
+    BindGroupEntry entry{};
+    entry.binding = 0;
+    entry.buffer = buffer;
+    entry.offset = 0;
+    entry.size = bufferDesc.size;
+    BindGroupDescriptor bindGroupDesc{};
+    bindGroupDesc.layout = bindGroupLayout;
+    bindGroupDesc.entryCount = 1;
+    bindGroupDesc.entries = &entry;
+    BindGroup bindGroup = device.createBindGroup(bindGroupDesc);
+
+    CommandEncoderDescriptor encoderDesc = {};
+    encoderDesc.label = "brdf lut encoder";
+    CommandEncoder encoder = device.createCommandEncoder(encoderDesc);
+    ComputePassDescriptor computePassDesc;
+    computePassDesc.timestampWrites = nullptr;
+    ComputePassEncoder computePass = encoder.beginComputePass(computePassDesc);
+    computePass.setPipeline(pipeline);
+    computePass.setBindGroup(0, bindGroup, 0, nullptr);
+    // @workgroup_size(8, 8): one workgroup per 8x8 texels
+    computePass.dispatchWorkgroups((Size + 7) / 8, (Size + 7) / 8, 1);
+    computePass.end();
+    computePass.release();
+
+    // rows of Size * 4 bytes: a multiple of 256 for the buffer to texture copy
+    ImageCopyBuffer source;
+    source.buffer = buffer;
+    source.layout.offset = 0;
+    source.layout.bytesPerRow = Size * sizeof(uint32_t);
+    source.layout.rowsPerImage = Size;
+    ImageCopyTexture destination;
+    destination.texture = texture;
+    destination.mipLevel = 0;
+    destination.origin = { 0, 0, 0 };
+    destination.aspect = TextureAspect::All;
+    encoder.copyBufferToTexture(source, destination, { Size, Size, 1 });
+
+    CommandBufferDescriptor cmdBufferDescriptor = {};
+    cmdBufferDescriptor.label = "BRDF LUT";
+    CommandBuffer command = encoder.finish(cmdBufferDescriptor);
+    encoder.release();
+    queue.submit(1, &command);
+    command.release();
+
+    bindGroup.release();
+    buffer.release();
+    return texture;
+}
+
+std::filesystem::path BrdfLut::getCachePath(const std::filesystem::path& directory) {
+    const uint64_t prime = 0x9E3779B97F4A7C15ull;
+    uint64_t key = 0;
+    for (uint64_t setting : { uint64_t(Size), uint64_t(SampleCount), uint64_t(Version) }) {
+        key = (key ^ setting) * prime;
+    }
+    std::ostringstream name;
+    name << "brdf-" << std::hex << std::setw(16) << std::setfill('0') << key << ".ktx2";
+    return directory / name.str();
+}
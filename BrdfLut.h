@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+
+#include <webgpu/webgpu.hpp>
+
+// Split sum BRDF table (files/brdflut.wgsl): texel (NdotV, roughness) of an RG16Float texture holds the
+// scale and bias of F0 in the GGX specular integral, so the shading pass gets the reflectance of the
+// prefiltered environment (SpecularPrefilter) from one fetch. It depends on nothing but the settings
+// below: the app writes it to getCachePath once and memory-maps it (Ktx2::read) on later launches.
+// EnvironmentMap::integrateBrdf is the CPU fallback.
+class BrdfLut
+{
+public:
+    static constexpr uint32_t Size = 128;
+    static constexpr uint32_t SampleCount = 1024;
+
+    bool initialize(wgpu::Device device);
+    void release();
+    bool isInitialized() const { return bool(pipeline); }
+
+    // the whole table, submitted right away. The texture has CopySrc usage for GpuReadback
+    wgpu::Texture generate(wgpu::Queue queue);
+
+    // <directory>/brdf-<key>.ktx2, the key hashes the settings above
+    static std::filesystem::path getCachePath(const std::filesystem::path& directory);
+
+private:
+    // bump when the integration changes: old cache files are then ignored
+    static constexpr uint32_t Version = 1;
+
+    wgpu::Device device;
+    wgpu::BindGroupLayout bindGroupLayout;
+    wgpu::ComputePipeline pipeline;
+};
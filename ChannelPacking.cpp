@@ -0,0 +1,22 @@
+#include "ChannelPacking.h"
+#include "Parallel.h"
+
+namespace {
+    // pixels per thread below which threads don't pay off
+    const size_t MinRangePixels = 1 << 16;
+}
+
+void ChannelPacking::pack(const ChannelSource* sources, uint32_t channelCount, size_t pixelCount, uint8_t* dst) {
+    Parallel::forRanges(pixelCount, MinRangePixels, [&](size_t begin, size_t end) {
+        for (uint32_t c = 0; c < channelCount; ++c) {
+            const ChannelSource& source = sources[c];
+            uint8_t* out = dst + c;
+            if (source.data == nullptr) {
+                for (size_t i = begin; i < end; ++i) out[i * channelCount] = 255;
+                continue;
+            }
+            const uint8_t* in = source.data + source.channel;
+            for (size_t i = begin; i < end; ++i) out[i * channelCount] = in[i * source.channelCount];
+        }
+    });
+}
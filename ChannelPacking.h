@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// one channel of an 8-bit image, null data: a constant 255
+struct ChannelSource {
+    const uint8_t* data = nullptr;
+    uint32_t channelCount = 1; // of data
+    uint32_t channel = 0;      // read from data
+};
+
+// Interleaves channels of 8-bit images of one size into another: separate grayscale maps packed into
+// one texture (occlusion, roughness, metallic -> ORM), or images moved between their decoded channel
+// count and the RGBA8 that MipGenerator filters.
+class ChannelPacking
+{
+public:
+    // images with 1 or 2 channels hold grayscale data (+ alpha), with 3 or 4 the glTF ORM layout
+    static constexpr uint32_t OcclusionChannel = 0;
+    static constexpr uint32_t RoughnessChannel = 1;
+    static constexpr uint32_t MetallicChannel = 2;
+
+    // the channel a map of an image with channelCount channels is stored in
+    static uint32_t getMapChannel(uint32_t channelCount, uint32_t ormChannel) { return channelCount <= 2 ? 0 : ormChannel; }
+
+    // dst gets channelCount channels per pixel, channel c from sources[c]
+    static void pack(const ChannelSource* sources, uint32_t channelCount, size_t pixelCount, uint8_t* dst);
+};
@@ -0,0 +1,266 @@
+#include "EnvironmentMap.h"
+#include "MipGenerator.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/vec2.hpp>
+
+namespace {
+    const float Pi = 3.14159265358979f;
+
+    // rows per thread below which threads don't pay off
+    const size_t MinRangeRows = 16;
+
+    // bilinear, texel centers at + 0.5, clamped at the face edges
+    glm::vec4 sampleFace(const float* face, uint32_t size, float u, float v) {
+        const float px = std::clamp((u + 1.0f) * 0.5f * size - 0.5f, 0.0f, float(size - 1));
+        const float py = std::clamp((v + 1.0f) * 0.5f * size - 0.5f, 0.0f, float(size - 1));
+        const uint32_t x0 = static_cast<uint32_t>(px), y0 = static_cast<uint32_t>(py);
+        const uint32_t x1 = std::min(x0 + 1, size - 1), y1 = std::min(y0 + 1, size - 1);
+        const float tx = px - x0, ty = py - y0;
+        const float* p00 = face + (size_t(y0) * size + x0) * 4;
+        const float* p10 = face + (size_t(y0) * size + x1) * 4;
+        const float* p01 = face + (size_t(y1) * size + x0) * 4;
+        const float* p11 = face + (size_t(y1) * size + x1) * 4;
+        glm::vec4 result;
+        for (int c = 0; c < 4; ++c) {
+            const float top = p00[c] + (p10[c] - p00[c]) * tx;
+            const float bottom = p01[c] + (p11[c] - p01[c]) * tx;
+            result[c] = top + (bottom - top) * ty;
+        }
+        return result;
+    }
+
+    // prefilter.wgsl hammersley / importanceSampleGgx
+    glm::vec2 hammersley(uint32_t i, uint32_t n) {
+        uint32_t bits = i;
+        bits = (bits << 16) | (bits >> 16);
+        bits = ((bits & 0x55555555u) << 1) | ((bits & 0xAAAAAAAAu) >> 1);
+        bits = ((bits & 0x33333333u) << 2) | ((bits & 0xCCCCCCCCu) >> 2);
+        bits = ((bits & 0x0F0F0F0Fu) << 4) | ((bits & 0xF0F0F0F0u) >> 4);
+        bits = ((bits & 0x00FF00FFu) << 8) | ((bits & 0xFF00FF00u) >> 8);
+        return glm::vec2(float(i) / float(n), float(bits) * 2.3283064365386963e-10f);
+    }
+
+    glm::vec3 importanceSampleGgx(const glm::vec2& xi, const glm::vec3& n, float a) {
+        const float phi = 2.0f * Pi * xi.x;
+        const float cosTheta = std::sqrt((1.0f - xi.y) / (1.0f + (a * a - 1.0f) * xi.y));
+        const float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+        const glm::vec3 up = std::abs(n.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+        const glm::vec3 tangentX = glm::normalize(glm::cross(up, n));
+        const glm::vec3 tangentY = glm::cross(n, tangentX);
+        return glm::normalize(tangentX * (std::cos(phi) * sinTheta) + tangentY * (std::sin(phi) * sinTheta) + n * cosTheta);
+    }
+}
+
+glm::vec3 EnvironmentMap::getFaceDirection(uint32_t face, float u, float v) {
+    switch (face) {
+    case 0: return glm::vec3(1.0f, -v, -u);  // +x
+    case 1: return glm::vec3(-1.0f, -v, u);  // -x
+    case 2: return glm::vec3(u, 1.0f, v);    // +y
+    case 3: return glm::vec3(u, -1.0f, -v);  // -y
+    case 4: return glm::vec3(u, -v, 1.0f);   // +z
+    default: return glm::vec3(-u, -v, -1.0f); // -z
+    }
+}
+
+void EnvironmentMap::equirectToCubemap(const float* rgba, uint32_t width, uint32_t height, uint32_t faceSize, std::vector<float>& faces) {
+    faces.resize(size_t(6) * faceSize * faceSize * 4);
+
+    // rows of every face, face by face
+    Parallel::forRanges(size_t(6) * faceSize, MinRangeRows, [&](size_t begin, size_t end) {
+        for (size_t row = begin; row < end; ++row) {
+            const uint32_t face = static_cast<uint32_t>(row / faceSize);
+            const uint32_t y = static_cast<uint32_t>(row % faceSize);
+            const float v = 2.0f * (y + 0.5f) / faceSize - 1.0f;
+            float* out = faces.data() + row * faceSize * 4;
+            for (uint32_t x = 0; x < faceSize; ++x) {
+                const float u = 2.0f * (x + 0.5f) / faceSize - 1.0f;
+                const glm::vec3 d = glm::normalize(getFaceDirection(face, u, v));
+
+                // panorama coordinates in texels, texel centers at + 0.5
+                const float longitude = std::atan2(d.x, -d.z);                  // [-pi, pi]
+                const float latitude = std::acos(std::clamp(d.y, -1.0f, 1.0f)); // 0 up, pi down
+                const float px = (longitude / (2.0f * Pi) + 0.5f) * width - 0.5f;
+                const float py = latitude / Pi * height - 0.5f;
+
+                const float fx = std::floor(px), fy = std::floor(py);
+                const float tx = px - fx, ty = py - fy;
+                const int ix = static_cast<int>(fx), iy = static_cast<int>(fy);
+                const uint32_t x0 = static_cast<uint32_t>((ix % int(width) + int(width)) % int(width));
+                const uint32_t x1 = (x0 + 1) % width;
+                const uint32_t y0 = static_cast<uint32_t>(std::clamp(iy, 0, int(height) - 1));
+                const uint32_t y1 = static_cast<uint32_t>(std::clamp(iy + 1, 0, int(height) - 1));
+                const float* p00 = rgba + (size_t(y0) * width + x0) * 4;
+                const float* p10 = rgba + (size_t(y0) * width + x1) * 4;
+                const float* p01 = rgba + (size_t(y1) * width + x0) * 4;
+                const float* p11 = rgba + (size_t(y1) * width + x1) * 4;
+                for (int c = 0; c < 4; ++c) {
+                    const float top = p00[c] + (p10[c] - p00[c]) * tx;
+                    const float bottom = p01[c] + (p11[c] - p01[c]) * tx;
+                    out[4 * x + c] = top + (bottom - top) * ty;
+                }
+            }
+        }
+    });
+}
+
+void EnvironmentMap::generateMips(std::vector<float> faces, uint32_t faceSize, std::vector<std::vector<float>>& levels) {
+    const uint32_t levelCount = MipGenerator::getLevelCount(faceSize, faceSize);
+    levels.resize(levelCount);
+    levels[0] = std::move(faces);
+    for (uint32_t level = 1; level < levelCount; ++level) {
+        const uint32_t srcSize = MipGenerator::getLevelSize(faceSize, level - 1);
+        const uint32_t dstSize = MipGenerator::getLevelSize(faceSize, level);
+        const float* src = levels[level - 1].data();
+        levels[level].resize(size_t(6) * dstSize * dstSize * 4);
+        float* dst = levels[level].data();
+
+        Parallel::forRanges(size_t(6) * dstSize, MinRangeRows, [&](size_t begin, size_t end) {
+            for (size_t row = begin; row < end; ++row) {
+                const size_t face = row / dstSize;
+                const uint32_t y = static_cast<uint32_t>(row % dstSize);
+                const float* face0 = src + face * srcSize * srcSize * 4;
+                const float* row0 = face0 + size_t(std::min(2 * y, srcSize - 1)) * srcSize * 4;
+                const float* row1 = face0 + size_t(std::min(2 * y + 1, srcSize - 1)) * srcSize * 4;
+                float* out = dst + row * dstSize * 4;
+                for (uint32_t x = 0; x < dstSize; ++x) {
+                    const uint32_t x0 = std::min(2 * x, srcSize - 1) * 4;
+                    const uint32_t x1 = std::min(2 * x + 1, srcSize - 1) * 4;
+                    for (uint32_t c = 0; c < 4; ++c) {
+                        out[4 * x + c] = 0.25f * (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c]);
+                    }
+                }
+            }
+        });
+    }
+}
+
+glm::vec4 EnvironmentMap::sampleCube(const std::vector<std::vector<float>>& levels, uint32_t faceSize, const glm::vec3& direction, float lod) {
+    // inverse of getFaceDirection: the major axis picks the face
+    const glm::vec3 a = glm::abs(direction);
+    uint32_t face;
+    float u, v, major;
+    if (a.x >= a.y && a.x >= a.z) {
+        face = direction.x > 0.0f ? 0 : 1;
+        major = a.x;
+        u = direction.x > 0.0f ? -direction.z : direction.z;
+        v = -direction.y;
+    }
+    else if (a.y >= a.z) {
+        face = direction.y > 0.0f ? 2 : 3;
+        major = a.y;
+        u = direction.x;
+        v = direction.y > 0.0f ? direction.z : -direction.z;
+    }
+    else {
+        face = direction.z > 0.0f ? 4 : 5;
+        major = a.z;
+        u = direction.z > 0.0f ? direction.x : -direction.x;
+        v = -direction.y;
+    }
+    u /= major;
+    v /= major;
+
+    const float maxLod = float(levels.size() - 1);
+    const float clamped = std::clamp(lod, 0.0f, maxLod);
+    const uint32_t level0 = static_cast<uint32_t>(clamped);
+    const uint32_t level1 = std::min(level0 + 1, static_cast<uint32_t>(levels.size() - 1));
+    const float t = clamped - level0;
+    const uint32_t size0 = MipGenerator::getLevelSize(faceSize, level0);
+    const uint32_t size1 = MipGenerator::getLevelSize(faceSize, level1);
+    const glm::vec4 c0 = sampleFace(levels[level0].data() + size_t(face) * size0 * size0 * 4, size0, u, v);
+    if (t == 0.0f) return c0;
+    const glm::vec4 c1 = sampleFace(levels[level1].data() + size_t(face) * size1 * size1 * 4, size1, u, v);
+    return c0 + (c1 - c0) * t;
+}
+
+void EnvironmentMap::prefilterSpecular(const std::vector<std::vector<float>>& levels, uint32_t faceSize, uint32_t outSize,
+                                       uint32_t levelCount, uint32_t sampleCount, std::vector<std::vector<float>>& out) {
+    const float texelSolidAngle = 4.0f * Pi / (6.0f * faceSize * faceSize);
+    const float maxLod = float(levels.size() - 1);
+    out.resize(levelCount);
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        const uint32_t size = MipGenerator::getLevelSize(outSize, level);
+        const float roughness = levelCount > 1 ? float(level) / float(levelCount - 1) : 0.0f;
+        const float a = roughness * roughness;
+        const float a2 = a * a;
+        out[level].resize(size_t(6) * size * size * 4);
+
+        Parallel::forRanges(size_t(6) * size, 1, [&](size_t begin, size_t end) {
+            for (size_t row = begin; row < end; ++row) {
+                const uint32_t face = static_cast<uint32_t>(row / size);
+                const float v = 2.0f * (row % size + 0.5f) / size - 1.0f;
+                float* dst = out[level].data() + row * size * 4;
+                for (uint32_t x = 0; x < size; ++x) {
+                    const float u = 2.0f * (x + 0.5f) / size - 1.0f;
+                    const glm::vec3 n = glm::normalize(getFaceDirection(face, u, v));
+                    glm::vec3 color(0.0f);
+                    if (roughness == 0.0f) {
+                        const float mirrorLod = std::max(std::log2(float(faceSize) / size), 0.0f);
+                        color = glm::vec3(sampleCube(levels, faceSize, n, mirrorLod));
+                    }
+                    else {
+                        float weight = 0.0f;
+                        for (uint32_t i = 0; i < sampleCount; ++i) {
+                            const glm::vec3 h = importanceSampleGgx(hammersley(i, sampleCount), n, a);
+                            const float nh = glm::dot(n, h);
+                            const glm::vec3 l = 2.0f * nh * h - n;
+                            const float nl = glm::dot(n, l);
+                            if (nl <= 0.0f) continue;
+                            // pdf = D nh / (4 vh) with v = n: D / 4
+                            const float d = nh * nh * (a2 - 1.0f) + 1.0f;
+                            const float pdf = a2 / (Pi * d * d) * 0.25f;
+                            const float sampleSolidAngle = 1.0f / (sampleCount * pdf + 0.0001f);
+                            const float lod = std::clamp(0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1.0f, 0.0f, maxLod);
+                            color += glm::vec3(sampleCube(levels, faceSize, l, lod)) * nl;
+                            weight += nl;
+                        }
+                        color /= std::max(weight, 0.0001f);
+                    }
+                    dst[4 * x + 0] = color.r;
+                    dst[4 * x + 1] = color.g;
+                    dst[4 * x + 2] = color.b;
+                    dst[4 * x + 3] = 1.0f;
+                }
+            }
+        });
+    }
+}
+
+void EnvironmentMap::integrateBrdf(uint32_t size, uint32_t sampleCount, std::vector<float>& rg) {
+    rg.resize(size_t(size) * size * 2);
+    const glm::vec3 n(0.0f, 0.0f, 1.0f);
+    Parallel::forRanges(size, MinRangeRows, [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; ++y) {
+            const float roughness = (y + 0.5f) / size;
+            const float a = roughness * roughness;
+            const float k = a * 0.5f; // Schlick-GGX for image based lighting
+            for (uint32_t x = 0; x < size; ++x) {
+                const float nv = (x + 0.5f) / size;
+                const glm::vec3 v(std::sqrt(1.0f - nv * nv), 0.0f, nv);
+                float scale = 0.0f;
+                float bias = 0.0f;
+                for (uint32_t i = 0; i < sampleCount; ++i) {
+                    const glm::vec3 h = importanceSampleGgx(hammersley(i, sampleCount), n, a);
+                    const float vh = glm::dot(v, h);
+                    const glm::vec3 l = 2.0f * vh * h - v;
+                    const float nl = l.z;
+                    if (nl <= 0.0f) continue;
+                    const float nh = std::max(h.z, 0.0f);
+                    const float g = nv / (nv * (1.0f - k) + k) * nl / (nl * (1.0f - k) + k);
+                    // BRDF * nl / pdf with pdf = D nh / (4 vh)
+                    const float gVis = g * std::max(vh, 0.0f) / (nh * nv + 0.0001f);
+                    const float fc = std::pow(1.0f - std::max(vh, 0.0f), 5.0f);
+                    scale += (1.0f - fc) * gVis;
+                    bias += fc * gVis;
+                }
+                rg[(y * size + x) * 2 + 0] = scale / sampleCount;
+                rg[(y * size + x) * 2 + 1] = bias / sampleCount;
+            }
+        }
+    });
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+// HDR environments: equirectangular (latitude / longitude) panoramas resampled to cubemaps of float
+// texels, their mip chains and GGX prefiltered levels (and the BRDF table that goes with them). Faces
+// in layer order +x -x +y -y +z -z with the WebGPU cube conventions; the rows of all 6 faces run in
+// parallel (Parallel::forRanges).
+class EnvironmentMap
+{
+public:
+    // direction through (u, v) in [-1, 1] of a face, v pointing down the rows; not normalized
+    static glm::vec3 getFaceDirection(uint32_t face, float u, float v);
+
+    // rgba: width x height, +y up, longitude 0 (the image center) looking down -z. faces: 6 * faceSize^2 rgba,
+    // bilinear (wrapping around in longitude)
+    static void equirectToCubemap(const float* rgba, uint32_t width, uint32_t height, uint32_t faceSize, std::vector<float>& faces);
+
+    // levels[0] is faces, then 2x2 box filtered levels down to 1x1 (6 faces each)
+    static void generateMips(std::vector<float> faces, uint32_t faceSize, std::vector<std::vector<float>>& levels);
+
+    // levels as generateMips makes them: bilinear inside the face the direction hits (clamped at its
+    // edges), linear between the two levels around lod
+    static glm::vec4 sampleCube(const std::vector<std::vector<float>>& levels, uint32_t faceSize, const glm::vec3& direction, float lod);
+
+    // CPU reference of files/prefilter.wgsl (SpecularPrefilter): out[l] is the environment convolved with
+    // the GGX lobe of roughness l / (levelCount - 1), 6 faces of outSize >> l, sampleCount samples per texel
+    static void prefilterSpecular(const std::vector<std::vector<float>>& levels, uint32_t faceSize, uint32_t outSize,
+                                  uint32_t levelCount, uint32_t sampleCount, std::vector<std::vector<float>>& out);
+
+    // CPU fallback of files/brdflut.wgsl (BrdfLut): size x size texels of (scale, bias) of F0 in the split
+    // sum GGX specular integral, NdotV along the rows, roughness down the columns, texel centers
+    static void integrateBrdf(uint32_t size, uint32_t sampleCount, std::vector<float>& rg);
+};
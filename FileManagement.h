@@ -6,14 +6,11 @@
 #include <string>
 
 #include <webgpu/webgpu.hpp>
-#include "VertexAttr.h"
-#include "tiny_obj_loader.h"
 
 class FileManagement
 {
 public:
-
-    static bool getObjGeometry(const std::filesystem::path& path, std::vector<VertexAttr>& vertexData);
+    // mesh files are read by MeshImporter, which has no GPU code and is shared with AssetCooker
 
     static wgpu::ShaderModule loadShaderModule(
         const std::filesystem::path& filepath,
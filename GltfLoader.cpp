@@ -0,0 +1,487 @@
+#include "GltfLoader.h"
+#include "Json.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <glm/geometric.hpp>
+#include <glm/matrix.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace {
+
+    const uint32_t GlbMagic = 0x46546C67; // "glTF"
+    const uint32_t GlbChunkJson = 0x4E4F534A;
+    const uint32_t GlbChunkBin = 0x004E4942;
+
+    struct BufferRange {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+    };
+
+    struct BufferView {
+        BufferRange range;
+        uint32_t stride = 0; // 0: tightly packed
+    };
+
+    uint32_t readU32(const uint8_t* p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    // "%20" -> ' ', URIs are relative to the glTF file
+    std::filesystem::path resolveUri(const std::filesystem::path& gltfPath, const std::string& uri) {
+        std::string decoded;
+        for (size_t i = 0; i < uri.size(); ++i) {
+            if (uri[i] == '%' && i + 2 < uri.size() && std::isxdigit((unsigned char)uri[i + 1]) && std::isxdigit((unsigned char)uri[i + 2])) {
+                decoded.push_back(static_cast<char>(std::strtol(uri.substr(i + 1, 2).c_str(), nullptr, 16)));
+                i += 2;
+            }
+            else {
+                decoded.push_back(uri[i]);
+            }
+        }
+        return (gltfPath.parent_path() / std::filesystem::u8path(decoded)).lexically_normal();
+    }
+
+    bool decodeBase64(const std::string& text, size_t start, std::vector<uint8_t>& out) {
+        auto value = [](char c) -> int {
+            if (c >= 'A' && c <= 'Z') return c - 'A';
+            if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+            if (c >= '0' && c <= '9') return c - '0' + 52;
+            if (c == '+') return 62;
+            if (c == '/') return 63;
+            return -1;
+        };
+        out.clear();
+        out.reserve((text.size() - start) / 4 * 3);
+        uint32_t bits = 0;
+        int count = 0;
+        for (size_t i = start; i < text.size() && text[i] != '='; ++i) {
+            const int v = value(text[i]);
+            if (v < 0) return false;
+            bits = (bits << 6) | uint32_t(v);
+            if (++count == 4) {
+                out.push_back(uint8_t(bits >> 16));
+                out.push_back(uint8_t(bits >> 8));
+                out.push_back(uint8_t(bits));
+                bits = 0;
+                count = 0;
+            }
+        }
+        if (count == 2) out.push_back(uint8_t(bits >> 4));
+        if (count == 3) {
+            out.push_back(uint8_t(bits >> 10));
+            out.push_back(uint8_t(bits >> 2));
+        }
+        return count != 1;
+    }
+
+    uint32_t getComponentSize(uint32_t componentType) {
+        switch (componentType) {
+        case GltfAccessor::Byte: case GltfAccessor::UnsignedByte: return 1;
+        case GltfAccessor::Short: case GltfAccessor::UnsignedShort: return 2;
+        case GltfAccessor::UnsignedInt: case GltfAccessor::Float: return 4;
+        }
+        return 0;
+    }
+
+    uint32_t getComponentCount(const std::string& type) {
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2") return 2;
+        if (type == "VEC3") return 3;
+        if (type == "VEC4") return 4;
+        return 0; // matrices are not vertex / index data
+    }
+
+    glm::mat4 getNodeMatrix(const JsonValue& node) {
+        const JsonValue& matrix = node["matrix"];
+        if (matrix.size() == 16) {
+            glm::mat4 m;
+            for (int i = 0; i < 16; ++i) glm::value_ptr(m)[i] = float(matrix[i].getNumber()); // column major
+            return m;
+        }
+        const JsonValue& t = node["translation"];
+        const JsonValue& r = node["rotation"];
+        const JsonValue& s = node["scale"];
+        const glm::vec3 translation = t.size() == 3 ? glm::vec3(t[0].getNumber(), t[1].getNumber(), t[2].getNumber()) : glm::vec3(0.0f);
+        // glTF stores x, y, z, w
+        const glm::quat rotation = r.size() == 4 ? glm::quat(float(r[3].getNumber()), float(r[0].getNumber()), float(r[1].getNumber()), float(r[2].getNumber())) : glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        const glm::vec3 scale = s.size() == 3 ? glm::vec3(s[0].getNumber(1.0), s[1].getNumber(1.0), s[2].getNumber(1.0)) : glm::vec3(1.0f);
+
+        glm::mat4 m = glm::mat4_cast(rotation);
+        m[0] *= scale.x;
+        m[1] *= scale.y;
+        m[2] *= scale.z;
+        m[3] = glm::vec4(translation, 1.0f);
+        return m;
+    }
+
+    class Parser
+    {
+    public:
+        Parser(const std::filesystem::path& path, const JsonValue& json, GltfModel& model)
+            : path(path), json(json), model(model) {}
+
+        bool loadBuffers(BufferRange glbChunk) {
+            const JsonValue& buffers = json["buffers"];
+            for (size_t i = 0; i < buffers.size(); ++i) {
+                const JsonValue& buffer = buffers[i];
+                const std::string& uri = buffer["uri"].getString();
+                const size_t byteLength = size_t(buffer["byteLength"].getInt(0));
+                BufferRange range;
+
+                if (uri.empty()) {
+                    // the GLB binary chunk
+                    range = glbChunk;
+                }
+                else if (uri.compare(0, 5, "data:") == 0) {
+                    const size_t comma = uri.find(";base64,");
+                    model.decodedBuffers.emplace_back();
+                    if (comma == std::string::npos || !decodeBase64(uri, comma + 8, model.decodedBuffers.back())) {
+                        std::cerr << path << ": unsupported data URI in buffer " << i << std::endl;
+                        return false;
+                    }
+                    range = { model.decodedBuffers.back().data(), model.decodedBuffers.back().size() };
+                }
+                else {
+                    auto file = std::make_unique<MappedFile>();
+                    if (!file->open(resolveUri(path, uri))) {
+                        std::cerr << path << ": could not open buffer " << uri << std::endl;
+                        return false;
+                    }
+                    range = { file->data(), file->size() };
+                    model.files.push_back(std::move(file));
+                }
+                if (range.size < byteLength) {
+                    std::cerr << path << ": buffer " << i << " is shorter than its byteLength" << std::endl;
+                    return false;
+                }
+                buffersRanges.push_back({ range.data, byteLength });
+            }
+
+            const JsonValue& views = json["bufferViews"];
+            for (size_t i = 0; i < views.size(); ++i) {
+                const JsonValue& view = views[i];
+                const int64_t buffer = view["buffer"].getInt();
+                const uint64_t offset = uint64_t(view["byteOffset"].getInt(0));
+                const uint64_t length = uint64_t(view["byteLength"].getInt(0));
+                if (buffer < 0 || size_t(buffer) >= buffersRanges.size() || offset + length > buffersRanges[buffer].size) {
+                    std::cerr << path << ": buffer view " << i << " out of range" << std::endl;
+                    return false;
+                }
+                bufferViews.push_back({ { buffersRanges[buffer].data + offset, size_t(length) }, uint32_t(view["byteStride"].getInt(0)) });
+            }
+            return true;
+        }
+
+        bool getAccessor(const JsonValue& index, GltfAccessor& accessor) {
+            accessor = GltfAccessor();
+            if (index.isNull()) return true; // optional attribute
+
+            const JsonValue& a = json["accessors"][size_t(index.getInt())];
+            const int64_t view = a["bufferView"].getInt();
+            accessor.count = uint32_t(a["count"].getInt(0));
+            accessor.componentType = uint32_t(a["componentType"].getInt(0));
+            accessor.componentCount = getComponentCount(a["type"].getString());
+            accessor.normalized = a["normalized"].getBool();
+            const uint32_t elementSize = accessor.getElementSize();
+
+            // sparse accessors and accessors without a buffer view (all zeros) are not supported
+            if (!a["sparse"].isNull() || view < 0 || size_t(view) >= bufferViews.size() || elementSize == 0) {
+                std::cerr << path << ": unsupported accessor " << index.getInt() << std::endl;
+                return false;
+            }
+            const BufferView& bufferView = bufferViews[view];
+            const uint64_t offset = uint64_t(a["byteOffset"].getInt(0));
+            accessor.stride = bufferView.stride ? bufferView.stride : elementSize;
+            if (accessor.count > 0 && offset + uint64_t(accessor.stride) * (accessor.count - 1) + elementSize > bufferView.range.size) {
+                std::cerr << path << ": accessor " << index.getInt() << " out of range" << std::endl;
+                return false;
+            }
+            accessor.data = bufferView.range.data + offset;
+
+            const JsonValue& min = a["min"];
+            const JsonValue& max = a["max"];
+            if (min.size() >= 3 && max.size() >= 3) {
+                accessor.hasBounds = true;
+                for (int c = 0; c < 3; ++c) {
+                    accessor.min[c] = float(min[c].getNumber());
+                    accessor.max[c] = float(max[c].getNumber());
+                }
+            }
+            return true;
+        }
+
+        // image file of a texture reference ({ "index": n }), empty if none / embedded
+        std::string getTexturePath(const JsonValue& textureInfo) {
+            if (textureInfo.isNull()) return std::string();
+            const JsonValue& texture = json["textures"][size_t(textureInfo["index"].getInt())];
+            const JsonValue& image = json["images"][size_t(texture["source"].getInt())];
+            const std::string& uri = image["uri"].getString();
+            if (uri.empty() || uri.compare(0, 5, "data:") == 0) {
+                if (!image.isNull()) std::cerr << path << ": embedded images are not supported" << std::endl;
+                return std::string();
+            }
+            return resolveUri(path, uri).string();
+        }
+
+        void loadMaterials() {
+            const JsonValue& materials = json["materials"];
+            for (size_t i = 0; i < materials.size(); ++i) {
+                const JsonValue& material = materials[i];
+                const JsonValue& pbr = material["pbrMetallicRoughness"];
+                const JsonValue& baseColor = pbr["baseColorFactor"];
+
+                MeshMaterial m;
+                m.name = material["name"].getString();
+                if (baseColor.size() >= 3) {
+                    m.diffuse = glm::vec3(baseColor[0].getNumber(1.0), baseColor[1].getNumber(1.0), baseColor[2].getNumber(1.0));
+                }
+                // glTF defaults: fully metallic and rough when not given
+                m.metallic = float(pbr["metallicFactor"].getNumber(1.0));
+                m.roughness = float(pbr["roughnessFactor"].getNumber(1.0));
+                m.diffuseTexture = getTexturePath(pbr["baseColorTexture"]);
+                m.normalTexture = getTexturePath(material["normalTexture"]);
+                // roughness in G, metallic in B
+                m.roughnessTexture = getTexturePath(pbr["metallicRoughnessTexture"]);
+                // occlusion in R, often the same image
+                m.occlusionTexture = getTexturePath(material["occlusionTexture"]);
+                model.materials.push_back(m);
+            }
+        }
+
+        bool addNode(size_t nodeIndex, const glm::mat4& parent, int depth) {
+            const JsonValue& node = json["nodes"][nodeIndex];
+            if (node.isNull() || depth > 64) {
+                std::cerr << path << ": invalid node hierarchy" << std::endl;
+                return false;
+            }
+            const glm::mat4 transform = parent * getNodeMatrix(node);
+
+            if (!node["mesh"].isNull()) {
+                const JsonValue& primitives = json["meshes"][size_t(node["mesh"].getInt())]["primitives"];
+                for (size_t i = 0; i < primitives.size(); ++i) {
+                    const JsonValue& primitive = primitives[i];
+                    if (primitive["mode"].getInt(4) != 4) {
+                        std::cerr << path << ": skipping a non-triangle primitive" << std::endl;
+                        continue;
+                    }
+                    const JsonValue& attributes = primitive["attributes"];
+                    GltfPrimitive p;
+                    if (!getAccessor(attributes["POSITION"], p.position) || !getAccessor(attributes["NORMAL"], p.normal)
+                        || !getAccessor(attributes["TEXCOORD_0"], p.uv) || !getAccessor(attributes["COLOR_0"], p.color)
+                        || !getAccessor(primitive["indices"], p.indices)) {
+                        return false;
+                    }
+                    if (!p.position.is(GltfAccessor::Float, 3)) {
+                        std::cerr << path << ": skipping a primitive without float3 positions" << std::endl;
+                        continue;
+                    }
+                    // attributes must cover every vertex
+                    const uint32_t vertexCount = p.position.count;
+                    for (GltfAccessor* attribute : { &p.normal, &p.uv, &p.color }) {
+                        if (attribute->data && attribute->count < vertexCount) *attribute = GltfAccessor();
+                    }
+                    if (p.indices.data && (p.indices.componentCount != 1 || p.indices.componentType == GltfAccessor::Float)) {
+                        std::cerr << path << ": invalid index accessor" << std::endl;
+                        return false;
+                    }
+                    p.materialId = int32_t(primitive["material"].getInt(-1));
+                    if (p.materialId >= int32_t(model.materials.size())) p.materialId = -1;
+                    p.transform = transform;
+                    model.primitives.push_back(p);
+                }
+            }
+
+            const JsonValue& children = node["children"];
+            for (size_t i = 0; i < children.size(); ++i) {
+                if (!addNode(size_t(children[i].getInt()), transform, depth + 1)) return false;
+            }
+            return true;
+        }
+
+        bool loadScene() {
+            const JsonValue& scenes = json["scenes"];
+            const JsonValue& nodes = json["nodes"];
+            std::vector<size_t> roots;
+            if (scenes.size() > 0) {
+                const JsonValue& scene = scenes[size_t(json["scene"].getInt(0))];
+                for (size_t i = 0; i < scene["nodes"].size(); ++i) roots.push_back(size_t(scene["nodes"][i].getInt()));
+            }
+            else {
+                // no scene: every node that is nobody's child
+                std::vector<char> isChild(nodes.size(), 0);
+                for (size_t i = 0; i < nodes.size(); ++i) {
+                    const JsonValue& children = nodes[i]["children"];
+                    for (size_t c = 0; c < children.size(); ++c) {
+                        const size_t child = size_t(children[c].getInt());
+                        if (child < isChild.size()) isChild[child] = 1;
+                    }
+                }
+                for (size_t i = 0; i < nodes.size(); ++i) if (!isChild[i]) roots.push_back(i);
+            }
+            for (size_t root : roots) {
+                if (!addNode(root, glm::mat4(1.0f), 0)) return false;
+            }
+            return true;
+        }
+
+    private:
+        const std::filesystem::path& path;
+        const JsonValue& json;
+        GltfModel& model;
+        std::vector<BufferRange> buffersRanges;
+        std::vector<BufferView> bufferViews;
+    };
+}
+
+uint32_t GltfAccessor::getElementSize() const {
+    return getComponentSize(componentType) * componentCount;
+}
+
+float GltfAccessor::getFloat(uint32_t i, uint32_t c) const {
+    const uint8_t* p = data + size_t(i) * stride + c * getComponentSize(componentType);
+    switch (componentType) {
+    case Float: { float v; std::memcpy(&v, p, 4); return v; }
+    case UnsignedByte: return normalized ? *p / 255.0f : float(*p);
+    case Byte: { const float v = float(int8_t(*p)); return normalized ? std::max(v / 127.0f, -1.0f) : v; }
+    case UnsignedShort: { uint16_t v; std::memcpy(&v, p, 2); return normalized ? v / 65535.0f : float(v); }
+    case Short: { int16_t v; std::memcpy(&v, p, 2); return normalized ? std::max(v / 32767.0f, -1.0f) : float(v); }
+    case UnsignedInt: return float(readU32(p));
+    }
+    return 0.0f;
+}
+
+uint32_t GltfAccessor::getIndex(uint32_t i) const {
+    const uint8_t* p = data + size_t(i) * stride;
+    switch (componentType) {
+    case UnsignedByte: return *p;
+    case UnsignedShort: { uint16_t v; std::memcpy(&v, p, 2); return v; }
+    case UnsignedInt: return readU32(p);
+    }
+    return 0;
+}
+
+bool GltfLoader::load(const std::filesystem::path& path, GltfModel& model) {
+    model = GltfModel();
+    auto file = std::make_unique<MappedFile>();
+    if (!file->open(path)) {
+        std::cerr << "Could not open " << path << std::endl;
+        return false;
+    }
+    const uint8_t* data = file->data();
+    const size_t size = file->size();
+
+    // GLB: 12 byte header, JSON chunk, optional BIN chunk
+    const char* jsonBegin = reinterpret_cast<const char*>(data);
+    const char* jsonEnd = jsonBegin + size;
+    BufferRange binChunk;
+    if (size >= 12 && readU32(data) == GlbMagic) {
+        if (readU32(data + 4) != 2 || readU32(data + 8) > size || size < 20) {
+            std::cerr << path << ": unsupported GLB" << std::endl;
+            return false;
+        }
+        const size_t length = readU32(data + 8);
+        const size_t jsonLength = readU32(data + 12);
+        if (readU32(data + 16) != GlbChunkJson || 20 + jsonLength > length) {
+            std::cerr << path << ": GLB without JSON chunk" << std::endl;
+            return false;
+        }
+        jsonBegin = reinterpret_cast<const char*>(data + 20);
+        jsonEnd = jsonBegin + jsonLength;
+
+        const size_t binOffset = 20 + ((jsonLength + 3) & ~size_t(3));
+        if (binOffset + 8 <= length && readU32(data + binOffset + 4) == GlbChunkBin) {
+            const size_t binLength = readU32(data + binOffset);
+            if (binOffset + 8 + binLength <= length) binChunk = { data + binOffset + 8, binLength };
+        }
+    }
+
+    JsonValue json;
+    std::string error;
+    if (!JsonValue::parse(jsonBegin, jsonEnd, json, error)) {
+        std::cerr << path << ": " << error << std::endl;
+        return false;
+    }
+    model.files.push_back(std::move(file)); // keeps the binary chunk mapped
+
+    Parser parser(path, json, model);
+    if (!parser.loadBuffers(binChunk)) return false;
+    parser.loadMaterials();
+    if (!parser.loadScene()) return false;
+
+    // draw ranges are batched by material
+    std::stable_sort(model.primitives.begin(), model.primitives.end(),
+        [](const GltfPrimitive& a, const GltfPrimitive& b) { return a.materialId < b.materialId; });
+
+    std::cout << path.filename().string() << ": " << model.primitives.size() << " primitives, "
+        << model.materials.size() << " materials" << std::endl;
+    return !model.primitives.empty();
+}
+
+bool GltfLoader::isDirectlyDrawable(const GltfModel& model) {
+    if (model.primitives.empty()) return false;
+    const GltfPrimitive& first = model.primitives[0];
+    for (const GltfPrimitive& p : model.primitives) {
+        const bool tight = p.position.is(GltfAccessor::Float, 3) && p.position.isTight() && p.normal.is(GltfAccessor::Float, 3) && p.normal.isTight()
+            && p.uv.is(GltfAccessor::Float, 2) && p.uv.isTight();
+        const bool indices = p.indices.data && p.indices.isTight() && p.indices.componentType == first.indices.componentType
+            && (p.indices.componentType == GltfAccessor::UnsignedShort || p.indices.componentType == GltfAccessor::UnsignedInt);
+        if (!tight || !indices || p.color.data || p.transform != first.transform) return false;
+    }
+    // a mirroring transform would flip the winding the pipeline culls with
+    return glm::determinant(glm::mat3(first.transform)) > 0.0f;
+}
+
+void GltfLoader::getGeometry(const GltfModel& model, MeshData& mesh) {
+    mesh = MeshData();
+    mesh.materials = model.materials;
+
+    for (const GltfPrimitive& p : model.primitives) {
+        const uint32_t base = static_cast<uint32_t>(mesh.vertices.size());
+        const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(p.transform)));
+
+        for (uint32_t i = 0; i < p.position.count; ++i) {
+            VertexAttr v;
+            v.position = glm::vec3(p.transform * glm::vec4(p.position.getFloat(i, 0), p.position.getFloat(i, 1), p.position.getFloat(i, 2), 1.0f));
+            v.color = p.color.data ? glm::vec3(p.color.getFloat(i, 0), p.color.getFloat(i, 1), p.color.getFloat(i, 2)) : glm::vec3(1.0f);
+            // zero: MeshNormals fills it in
+            v.normal = p.normal.data ? normalMatrix * glm::vec3(p.normal.getFloat(i, 0), p.normal.getFloat(i, 1), p.normal.getFloat(i, 2)) : glm::vec3(0.0f);
+            if (p.normal.data && glm::dot(v.normal, v.normal) > 0.0f) v.normal = glm::normalize(v.normal);
+            v.uv = p.uv.data ? glm::vec2(p.uv.getFloat(i, 0), p.uv.getFloat(i, 1)) : glm::vec2(0.0f);
+            mesh.vertices.push_back(v);
+        }
+
+        // mirroring transforms flip the winding
+        const bool flip = glm::determinant(glm::mat3(p.transform)) < 0.0f;
+        const uint32_t cornerCount = p.indices.data ? p.indices.count : p.position.count;
+        if (mesh.submeshes.empty() || mesh.submeshes.back().materialId != p.materialId) {
+            Submesh submesh;
+            submesh.indexOffset = static_cast<uint32_t>(mesh.indices.size());
+            submesh.materialId = p.materialId;
+            mesh.submeshes.push_back(submesh);
+        }
+        for (uint32_t i = 0; i + 2 < cornerCount; i += 3) {
+            uint32_t corner[3];
+            for (int k = 0; k < 3; ++k) corner[k] = p.indices.data ? p.indices.getIndex(i + k) : i + k;
+            if (corner[0] >= p.position.count || corner[1] >= p.position.count || corner[2] >= p.position.count) continue;
+            if (flip) std::swap(corner[1], corner[2]);
+            mesh.indices.insert(mesh.indices.end(), { base + corner[0], base + corner[1], base + corner[2] });
+        }
+        mesh.submeshes.back().indexCount = static_cast<uint32_t>(mesh.indices.size()) - mesh.submeshes.back().indexOffset;
+    }
+
+    if (mesh.vertices.empty()) return;
+    mesh.boundsMin = mesh.vertices[0].position;
+    mesh.boundsMax = mesh.vertices[0].position;
+    for (const VertexAttr& v : mesh.vertices) {
+        mesh.boundsMin = glm::min(mesh.boundsMin, v.position);
+        mesh.boundsMax = glm::max(mesh.boundsMax, v.position);
+    }
+}
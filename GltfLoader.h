@@ -0,0 +1,69 @@
+#pragma once
+#include <filesystem>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <glm/mat4x4.hpp>
+
+#include "MeshData.h"
+#include "MappedFile.h"
+
+// typed view of an accessor inside one of GltfModel's buffers (data == nullptr: attribute absent)
+struct GltfAccessor {
+    // glTF / GL component types
+    static constexpr uint32_t Byte = 5120, UnsignedByte = 5121, Short = 5122, UnsignedShort = 5123,
+        UnsignedInt = 5125, Float = 5126;
+
+    const uint8_t* data = nullptr; // first element
+    uint32_t count = 0;
+    uint32_t componentType = 0;
+    uint32_t componentCount = 0; // SCALAR 1, VEC2 2, VEC3 3, VEC4 4
+    uint32_t stride = 0;         // bytes between elements
+    bool normalized = false;
+    bool hasBounds = false;      // min / max of the first three components
+    float min[3] = {};
+    float max[3] = {};
+
+    uint32_t getElementSize() const;
+    // elements are packed back to back: the range can be uploaded as is
+    bool isTight() const { return stride == getElementSize(); }
+    bool is(uint32_t type, uint32_t components) const { return data && componentType == type && componentCount == components; }
+    // component c of element i as float (normalized integers are mapped to [0, 1] / [-1, 1])
+    float getFloat(uint32_t i, uint32_t c) const;
+    uint32_t getIndex(uint32_t i) const;
+};
+
+// triangle primitive of a mesh instance in the scene
+struct GltfPrimitive {
+    GltfAccessor position;
+    GltfAccessor normal;
+    GltfAccessor uv;      // TEXCOORD_0
+    GltfAccessor color;   // COLOR_0
+    GltfAccessor indices; // absent: non indexed
+    int32_t materialId = -1;
+    glm::mat4 transform = glm::mat4(1.0f); // world matrix of the node
+};
+
+// A loaded .gltf / .glb. Accessors point into the memory-mapped files (GLB binary chunk,
+// external .bin buffers) or decoded data: URIs, all owned by the model.
+struct GltfModel {
+    std::vector<GltfPrimitive> primitives; // sorted by material
+    std::vector<MeshMaterial> materials;   // metallic-roughness, textures resolved to file paths
+
+    std::vector<std::unique_ptr<MappedFile>> files;
+    std::vector<std::vector<uint8_t>> decodedBuffers;
+};
+
+class GltfLoader
+{
+public:
+    // parses the JSON, maps the buffers and flattens the default scene's node hierarchy
+    static bool load(const std::filesystem::path& path, GltfModel& model);
+
+    // true when every primitive can be uploaded straight from the file: tight float32 POSITION,
+    // NORMAL and TEXCOORD_0, no COLOR_0, tight indices of one type and one shared, non mirroring node transform
+    static bool isDirectlyDrawable(const GltfModel& model);
+
+    // copies into an indexed MeshData with node transforms applied, one submesh per material
+    static void getGeometry(const GltfModel& model, MeshData& mesh);
+};
@@ -0,0 +1,176 @@
+#include "GpuMipGenerator.h"
+#include "FileManagement.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace wgpu;
+
+bool GpuMipGenerator::initialize(Device targetDevice) {
+    device = targetDevice;
+    ShaderModule module = FileManagement::loadShaderModule("../files/mipmap.wgsl", device);
+    if (!module) {
+        std::cerr << "Mipmap shader module creation failed!" << std::endl;
+        return false;
+    }
+
+    std::vector<BindGroupLayoutEntry> layoutEntries(5, Default);
+    // 0. MipParams
+    layoutEntries[0].binding = 0;
+    layoutEntries[0].visibility = ShaderStage::Compute;
+    layoutEntries[0].buffer.type = BufferBindingType::Uniform;
+    layoutEntries[0].buffer.minBindingSize = sizeof(MipParams);
+    // 1. source level
+    layoutEntries[1].binding = 1;
+    layoutEntries[1].visibility = ShaderStage::Compute;
+    layoutEntries[1].texture.sampleType = TextureSampleType::UnfilterableFloat;
+    layoutEntries[1].texture.viewDimension = TextureViewDimension::_2DArray;
+    // 2. 3. 4. the levels below
+    for (uint32_t i = 2; i < 5; ++i) {
+        layoutEntries[i].binding = i;
+        layoutEntries[i].visibility = ShaderStage::Compute;
+        layoutEntries[i].storageTexture.access = StorageTextureAccess::WriteOnly;
+        layoutEntries[i].storageTexture.format = TextureFormat::RGBA8Unorm;
+        layoutEntries[i].storageTexture.viewDimension = TextureViewDimension::_2DArray;
+    }
+
+    BindGroupLayoutDescriptor layoutDesc{};
+    layoutDesc.entryCount = (uint32_t)layoutEntries.size();
+    layoutDesc.entries = layoutEntries.data();
+    bindGroupLayout = device.createBindGroupLayout(layoutDesc);
+
+    PipelineLayoutDescriptor pipelineLayoutDesc{};
+    pipelineLayoutDesc.bindGroupLayoutCount = 1;
+    pipelineLayoutDesc.bindGroupLayouts = (WGPUBindGroupLayout*)&bindGroupLayout;
+    PipelineLayout pipelineLayout = device.createPipelineLayout(pipelineLayoutDesc);
+
+    ComputePipelineDescriptor pipelineDesc;
+    pipelineDesc.label = "Mipmap Pipeline";
+    pipelineDesc.layout = pipelineLayout;
+    pipelineDesc.compute.module = module;
+    pipelineDesc.compute.entryPoint = "cs_mips";
+    pipelineDesc.compute.constantCount = 0;
+    pipelineDesc.compute.constants = nullptr;
+    pipeline = device.createComputePipeline(pipelineDesc);
+
+    pipelineLayout.release();
+    module.release();
+
+    TextureDescriptor dummyDesc;
+    dummyDesc.label = "Mipmap dummy output";
+    dummyDesc.dimension = TextureDimension::_2D;
+    dummyDesc.format = TextureFormat::RGBA8Unorm;
+    dummyDesc.mipLevelCount = 1;
+    dummyDesc.sampleCount = 1;
+    dummyDesc.size = { 1, 1, 1 };
+    dummyDesc.usage = TextureUsage::StorageBinding;
+    dummyDesc.viewFormatCount = 0;
+    dummyDesc.viewFormats = nullptr;
+    dummyTexture = device.createTexture(dummyDesc);
+    dummyView = createLevelView(dummyTexture, 0);
+    return true;
+}
+
+void GpuMipGenerator::release() {
+    if (!pipeline) return;
+    dummyView.release();
+    dummyTexture.destroy();
+    dummyTexture.release();
+    pipeline.release();
+    bindGroupLayout.release();
+    pipeline = nullptr;
+}
+
+TextureView GpuMipGenerator::createLevelView(Texture texture, uint32_t level) {
+    TextureViewDescriptor viewDesc;
+    viewDesc.aspect = TextureAspect::All;
+    viewDesc.baseArrayLayer = 0;
+    viewDesc.arrayLayerCount = texture.getDepthOrArrayLayers();
+    viewDesc.baseMipLevel = level;
+    viewDesc.mipLevelCount = 1;
+    viewDesc.dimension = TextureViewDimension::_2DArray;
+    viewDesc.format = TextureFormat::RGBA8Unorm;
+    return texture.createView(viewDesc);
+}
+
+void GpuMipGenerator::generate(Queue queue, Texture texture, bool srgb) {
+    const uint32_t levelCount = texture.getMipLevelCount();
+    if (!pipeline || levelCount < 2) return;
+    const uint32_t dispatchCount = (levelCount - 1 + LevelsPerDispatch - 1) / LevelsPerDispatch;
+
+    // the parameters of every dispatch in one uniform buffer
+    SupportedLimits limits;
+    device.getLimits(&limits);
+    const uint64_t alignment = limits.limits.minUniformBufferOffsetAlignment;
+    const uint64_t stride = (sizeof(MipParams) + alignment - 1) / alignment * alignment;
+    std::vector<uint8_t> paramData(dispatchCount * stride, 0);
+    for (uint32_t d = 0; d < dispatchCount; ++d) {
+        MipParams params{};
+        params.levelCount = std::min(LevelsPerDispatch, levelCount - 1 - d * LevelsPerDispatch);
+        params.srgb = srgb ? 1 : 0;
+        std::memcpy(paramData.data() + d * stride, &params, sizeof(params));
+    }
+    BufferDescriptor paramBufferDesc;
+    paramBufferDesc.label = "Mipmap Params";
+    paramBufferDesc.usage = BufferUsage::CopyDst | BufferUsage::Uniform;
+    paramBufferDesc.size = paramData.size();
+    paramBufferDesc.mappedAtCreation = false;
+    Buffer paramBuffer = device.createBuffer(paramBufferDesc);
+    queue.writeBuffer(paramBuffer, 0, paramData.data(), paramData.size());
+
+    std::vector<TextureView> views(levelCount);
+    for (uint32_t level = 0; level < levelCount; ++level) views[level] = createLevelView(texture, level);
+
+    CommandEncoderDescriptor encoderDesc = {};
+    encoderDesc.label = "mipmap encoder";
+    CommandEncoder encoder = device.createCommandEncoder(encoderDesc);
+    ComputePassDescriptor computePassDesc;
+    computePassDesc.timestampWrites = nullptr;
+    ComputePassEncoder computePass = encoder.beginComputePass(computePassDesc);
+    computePass.setPipeline(pipeline);
+
+    // dispatches see the levels written by the ones before
+    std::vector<BindGroup> bindGroups(dispatchCount);
+    for (uint32_t d = 0; d < dispatchCount; ++d) {
+        const uint32_t base = d * LevelsPerDispatch;
+        std::vector<BindGroupEntry> entries(5);
+        entries[0].binding = 0;
+        entries[0].buffer = paramBuffer;
+        entries[0].offset = d * stride;
+        entries[0].size = sizeof(MipParams);
+        entries[1].binding = 1;
+        entries[1].textureView = views[base];
+        for (uint32_t i = 0; i < LevelsPerDispatch; ++i) {
+            const uint32_t level = base + 1 + i;
+            entries[2 + i].binding = 2 + i;
+            entries[2 + i].textureView = level < levelCount ? views[level] : dummyView;
+        }
+
+        BindGroupDescriptor bindGroupDesc{};
+        bindGroupDesc.layout = bindGroupLayout;
+        bindGroupDesc.entryCount = (uint32_t)entries.size();
+        bindGroupDesc.entries = entries.data();
+        bindGroups[d] = device.createBindGroup(bindGroupDesc);
+
+        // @workgroup_size(8, 8): one workgroup per 8x8 texels of the first level written
+        const uint32_t width = std::max(1u, texture.getWidth() >> (base + 1));
+        const uint32_t height = std::max(1u, texture.getHeight() >> (base + 1));
+        computePass.setBindGroup(0, bindGroups[d], 0, nullptr);
+        computePass.dispatchWorkgroups((width + 7) / 8, (height + 7) / 8, texture.getDepthOrArrayLayers());
+    }
+    computePass.end();
+    computePass.release();
+
+    CommandBufferDescriptor cmdBufferDescriptor = {};
+    cmdBufferDescriptor.label = "Mipmaps";
+    CommandBuffer command = encoder.finish(cmdBufferDescriptor);
+    encoder.release();
+    queue.submit(1, &command);
+    command.release();
+
+    for (BindGroup& bindGroup : bindGroups) bindGroup.release();
+    for (TextureView& view : views) view.release();
+    paramBuffer.release();
+}
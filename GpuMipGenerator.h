@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+
+#include <webgpu/webgpu.hpp>
+
+// Mip chains built on the GPU from the uploaded level 0 (files/mipmap.wgsl): only the base level
+// crosses the bus and no CPU time goes into filtering. Every compute dispatch writes up to
+// LevelsPerDispatch levels of all array layers (cube faces) at once. Same 2x2 box filter as
+// MipGenerator, for RGBA8Unorm textures created with TextureBinding | StorageBinding usage.
+class GpuMipGenerator
+{
+public:
+    static constexpr uint32_t LevelsPerDispatch = 3;
+
+    bool initialize(wgpu::Device device);
+    void release();
+    bool isInitialized() const { return bool(pipeline); }
+
+    // levels 1.. of every layer from level 0, submitted right away
+    // srgb: rgb holds sRGB encoded color, filtered in linear space
+    void generate(wgpu::Queue queue, wgpu::Texture texture, bool srgb);
+
+private:
+    // mipmap.wgsl MipParams, one per dispatch at the uniform offset alignment
+    struct MipParams {
+        uint32_t levelCount;
+        uint32_t srgb;
+        uint32_t padding[2];
+    };
+
+    wgpu::TextureView createLevelView(wgpu::Texture texture, uint32_t level);
+
+    wgpu::Device device;
+    wgpu::BindGroupLayout bindGroupLayout;
+    wgpu::ComputePipeline pipeline;
+    wgpu::Texture dummyTexture; // bound to the outputs a dispatch does not write
+    wgpu::TextureView dummyView;
+};
@@ -0,0 +1,140 @@
+#include "GpuReadback.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+using namespace wgpu;
+
+#ifndef __EMSCRIPTEN__
+// waits for the whole buffer to map for reading
+static bool mapForRead(Device device, Buffer buffer) {
+    bool done = false;
+    bool mapped = false;
+    std::unique_ptr<BufferMapCallback> callbackHandle = buffer.mapAsync(MapMode::Read, 0, buffer.getSize(), [&](BufferMapAsyncStatus status) {
+        done = true;
+        mapped = status == BufferMapAsyncStatus::Success;
+    });
+    while (!done) {
+#if defined(WEBGPU_BACKEND_DAWN)
+        device.tick();
+#elif defined(WEBGPU_BACKEND_WGPU)
+        wgpuDevicePoll(device, true, nullptr);
+#endif
+    }
+    return mapped;
+}
+#endif // NOT __EMSCRIPTEN__
+
+bool GpuReadback::readTexture(Device device, Queue queue, Texture texture, uint32_t bytesPerTexel,
+                              std::vector<std::vector<uint8_t>>& levels) {
+#ifdef __EMSCRIPTEN__
+    std::cerr << "GPU readback is not available on the web" << std::endl;
+    return false;
+#else
+    const uint32_t levelCount = texture.getMipLevelCount();
+    const uint32_t layerCount = texture.getDepthOrArrayLayers();
+
+    // every level in one staging buffer, rows padded to RowAlignment (so every level starts aligned too)
+    std::vector<uint64_t> offsets(levelCount);
+    std::vector<uint32_t> paddedRowBytes(levelCount);
+    uint64_t size = 0;
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        const uint32_t width = std::max(1u, texture.getWidth() >> level);
+        const uint32_t height = std::max(1u, texture.getHeight() >> level);
+        paddedRowBytes[level] = (width * bytesPerTexel + RowAlignment - 1) / RowAlignment * RowAlignment;
+        offsets[level] = size;
+        size += uint64_t(paddedRowBytes[level]) * height * layerCount;
+    }
+
+    BufferDescriptor bufferDesc;
+    bufferDesc.label = "Readback";
+    bufferDesc.usage = BufferUsage::CopyDst | BufferUsage::MapRead;
+    bufferDesc.size = size;
+    bufferDesc.mappedAtCreation = false;
+    Buffer buffer = device.createBuffer(bufferDesc);
+
+    CommandEncoderDescriptor encoderDesc = {};
+    encoderDesc.label = "readback encoder";
+    CommandEncoder encoder = device.createCommandEncoder(encoderDesc);
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        ImageCopyTexture source;
+        source.texture = texture;
+        source.mipLevel = level;
+        source.origin = { 0, 0, 0 };
+        source.aspect = TextureAspect::All;
+        ImageCopyBuffer destination;
+        destination.buffer = buffer;
+        destination.layout.offset = offsets[level];
+        destination.layout.bytesPerRow = paddedRowBytes[level];
+        destination.layout.rowsPerImage = std::max(1u, texture.getHeight() >> level);
+        encoder.copyTextureToBuffer(source, destination, { std::max(1u, texture.getWidth() >> level), destination.layout.rowsPerImage, layerCount });
+    }
+    CommandBufferDescriptor cmdBufferDescriptor = {};
+    cmdBufferDescriptor.label = "Readback";
+    CommandBuffer command = encoder.finish(cmdBufferDescriptor);
+    encoder.release();
+    queue.submit(1, &command);
+    command.release();
+
+    const bool mapped = mapForRead(device, buffer);
+    if (mapped) {
+        const uint8_t* data = static_cast<const uint8_t*>(buffer.getConstMappedRange(0, size));
+        levels.resize(levelCount);
+        for (uint32_t level = 0; level < levelCount; ++level) {
+            const uint32_t rowBytes = std::max(1u, texture.getWidth() >> level) * bytesPerTexel;
+            const uint32_t rowCount = std::max(1u, texture.getHeight() >> level) * layerCount;
+            levels[level].resize(size_t(rowBytes) * rowCount);
+            for (uint32_t row = 0; row < rowCount; ++row) {
+                std::memcpy(levels[level].data() + size_t(row) * rowBytes, data + offsets[level] + uint64_t(row) * paddedRowBytes[level], rowBytes);
+            }
+        }
+        buffer.unmap();
+    }
+    else {
+        std::cerr << "Could not map the readback buffer" << std::endl;
+    }
+    buffer.destroy();
+    buffer.release();
+    return mapped;
+#endif // __EMSCRIPTEN__
+}
+
+bool GpuReadback::readBuffer(Device device, Queue queue, Buffer buffer, std::vector<uint8_t>& data) {
+#ifdef __EMSCRIPTEN__
+    std::cerr << "GPU readback is not available on the web" << std::endl;
+    return false;
+#else
+    const uint64_t size = buffer.getSize();
+    BufferDescriptor bufferDesc;
+    bufferDesc.label = "Readback";
+    bufferDesc.usage = BufferUsage::CopyDst | BufferUsage::MapRead;
+    bufferDesc.size = size;
+    bufferDesc.mappedAtCreation = false;
+    Buffer staging = device.createBuffer(bufferDesc);
+
+    CommandEncoderDescriptor encoderDesc = {};
+    encoderDesc.label = "readback encoder";
+    CommandEncoder encoder = device.createCommandEncoder(encoderDesc);
+    encoder.copyBufferToBuffer(buffer, 0, staging, 0, size);
+    CommandBufferDescriptor cmdBufferDescriptor = {};
+    cmdBufferDescriptor.label = "Readback";
+    CommandBuffer command = encoder.finish(cmdBufferDescriptor);
+    encoder.release();
+    queue.submit(1, &command);
+    command.release();
+
+    const bool mapped = mapForRead(device, staging);
+    if (mapped) {
+        const uint8_t* mappedData = static_cast<const uint8_t*>(staging.getConstMappedRange(0, size));
+        data.assign(mappedData, mappedData + size);
+        staging.unmap();
+    }
+    else {
+        std::cerr << "Could not map the readback buffer" << std::endl;
+    }
+    staging.destroy();
+    staging.release();
+    return mapped;
+#endif // __EMSCRIPTEN__
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include <webgpu/webgpu.hpp>
+
+// GPU results copied back to the CPU, blocking (the device is ticked until the staging buffer maps):
+// for one-off results that are then written to disk, not for anything per frame. Not available on
+// the web, where mapAsync only resolves once the frame returns to the browser: every call fails there.
+class GpuReadback
+{
+public:
+    // copies need rows of a multiple of this many bytes
+    static constexpr uint32_t RowAlignment = 256;
+
+    // every level of a texture created with CopySrc usage, all array layers (cube faces), tightly
+    // packed: levels[l] holds layers * width_l * height_l * bytesPerTexel bytes
+    static bool readTexture(wgpu::Device device, wgpu::Queue queue, wgpu::Texture texture, uint32_t bytesPerTexel,
+                            std::vector<std::vector<uint8_t>>& levels);
+    // the whole of a buffer created with CopySrc usage
+    static bool readBuffer(wgpu::Device device, wgpu::Queue queue, wgpu::Buffer buffer, std::vector<uint8_t>& data);
+};
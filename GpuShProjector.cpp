@@ -0,0 +1,134 @@
+#include "GpuShProjector.h"
+#include "GpuReadback.h"
+#include "FileManagement.h"
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace wgpu;
+
+bool GpuShProjector::initialize(Device targetDevice) {
+    device = targetDevice;
+    ShaderModule module = FileManagement::loadShaderModule("../files/shproject.wgsl", device);
+    if (!module) {
+        std::cerr << "SH projection shader module creation failed!" << std::endl;
+        return false;
+    }
+
+    std::vector<BindGroupLayoutEntry> layoutEntries(2, Default);
+    // 0. cube faces, level 0
+    layoutEntries[0].binding = 0;
+    layoutEntries[0].visibility = ShaderStage::Compute;
+    layoutEntries[0].texture.sampleType = TextureSampleType::UnfilterableFloat;
+    layoutEntries[0].texture.viewDimension = TextureViewDimension::_2DArray;
+    // 1. tile sums
+    layoutEntries[1].binding = 1;
+    layoutEntries[1].visibility = ShaderStage::Compute;
+    layoutEntries[1].buffer.type = BufferBindingType::Storage;
+    layoutEntries[1].buffer.minBindingSize = 9 * 4 * sizeof(float);
+
+    BindGroupLayoutDescriptor layoutDesc{};
+    layoutDesc.entryCount = (uint32_t)layoutEntries.size();
+    layoutDesc.entries = layoutEntries.data();
+    bindGroupLayout = device.createBindGroupLayout(layoutDesc);
+
+    PipelineLayoutDescriptor pipelineLayoutDesc{};
+    pipelineLayoutDesc.bindGroupLayoutCount = 1;
+    pipelineLayoutDesc.bindGroupLayouts = (WGPUBindGroupLayout*)&bindGroupLayout;
+    PipelineLayout pipelineLayout = device.createPipelineLayout(pipelineLayoutDesc);
+
+    ComputePipelineDescriptor pipelineDesc;
+    pipelineDesc.label = "SH Projection Pipeline";
+    pipelineDesc.layout = pipelineLayout;
+    pipelineDesc.compute.module = module;
+    pipelineDesc.compute.entryPoint = "cs_project";
+    pipelineDesc.compute.constantCount = 0;
+    pipelineDesc.compute.constants = nullptr;
+    pipeline = device.createComputePipeline(pipelineDesc);
+
+    pipelineLayout.release();
+    module.release();
+    return true;
+}
+
+void GpuShProjector::release() {
+    if (!pipeline) return;
+    pipeline.release();
+    bindGroupLayout.release();
+    pipeline = nullptr;
+}
+
+bool GpuShProjector::project(Queue queue, Texture cubemap, TextureFormat viewFormat, ShProjection& projection) {
+    if (!pipeline) return false;
+    const uint32_t tilesWide = (cubemap.getWidth() + TileSize - 1) / TileSize;
+    const uint32_t tilesHigh = (cubemap.getHeight() + TileSize - 1) / TileSize;
+    const uint32_t tileCount = tilesWide * tilesHigh * 6;
+
+    TextureViewDescriptor viewDesc;
+    viewDesc.aspect = TextureAspect::All;
+    viewDesc.baseArrayLayer = 0;
+    viewDesc.arrayLayerCount = 6;
+    viewDesc.baseMipLevel = 0;
+    viewDesc.mipLevelCount = 1;
+    viewDesc.dimension = TextureViewDimension::_2DArray;
+    viewDesc.format = viewFormat;
+    TextureView view = cubemap.createView(viewDesc);
+
+    BufferDescriptor sumBufferDesc;
+    sumBufferDesc.label = "SH Tile Sums";
+    sumBufferDesc.usage = BufferUsage::Storage | BufferUsage::CopySrc;
+    sumBufferDesc.size = uint64_t(tileCount) * 9 * 4 * sizeof(float);
+    sumBufferDesc.mappedAtCreation = false;
+    Buffer sumBuffer = device.createBuffer(sumBufferDesc);
+
+    std::vector<BindGroupEntry> entries(2);
+    entries[0].binding = 0;
+    entries[0].textureView = view;
+    entries[1].binding = 1;
+    entries[1].buffer = sumBuffer;
+    entries[1].offset = 0;
+    entries[1].size = sumBufferDesc.size;
+    BindGroupDescriptor bindGroupDesc{};
+    bindGroupDesc.layout = bindGroupLayout;
+    bindGroupDesc.entryCount = (uint32_t)entries.size();
+    bindGroupDesc.entries = entries.data();
+    BindGroup bindGroup = device.createBindGroup(bindGroupDesc);
+
+    CommandEncoderDescriptor encoderDesc = {};
+    encoderDesc.label = "sh projection encoder";
+    CommandEncoder encoder = device.createCommandEncoder(encoderDesc);
+    ComputePassDescriptor computePassDesc;
+    computePassDesc.timestampWrites = nullptr;
+    ComputePassEncoder computePass = encoder.beginComputePass(computePassDesc);
+    computePass.setPipeline(pipeline);
+    computePass.setBindGroup(0, bindGroup, 0, nullptr);
+    computePass.dispatchWorkgroups(tilesWide, tilesHigh, 6);
+    computePass.end();
+    computePass.release();
+
+    CommandBufferDescriptor cmdBufferDescriptor = {};
+    cmdBufferDescriptor.label = "SH Projection";
+    CommandBuffer command = encoder.finish(cmdBufferDescriptor);
+    encoder.release();
+    queue.submit(1, &command);
+    command.release();
+
+    std::vector<uint8_t> data;
+    const bool read = GpuReadback::readBuffer(device, queue, sumBuffer, data);
+    if (read) {
+        std::vector<float> tileSums(data.size() / sizeof(float));
+        std::memcpy(tileSums.data(), data.data(), tileSums.size() * sizeof(float));
+        for (uint32_t tile = 0; tile < tileCount; ++tile) {
+            const float* sums = tileSums.data() + size_t(tile) * 9 * 4;
+            for (int k = 0; k < 9; ++k) projection.sums[k] += glm::dvec3(sums[4 * k], sums[4 * k + 1], sums[4 * k + 2]);
+            projection.weight += sums[3];
+        }
+    }
+
+    bindGroup.release();
+    sumBuffer.destroy();
+    sumBuffer.release();
+    view.release();
+    return read;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "SphericalHarmonics.h"
+#include <cstdint>
+
+#include <webgpu/webgpu.hpp>
+
+// SphericalHarmonics::projectFace as a compute pass (files/shproject.wgsl): projects the uploaded cubemap
+// where it already is, whatever its format, instead of converting the decoded faces on the CPU. The
+// workgroups reduce 64x64 texel tiles, the tile sums are read back (GpuReadback, blocking) and added up
+// in double. Fails on the web, like GpuReadback.
+class GpuShProjector
+{
+public:
+    static constexpr uint32_t TileSize = 64;
+
+    bool initialize(wgpu::Device device);
+    void release();
+    bool isInitialized() const { return bool(pipeline); }
+
+    // level 0 of all 6 faces of a float / unorm cubemap into projection, read as viewFormat (the sRGB
+    // view format of an RGBA8Unorm cube that lists it in its viewFormats, the cube's format otherwise)
+    bool project(wgpu::Queue queue, wgpu::Texture cubemap, wgpu::TextureFormat viewFormat, ShProjection& projection);
+
+private:
+    wgpu::Device device;
+    wgpu::BindGroupLayout bindGroupLayout;
+    wgpu::ComputePipeline pipeline;
+};
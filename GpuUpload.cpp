@@ -0,0 +1,53 @@
+#include "GpuUpload.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+
+wgpu::Buffer GpuUpload::createBuffer(wgpu::Device device, const char* label, wgpu::BufferUsageFlags usage,
+                                     uint64_t dataBytes, uint32_t elementSize, const ChunkWriter& writer) {
+    wgpu::BufferDescriptor desc;
+    desc.label = label;
+    desc.usage = usage;
+    desc.size = (dataBytes + 3) & ~uint64_t(3); // align to 4 bytes
+    desc.mappedAtCreation = true;
+    wgpu::Buffer buffer = device.createBuffer(desc);
+
+    // mapped offsets must be multiples of 8, chunks whole elements
+    const uint64_t step = std::lcm<uint64_t>(std::max(elementSize, 1u), 8);
+    const uint64_t chunkBytes = std::max(step, ChunkSize / step * step);
+
+    for (uint64_t offset = 0; offset < dataBytes; offset += chunkBytes) {
+        // the padded size keeps the last mapped range a multiple of 4
+        const uint64_t mappedBytes = std::min(chunkBytes, desc.size - offset);
+        uint8_t* dst = static_cast<uint8_t*>(buffer.getMappedRange(offset, mappedBytes));
+        if (!dst) {
+            std::cerr << "Could not map " << label << std::endl;
+            break;
+        }
+        writer(dst, offset, std::min(chunkBytes, dataBytes - offset));
+    }
+    buffer.unmap();
+    return buffer;
+}
+
+GpuUpload::ChunkWriter GpuUpload::copyFrom(const void* data) {
+    return [data](uint8_t* dst, uint64_t offset, uint64_t size) {
+        std::memcpy(dst, static_cast<const uint8_t*>(data) + offset, size);
+    };
+}
+
+GpuUpload::ChunkWriter GpuUpload::copyRanges(std::vector<Range> ranges) {
+    std::sort(ranges.begin(), ranges.end(), [](const Range& a, const Range& b) { return a.offset < b.offset; });
+    return [ranges = std::move(ranges)](uint8_t* dst, uint64_t offset, uint64_t size) {
+        // first range ending after the chunk start
+        auto it = std::upper_bound(ranges.begin(), ranges.end(), offset,
+            [](uint64_t value, const Range& r) { return value < r.offset + r.size; });
+        for (; it != ranges.end() && it->offset < offset + size; ++it) {
+            const uint64_t begin = std::max(offset, it->offset);
+            const uint64_t end = std::min(offset + size, it->offset + it->size);
+            std::memcpy(dst + (begin - offset), static_cast<const uint8_t*>(it->data) + (begin - it->offset), end - begin);
+        }
+    };
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <functional>
+#include <vector>
+#include <cstdint>
+
+#include <webgpu/webgpu.hpp>
+
+// Buffers created with mappedAtCreation and filled in place, chunk by chunk: the source is written
+// straight into the mapped range instead of being staged again by queue.writeBuffer, so no extra
+// CPU copy of the whole buffer has to exist next to the source (mapped file or mesh being packed).
+class GpuUpload
+{
+public:
+    static constexpr uint64_t ChunkSize = 4ull << 20;
+
+    // fills dst with bytes [offset, offset + size) of the buffer contents
+    using ChunkWriter = std::function<void(uint8_t* dst, uint64_t offset, uint64_t size)>;
+
+    // bytes of the buffer copied from memory
+    struct Range {
+        uint64_t offset = 0;
+        const void* data = nullptr;
+        uint64_t size = 0;
+    };
+
+    // buffer of dataBytes rounded up to 4. Chunks start at multiples of elementSize so a writer
+    // always produces whole elements (e.g. vertices). Returns an unmapped buffer.
+    static wgpu::Buffer createBuffer(wgpu::Device device, const char* label, wgpu::BufferUsageFlags usage,
+                                     uint64_t dataBytes, uint32_t elementSize, const ChunkWriter& writer);
+
+    static ChunkWriter copyFrom(const void* data);
+    // ranges must not overlap, bytes not covered stay zero
+    static ChunkWriter copyRanges(std::vector<Range> ranges);
+};
@@ -0,0 +1,265 @@
+#include "Json.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// recursive descent parser over a character range
+class JsonParser
+{
+public:
+    JsonParser(const char* begin, const char* end) : start(begin), p(begin), end(end) {}
+
+    bool parseDocument(JsonValue& value) {
+        skipWhitespace();
+        if (!parseValue(value, 0)) return false;
+        skipWhitespace();
+        if (p != end) return fail("unexpected data after the document");
+        return true;
+    }
+
+    std::string error;
+
+private:
+    static constexpr int MaxDepth = 256;
+
+    const char* start;
+    const char* p;
+    const char* end;
+
+    bool fail(const char* message) {
+        if (error.empty()) error = std::string(message) + " at byte " + std::to_string(p - start);
+        return false;
+    }
+
+    void skipWhitespace() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) ++p;
+    }
+
+    bool consume(const char* literal) {
+        const size_t length = std::strlen(literal);
+        if (size_t(end - p) < length || std::memcmp(p, literal, length) != 0) return false;
+        p += length;
+        return true;
+    }
+
+    bool parseValue(JsonValue& value, int depth) {
+        if (depth > MaxDepth) return fail("nesting too deep");
+        if (p == end) return fail("unexpected end of input");
+
+        switch (*p) {
+        case '{': return parseObject(value, depth);
+        case '[': return parseArray(value, depth);
+        case '"':
+            value.type = JsonValue::Type::String;
+            return parseString(value.string);
+        case 't':
+            if (!consume("true")) return fail("invalid literal");
+            value.type = JsonValue::Type::Bool;
+            value.boolean = true;
+            return true;
+        case 'f':
+            if (!consume("false")) return fail("invalid literal");
+            value.type = JsonValue::Type::Bool;
+            value.boolean = false;
+            return true;
+        case 'n':
+            if (!consume("null")) return fail("invalid literal");
+            value.type = JsonValue::Type::Null;
+            return true;
+        default:
+            return parseNumber(value);
+        }
+    }
+
+    bool parseObject(JsonValue& value, int depth) {
+        value.type = JsonValue::Type::Object;
+        ++p; // {
+        skipWhitespace();
+        if (p < end && *p == '}') {
+            ++p;
+            return true;
+        }
+        while (true) {
+            skipWhitespace();
+            if (p == end || *p != '"') return fail("expected a member name");
+            value.members.emplace_back();
+            if (!parseString(value.members.back().first)) return false;
+            skipWhitespace();
+            if (p == end || *p != ':') return fail("expected ':'");
+            ++p;
+            skipWhitespace();
+            if (!parseValue(value.members.back().second, depth + 1)) return false;
+            skipWhitespace();
+            if (p < end && *p == ',') {
+                ++p;
+                continue;
+            }
+            if (p < end && *p == '}') {
+                ++p;
+                return true;
+            }
+            return fail("expected ',' or '}'");
+        }
+    }
+
+    bool parseArray(JsonValue& value, int depth) {
+        value.type = JsonValue::Type::Array;
+        ++p; // [
+        skipWhitespace();
+        if (p < end && *p == ']') {
+            ++p;
+            return true;
+        }
+        while (true) {
+            skipWhitespace();
+            value.elements.emplace_back();
+            if (!parseValue(value.elements.back(), depth + 1)) return false;
+            skipWhitespace();
+            if (p < end && *p == ',') {
+                ++p;
+                continue;
+            }
+            if (p < end && *p == ']') {
+                ++p;
+                return true;
+            }
+            return fail("expected ',' or ']'");
+        }
+    }
+
+    bool parseHex4(uint32_t& code) {
+        if (end - p < 4) return fail("truncated \\u escape");
+        code = 0;
+        for (int i = 0; i < 4; ++i, ++p) {
+            const char c = *p;
+            code <<= 4;
+            if (c >= '0' && c <= '9') code |= c - '0';
+            else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+            else return fail("invalid \\u escape");
+        }
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, uint32_t code) {
+        if (code < 0x80) {
+            out.push_back(static_cast<char>(code));
+        }
+        else if (code < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+        else if (code < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+        else {
+            out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+    }
+
+    bool parseString(std::string& out) {
+        ++p; // "
+        while (true) {
+            // copy runs without escapes at once
+            const char* run = p;
+            while (p < end && *p != '"' && *p != '\\' && static_cast<unsigned char>(*p) >= 0x20) ++p;
+            out.append(run, p);
+
+            if (p == end) return fail("unterminated string");
+            if (*p == '"') {
+                ++p;
+                return true;
+            }
+            if (*p != '\\') return fail("control character in string");
+
+            ++p; // backslash
+            if (p == end) return fail("unterminated string");
+            const char escape = *p++;
+            switch (escape) {
+            case '"': out.push_back('"'); break;
+            case '\\': out.push_back('\\'); break;
+            case '/': out.push_back('/'); break;
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'u': {
+                uint32_t code = 0;
+                if (!parseHex4(code)) return false;
+                // surrogate pair
+                if (code >= 0xD800 && code < 0xDC00) {
+                    uint32_t low = 0;
+                    if (!consume("\\u") || !parseHex4(low) || low < 0xDC00 || low >= 0xE000) {
+                        return fail("invalid surrogate pair");
+                    }
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                appendUtf8(out, code);
+                break;
+            }
+            default:
+                return fail("invalid escape");
+            }
+        }
+    }
+
+    bool parseNumber(JsonValue& value) {
+        // validate the JSON grammar, then let strtod convert
+        const char* q = p;
+        if (q < end && *q == '-') ++q;
+        if (q == end || *q < '0' || *q > '9') return fail("invalid value");
+        if (*q == '0') ++q;
+        else while (q < end && *q >= '0' && *q <= '9') ++q;
+        if (q < end && *q == '.') {
+            ++q;
+            if (q == end || *q < '0' || *q > '9') return fail("invalid number");
+            while (q < end && *q >= '0' && *q <= '9') ++q;
+        }
+        if (q < end && (*q == 'e' || *q == 'E')) {
+            ++q;
+            if (q < end && (*q == '+' || *q == '-')) ++q;
+            if (q == end || *q < '0' || *q > '9') return fail("invalid number");
+            while (q < end && *q >= '0' && *q <= '9') ++q;
+        }
+
+        const std::string text(p, q); // strtod needs a terminated string
+        value.type = JsonValue::Type::Number;
+        value.number = std::strtod(text.c_str(), nullptr);
+        p = q;
+        return true;
+    }
+};
+
+static const JsonValue NullValue;
+
+const JsonValue& JsonValue::operator[](const char* key) const {
+    for (const auto& member : members) {
+        if (member.first == key) return member.second;
+    }
+    return NullValue;
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const {
+    return index < elements.size() ? elements[index] : NullValue;
+}
+
+size_t JsonValue::size() const {
+    return type == Type::Array ? elements.size() : type == Type::Object ? members.size() : 0;
+}
+
+bool JsonValue::parse(const char* begin, const char* end, JsonValue& document, std::string& error) {
+    document = JsonValue();
+    JsonParser parser(begin, end);
+    if (!parser.parseDocument(document)) {
+        error = parser.error;
+        return false;
+    }
+    return true;
+}
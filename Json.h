@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+// Minimal JSON document (RFC 8259) for glTF: numbers are doubles, objects keep their member order.
+// Lookups never fail: missing members / elements return a null value.
+class JsonValue
+{
+public:
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    Type getType() const { return type; }
+    bool isNull() const { return type == Type::Null; }
+    bool isNumber() const { return type == Type::Number; }
+    bool isString() const { return type == Type::String; }
+    bool isArray() const { return type == Type::Array; }
+    bool isObject() const { return type == Type::Object; }
+
+    const JsonValue& operator[](const char* key) const;
+    const JsonValue& operator[](size_t index) const;
+    const JsonValue& operator[](int index) const { return (*this)[static_cast<size_t>(index)]; }
+    // array elements or object members
+    size_t size() const;
+
+    bool getBool(bool fallback = false) const { return type == Type::Bool ? boolean : fallback; }
+    double getNumber(double fallback = 0.0) const { return type == Type::Number ? number : fallback; }
+    int64_t getInt(int64_t fallback = -1) const { return type == Type::Number ? static_cast<int64_t>(number) : fallback; }
+    const std::string& getString() const { return string; } // empty unless a string
+    const std::vector<std::pair<std::string, JsonValue>>& getMembers() const { return members; }
+
+    // whole document in [begin, end); false + error message (with byte offset) on malformed input
+    static bool parse(const char* begin, const char* end, JsonValue& document, std::string& error);
+
+private:
+    friend class JsonParser;
+
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> elements;
+    std::vector<std::pair<std::string, JsonValue>> members;
+};
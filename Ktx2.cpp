@@ -0,0 +1,229 @@
+#include "Ktx2.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static const uint8_t Ktx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+// everything up to the level index
+struct Ktx2Header {
+    uint8_t identifier[12];
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t layerCount;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;
+    uint32_t dfdByteOffset;
+    uint32_t dfdByteLength;
+    uint32_t kvdByteOffset;
+    uint32_t kvdByteLength;
+    uint64_t sgdByteOffset;
+    uint64_t sgdByteLength;
+};
+static_assert(sizeof(Ktx2Header) == 80, "KTX2 header layout");
+
+struct Ktx2LevelIndex {
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+};
+
+// data format descriptor facts of a supported format
+struct Ktx2FormatInfo {
+    uint32_t blockSize;  // texel block width and height
+    uint32_t blockBytes; // 0: unsupported
+    uint32_t colorModel; // KHR_DF_MODEL_*
+    bool srgb;
+    bool float16; // 16-bit float channels
+    uint32_t channelCount = 4; // uncompressed formats
+};
+
+static Ktx2FormatInfo getFormatInfo(uint32_t vkFormat) {
+    switch (vkFormat) {
+    case Ktx2::FormatRGBA8Unorm: return { 1, 4, 1, false, false }; // RGBSDA
+    case Ktx2::FormatRGBA8Srgb: return { 1, 4, 1, true, false };
+    case Ktx2::FormatRG16Float: return { 1, 4, 1, false, true, 2 };
+    case Ktx2::FormatRGBA16Float: return { 1, 8, 1, false, true };
+    case Ktx2::FormatBC1Unorm: return { 4, 8, 129, false, false }; // BC1A
+    case Ktx2::FormatBC1Srgb: return { 4, 8, 129, true, false };
+    case Ktx2::FormatBC3Unorm: return { 4, 16, 131, false, false }; // BC3
+    case Ktx2::FormatBC3Srgb: return { 4, 16, 131, true, false };
+    case Ktx2::FormatBC5Unorm: return { 4, 16, 133, false, false }; // BC5
+    case Ktx2::FormatBC7Unorm: return { 4, 16, 135, false, false }; // BC7
+    case Ktx2::FormatBC7Srgb: return { 4, 16, 135, true, false };
+    default: return { 1, 0, 0, false, false };
+    }
+}
+
+// basic data format descriptor block (Khronos Data Format spec): one sample per 8-bit channel, or per
+// 64 / 128 bits of compressed block
+static std::vector<uint32_t> makeDataFormatDescriptor(uint32_t vkFormat) {
+    const Ktx2FormatInfo info = getFormatInfo(vkFormat);
+    struct Sample {
+        uint32_t channel; // KHR_DF_CHANNEL_*
+        uint32_t bitOffset;
+        uint32_t bitLength;
+    };
+    static const Sample Rgba8Samples[] = { { 0, 0, 8 }, { 1, 8, 8 }, { 2, 16, 8 }, { 15, 24, 8 } }; // R, G, B, ALPHA
+    static const Sample Rgba16Samples[] = { { 0, 0, 16 }, { 1, 16, 16 }, { 2, 32, 16 }, { 15, 48, 16 } };
+    static const Sample Bc1Samples[] = { { 1, 0, 64 } };               // color + 1-bit alpha
+    static const Sample Bc3Samples[] = { { 15, 0, 64 }, { 0, 64, 64 } }; // alpha, color
+    static const Sample Bc5Samples[] = { { 0, 0, 64 }, { 1, 64, 64 } };  // red, green
+    static const Sample Bc7Samples[] = { { 0, 0, 128 } };              // color
+    const Sample* samples = info.float16 ? Rgba16Samples : Rgba8Samples;
+    uint32_t sampleCount = info.channelCount;
+    switch (info.colorModel) {
+    case 129: samples = Bc1Samples; sampleCount = 1; break;
+    case 131: samples = Bc3Samples; sampleCount = 2; break;
+    case 133: samples = Bc5Samples; sampleCount = 2; break;
+    case 135: samples = Bc7Samples; sampleCount = 1; break;
+    }
+    const bool compressed = info.blockSize > 1;
+    const uint32_t blockSize = 24 + 16 * sampleCount;
+
+    std::vector<uint32_t> dfd;
+    dfd.push_back(4 + blockSize);   // dfdTotalSize
+    dfd.push_back(0);               // vendorId KHRONOS, descriptorType BASICFORMAT
+    dfd.push_back(2 | (blockSize << 16)); // versionNumber 1.3, descriptorBlockSize
+    dfd.push_back(info.colorModel | (1 << 8) | ((info.srgb ? 2 : 1) << 16)); // primaries BT709, transfer, straight alpha
+    dfd.push_back((info.blockSize - 1) | ((info.blockSize - 1) << 8)); // texel block dimensions - 1
+    dfd.push_back(info.blockBytes); // bytesPlane0
+    dfd.push_back(0);
+    for (uint32_t s = 0; s < sampleCount; ++s) {
+        const Sample& sample = samples[s];
+        // qualifiers: alpha stays linear in sRGB formats (LINEAR), floats are FLOAT | SIGNED
+        uint32_t channelType = sample.channel | (info.srgb && sample.channel == 15 ? 0x10u : 0u);
+        if (info.float16) channelType |= 0xC0u;
+        dfd.push_back(sample.bitOffset | ((sample.bitLength - 1) << 16) | (channelType << 24));
+        dfd.push_back(0); // samplePosition
+        // sampleLower / sampleUpper: -1.0f / 1.0f for floats
+        dfd.push_back(info.float16 ? 0xBF800000u : 0u);
+        dfd.push_back(info.float16 ? 0x3F800000u : compressed ? 0xFFFFFFFFu : (1u << sample.bitLength) - 1);
+    }
+    return dfd;
+}
+
+uint32_t Ktx2::getBlockSize(uint32_t vkFormat) {
+    return getFormatInfo(vkFormat).blockSize;
+}
+
+uint32_t Ktx2::getBlockBytes(uint32_t vkFormat) {
+    return getFormatInfo(vkFormat).blockBytes;
+}
+
+uint64_t Ktx2::getLevelBytes(uint32_t vkFormat, uint32_t width, uint32_t height, uint32_t level) {
+    const Ktx2FormatInfo info = getFormatInfo(vkFormat);
+    const uint64_t blocksWide = (std::max(1u, width >> level) + info.blockSize - 1) / info.blockSize;
+    const uint64_t blocksHigh = (std::max(1u, height >> level) + info.blockSize - 1) / info.blockSize;
+    return blocksWide * blocksHigh * info.blockBytes;
+}
+
+bool Ktx2::write(const std::filesystem::path& path, const Ktx2Texture& texture) {
+    const uint32_t blockBytes = getBlockBytes(texture.vkFormat);
+    if (blockBytes == 0 || texture.levels.empty()) return false;
+    for (uint32_t level = 0; level < texture.levels.size(); ++level) {
+        if (texture.levels[level].size() != getLevelBytes(texture.vkFormat, texture.width, texture.height, level) * texture.faceCount) return false;
+    }
+
+    const std::vector<uint32_t> dfd = makeDataFormatDescriptor(texture.vkFormat);
+    // key / value data: length, "key\0value\0", padded to 4 bytes
+    const char writerKey[] = "KTXwriter";
+    const char writerValue[] = "BaseWebGPU AssetCooker";
+    std::vector<uint8_t> kvd(4);
+    kvd.insert(kvd.end(), writerKey, writerKey + sizeof(writerKey));
+    kvd.insert(kvd.end(), writerValue, writerValue + sizeof(writerValue));
+    const uint32_t kvLength = static_cast<uint32_t>(kvd.size() - 4);
+    std::memcpy(kvd.data(), &kvLength, sizeof(kvLength));
+    kvd.resize((kvd.size() + 3) & ~size_t(3), 0);
+
+    const uint32_t levelCount = static_cast<uint32_t>(texture.levels.size());
+    Ktx2Header header = {};
+    std::memcpy(header.identifier, Ktx2Identifier, sizeof(Ktx2Identifier));
+    header.vkFormat = texture.vkFormat;
+    header.typeSize = getFormatInfo(texture.vkFormat).float16 ? 2 : 1;
+    header.pixelWidth = texture.width;
+    header.pixelHeight = texture.height;
+    header.faceCount = texture.faceCount;
+    header.levelCount = levelCount;
+    header.dfdByteOffset = static_cast<uint32_t>(sizeof(Ktx2Header) + levelCount * sizeof(Ktx2LevelIndex));
+    header.dfdByteLength = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t));
+    header.kvdByteOffset = header.dfdByteOffset + header.dfdByteLength;
+    header.kvdByteLength = static_cast<uint32_t>(kvd.size());
+
+    // level data smallest first, every level aligned to lcm(texel block size, 4)
+    const uint64_t alignment = blockBytes % 4 == 0 ? blockBytes : blockBytes * 4;
+    std::vector<Ktx2LevelIndex> levelIndex(levelCount);
+    uint64_t offset = header.kvdByteOffset + header.kvdByteLength;
+    for (uint32_t level = levelCount; level-- > 0;) {
+        offset = (offset + alignment - 1) / alignment * alignment;
+        levelIndex[level].byteOffset = offset;
+        levelIndex[level].byteLength = texture.levels[level].size();
+        levelIndex[level].uncompressedByteLength = texture.levels[level].size();
+        offset += texture.levels[level].size();
+    }
+
+    std::filesystem::path tempPath = path;
+    tempPath += ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return false;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(levelIndex.data()), static_cast<std::streamsize>(levelIndex.size() * sizeof(Ktx2LevelIndex)));
+        out.write(reinterpret_cast<const char*>(dfd.data()), header.dfdByteLength);
+        out.write(reinterpret_cast<const char*>(kvd.data()), header.kvdByteLength);
+        for (uint32_t level = levelCount; level-- > 0;) {
+            static const char zeros[16] = {};
+            out.write(zeros, static_cast<std::streamsize>(levelIndex[level].byteOffset - static_cast<uint64_t>(out.tellp())));
+            out.write(reinterpret_cast<const char*>(texture.levels[level].data()), static_cast<std::streamsize>(texture.levels[level].size()));
+        }
+        if (!out) return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+bool Ktx2::read(const std::filesystem::path& path, Ktx2Texture& texture) {
+    MappedFile file;
+    if (!file.open(path) || file.size() < sizeof(Ktx2Header)) return false;
+
+    Ktx2Header header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.identifier, Ktx2Identifier, sizeof(Ktx2Identifier)) != 0) return false;
+    if (header.supercompressionScheme != 0 || header.pixelDepth != 0 || header.layerCount > 1
+        || (header.faceCount != 1 && header.faceCount != 6) || header.levelCount == 0 || header.levelCount > 32
+        || getBlockBytes(header.vkFormat) == 0
+        || sizeof(Ktx2Header) + uint64_t(header.levelCount) * sizeof(Ktx2LevelIndex) > file.size()) {
+        std::cerr << "Unsupported KTX2 file " << path << std::endl;
+        return false;
+    }
+
+    texture.vkFormat = header.vkFormat;
+    texture.width = header.pixelWidth;
+    texture.height = header.pixelHeight;
+    texture.faceCount = header.faceCount;
+    texture.levels.assign(header.levelCount, {});
+    for (uint32_t level = 0; level < header.levelCount; ++level) {
+        Ktx2LevelIndex index;
+        std::memcpy(&index, file.data() + sizeof(Ktx2Header) + level * sizeof(Ktx2LevelIndex), sizeof(index));
+        const uint64_t expected = getLevelBytes(header.vkFormat, header.pixelWidth, header.pixelHeight, level) * header.faceCount;
+        if (index.byteLength != expected || index.byteOffset + index.byteLength > file.size()) {
+            std::cerr << "Corrupt KTX2 file " << path << std::endl;
+            return false;
+        }
+        texture.levels[level].assign(file.data() + index.byteOffset, file.data() + index.byteOffset + index.byteLength);
+    }
+    return true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <filesystem>
+#include <vector>
+#include <cstdint>
+
+// texture stored in a KTX2 file
+struct Ktx2Texture {
+    uint32_t vkFormat = 0; // VkFormat, see Ktx2::Format*
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t faceCount = 1; // 6: cubemap, faces +x -x +y -y +z -z
+    std::vector<std::vector<uint8_t>> levels; // level 0 first, the faces of a level back to back
+};
+
+// KTX 2.0 container (Khronos): 2D textures and cubemaps with their mip chains, no supercompression.
+// Files hold a basic data format descriptor so other KTX2 tools can read them.
+class Ktx2
+{
+public:
+    static constexpr uint32_t FormatRGBA8Unorm = 37; // VK_FORMAT_R8G8B8A8_UNORM
+    static constexpr uint32_t FormatRGBA8Srgb = 43;  // VK_FORMAT_R8G8B8A8_SRGB
+    static constexpr uint32_t FormatRG16Float = 83;   // VK_FORMAT_R16G16_SFLOAT, BRDF lookup table
+    static constexpr uint32_t FormatRGBA16Float = 97; // VK_FORMAT_R16G16B16A16_SFLOAT, HDR environments
+    // block compressed, 4x4 pixel blocks (BlockCompression)
+    static constexpr uint32_t FormatBC1Unorm = 133; // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+    static constexpr uint32_t FormatBC1Srgb = 134;  // VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+    static constexpr uint32_t FormatBC3Unorm = 137; // VK_FORMAT_BC3_UNORM_BLOCK
+    static constexpr uint32_t FormatBC3Srgb = 138;  // VK_FORMAT_BC3_SRGB_BLOCK
+    static constexpr uint32_t FormatBC5Unorm = 141; // VK_FORMAT_BC5_UNORM_BLOCK
+    static constexpr uint32_t FormatBC7Unorm = 145; // VK_FORMAT_BC7_UNORM_BLOCK
+    static constexpr uint32_t FormatBC7Srgb = 146;  // VK_FORMAT_BC7_SRGB_BLOCK
+
+    // texel block of a format: width / height in pixels (1, or 4 for BC) and bytes, 0 for unsupported formats
+    static uint32_t getBlockSize(uint32_t vkFormat);
+    static uint32_t getBlockBytes(uint32_t vkFormat);
+
+    // bytes of one face of a level (whole blocks), 0 for unsupported formats
+    static uint64_t getLevelBytes(uint32_t vkFormat, uint32_t width, uint32_t height, uint32_t level);
+
+    static bool write(const std::filesystem::path& path, const Ktx2Texture& texture);
+    // fails on supercompressed files, arrays, 3D textures and formats getLevelBytes does not know
+    static bool read(const std::filesystem::path& path, Ktx2Texture& texture);
+};
@@ -1,13 +1,43 @@
 #include "Application.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
 // Emscripten
 #ifdef __EMSCRIPTEN__
 #  include <emscripten.h>
 #endif // __EMSCRIPTEN__
 
-int main() {
+int main(int argc, char** argv) {
+#ifdef __EMSCRIPTEN__
+    (void)argc;
+    (void)argv;
+#endif
+
     Application app;
 
+#ifndef __EMSCRIPTEN__
+    // App --instances 100000
+    // instancing benchmark: a grid of the mesh (files/sphere.obj by default) with varying materials, frame times on stdout
+    // App --environment sky.hdr [--environment-size 1024]
+    // HDR panorama instead of the cubemap folder, converted to faceSize faces once (sky.hdr.ktx2)
+    // App --gpu-irradiance
+    // spherical harmonics of the environment from a compute pass instead of the CPU
+    std::filesystem::path environmentPath;
+    uint32_t environmentSize = TextureCooker::DefaultEnvironmentSize;
+    for (int i = 1; i + 1 < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--instances") app.SetInstanceBenchmark(static_cast<uint32_t>(std::strtoul(argv[i + 1], nullptr, 10)));
+        else if (arg == "--environment") environmentPath = argv[i + 1];
+        else if (arg == "--environment-size") environmentSize = std::max(1u, static_cast<uint32_t>(std::strtoul(argv[i + 1], nullptr, 10)));
+    }
+    if (!environmentPath.empty()) app.SetEnvironment(environmentPath, environmentSize);
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--gpu-irradiance") app.SetGpuIrradiance(true);
+    }
+#endif
+
     if (!app.Initialize()) {
         return 1;
     }
@@ -0,0 +1,141 @@
+#include "MappedFile.h"
+
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+#ifdef _WIN32
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this == &other) return *this;
+    close();
+    bytes = other.bytes;
+    fileSize = other.fileSize;
+    opened = other.opened;
+#ifdef _WIN32
+    fileHandle = other.fileHandle;
+    mappingHandle = other.mappingHandle;
+    other.fileHandle = nullptr;
+    other.mappingHandle = nullptr;
+#endif
+    fallback = std::move(other.fallback);
+    other.bytes = nullptr;
+    other.fileSize = 0;
+    other.opened = false;
+    return *this;
+}
+
+bool MappedFile::open(const std::filesystem::path& path) {
+    close();
+
+    std::error_code ec;
+    const uintmax_t size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    fileSize = static_cast<size_t>(size);
+    opened = true;
+    if (fileSize == 0) return true; // nothing to map
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file != INVALID_HANDLE_VALUE) {
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr) {
+            void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (view != nullptr) {
+                fileHandle = file;
+                mappingHandle = mapping;
+                bytes = static_cast<const uint8_t*>(view);
+                return true;
+            }
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+    }
+#elif !defined(__EMSCRIPTEN__)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        void* view = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // the mapping keeps its own reference to the file
+        if (view != MAP_FAILED) {
+            bytes = static_cast<const uint8_t*>(view);
+            return true;
+        }
+    }
+#endif
+
+    // no mapping: read the whole file instead
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        close();
+        return false;
+    }
+    fallback.resize(fileSize);
+    file.read(reinterpret_cast<char*>(fallback.data()), fileSize);
+    if (!file) {
+        close();
+        return false;
+    }
+    bytes = fallback.data();
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes != nullptr && fallback.empty()) {
+#if defined(_WIN32)
+        UnmapViewOfFile(bytes);
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        mappingHandle = nullptr;
+        fileHandle = nullptr;
+#elif !defined(__EMSCRIPTEN__)
+        munmap(const_cast<uint8_t*>(bytes), fileSize);
+#endif
+    }
+    fallback.clear();
+    fallback.shrink_to_fit();
+    bytes = nullptr;
+    fileSize = 0;
+    opened = false;
+}
+
+uint64_t MappedFile::hashBytes(const uint8_t* data, size_t size) {
+    const uint64_t prime = 0x9E3779B97F4A7C15ull;
+    uint64_t lanes[4] = { 1, 2, 3, 4 };
+
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int l = 0; l < 4; ++l) {
+            uint64_t word;
+            std::memcpy(&word, data + i + 8 * l, sizeof(word));
+            lanes[l] = (lanes[l] ^ word) * prime;
+            lanes[l] ^= lanes[l] >> 29;
+        }
+    }
+    uint64_t hash = size;
+    for (int l = 0; l < 4; ++l) {
+        hash = (hash ^ lanes[l]) * prime;
+    }
+    for (; i < size; ++i) {
+        hash = (hash ^ data[i]) * 0x100000001B3ull;
+    }
+    return hash ^ (hash >> 32);
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <filesystem>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Read-only memory mapping of a whole file.
+// Falls back to reading the file into memory where mapping is unavailable.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool open(const std::filesystem::path& path);
+    void close();
+
+    bool isOpen() const { return opened; }
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return fileSize; }
+
+    // 64-bit hash of file contents (cache keys), 4 independent lanes so it runs near memory speed
+    static uint64_t hashBytes(const uint8_t* data, size_t size);
+
+private:
+    const uint8_t* bytes = nullptr;
+    size_t fileSize = 0;
+    bool opened = false;
+
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+    std::vector<uint8_t> fallback; // used when the file could not be mapped
+};
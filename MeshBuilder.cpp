@@ -0,0 +1,93 @@
+#include "MeshBuilder.h"
+
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <glm/common.hpp>
+
+// VertexAttr is 11 tightly packed floats, so raw bytes can be hashed / compared
+static_assert(sizeof(VertexAttr) == 11 * sizeof(float), "VertexAttr must not contain padding");
+
+size_t VertexAttrHash::operator()(const VertexAttr& v) const {
+    // FNV-1a over the raw bytes
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&v);
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < sizeof(VertexAttr); ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return static_cast<size_t>(hash);
+}
+
+bool VertexAttrEqual::operator()(const VertexAttr& a, const VertexAttr& b) const {
+    return std::memcmp(&a, &b, sizeof(VertexAttr)) == 0;
+}
+
+MeshBuilder::MeshBuilder(MeshData& target) : mesh(target) {
+    mesh.vertices.clear();
+    mesh.indices.clear();
+    mesh.submeshes.clear();
+}
+
+void MeshBuilder::reserve(size_t corners) {
+    // scans usually share each vertex between ~6 triangles -> ~corners / 6 unique, corners / 4 leaves
+    // headroom for the vertices that UV and normal seams split
+    mesh.indices.reserve(corners);
+    mesh.vertices.reserve(corners / 4);
+    lookup.reserve(corners / 4);
+}
+
+void MeshBuilder::beginSubmesh(int32_t materialId) {
+    if (!mesh.submeshes.empty()) {
+        Submesh& last = mesh.submeshes.back();
+        last.indexCount = static_cast<uint32_t>(mesh.indices.size()) - last.indexOffset;
+    }
+    Submesh submesh;
+    submesh.indexOffset = static_cast<uint32_t>(mesh.indices.size());
+    submesh.materialId = materialId;
+    mesh.submeshes.push_back(submesh);
+}
+
+void MeshBuilder::addCorner(const VertexAttr& vertex) {
+    ++cornerCount;
+    auto inserted = lookup.emplace(vertex, static_cast<uint32_t>(mesh.vertices.size()));
+    if (inserted.second) {
+        mesh.vertices.push_back(vertex);
+    }
+    mesh.indices.push_back(inserted.first->second);
+}
+
+void MeshBuilder::finish() {
+    if (!mesh.submeshes.empty()) {
+        Submesh& last = mesh.submeshes.back();
+        last.indexCount = static_cast<uint32_t>(mesh.indices.size()) - last.indexOffset;
+        mesh.submeshes.erase(std::remove_if(mesh.submeshes.begin(), mesh.submeshes.end(),
+            [](const Submesh& submesh) { return submesh.indexCount == 0; }), mesh.submeshes.end());
+    }
+    if (mesh.submeshes.empty() && !mesh.indices.empty()) {
+        mesh.submeshes.push_back({ 0, static_cast<uint32_t>(mesh.indices.size()), -1 });
+    }
+
+    if (mesh.vertices.empty()) return;
+    mesh.boundsMin = mesh.vertices[0].position;
+    mesh.boundsMax = mesh.vertices[0].position;
+    for (const VertexAttr& v : mesh.vertices) {
+        mesh.boundsMin = glm::min(mesh.boundsMin, v.position);
+        mesh.boundsMax = glm::max(mesh.boundsMax, v.position);
+    }
+}
+
+void MeshBuilder::printStats(const char* label) const {
+    const size_t vertexCount = mesh.vertices.size();
+    const size_t indexSize = vertexCount <= 0xFFFF ? sizeof(uint16_t) : sizeof(uint32_t);
+
+    const double flatBytes = double(cornerCount) * sizeof(VertexAttr);
+    const double indexedBytes = double(vertexCount) * sizeof(VertexAttr) + double(cornerCount) * indexSize;
+    const double mb = 1.0 / (1024.0 * 1024.0);
+
+    std::cout << label << ": " << cornerCount << " corners -> " << vertexCount << " unique vertices"
+        << " (dedup ratio " << (vertexCount ? double(cornerCount) / vertexCount : 0.0) << "x, "
+        << indexSize * 8 << "-bit indices)" << std::endl;
+    std::cout << label << ": " << flatBytes * mb << " MB flat -> " << indexedBytes * mb << " MB indexed"
+        << " (saved " << (flatBytes - indexedBytes) * mb << " MB)" << std::endl;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+#include "MeshData.h"
+
+// hash / compare a whole vertex (position, color, normal, uv) bit for bit
+struct VertexAttrHash {
+    size_t operator()(const VertexAttr& v) const;
+};
+struct VertexAttrEqual {
+    bool operator()(const VertexAttr& a, const VertexAttr& b) const;
+};
+
+// Builds an indexed mesh from a stream of triangle corners,
+// merging corners whose attributes are identical into one vertex
+class MeshBuilder
+{
+public:
+    explicit MeshBuilder(MeshData& target);
+
+    void reserve(size_t cornerCount);
+    // ends the current submesh and starts a new one at the next corner
+    void beginSubmesh(int32_t materialId);
+    void addCorner(const VertexAttr& vertex);
+    // computes bounds, drops empty submeshes + adds a single one covering everything if none were begun
+    void finish();
+
+    // corners pushed so far vs. unique vertices kept
+    size_t getCornerCount() const { return cornerCount; }
+    size_t getVertexCount() const { return mesh.vertices.size(); }
+
+    // print dedup ratio + memory of the flat vs. indexed representation
+    void printStats(const char* label) const;
+
+private:
+    MeshData& mesh;
+    std::unordered_map<VertexAttr, uint32_t, VertexAttrHash, VertexAttrEqual> lookup;
+    size_t cornerCount = 0;
+};
@@ -0,0 +1,314 @@
+#include "MeshCache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <type_traits>
+
+static const char MeshCacheMagic[4] = { 'B', 'M', 'S', 'H' };
+
+static_assert(std::is_trivially_copyable<MeshCacheHeader>::value, "header is read straight from the mapping");
+static_assert(std::is_trivially_copyable<Submesh>::value, "submeshes are read straight from the mapping");
+static_assert(std::is_trivially_copyable<SubmeshLod>::value, "LODs are read straight from the mapping");
+static_assert(std::is_trivially_copyable<MeshCacheMaterial>::value, "materials are read straight from the mapping");
+static_assert(std::is_trivially_copyable<Meshlet>::value && sizeof(Meshlet) == 48, "meshlets are uploaded straight from the mapping");
+static_assert(std::is_trivially_copyable<MeshPage>::value, "pages are read straight from the mapping");
+
+static uint64_t alignTo16(uint64_t offset) {
+    return (offset + 15) & ~uint64_t(15);
+}
+
+// rewrites source.modifiedTime of a cache file in place
+static bool writeSourceTime(const std::filesystem::path& cachePath, int64_t modifiedTime) {
+    std::fstream out(cachePath, std::ios::binary | std::ios::in | std::ios::out);
+    if (!out.is_open()) return false;
+    out.seekp(offsetof(MeshCacheHeader, source) + offsetof(MeshSourceStamp, modifiedTime));
+    out.write(reinterpret_cast<const char*>(&modifiedTime), sizeof(modifiedTime));
+    return bool(out);
+}
+
+std::filesystem::path MeshCache::getCachePath(const std::filesystem::path& sourcePath) {
+    std::filesystem::path cachePath = sourcePath;
+    cachePath += ".meshcache";
+    return cachePath;
+}
+
+bool MeshCache::getSourceStamp(const std::filesystem::path& sourcePath, MeshSourceStamp& stamp, bool hashContents) {
+    std::error_code ec;
+    auto time = std::filesystem::last_write_time(sourcePath, ec);
+    if (ec) return false;
+    stamp.modifiedTime = static_cast<int64_t>(time.time_since_epoch().count());
+
+    if (!hashContents) {
+        stamp.size = std::filesystem::file_size(sourcePath, ec);
+        stamp.contentHash = 0;
+        return !ec;
+    }
+
+    MappedFile source;
+    if (!source.open(sourcePath)) return false;
+
+    stamp.size = source.size();
+    stamp.contentHash = MappedFile::hashBytes(source.data(), source.size());
+    return true;
+}
+
+void MeshCache::initHeader(MeshCacheHeader& header, const MeshSourceStamp& source) {
+    header = MeshCacheHeader(); // not {}: GCC 12 fails on it (internal compiler error)
+    std::memcpy(header.magic, MeshCacheMagic, sizeof(header.magic));
+    header.version = Version;
+    header.source = source;
+}
+
+void MeshCache::layoutSections(MeshCacheHeader& header) {
+    header.positionStreamOffset = alignTo16(sizeof(MeshCacheHeader));
+    header.positionStreamBytes = uint64_t(header.vertexCount) * header.positionLayout.stride;
+    header.vertexOffset = alignTo16(header.positionStreamOffset + header.positionStreamBytes);
+    header.vertexBytes = uint64_t(header.vertexCount) * header.layout.stride;
+    header.tangentOffset = alignTo16(header.vertexOffset + header.vertexBytes);
+    header.indexOffset = alignTo16(header.tangentOffset + header.tangentBytes);
+    // padded to 4 bytes so the blob can go to writeBuffer as is
+    header.indexBytes = (uint64_t(header.indexCount) * header.indexSize + 3) & ~uint64_t(3);
+    header.submeshOffset = alignTo16(header.indexOffset + header.indexBytes);
+    header.lodOffset = alignTo16(header.submeshOffset + uint64_t(header.submeshCount) * sizeof(Submesh));
+    header.meshletOffset = alignTo16(header.lodOffset + uint64_t(header.lodCount) * sizeof(SubmeshLod));
+    header.materialOffset = alignTo16(header.meshletOffset + uint64_t(header.meshletCount) * sizeof(Meshlet));
+    header.stringOffset = alignTo16(header.materialOffset + uint64_t(header.materialCount) * sizeof(MeshCacheMaterial));
+    header.pageOffset = alignTo16(header.stringOffset + header.stringBytes);
+}
+
+void MeshCache::makeMaterialRecords(const std::vector<MeshMaterial>& materials,
+                                    std::vector<MeshCacheMaterial>& records, std::string& strings) {
+    // fixed size records + string table, offset 0 is the empty string
+    strings.assign(1, '\0');
+    auto addString = [&strings](const std::string& value) {
+        if (value.empty()) return uint32_t(0);
+        uint32_t offset = static_cast<uint32_t>(strings.size());
+        strings.append(value);
+        strings.push_back('\0');
+        return offset;
+    };
+    records.assign(materials.size(), MeshCacheMaterial{});
+    for (size_t i = 0; i < materials.size(); ++i) {
+        const MeshMaterial& m = materials[i];
+        for (int c = 0; c < 3; ++c) records[i].diffuse[c] = m.diffuse[c];
+        records[i].roughness = m.roughness;
+        records[i].metallic = m.metallic;
+        records[i].name = addString(m.name);
+        records[i].diffuseTexture = addString(m.diffuseTexture);
+        records[i].normalTexture = addString(m.normalTexture);
+        records[i].roughnessTexture = addString(m.roughnessTexture);
+        records[i].metallicTexture = addString(m.metallicTexture);
+        records[i].occlusionTexture = addString(m.occlusionTexture);
+    }
+}
+
+bool MeshCache::write(const std::filesystem::path& cachePath, const std::filesystem::path& sourcePath,
+                      const MeshData& mesh, const PackedVertices& vertices) {
+    MeshSourceStamp source;
+    if (!getSourceStamp(sourcePath, source)) return false;
+    MeshCacheHeader header;
+    initHeader(header, source);
+
+    header.positionLayout = vertices.positionLayout;
+    header.layout = vertices.layout;
+    header.formatBits = vertices.formatBits;
+    header.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+    header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+    header.indexSize = mesh.vertices.size() <= 0xFFFF ? 2 : 4;
+    header.submeshCount = static_cast<uint32_t>(mesh.submeshes.size());
+    header.lodCount = static_cast<uint32_t>(mesh.lods.size());
+    header.meshletCount = static_cast<uint32_t>(mesh.meshlets.size());
+    header.materialCount = static_cast<uint32_t>(mesh.materials.size());
+    // not built progressively: a single page
+    std::vector<MeshPage> pages = mesh.pages;
+    if (pages.empty()) pages.push_back({ header.vertexCount, header.indexCount });
+    header.pageCount = static_cast<uint32_t>(pages.size());
+    for (int c = 0; c < 3; ++c) {
+        header.boundsMin[c] = mesh.boundsMin[c];
+        header.boundsMax[c] = mesh.boundsMax[c];
+        header.positionOffset[c] = vertices.positionOffset[c];
+        header.positionScale[c] = vertices.positionScale[c];
+    }
+
+    std::vector<MeshCacheMaterial> materials;
+    std::string strings;
+    makeMaterialRecords(mesh.materials, materials, strings);
+    header.tangentBytes = vertices.tangents.size();
+    header.stringBytes = strings.size();
+    layoutSections(header);
+
+    // write to a temporary file first so a crash never leaves a half-written cache behind
+    std::filesystem::path tempPath = cachePath;
+    tempPath += ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return false;
+
+        auto padTo = [&out](uint64_t offset) {
+            static const char zeros[16] = {};
+            uint64_t pos = static_cast<uint64_t>(out.tellp());
+            out.write(zeros, static_cast<std::streamsize>(offset - pos));
+        };
+
+        auto writeStream = [&](const VertexLayoutDesc& layout, const std::vector<uint8_t>& data) {
+            if (!data.empty()) {
+                out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+                return;
+            }
+            // only prepared: pack through a small scratch buffer instead of holding every vertex twice
+            const size_t chunkVertices = std::max<size_t>(1, (size_t(1) << 20) / layout.stride);
+            std::vector<uint8_t> chunk(chunkVertices * layout.stride);
+            for (size_t first = 0; first < mesh.vertices.size(); first += chunkVertices) {
+                const size_t count = std::min(chunkVertices, mesh.vertices.size() - first);
+                VertexQuantization::packVertices(mesh, vertices, layout, first, count, chunk.data());
+                out.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(count * layout.stride));
+            }
+        };
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        padTo(header.positionStreamOffset);
+        writeStream(header.positionLayout, vertices.positions);
+        padTo(header.vertexOffset);
+        writeStream(header.layout, vertices.data);
+
+        padTo(header.tangentOffset);
+        out.write(reinterpret_cast<const char*>(vertices.tangents.data()), static_cast<std::streamsize>(header.tangentBytes));
+
+        padTo(header.indexOffset);
+        if (header.indexSize == 2) {
+            std::vector<uint16_t> indices16(mesh.indices.begin(), mesh.indices.end());
+            out.write(reinterpret_cast<const char*>(indices16.data()), static_cast<std::streamsize>(indices16.size() * sizeof(uint16_t)));
+        }
+        else {
+            out.write(reinterpret_cast<const char*>(mesh.indices.data()), static_cast<std::streamsize>(mesh.indices.size() * sizeof(uint32_t)));
+        }
+
+        padTo(header.submeshOffset);
+        out.write(reinterpret_cast<const char*>(mesh.submeshes.data()), static_cast<std::streamsize>(mesh.submeshes.size() * sizeof(Submesh)));
+
+        padTo(header.lodOffset);
+        out.write(reinterpret_cast<const char*>(mesh.lods.data()), static_cast<std::streamsize>(mesh.lods.size() * sizeof(SubmeshLod)));
+
+        padTo(header.meshletOffset);
+        out.write(reinterpret_cast<const char*>(mesh.meshlets.data()), static_cast<std::streamsize>(mesh.meshlets.size() * sizeof(Meshlet)));
+
+        padTo(header.materialOffset);
+        out.write(reinterpret_cast<const char*>(materials.data()), static_cast<std::streamsize>(materials.size() * sizeof(MeshCacheMaterial)));
+        padTo(header.stringOffset);
+        out.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+        padTo(header.pageOffset);
+        out.write(reinterpret_cast<const char*>(pages.data()), static_cast<std::streamsize>(pages.size() * sizeof(MeshPage)));
+        if (!out) return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, cachePath, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+bool MeshCache::open(const std::filesystem::path& cachePath, const std::filesystem::path& sourcePath,
+                     const VertexFormatOptions& options) {
+    close();
+    if (!file.open(cachePath) || file.size() < sizeof(MeshCacheHeader)) {
+        close();
+        return false;
+    }
+
+    const MeshCacheHeader* h = reinterpret_cast<const MeshCacheHeader*>(file.data());
+    bool valid = std::memcmp(h->magic, MeshCacheMagic, sizeof(h->magic)) == 0
+        && h->version == Version
+        && h->formatBits == options.getBits()
+        && h->positionLayout == VertexQuantization::makePositionLayout(options)
+        && (h->layout == VertexQuantization::makeLayout(options, true) || h->layout == VertexQuantization::makeLayout(options, false))
+        && (h->indexSize == 2 || h->indexSize == 4)
+        && h->positionStreamBytes == uint64_t(h->vertexCount) * h->positionLayout.stride
+        && h->positionStreamOffset + h->positionStreamBytes <= file.size()
+        && h->vertexBytes == uint64_t(h->vertexCount) * h->layout.stride
+        && h->vertexOffset + h->vertexBytes <= file.size()
+        && (h->tangentBytes == 0 || h->tangentBytes == uint64_t(h->vertexCount) * VertexQuantization::getFormatSize(VertexElementFormat::Snorm16x4))
+        && h->tangentOffset + h->tangentBytes <= file.size()
+        && h->indexBytes == ((uint64_t(h->indexCount) * h->indexSize + 3) & ~uint64_t(3))
+        && h->indexOffset + h->indexBytes <= file.size()
+        && h->submeshOffset + uint64_t(h->submeshCount) * sizeof(Submesh) <= file.size()
+        && h->lodOffset + uint64_t(h->lodCount) * sizeof(SubmeshLod) <= file.size()
+        && h->meshletOffset + uint64_t(h->meshletCount) * sizeof(Meshlet) <= file.size()
+        && h->materialOffset + uint64_t(h->materialCount) * sizeof(MeshCacheMaterial) <= file.size()
+        && h->stringBytes > 0 && h->stringOffset + h->stringBytes <= file.size()
+        && file.data()[h->stringOffset + h->stringBytes - 1] == '\0'
+        && h->pageCount > 0 && h->pageOffset + uint64_t(h->pageCount) * sizeof(MeshPage) <= file.size();
+    if (valid) {
+        const MeshPage& lastPage = reinterpret_cast<const MeshPage*>(file.data() + h->pageOffset)[h->pageCount - 1];
+        valid = lastPage.vertexCount == h->vertexCount && lastPage.indexCount == h->indexCount;
+    }
+
+    // stale if the source changed. Size and mtime are enough for an untouched source, so a warm cache never
+    // reads it: the contents are only hashed when the mtime alone moved (touch, copy, checkout), and a
+    // matching hash keeps the cache. A missing source keeps the cache usable.
+    MeshSourceStamp stamp;
+    bool restamp = false;
+    if (valid && getSourceStamp(sourcePath, stamp, false)) {
+        valid = stamp.size == h->source.size;
+        if (valid && stamp.modifiedTime != h->source.modifiedTime) {
+            valid = getSourceStamp(sourcePath, stamp) && stamp.contentHash == h->source.contentHash;
+            restamp = valid;
+        }
+    }
+
+    if (!valid) {
+        close();
+        return false;
+    }
+
+    if (restamp) {
+        // same contents: store the new mtime so later launches skip the hash again. Unmapped meanwhile,
+        // Windows does not write to mapped files
+        const size_t size = file.size();
+        file.close();
+        if (!writeSourceTime(cachePath, stamp.modifiedTime)) {
+            std::cerr << "Could not update the source stamp of " << cachePath << ", the source is hashed on every open" << std::endl;
+        }
+        if (!file.open(cachePath) || file.size() != size) {
+            close();
+            return false;
+        }
+        h = reinterpret_cast<const MeshCacheHeader*>(file.data());
+    }
+    header = h;
+    return true;
+}
+
+void MeshCache::close() {
+    file.close();
+    header = nullptr;
+}
+
+std::vector<MeshMaterial> MeshCache::getMaterials() const {
+    const MeshCacheMaterial* records = reinterpret_cast<const MeshCacheMaterial*>(file.data() + header->materialOffset);
+    const char* strings = reinterpret_cast<const char*>(file.data() + header->stringOffset);
+    auto getString = [&](uint32_t offset) {
+        return offset < header->stringBytes ? std::string(strings + offset) : std::string();
+    };
+
+    std::vector<MeshMaterial> materials(header->materialCount);
+    for (uint32_t i = 0; i < header->materialCount; ++i) {
+        const MeshCacheMaterial& record = records[i];
+        MeshMaterial& m = materials[i];
+        m.diffuse = glm::vec3(record.diffuse[0], record.diffuse[1], record.diffuse[2]);
+        m.roughness = record.roughness;
+        m.metallic = record.metallic;
+        m.name = getString(record.name);
+        m.diffuseTexture = getString(record.diffuseTexture);
+        m.normalTexture = getString(record.normalTexture);
+        m.roughnessTexture = getString(record.roughnessTexture);
+        m.metallicTexture = getString(record.metallicTexture);
+        m.occlusionTexture = getString(record.occlusionTexture);
+    }
+    return materials;
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <filesystem>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MeshData.h"
+#include "MappedFile.h"
+#include "VertexLayout.h"
+#include "VertexQuantization.h"
+
+// identifies the source file a cache was built from
+struct MeshSourceStamp {
+    uint64_t size = 0;
+    int64_t modifiedTime = 0;
+    uint64_t contentHash = 0;
+};
+
+// On-disk header of a binary mesh file. All sections start 16-byte aligned:
+//   [header][position blob][vertex blob][tangent blob (optional)][index blob (u16 or u32)][Submesh records][SubmeshLod records][Meshlet records]
+//   [MeshCacheMaterial records][string table][MeshPage records]
+struct MeshCacheHeader {
+    char magic[4];
+    uint32_t version;
+    MeshSourceStamp source;
+
+    VertexLayoutDesc positionLayout; // position stream, vertex buffer slot 0
+    VertexLayoutDesc layout;         // attribute stream, slot 1
+    uint32_t formatBits; // VertexFormatOptions the vertices were packed with
+    float positionOffset[3]; // dequantization of stored positions
+    float positionScale[3];
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t indexSize; // 2 or 4 bytes
+    uint32_t submeshCount;
+    uint32_t lodCount;
+    uint32_t meshletCount;
+    uint32_t materialCount;
+    uint32_t pageCount; // >= 1, the last page covers every vertex and index
+    float boundsMin[3];
+    float boundsMax[3];
+
+    uint64_t positionStreamOffset;
+    uint64_t positionStreamBytes;
+    uint64_t vertexOffset;
+    uint64_t vertexBytes;
+    uint64_t tangentOffset; // Snorm16x4 per vertex
+    uint64_t tangentBytes;  // 0: no tangent stream
+    uint64_t indexOffset;
+    uint64_t indexBytes;
+    uint64_t submeshOffset;
+    uint64_t lodOffset;
+    uint64_t meshletOffset;
+    uint64_t materialOffset;
+    uint64_t stringOffset;
+    uint64_t stringBytes;
+    uint64_t pageOffset;
+};
+
+// MeshMaterial on disk, strings are offsets of NUL terminated entries in the string table
+struct MeshCacheMaterial {
+    float diffuse[3];
+    float roughness;
+    float metallic;
+    uint32_t name;
+    uint32_t diffuseTexture;
+    uint32_t normalTexture;
+    uint32_t roughnessTexture;
+    uint32_t metallicTexture;
+    uint32_t occlusionTexture;
+};
+
+// Versioned binary mesh written after the first OBJ parse and memory-mapped on later launches
+class MeshCache
+{
+public:
+    static constexpr uint32_t Version = 11; // 2: meshes are stored optimized, 3: packed vertex formats, 4: meshlets, 5: LODs, 6: materials, 7: tangents, 8: Submesh::baseVertex, 9: progressive pages, 10: position stream, 11: metallic / occlusion maps
+
+    // sphere.obj -> sphere.obj.meshcache
+    static std::filesystem::path getCachePath(const std::filesystem::path& sourcePath);
+    // hashContents false: size and mtime only (contentHash stays 0), without reading the file
+    static bool getSourceStamp(const std::filesystem::path& sourcePath, MeshSourceStamp& stamp, bool hashContents = true);
+
+    // pieces of write() for writers that stream the sections themselves (ObjConverter):
+    // magic, version and source stamp
+    static void initHeader(MeshCacheHeader& header, const MeshSourceStamp& source);
+    // section offsets and sizes from the counts, the layout strides, tangentBytes and stringBytes
+    static void layoutSections(MeshCacheHeader& header);
+    static void makeMaterialRecords(const std::vector<MeshMaterial>& materials,
+                                    std::vector<MeshCacheMaterial>& records, std::string& strings);
+
+    // indices, submeshes and bounds come from mesh, the vertex blobs from its packed version
+    // (packed there chunk by chunk when vertices.data is empty, see VertexQuantization::prepare)
+    static bool write(const std::filesystem::path& cachePath, const std::filesystem::path& sourcePath,
+                      const MeshData& mesh, const PackedVertices& vertices);
+
+    // maps the cache; fails if missing, corrupt, stale w.r.t. the source file or packed with other options.
+    // A source that was only touched gets its new mtime written back (when the cache is writable)
+    bool open(const std::filesystem::path& cachePath, const std::filesystem::path& sourcePath,
+              const VertexFormatOptions& options);
+    void close();
+    bool isOpen() const { return header != nullptr; }
+
+    // views into the mapping, valid while open
+    const MeshCacheHeader& getHeader() const { return *header; }
+    const void* getPositionData() const { return file.data() + header->positionStreamOffset; }
+    const void* getVertexData() const { return file.data() + header->vertexOffset; }
+    const void* getTangentData() const { return header->tangentBytes > 0 ? file.data() + header->tangentOffset : nullptr; }
+    const void* getIndexData() const { return file.data() + header->indexOffset; }
+    const Submesh* getSubmeshes() const { return reinterpret_cast<const Submesh*>(file.data() + header->submeshOffset); }
+    const SubmeshLod* getLods() const { return reinterpret_cast<const SubmeshLod*>(file.data() + header->lodOffset); }
+    const Meshlet* getMeshlets() const { return reinterpret_cast<const Meshlet*>(file.data() + header->meshletOffset); }
+    const MeshPage* getPages() const { return reinterpret_cast<const MeshPage*>(file.data() + header->pageOffset); }
+    // copies, materials hold strings
+    std::vector<MeshMaterial> getMaterials() const;
+
+private:
+    MappedFile file;
+    const MeshCacheHeader* header = nullptr;
+};
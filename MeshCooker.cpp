@@ -0,0 +1,41 @@
+#include "MeshCooker.h"
+#include "MeshCache.h"
+#include "MeshImporter.h"
+#include "MeshNormals.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+#include "ProgressiveMesh.h"
+
+#include <iostream>
+
+bool MeshCooker::build(const std::filesystem::path& meshPath, const VertexFormatOptions& options,
+                       MeshData& mesh, PackedVertices& vertices) {
+    const bool isGltf = meshPath.extension() == ".gltf" || meshPath.extension() == ".glb";
+    bool success = isGltf ? MeshImporter::getGltfGeometry(meshPath, mesh) : MeshImporter::getObjGeometry(meshPath, mesh);
+    if (!success) return false;
+
+    // tangent frames for normal maps, before the optimizer renumbers the vertices
+    if (options.tangents) MeshNormals::generateTangents(mesh);
+    // reorder for vertex cache, overdraw and vertex fetch before it gets cached / uploaded
+    MeshOptimizer::optimize(mesh);
+    // simplified versions of every submesh, drawn when the camera is far away
+    MeshSimplifier::buildLods(mesh);
+    // clusters for GPU culling, regroups the triangles of every submesh and LOD
+    MeshletBuilder::build(mesh);
+    // coarsest LODs first so they can be drawn before the rest is uploaded
+    ProgressiveMesh::build(mesh);
+
+    // layout only: the vertices are packed chunk by chunk into the cache file
+    VertexQuantization::prepare(mesh, options, vertices);
+    std::cout << "Vertex stride " << sizeof(VertexAttr) << " -> " << vertices.positionLayout.stride << " (positions) + "
+              << vertices.layout.stride << " (attributes) bytes" << std::endl;
+    return true;
+}
+
+bool MeshCooker::cook(const std::filesystem::path& meshPath, const VertexFormatOptions& options) {
+    MeshData mesh;
+    PackedVertices vertices;
+    if (!build(meshPath, options, mesh, vertices)) return false;
+    return MeshCache::write(MeshCache::getCachePath(meshPath), meshPath, mesh, vertices);
+}
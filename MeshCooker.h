@@ -0,0 +1,20 @@
+#pragma once
+#include <filesystem>
+
+#include "MeshData.h"
+#include "VertexQuantization.h"
+
+// Source mesh -> the runtime representation stored in a MeshCache: indexed, optimized for the vertex
+// cache, with LODs, meshlets and progressive pages, vertices quantized. Used by MeshStreamer on a
+// cache miss and by AssetCooker ahead of time.
+class MeshCooker
+{
+public:
+    // .obj, .gltf or .glb. vertices.data stays empty (VertexQuantization::prepare): MeshCache::write
+    // packs them chunk by chunk
+    static bool build(const std::filesystem::path& meshPath, const VertexFormatOptions& options,
+                      MeshData& mesh, PackedVertices& vertices);
+
+    // build + MeshCache::write to MeshCache::getCachePath(meshPath)
+    static bool cook(const std::filesystem::path& meshPath, const VertexFormatOptions& options);
+};
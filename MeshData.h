@@ -0,0 +1,79 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include "VertexAttr.h"
+
+// range of the index buffer drawn with one material
+struct Submesh {
+    uint32_t indexOffset = 0;
+    uint32_t indexCount = 0;
+    int32_t materialId = -1; // index into MeshData::materials, -1: no material
+    uint32_t meshletOffset = 0; // range in MeshData::meshlets
+    uint32_t meshletCount = 0;
+    uint32_t lodOffset = 0; // range in MeshData::lods, level 1 first
+    uint32_t lodCount = 0;
+    uint32_t baseVertex = 0; // added to every index (submeshes uploaded straight from a glTF)
+};
+
+// surface parameters + texture files of a submesh (paths relative to the working directory, empty: none)
+struct MeshMaterial {
+    std::string name;
+    glm::vec3 diffuse = glm::vec3(1.0f);
+    float roughness = 0.5f;
+    float metallic = 0.0f;
+    std::string diffuseTexture;
+    std::string normalTexture;
+    std::string roughnessTexture;
+    // separate grayscale maps are packed with the roughness map into one ORM texture at load (ChannelPacking)
+    std::string metallicTexture;
+    std::string occlusionTexture;
+};
+
+// simplified version of a submesh, indexing the same vertices
+struct SubmeshLod {
+    uint32_t indexOffset = 0;
+    uint32_t indexCount = 0;
+    uint32_t meshletOffset = 0;
+    uint32_t meshletCount = 0;
+    float error = 0.0f; // object space deviation from the full resolution submesh
+};
+
+// Cluster of <= 64 vertices / <= 124 triangles, a contiguous range of the index buffer.
+// Same layout as struct Meshlet in cull.wgsl (48 bytes).
+struct Meshlet {
+    float center[3]; // object space bounding sphere
+    float radius;
+    float coneAxis[3]; // average facing direction of the triangles
+    float coneCutoff;  // sin of the cone half angle (1: cone too wide, never backface culled)
+    uint32_t indexOffset;
+    uint32_t triangleCount;
+    uint32_t submeshIndex;
+    uint32_t lodLevel; // 0: full resolution, else SubmeshLod level
+};
+
+// Step of progressive loading: the vertex and index prefixes that draw every submesh one LOD finer
+// than the previous page (page 0: coarsest levels, last page: full resolution), see ProgressiveMesh
+struct MeshPage {
+    uint32_t vertexCount = 0; // vertices [0, vertexCount)
+    uint32_t indexCount = 0;  // indices [0, indexCount)
+};
+
+// Indexed triangle mesh: unique vertices + triangle list indexing into them
+struct MeshData {
+    std::vector<VertexAttr> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<glm::vec4> tangents; // optional, one per vertex: xyz tangent, w bitangent sign (MeshNormals::generateTangents)
+    std::vector<Submesh> submeshes; // sorted by material
+    std::vector<MeshMaterial> materials;
+    std::vector<SubmeshLod> lods;  // filled by MeshSimplifier::buildLods, indices after all full resolution submeshes
+    std::vector<Meshlet> meshlets; // filled by MeshletBuilder
+    std::vector<MeshPage> pages;   // filled by ProgressiveMesh, empty: one page holding everything
+
+    // object space bounds of all vertices
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+};
@@ -0,0 +1,156 @@
+#include "MeshImporter.h"
+#include "GltfLoader.h"
+#include "MeshBuilder.h"
+#include "MeshNormals.h"
+#include "ObjParser.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// obj index (pos/normal/uv indices) -> full vertex
+static VertexAttr makeVertex(const tinyobj::attrib_t& attrib, const tinyobj::index_t& idx)
+{
+    VertexAttr v{};
+
+    // pos + color
+    if (idx.vertex_index >= 0) {
+        v.position = {
+            attrib.vertices[3 * idx.vertex_index + 0],
+            attrib.vertices[3 * idx.vertex_index + 1],
+            attrib.vertices[3 * idx.vertex_index + 2]
+        };
+
+        if (!attrib.colors.empty()) {
+            v.color = {
+                attrib.colors[3 * idx.vertex_index + 0],
+                attrib.colors[3 * idx.vertex_index + 1],
+                attrib.colors[3 * idx.vertex_index + 2]
+            };
+        }
+        else {
+            v.color = glm::vec3(1.0f); // default white if no color data
+        }
+    }
+
+    // normal
+    if (idx.normal_index >= 0) {
+        v.normal = {
+            attrib.normals[3 * idx.normal_index + 0],
+            attrib.normals[3 * idx.normal_index + 1],
+            attrib.normals[3 * idx.normal_index + 2]
+        };
+    }
+
+    // uv
+    if (idx.texcoord_index >= 0) {
+        v.uv = {
+            attrib.texcoords[2 * idx.texcoord_index + 0],
+            1 - attrib.texcoords[2 * idx.texcoord_index + 1] // y-axis: 0-1 up for obj -> 0 to 1 down for webgpu
+        };
+    }
+    return v;
+}
+
+static bool parseObj(const std::filesystem::path& path, tinyobj::ObjReader& reader)
+{
+    tinyobj::ObjReaderConfig reader_config;
+    reader_config.mtl_search_path = path.parent_path().string(); // use directory of input path
+
+    if (!reader.ParseFromFile(path.string(), reader_config)) {
+        if (!reader.Error().empty()) {
+            std::cerr << "TinyObjReader: " << reader.Error() << std::endl;
+        }
+        return false;
+    }
+
+    if (!reader.Warning().empty()) {
+        std::cout << "TinyObjReader: " << reader.Warning() << std::endl;
+    }
+    return true;
+}
+
+bool MeshImporter::getObjGeometry(const std::filesystem::path& path, MeshData& meshData)
+{
+    // multithreaded parser first, tinyobj for files it does not handle (n-gons) or rejects
+    ObjGeometry geometry;
+    if (!ObjParser::parse(path, geometry)) {
+        tinyobj::ObjReader reader;
+        if (!parseObj(path, reader)) return false;
+
+        geometry.attrib = reader.GetAttrib();
+        geometry.materials = reader.GetMaterials();
+        geometry.indices.clear();
+        geometry.materialIds.clear();
+        geometry.shapeOffsets.clear();
+        for (const auto& shape : reader.GetShapes()) {
+            geometry.shapeOffsets.push_back(geometry.indices.size() / 3);
+            geometry.indices.insert(geometry.indices.end(), shape.mesh.indices.begin(), shape.mesh.indices.end());
+            geometry.materialIds.insert(geometry.materialIds.end(), shape.mesh.material_ids.begin(), shape.mesh.material_ids.end());
+        }
+    }
+
+    meshData.materials.clear();
+    for (const tinyobj::material_t& material : geometry.materials) {
+        meshData.materials.push_back(ObjParser::getMaterial(path, material));
+    }
+
+    // one range per shape and material, sorted by material so each material is bound once per frame
+    struct TriangleRun {
+        int materialId;
+        size_t shape;
+        size_t first, count;
+    };
+    std::vector<TriangleRun> runs;
+    const size_t triangleCount = geometry.indices.size() / 3;
+    size_t shape = 0;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        while (shape + 1 < geometry.shapeOffsets.size() && geometry.shapeOffsets[shape + 1] <= t) ++shape;
+        int materialId = t < geometry.materialIds.size() ? geometry.materialIds[t] : -1;
+        if (materialId >= int(geometry.materials.size())) materialId = -1;
+
+        if (!runs.empty() && runs.back().materialId == materialId && runs.back().shape == shape) {
+            runs.back().count++;
+        }
+        else {
+            runs.push_back({ materialId, shape, t, 1 });
+        }
+    }
+    std::stable_sort(runs.begin(), runs.end(),
+        [](const TriangleRun& a, const TriangleRun& b) { return a.materialId < b.materialId; });
+
+    // same vertices as the flat path, but identical corners are merged
+    MeshBuilder builder(meshData);
+    builder.reserve(geometry.indices.size());
+    for (size_t r = 0; r < runs.size(); ++r) {
+        const TriangleRun& run = runs[r];
+        // runs of one shape split by material changes back and forth become one submesh
+        if (r == 0 || runs[r - 1].materialId != run.materialId || runs[r - 1].shape != run.shape) {
+            builder.beginSubmesh(run.materialId);
+        }
+        for (size_t i = run.first * 3; i < (run.first + run.count) * 3; ++i) {
+            builder.addCorner(makeVertex(geometry.attrib, geometry.indices[i]));
+        }
+    }
+    builder.finish();
+    // OBJs without vn records
+    MeshNormals::generateNormals(meshData);
+    std::cout << path.filename().string() << ": " << meshData.submeshes.size() << " submeshes, "
+        << meshData.materials.size() << " materials" << std::endl;
+    builder.printStats(path.filename().string().c_str());
+
+    return true;
+}
+
+bool MeshImporter::getGltfGeometry(const std::filesystem::path& path, MeshData& meshData)
+{
+    GltfModel model;
+    if (!GltfLoader::load(path, model)) return false;
+    GltfLoader::getGeometry(model, meshData);
+    // primitives without NORMAL
+    MeshNormals::generateNormals(meshData);
+    std::cout << path.filename().string() << ": " << meshData.submeshes.size() << " submeshes, "
+        << meshData.materials.size() << " materials, " << meshData.vertices.size() << " vertices" << std::endl;
+
+    return true;
+}
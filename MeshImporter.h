@@ -0,0 +1,17 @@
+#pragma once
+#include <vector>
+#include <filesystem>
+
+#include "VertexAttr.h"
+#include "MeshData.h"
+#include "tiny_obj_loader.h"
+
+// OBJ / glTF files -> MeshData. No GPU code: shared by the app and AssetCooker.
+class MeshImporter
+{
+public:
+    // indexed: identical corners deduplicated into a unique vertex table
+    static bool getObjGeometry(const std::filesystem::path& path, MeshData& meshData);
+    // .gltf / .glb scene baked into one indexed mesh (node transforms applied)
+    static bool getGltfGeometry(const std::filesystem::path& path, MeshData& meshData);
+};
@@ -0,0 +1,273 @@
+#include "MeshNormals.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <glm/geometric.hpp>
+#include <glm/trigonometric.hpp>
+
+namespace {
+
+    // triangles / vertices per thread below which threads don't pay off
+    const size_t MinRange = 16384;
+
+    float getCornerAngle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b) {
+        const glm::vec3 e0 = a - p, e1 = b - p;
+        const float lengths = std::sqrt(glm::dot(e0, e0) * glm::dot(e1, e1));
+        if (lengths <= 0.0f) return 0.0f;
+        return std::acos(std::clamp(glm::dot(e0, e1) / lengths, -1.0f, 1.0f));
+    }
+
+    // corner -> vertex lists in CSR form (corner = index of mesh.indices)
+    struct VertexCorners {
+        std::vector<uint32_t> offsets; // vertexCount + 1
+        std::vector<uint32_t> corners;
+
+        VertexCorners(const std::vector<uint32_t>& vertexOfCorner, size_t vertexCount)
+            : offsets(vertexCount + 1, 0), corners(vertexOfCorner.size()) {
+            for (uint32_t v : vertexOfCorner) offsets[v + 1]++;
+            for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] += offsets[v];
+
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t c = 0; c < vertexOfCorner.size(); ++c) {
+                corners[fill[vertexOfCorner[c]]++] = static_cast<uint32_t>(c);
+            }
+        }
+    };
+
+    // Gives every vertex whose corners disagree (same(c0, c1) == false) one copy per group of
+    // agreeing corners and rewrites the indices. Returns one corner of every vertex (UINT32_MAX: unused).
+    template <typename Same>
+    std::vector<uint32_t> splitVertices(MeshData& mesh, const Same& same) {
+        const size_t vertexCount = mesh.vertices.size();
+        const size_t cornerCount = mesh.indices.size();
+        const VertexCorners vertexCorners(mesh.indices, vertexCount);
+
+        // group of every corner within its vertex, group 0 keeps the vertex
+        std::vector<uint32_t> group(cornerCount);
+        std::vector<uint32_t> extra(vertexCount + 1, 0);
+        Parallel::forRanges(vertexCount, MinRange, [&](size_t begin, size_t end) {
+            std::vector<uint32_t> leaders;
+            for (size_t v = begin; v < end; ++v) {
+                leaders.clear();
+                for (uint32_t i = vertexCorners.offsets[v]; i < vertexCorners.offsets[v + 1]; ++i) {
+                    const uint32_t c = vertexCorners.corners[i];
+                    uint32_t g = 0;
+                    while (g < leaders.size() && !same(leaders[g], c)) ++g;
+                    if (g == leaders.size()) leaders.push_back(c);
+                    group[c] = g;
+                }
+                extra[v + 1] = leaders.empty() ? 0 : static_cast<uint32_t>(leaders.size() - 1);
+            }
+        });
+        for (size_t v = 0; v < vertexCount; ++v) extra[v + 1] += extra[v];
+
+        const size_t newCount = vertexCount + extra[vertexCount];
+        mesh.vertices.resize(newCount);
+        if (!mesh.tangents.empty()) mesh.tangents.resize(newCount);
+
+        std::vector<uint32_t> firstCorner(newCount, UINT32_MAX);
+        Parallel::forRanges(vertexCount, MinRange, [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; ++v) {
+                for (uint32_t i = vertexCorners.offsets[v]; i < vertexCorners.offsets[v + 1]; ++i) {
+                    const uint32_t c = vertexCorners.corners[i];
+                    const uint32_t target = group[c] == 0 ? static_cast<uint32_t>(v)
+                        : static_cast<uint32_t>(vertexCount + extra[v] + group[c] - 1);
+                    if (firstCorner[target] == UINT32_MAX) {
+                        firstCorner[target] = c;
+                        if (target != v) {
+                            mesh.vertices[target] = mesh.vertices[v];
+                            if (!mesh.tangents.empty()) mesh.tangents[target] = mesh.tangents[v];
+                        }
+                    }
+                    mesh.indices[c] = target;
+                }
+            }
+        });
+        return firstCorner;
+    }
+
+    // exact position match, the representative is the lowest vertex index with that position
+    std::vector<uint32_t> weldPositions(const std::vector<VertexAttr>& vertices) {
+        struct PositionHash {
+            size_t operator()(const glm::vec3& p) const {
+                uint32_t bits[3];
+                std::memcpy(bits, &p, sizeof(bits));
+                return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+            }
+        };
+        const size_t vertexCount = vertices.size();
+        std::vector<uint32_t> welded(vertexCount);
+
+        // positions are partitioned by hash, one partition per thread
+        const size_t partitions = std::max<size_t>(1, std::min<size_t>(Parallel::getThreadCount(), vertexCount / MinRange));
+        Parallel::forRanges(partitions, 1, [&](size_t begin, size_t end) {
+            for (size_t partition = begin; partition < end; ++partition) {
+                std::unordered_map<glm::vec3, uint32_t, PositionHash> first;
+                first.reserve(vertexCount / partitions + 1);
+                const PositionHash hash;
+                for (size_t v = 0; v < vertexCount; ++v) {
+                    const glm::vec3& p = vertices[v].position;
+                    if (hash(p) % partitions != partition) continue;
+                    welded[v] = first.emplace(p, static_cast<uint32_t>(v)).first->second;
+                }
+            }
+        });
+        return welded;
+    }
+}
+
+bool MeshNormals::generateNormals(MeshData& mesh, float creaseAngle) {
+    const auto start = std::chrono::steady_clock::now();
+    const size_t vertexCount = mesh.vertices.size();
+    const size_t cornerCount = mesh.indices.size();
+    const size_t triangleCount = cornerCount / 3;
+
+    std::vector<char> missing(vertexCount, 0);
+    bool anyMissing = false;
+    for (size_t v = 0; v < vertexCount; ++v) {
+        const glm::vec3& n = mesh.vertices[v].normal;
+        missing[v] = glm::dot(n, n) < 1e-12f;
+        anyMissing = anyMissing || missing[v];
+    }
+    if (!anyMissing) return false;
+
+    // smooth across UV / color seams: corners are grouped by position, not by vertex
+    const std::vector<uint32_t> welded = weldPositions(mesh.vertices);
+    std::vector<uint32_t> positionOfCorner(cornerCount);
+    for (size_t c = 0; c < cornerCount; ++c) positionOfCorner[c] = welded[mesh.indices[c]];
+    const VertexCorners positionCorners(positionOfCorner, vertexCount);
+
+    // face normals, length = 2 * area, and corner angles
+    std::vector<glm::vec3> faceNormals(triangleCount);
+    std::vector<glm::vec3> faceDirections(triangleCount);
+    std::vector<float> cornerAngles(cornerCount);
+    Parallel::forRanges(triangleCount, MinRange, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; ++t) {
+            const glm::vec3& p0 = mesh.vertices[mesh.indices[3 * t + 0]].position;
+            const glm::vec3& p1 = mesh.vertices[mesh.indices[3 * t + 1]].position;
+            const glm::vec3& p2 = mesh.vertices[mesh.indices[3 * t + 2]].position;
+            faceNormals[t] = glm::cross(p1 - p0, p2 - p0);
+            const float length = glm::length(faceNormals[t]);
+            faceDirections[t] = length > 0.0f ? faceNormals[t] / length : glm::vec3(0.0f);
+            cornerAngles[3 * t + 0] = getCornerAngle(p0, p1, p2);
+            cornerAngles[3 * t + 1] = getCornerAngle(p1, p2, p0);
+            cornerAngles[3 * t + 2] = getCornerAngle(p2, p0, p1);
+        }
+    });
+
+    // angle * area weighted average of the faces around the corner within the crease angle
+    const float creaseCos = std::cos(glm::radians(creaseAngle));
+    std::vector<glm::vec3> cornerNormals(cornerCount, glm::vec3(0.0f));
+    Parallel::forRanges(triangleCount, MinRange, [&](size_t begin, size_t end) {
+        for (size_t c = begin * 3; c < end * 3; ++c) {
+            if (!missing[mesh.indices[c]]) continue;
+            const glm::vec3& face = faceDirections[c / 3];
+            glm::vec3 sum(0.0f);
+            const uint32_t p = positionOfCorner[c];
+            for (uint32_t i = positionCorners.offsets[p]; i < positionCorners.offsets[p + 1]; ++i) {
+                const uint32_t other = positionCorners.corners[i];
+                if (glm::dot(faceDirections[other / 3], face) < creaseCos) continue;
+                sum += faceNormals[other / 3] * cornerAngles[other];
+            }
+            const float length = glm::length(sum);
+            cornerNormals[c] = length > 0.0f ? sum / length : (glm::dot(face, face) > 0.0f ? face : glm::vec3(0.0f, 0.0f, 1.0f));
+        }
+    });
+
+    // vertices on creases get one copy per side
+    const std::vector<uint32_t> firstCorner = splitVertices(mesh, [&](uint32_t c0, uint32_t c1) {
+        return glm::dot(cornerNormals[c0], cornerNormals[c1]) > 0.9999f;
+    });
+    Parallel::forRanges(mesh.vertices.size(), MinRange, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            const uint32_t c = firstCorner[v];
+            if (c != UINT32_MAX && glm::dot(cornerNormals[c], cornerNormals[c]) > 0.0f) mesh.vertices[v].normal = cornerNormals[c];
+        }
+    });
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "MeshNormals: normals for " << triangleCount << " triangles, " << vertexCount << " -> "
+        << mesh.vertices.size() << " vertices in " << seconds << " s" << std::endl;
+    return true;
+}
+
+void MeshNormals::generateTangents(MeshData& mesh) {
+    const auto start = std::chrono::steady_clock::now();
+    const size_t cornerCount = mesh.indices.size();
+    const size_t triangleCount = cornerCount / 3;
+    const size_t vertexCountBefore = mesh.vertices.size();
+
+    // UV tangent of every face, oriented by the sign of its UV area (0: degenerate UVs)
+    std::vector<glm::vec3> faceTangents(triangleCount);
+    std::vector<int8_t> orientation(triangleCount);
+    std::vector<float> cornerAngles(cornerCount);
+    Parallel::forRanges(triangleCount, MinRange, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; ++t) {
+            const VertexAttr& v0 = mesh.vertices[mesh.indices[3 * t + 0]];
+            const VertexAttr& v1 = mesh.vertices[mesh.indices[3 * t + 1]];
+            const VertexAttr& v2 = mesh.vertices[mesh.indices[3 * t + 2]];
+            const glm::vec3 d1 = v1.position - v0.position, d2 = v2.position - v0.position;
+            const glm::vec2 t1 = v1.uv - v0.uv, t2 = v2.uv - v0.uv;
+            const float signedArea = t1.x * t2.y - t1.y * t2.x;
+            const glm::vec3 tangent = t2.y * d1 - t1.y * d2;
+            const float length = glm::length(tangent);
+
+            if (std::abs(signedArea) > 1e-20f && length > 0.0f) {
+                orientation[t] = signedArea > 0.0f ? 1 : -1;
+                faceTangents[t] = tangent * (float(orientation[t]) / length);
+            }
+            else {
+                orientation[t] = 0;
+                faceTangents[t] = glm::vec3(0.0f);
+            }
+            cornerAngles[3 * t + 0] = getCornerAngle(v0.position, v1.position, v2.position);
+            cornerAngles[3 * t + 1] = getCornerAngle(v1.position, v2.position, v0.position);
+            cornerAngles[3 * t + 2] = getCornerAngle(v2.position, v0.position, v1.position);
+        }
+    });
+
+    // mirrored UVs: faces of both orientations can't share a tangent frame
+    mesh.tangents.clear();
+    splitVertices(mesh, [&](uint32_t c0, uint32_t c1) {
+        const int8_t o0 = orientation[c0 / 3], o1 = orientation[c1 / 3];
+        return o0 == 0 || o1 == 0 || o0 == o1;
+    });
+
+    const size_t vertexCount = mesh.vertices.size();
+    const VertexCorners vertexCorners(mesh.indices, vertexCount);
+    mesh.tangents.assign(vertexCount, glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
+    Parallel::forRanges(vertexCount, MinRange, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            const glm::vec3 n = mesh.vertices[v].normal;
+            glm::vec3 sum(0.0f);
+            float sign = 1.0f;
+            for (uint32_t i = vertexCorners.offsets[v]; i < vertexCorners.offsets[v + 1]; ++i) {
+                const uint32_t c = vertexCorners.corners[i];
+                if (orientation[c / 3] == 0) continue;
+                sign = float(orientation[c / 3]);
+                // projected into the tangent plane of the vertex normal
+                const glm::vec3 projected = faceTangents[c / 3] - n * glm::dot(n, faceTangents[c / 3]);
+                const float length = glm::length(projected);
+                if (length > 0.0f) sum += projected * (cornerAngles[c] / length);
+            }
+
+            glm::vec3 tangent = sum - n * glm::dot(n, sum);
+            float length = glm::length(tangent);
+            if (length <= 0.0f) {
+                // no usable UVs: any direction perpendicular to the normal
+                tangent = std::abs(n.x) < 0.9f ? glm::cross(n, glm::vec3(1.0f, 0.0f, 0.0f)) : glm::cross(n, glm::vec3(0.0f, 1.0f, 0.0f));
+                length = glm::length(tangent);
+            }
+            if (length > 0.0f) mesh.tangents[v] = glm::vec4(tangent / length, sign);
+        }
+    });
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "MeshNormals: tangents for " << triangleCount << " triangles, " << vertexCountBefore << " -> "
+        << vertexCount << " vertices in " << seconds << " s" << std::endl;
+}
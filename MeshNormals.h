@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+
+#include "MeshData.h"
+
+// Load time normal / tangent generation, parallel over triangles and vertices.
+// Vertices are split where a corner needs a different value (creases, mirrored UVs).
+class MeshNormals
+{
+public:
+    // smooth normals for vertices without one (zero length): welds equal positions, then averages
+    // the angle and area weighted normals of the faces around each corner whose normals are within
+    // creaseAngle (degrees) of the corner's face. Returns false if every vertex already had a normal.
+    static bool generateNormals(MeshData& mesh, float creaseAngle = 60.0f);
+
+    // fills mesh.tangents the way MikkTSpace does: per vertex, the corner angle weighted sum of the
+    // face UV tangents projected into the normal's plane, w = bitangent sign of the face orientation
+    static void generateTangents(MeshData& mesh);
+};
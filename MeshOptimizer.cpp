@@ -0,0 +1,338 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <glm/geometric.hpp>
+
+namespace {
+
+    // vertex -> triangles adjacency in CSR form
+    struct TriangleAdjacency {
+        std::vector<uint32_t> offsets; // vertexCount + 1
+        std::vector<uint32_t> triangles;
+
+        TriangleAdjacency(const uint32_t* indices, size_t indexCount, size_t vertexCount)
+            : offsets(vertexCount + 1, 0), triangles(indexCount) {
+            for (size_t i = 0; i < indexCount; ++i) offsets[indices[i] + 1]++;
+            for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] += offsets[v];
+
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indexCount; ++i) {
+                triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+    };
+
+    // timestamp based FIFO cache: vertex is cached if it was inserted less than cacheSize insertions ago
+    struct FifoCache {
+        std::vector<uint32_t> timestamps;
+        uint32_t time;
+        uint32_t size;
+
+        FifoCache(size_t vertexCount, uint32_t cacheSize)
+            : timestamps(vertexCount, 0), time(cacheSize + 1), size(cacheSize) {}
+
+        // returns 1 on a miss
+        unsigned touch(uint32_t v) {
+            if (time - timestamps[v] > size) {
+                timestamps[v] = time++;
+                return 1;
+            }
+            return 0;
+        }
+        void flush() { time += size + 1; }
+    };
+
+    void printStats(const char* step, const VertexCacheStats& before, const VertexCacheStats& after) {
+        std::cout << "MeshOptimizer " << step << ": ACMR " << before.acmr << " -> " << after.acmr
+            << ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+    }
+}
+
+VertexCacheStats MeshOptimizer::analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+                                                   uint32_t cacheSize) {
+    VertexCacheStats stats;
+    if (indexCount == 0 || vertexCount == 0) return stats;
+
+    FifoCache cache(vertexCount, cacheSize);
+    std::vector<char> used(vertexCount, 0);
+    size_t misses = 0, usedCount = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        misses += cache.touch(indices[i]);
+        if (!used[indices[i]]) {
+            used[indices[i]] = 1;
+            ++usedCount;
+        }
+    }
+    stats.acmr = float(misses) / float(indexCount / 3);
+    stats.atvr = float(misses) / float(usedCount);
+    return stats;
+}
+
+float MeshOptimizer::analyzeVertexFetch(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t vertexSize) {
+    if (indexCount == 0 || vertexCount == 0) return 0.0f;
+
+    // small fully associative LRU of 64-byte lines, roughly a GPU vertex fetch cache
+    const size_t lineSize = 64;
+    const size_t lineCount = 32;
+    std::vector<size_t> lines;
+    lines.reserve(lineCount);
+
+    std::vector<char> used(vertexCount, 0);
+    size_t usedCount = 0, fetchedBytes = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        const uint32_t v = indices[i];
+        if (!used[v]) {
+            used[v] = 1;
+            ++usedCount;
+        }
+        const size_t firstLine = v * vertexSize / lineSize;
+        const size_t lastLine = (v * vertexSize + vertexSize - 1) / lineSize;
+        for (size_t line = firstLine; line <= lastLine; ++line) {
+            auto it = std::find(lines.begin(), lines.end(), line);
+            if (it != lines.end()) {
+                lines.erase(it);
+            }
+            else {
+                fetchedBytes += lineSize;
+                if (lines.size() == lineCount) lines.erase(lines.begin());
+            }
+            lines.push_back(line); // most recent at the back
+        }
+    }
+    return float(fetchedBytes) / float(usedCount * vertexSize);
+}
+
+void MeshOptimizer::optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize) {
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) return;
+
+    TriangleAdjacency adjacency(indices, indexCount, vertexCount);
+
+    // live triangle count per vertex
+    std::vector<uint32_t> liveTriangles(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+    }
+
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<char> emitted(triangleCount, 0);
+    std::vector<uint32_t> deadEnd; // recently referenced vertices, used when the fan runs out
+    deadEnd.reserve(indexCount);
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    output.reserve(indexCount);
+
+    uint32_t time = cacheSize + 1;
+    size_t scan = 0; // next vertex for the linear dead-end fallback
+
+    // first vertex that is actually used
+    int64_t fan = -1;
+    for (size_t v = 0; v < vertexCount; ++v) {
+        if (liveTriangles[v] > 0) {
+            fan = static_cast<int64_t>(v);
+            break;
+        }
+    }
+
+    while (fan >= 0) {
+        candidates.clear();
+
+        // emit every remaining triangle around the fanning vertex
+        for (uint32_t a = adjacency.offsets[fan]; a < adjacency.offsets[fan + 1]; ++a) {
+            const uint32_t t = adjacency.triangles[a];
+            if (emitted[t]) continue;
+            emitted[t] = 1;
+
+            for (int k = 0; k < 3; ++k) {
+                const uint32_t v = indices[3 * t + k];
+                output.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                liveTriangles[v]--;
+                if (time - cacheTime[v] > cacheSize) {
+                    cacheTime[v] = time++;
+                }
+            }
+        }
+
+        // next fan: the candidate that stays in cache longest while still having work left
+        int64_t best = -1;
+        uint32_t bestPriority = 0;
+        for (uint32_t v : candidates) {
+            if (liveTriangles[v] == 0) continue;
+            uint32_t priority = 0;
+            if (time - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize) {
+                priority = time - cacheTime[v];
+            }
+            if (best < 0 || priority > bestPriority) {
+                bestPriority = priority;
+                best = v;
+            }
+        }
+
+        if (best < 0) {
+            // dead end: most recently used vertex with live triangles, else the next one in input order
+            while (!deadEnd.empty() && best < 0) {
+                const uint32_t v = deadEnd.back();
+                deadEnd.pop_back();
+                if (liveTriangles[v] > 0) best = v;
+            }
+            while (best < 0 && scan < vertexCount) {
+                if (liveTriangles[scan] > 0) best = static_cast<int64_t>(scan);
+                ++scan;
+            }
+        }
+        fan = best;
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void MeshOptimizer::optimizeOverdraw(uint32_t* indices, size_t indexCount, const std::vector<VertexAttr>& vertices,
+                                     float threshold, uint32_t cacheSize) {
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) return;
+
+    // 1. hard boundaries: triangles where all 3 vertices miss, i.e. the cache order restarted
+    std::vector<size_t> hard;
+    {
+        FifoCache cache(vertices.size(), cacheSize);
+        for (size_t t = 0; t < triangleCount; ++t) {
+            unsigned misses = cache.touch(indices[3 * t]) + cache.touch(indices[3 * t + 1]) + cache.touch(indices[3 * t + 2]);
+            if (misses == 3) hard.push_back(t);
+        }
+        if (hard.empty() || hard[0] != 0) hard.insert(hard.begin(), 0);
+        hard.push_back(triangleCount);
+    }
+
+    // 2. soft boundaries: split hard clusters further as long as each piece stays within threshold of its ACMR
+    std::vector<size_t> clusters;
+    {
+        FifoCache cache(vertices.size(), cacheSize);
+        for (size_t h = 0; h + 1 < hard.size(); ++h) {
+            const size_t start = hard[h];
+            const size_t end = hard[h + 1];
+
+            cache.flush();
+            size_t clusterMisses = 0;
+            for (size_t t = start; t < end; ++t) {
+                clusterMisses += cache.touch(indices[3 * t]) + cache.touch(indices[3 * t + 1]) + cache.touch(indices[3 * t + 2]);
+            }
+            const float clusterThreshold = threshold * float(clusterMisses) / float(end - start);
+
+            clusters.push_back(start);
+            cache.flush();
+            size_t runningMisses = 0, runningTriangles = 0;
+            for (size_t t = start; t < end; ++t) {
+                runningMisses += cache.touch(indices[3 * t]) + cache.touch(indices[3 * t + 1]) + cache.touch(indices[3 * t + 2]);
+                runningTriangles++;
+                if (float(runningMisses) / float(runningTriangles) <= clusterThreshold && t + 1 < end) {
+                    clusters.push_back(t + 1);
+                    cache.flush();
+                    runningMisses = runningTriangles = 0;
+                }
+            }
+        }
+        clusters.push_back(triangleCount);
+    }
+
+    // 3. sort clusters by how far out they face: dot(centroid - mesh centroid, cluster normal)
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    const size_t clusterCount = clusters.size() - 1;
+    std::vector<float> sortKey(clusterCount);
+    std::vector<glm::vec3> clusterCentroid(clusterCount);
+    std::vector<glm::vec3> clusterNormal(clusterCount);
+
+    for (size_t c = 0; c < clusterCount; ++c) {
+        glm::vec3 centroid(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+            const glm::vec3& p0 = vertices[indices[3 * t]].position;
+            const glm::vec3& p1 = vertices[indices[3 * t + 1]].position;
+            const glm::vec3& p2 = vertices[indices[3 * t + 2]].position;
+            const glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            const float a = glm::length(n);
+            centroid += (p0 + p1 + p2) * (a / 3.0f);
+            normal += n;
+            area += a;
+        }
+        meshCentroid += centroid;
+        meshArea += area;
+        clusterCentroid[c] = area > 0.0f ? centroid / area : vertices[indices[3 * clusters[c]]].position;
+        clusterNormal[c] = glm::length(normal) > 0.0f ? glm::normalize(normal) : glm::vec3(0.0f);
+    }
+    if (meshArea > 0.0f) meshCentroid /= meshArea;
+    for (size_t c = 0; c < clusterCount; ++c) {
+        sortKey[c] = glm::dot(clusterCentroid[c] - meshCentroid, clusterNormal[c]);
+    }
+
+    std::vector<size_t> order(clusterCount);
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sortKey[a] > sortKey[b]; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indexCount);
+    for (size_t c : order) {
+        output.insert(output.end(), indices + 3 * clusters[c], indices + 3 * clusters[c + 1]);
+    }
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void MeshOptimizer::optimizeVertexFetch(MeshData& mesh) {
+    const uint32_t unused = UINT32_MAX;
+    std::vector<uint32_t> remap(mesh.vertices.size(), unused);
+    std::vector<VertexAttr> reordered;
+    reordered.reserve(mesh.vertices.size());
+    std::vector<glm::vec4> reorderedTangents;
+    reorderedTangents.reserve(mesh.tangents.size());
+
+    for (uint32_t& index : mesh.indices) {
+        if (remap[index] == unused) {
+            remap[index] = static_cast<uint32_t>(reordered.size());
+            reordered.push_back(mesh.vertices[index]);
+            if (!mesh.tangents.empty()) reorderedTangents.push_back(mesh.tangents[index]);
+        }
+        index = remap[index];
+    }
+    // unreferenced vertices are dropped
+    mesh.vertices.swap(reordered);
+    mesh.tangents.swap(reorderedTangents);
+}
+
+void MeshOptimizer::optimize(MeshData& mesh) {
+    if (mesh.indices.empty()) return;
+    const size_t vertexCount = mesh.vertices.size();
+
+    auto analyze = [&]() {
+        return analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+    };
+
+    // ranges to optimize independently (materials must stay contiguous)
+    std::vector<Submesh> ranges = mesh.submeshes;
+    if (ranges.empty()) ranges.push_back({ 0, static_cast<uint32_t>(mesh.indices.size()), -1 });
+
+    VertexCacheStats before = analyze();
+    for (const Submesh& range : ranges) {
+        optimizeVertexCache(mesh.indices.data() + range.indexOffset, range.indexCount, vertexCount);
+    }
+    VertexCacheStats after = analyze();
+    printStats("vertex cache", before, after);
+
+    before = after;
+    for (const Submesh& range : ranges) {
+        optimizeOverdraw(mesh.indices.data() + range.indexOffset, range.indexCount, mesh.vertices);
+    }
+    after = analyze();
+    printStats("overdraw", before, after);
+
+    before = after;
+    const float fetchBefore = analyzeVertexFetch(mesh.indices.data(), mesh.indices.size(), vertexCount, sizeof(VertexAttr));
+    optimizeVertexFetch(mesh);
+    const float fetchAfter = analyzeVertexFetch(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size(), sizeof(VertexAttr));
+    after = analyze();
+    printStats("vertex fetch", before, after);
+    std::cout << "MeshOptimizer vertex fetch: overfetch " << fetchBefore << " -> " << fetchAfter << std::endl;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "MeshData.h"
+
+// post-transform cache statistics of an index buffer
+struct VertexCacheStats {
+    float acmr = 0.0f; // average cache misses per triangle (0.5 is ideal on big grids, 3 is worst)
+    float atvr = 0.0f; // average transformed vertices per vertex (1 is ideal)
+};
+
+// Reorders an indexed mesh for the GPU: vertex cache locality (Tipsify), overdraw (cluster sort)
+// and vertex fetch locality (first-use order). Runs per submesh, so material ranges stay intact.
+class MeshOptimizer
+{
+public:
+    static constexpr uint32_t CacheSize = 16;
+
+    // FIFO cache simulation
+    static VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+                                               uint32_t cacheSize = CacheSize);
+    // bytes pulled from memory per vertex with a small 64-byte line cache (1 = every byte fetched once)
+    static float analyzeVertexFetch(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t vertexSize);
+
+    // Tipsify (Sander et al. 2007), linear time
+    static void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount,
+                                    uint32_t cacheSize = CacheSize);
+    // splits the cache-optimized order into clusters whose ACMR stays within `threshold` of the
+    // original and sorts them so outward facing clusters come first (Sander et al. 2007)
+    static void optimizeOverdraw(uint32_t* indices, size_t indexCount, const std::vector<VertexAttr>& vertices,
+                                 float threshold = 1.05f, uint32_t cacheSize = CacheSize);
+    // renumbers vertices in order of first use
+    static void optimizeVertexFetch(MeshData& mesh);
+
+    // all of the above, with before/after stats printed for every step
+    static void optimize(MeshData& mesh);
+};
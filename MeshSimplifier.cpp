@@ -0,0 +1,238 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <unordered_set>
+#include <glm/geometric.hpp>
+
+namespace {
+
+    // vertex -> triangles adjacency in CSR form
+    struct TriangleAdjacency {
+        std::vector<uint32_t> offsets; // vertexCount + 1
+        std::vector<uint32_t> triangles;
+
+        TriangleAdjacency(const uint32_t* indices, size_t indexCount, size_t vertexCount)
+            : offsets(vertexCount + 1, 0), triangles(indexCount) {
+            for (size_t i = 0; i < indexCount; ++i) offsets[indices[i] + 1]++;
+            for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] += offsets[v];
+
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indexCount; ++i) {
+                triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+    };
+
+    // sum of area weighted squared plane distances: p^T A p + 2 b.p + c, A symmetric
+    struct Quadric {
+        double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+        double b0 = 0, b1 = 0, b2 = 0;
+        double c = 0;
+        double weight = 0;
+
+        // plane n.p + d = 0, n unit length
+        static Quadric fromPlane(const glm::dvec3& n, double d, double w) {
+            Quadric q;
+            q.a00 = w * n.x * n.x; q.a01 = w * n.x * n.y; q.a02 = w * n.x * n.z;
+            q.a11 = w * n.y * n.y; q.a12 = w * n.y * n.z; q.a22 = w * n.z * n.z;
+            q.b0 = w * n.x * d; q.b1 = w * n.y * d; q.b2 = w * n.z * d;
+            q.c = w * d * d;
+            q.weight = w;
+            return q;
+        }
+
+        void add(const Quadric& q) {
+            a00 += q.a00; a01 += q.a01; a02 += q.a02;
+            a11 += q.a11; a12 += q.a12; a22 += q.a22;
+            b0 += q.b0; b1 += q.b1; b2 += q.b2;
+            c += q.c;
+            weight += q.weight;
+        }
+
+        // RMS distance of p to the planes
+        float getError(const glm::vec3& p) const {
+            if (weight <= 0.0) return 0.0f;
+            const double x = p.x, y = p.y, z = p.z;
+            const double r = a00 * x * x + a11 * y * y + a22 * z * z
+                + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+            return static_cast<float>(std::sqrt(std::max(r, 0.0) / weight));
+        }
+    };
+
+    struct Collapse {
+        uint32_t from;
+        uint32_t to;
+        float error;
+    };
+
+    uint64_t edgeKey(uint32_t a, uint32_t b) {
+        return (uint64_t(a) << 32) | b;
+    }
+}
+
+float MeshSimplifier::simplify(const std::vector<VertexAttr>& vertices, const uint32_t* indices, size_t indexCount,
+                               size_t targetIndexCount, float targetError, std::vector<uint32_t>& result) {
+    result.assign(indices, indices + indexCount);
+    if (indexCount <= targetIndexCount) return 0.0f;
+
+    const size_t vertexCount = vertices.size();
+
+    // an edge is open if no triangle uses it in the opposite direction
+    std::unordered_set<uint64_t> edges;
+    edges.reserve(indexCount);
+    for (size_t i = 0; i < indexCount; i += 3) {
+        for (int k = 0; k < 3; ++k) edges.insert(edgeKey(indices[i + k], indices[i + (k + 1) % 3]));
+    }
+    std::vector<char> locked(vertexCount, 0);
+    for (size_t i = 0; i < indexCount; i += 3) {
+        for (int k = 0; k < 3; ++k) {
+            const uint32_t a = indices[i + k], b = indices[i + (k + 1) % 3];
+            if (edges.count(edgeKey(b, a)) == 0) locked[a] = locked[b] = 1;
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < indexCount; i += 3) {
+        const glm::dvec3 p0 = vertices[indices[i + 0]].position;
+        const glm::dvec3 p1 = vertices[indices[i + 1]].position;
+        const glm::dvec3 p2 = vertices[indices[i + 2]].position;
+        glm::dvec3 n = glm::cross(p1 - p0, p2 - p0);
+        const double area = glm::length(n);
+        if (area == 0.0) continue;
+        n /= area;
+
+        const Quadric q = Quadric::fromPlane(n, -glm::dot(n, p0), area * 0.5);
+        for (int k = 0; k < 3; ++k) quadrics[indices[i + k]].add(q);
+    }
+
+    float resultError = 0.0f;
+    std::vector<uint32_t> remap(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) remap[v] = static_cast<uint32_t>(v);
+    std::vector<char> touched(vertexCount, 0);
+    std::vector<Collapse> collapses;
+
+    // passes of independent collapses, cheapest first
+    while (result.size() > targetIndexCount) {
+        const TriangleAdjacency adjacency(result.data(), result.size(), vertexCount);
+
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); i += 3) {
+            for (int k = 0; k < 3; ++k) {
+                const uint32_t a = result[i + k], b = result[i + (k + 1) % 3];
+                if (a > b || (locked[a] && locked[b])) continue; // interior edges show up once per direction
+                // smooth shading across the collapse: don't merge vertices with diverging normals
+                if (glm::dot(vertices[a].normal, vertices[b].normal) < 0.5f) continue;
+
+                Quadric merged = quadrics[a];
+                merged.add(quadrics[b]);
+                const float errorAB = locked[a] ? std::numeric_limits<float>::max() : merged.getError(vertices[b].position);
+                const float errorBA = locked[b] ? std::numeric_limits<float>::max() : merged.getError(vertices[a].position);
+
+                collapses.push_back(errorAB <= errorBA ? Collapse{ a, b, errorAB } : Collapse{ b, a, errorBA });
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(),
+            [](const Collapse& x, const Collapse& y) { return x.error < y.error; });
+
+        std::fill(touched.begin(), touched.end(), 0);
+        size_t triangleCount = result.size() / 3;
+        std::vector<uint32_t> collapsed;
+
+        for (const Collapse& collapse : collapses) {
+            if (collapse.error > targetError || triangleCount * 3 <= targetIndexCount) break;
+            if (touched[collapse.from] || touched[collapse.to]) continue;
+
+            // reject collapses that fold a remaining triangle over
+            bool valid = true;
+            size_t removed = 0;
+            const glm::vec3& target = vertices[collapse.to].position;
+            for (uint32_t a = adjacency.offsets[collapse.from]; a < adjacency.offsets[collapse.from + 1] && valid; ++a) {
+                const uint32_t* tri = &result[3 * adjacency.triangles[a]];
+                if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to) {
+                    removed++;
+                    continue;
+                }
+                glm::vec3 p[3], q[3];
+                for (int k = 0; k < 3; ++k) {
+                    p[k] = vertices[tri[k]].position;
+                    q[k] = tri[k] == collapse.from ? target : p[k];
+                }
+                const glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                const glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+                const float lengths = glm::length(before) * glm::length(after);
+                if (glm::length(before) > 0.0f && glm::dot(before, after) <= 0.25f * lengths) valid = false;
+            }
+            if (!valid) continue;
+
+            // the one-ring of `from` changes: keep it out of the rest of this pass
+            for (uint32_t a = adjacency.offsets[collapse.from]; a < adjacency.offsets[collapse.from + 1]; ++a) {
+                const uint32_t* tri = &result[3 * adjacency.triangles[a]];
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = 1;
+            }
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to].add(quadrics[collapse.from]);
+            collapsed.push_back(collapse.from);
+            triangleCount -= removed;
+            resultError = std::max(resultError, collapse.error);
+        }
+        if (collapsed.empty()) break;
+
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3) {
+            const uint32_t a = remap[result[i + 0]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+            if (a == b || b == c || a == c) continue;
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+        for (uint32_t v : collapsed) remap[v] = v;
+    }
+    return resultError;
+}
+
+void MeshSimplifier::buildLods(MeshData& mesh, float ratio, uint32_t minTriangles) {
+    mesh.lods.clear();
+    std::vector<uint32_t> current, next;
+
+    for (uint32_t s = 0; s < mesh.submeshes.size(); ++s) {
+        Submesh& submesh = mesh.submeshes[s];
+        submesh.lodOffset = static_cast<uint32_t>(mesh.lods.size());
+        submesh.lodCount = 0;
+
+        current.assign(mesh.indices.begin() + submesh.indexOffset,
+                       mesh.indices.begin() + submesh.indexOffset + submesh.indexCount);
+        // every level is simplified from the previous one, so errors add up
+        float error = 0.0f;
+
+        while (submesh.lodCount < MaxLods) {
+            const size_t targetIndexCount = static_cast<size_t>(current.size() / 3 * ratio) * 3;
+            if (targetIndexCount / 3 < minTriangles) break;
+
+            const float levelError = simplify(mesh.vertices, current.data(), current.size(), targetIndexCount,
+                std::numeric_limits<float>::max(), next);
+            // stuck on locked vertices: less than half of the requested reduction
+            if (next.size() > (current.size() + targetIndexCount) / 2) break;
+
+            MeshOptimizer::optimizeVertexCache(next.data(), next.size(), mesh.vertices.size());
+            error += levelError;
+
+            SubmeshLod lod;
+            lod.indexOffset = static_cast<uint32_t>(mesh.indices.size());
+            lod.indexCount = static_cast<uint32_t>(next.size());
+            lod.error = error;
+            mesh.indices.insert(mesh.indices.end(), next.begin(), next.end());
+            mesh.lods.push_back(lod);
+            submesh.lodCount++;
+
+            std::cout << "MeshSimplifier submesh " << s << " LOD " << submesh.lodCount << ": "
+                << current.size() / 3 << " -> " << next.size() / 3 << " triangles, error " << error << std::endl;
+            current.swap(next);
+        }
+    }
+}
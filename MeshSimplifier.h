@@ -0,0 +1,23 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "MeshData.h"
+
+// Quadric error metric simplification (Garland & Heckbert 1997) by half-edge collapses, so every
+// LOD indexes the original vertex buffer. Vertices on open edges are locked: this keeps borders,
+// UV / normal seams (split vertices) and the boundaries between submeshes in place.
+class MeshSimplifier
+{
+public:
+    static constexpr uint32_t MaxLods = 8;
+
+    // collapses until the index count reaches targetIndexCount or the next collapse would exceed
+    // targetError (object space distance). Returns the error of the result.
+    static float simplify(const std::vector<VertexAttr>& vertices, const uint32_t* indices, size_t indexCount,
+                          size_t targetIndexCount, float targetError, std::vector<uint32_t>& result);
+
+    // appends a chain of LODs per submesh, each about `ratio` of the previous one, to mesh.lods / mesh.indices
+    static void buildLods(MeshData& mesh, float ratio = 0.5f, uint32_t minTriangles = 64);
+};
@@ -0,0 +1,150 @@
+#include "MeshStreamer.h"
+#include "MeshCooker.h"
+#include "ObjConverter.h"
+
+#include <iostream>
+
+// reads one byte of every 4 KiB page of [begin, end) so the OS faults the file range in
+static uint8_t touchPages(const uint8_t* data, uint64_t begin, uint64_t end) {
+    uint8_t sum = 0;
+    for (uint64_t offset = begin; offset < end; offset += 4096) sum ^= data[offset];
+    return sum;
+}
+
+void MeshStreamer::start(const std::filesystem::path& path, const VertexFormatOptions& formatOptions) {
+    meshPath = path;
+    options = formatOptions;
+    started = true;
+#ifdef __EMSCRIPTEN__
+    run();
+#else
+    thread = std::thread(&MeshStreamer::run, this);
+#endif
+}
+
+void MeshStreamer::stop() {
+    stopRequested.store(true);
+    if (thread.joinable()) thread.join();
+}
+
+void MeshStreamer::run() {
+    if (!load()) {
+        state.store(State::Failed, std::memory_order_release);
+        return;
+    }
+    state.store(State::Ready, std::memory_order_release);
+
+    // pages in upload order, the render thread then copies from memory instead of the disk
+    volatile uint8_t sink = 0;
+    uint64_t positionEnd = 0;
+    uint64_t vertexEnd = 0;
+    uint64_t tangentEnd = 0;
+    uint64_t indexEnd = 0;
+    for (uint32_t p = 0; p < mesh.pages.size() && !stopRequested.load(); ++p) {
+        const uint64_t positionBytes = uint64_t(mesh.pages[p].vertexCount) * mesh.positionLayout.stride;
+        const uint64_t vertexBytes = uint64_t(mesh.pages[p].vertexCount) * mesh.layout.stride;
+        const uint64_t tangentBytes = mesh.tangentData ? uint64_t(mesh.pages[p].vertexCount) * 8 : 0;
+        const uint64_t indexBytes = uint64_t(mesh.pages[p].indexCount) * mesh.indexSize;
+        sink = sink ^ touchPages(mesh.positionData, positionEnd, positionBytes) ^
+            touchPages(mesh.vertexData, vertexEnd, vertexBytes) ^ touchPages(mesh.tangentData, tangentEnd, tangentBytes) ^
+            touchPages(mesh.indexData, indexEnd, indexBytes);
+        positionEnd = positionBytes;
+        vertexEnd = vertexBytes;
+        tangentEnd = tangentBytes;
+        indexEnd = indexBytes;
+        loadedPages.store(p + 1, std::memory_order_release);
+    }
+}
+
+bool MeshStreamer::load() {
+    // binary cache: mapped as is, no OBJ parsing
+    const std::filesystem::path cachePath = MeshCache::getCachePath(meshPath);
+    if (cache.open(cachePath, meshPath, options)) {
+        std::cout << "Loaded mesh cache " << cachePath << std::endl;
+        setMeshFromCache();
+        return true;
+    }
+
+    // too large to parse in memory: converted out of core, then mapped like any cache
+    if (ObjConverter::needsConversion(meshPath, ObjConverter::DefaultMaxMemory)) {
+        if (!ObjConverter::convert(meshPath, cachePath, options, ObjConverter::DefaultMaxMemory) || !cache.open(cachePath, meshPath, options)) {
+            std::cerr << "Could not convert " << meshPath << std::endl;
+            return false;
+        }
+        setMeshFromCache();
+        return true;
+    }
+
+    if (!MeshCooker::build(meshPath, options, meshData, packed)) {
+        std::cerr << "Could not load geometry!" << std::endl;
+        return false;
+    }
+
+    if (MeshCache::write(cachePath, meshPath, meshData, packed) && cache.open(cachePath, meshPath, options)) {
+        setMeshFromCache();
+        meshData = MeshData();
+        return true;
+    }
+
+    // e.g. read-only asset folder: serve the parsed mesh from memory. The unpacked vertices are freed once
+    // packed, only the packed streams and the indices stay resident
+    const size_t vertexCount = meshData.vertices.size();
+    std::cerr << "Could not write mesh cache " << cachePath << ", keeping the mesh in memory ("
+              << (vertexCount * (packed.positionLayout.stride + packed.layout.stride) + packed.tangents.size() +
+                  meshData.indices.size() * sizeof(uint32_t)) / (1024 * 1024) << " MB)" << std::endl;
+    packed.positions.resize(vertexCount * packed.positionLayout.stride);
+    VertexQuantization::packVertices(meshData, packed, packed.positionLayout, 0, vertexCount, packed.positions.data());
+    packed.data.resize(vertexCount * packed.layout.stride);
+    VertexQuantization::packVertices(meshData, packed, packed.layout, 0, vertexCount, packed.data.data());
+    meshData.vertices = std::vector<VertexAttr>();
+    meshData.tangents = std::vector<glm::vec4>();
+    mesh.positionLayout = packed.positionLayout;
+    mesh.layout = packed.layout;
+    mesh.positionOffset = packed.positionOffset;
+    mesh.positionScale = packed.positionScale;
+    mesh.boundsMin = meshData.boundsMin;
+    mesh.boundsMax = meshData.boundsMax;
+    mesh.positionData = packed.positions.data();
+    mesh.vertexData = packed.data.data();
+    mesh.tangentData = packed.tangents.empty() ? nullptr : packed.tangents.data();
+    mesh.indexData = reinterpret_cast<const uint8_t*>(meshData.indices.data());
+    mesh.indexSize = sizeof(uint32_t);
+    mesh.vertexCount = static_cast<uint32_t>(vertexCount);
+    mesh.indexCount = static_cast<uint32_t>(meshData.indices.size());
+    mesh.submeshes = meshData.submeshes;
+    mesh.lods = meshData.lods;
+    mesh.meshlets = meshData.meshlets.data();
+    mesh.meshletCount = static_cast<uint32_t>(meshData.meshlets.size());
+    mesh.materials = meshData.materials;
+    mesh.pages = meshData.pages;
+    if (mesh.pages.empty()) mesh.pages.push_back({ mesh.vertexCount, mesh.indexCount });
+    return true;
+}
+
+void MeshStreamer::setMeshFromCache() {
+    const MeshCacheHeader& header = cache.getHeader();
+    mesh.positionLayout = header.positionLayout;
+    mesh.layout = header.layout;
+    mesh.positionOffset = glm::vec3(header.positionOffset[0], header.positionOffset[1], header.positionOffset[2]);
+    mesh.positionScale = glm::vec3(header.positionScale[0], header.positionScale[1], header.positionScale[2]);
+    mesh.boundsMin = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+    mesh.boundsMax = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+    mesh.positionData = static_cast<const uint8_t*>(cache.getPositionData());
+    mesh.vertexData = static_cast<const uint8_t*>(cache.getVertexData());
+    mesh.tangentData = static_cast<const uint8_t*>(cache.getTangentData());
+    mesh.indexData = static_cast<const uint8_t*>(cache.getIndexData());
+    mesh.indexSize = header.indexSize;
+    mesh.vertexCount = header.vertexCount;
+    mesh.indexCount = header.indexCount;
+    mesh.submeshes.assign(cache.getSubmeshes(), cache.getSubmeshes() + header.submeshCount);
+    mesh.lods.assign(cache.getLods(), cache.getLods() + header.lodCount);
+    mesh.meshlets = cache.getMeshlets();
+    mesh.meshletCount = header.meshletCount;
+    mesh.materials = cache.getMaterials();
+    mesh.pages.assign(cache.getPages(), cache.getPages() + header.pageCount);
+
+    // MeshCooker builds meshlets for every mesh, ObjConverter none
+    if (header.meshletCount == 0 && header.indexCount > 0) {
+        std::cout << "Mesh converted out of core: no LODs, meshlets or progressive pages, drawn whole without culling" << std::endl;
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <filesystem>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <glm/vec3.hpp>
+
+#include "MeshData.h"
+#include "MeshCache.h"
+#include "VertexLayout.h"
+#include "VertexQuantization.h"
+
+// Loads the mesh drawn by Application on a background thread: maps its cache (cooked by AssetCooker
+// or a previous launch), or builds it first on a miss (MeshCooker), then reads the pages in order
+// so the render thread can upload each one without waiting on the disk.
+class MeshStreamer
+{
+public:
+    // what the renderer needs, views into the cache mapping (or the in-memory mesh if no cache could be written)
+    struct Mesh {
+        VertexLayoutDesc positionLayout; // position stream, vertex buffer slot 0
+        VertexLayoutDesc layout;         // attribute stream, slot 1
+        glm::vec3 positionOffset = glm::vec3(0.0f);
+        glm::vec3 positionScale = glm::vec3(1.0f);
+        glm::vec3 boundsMin = glm::vec3(0.0f);
+        glm::vec3 boundsMax = glm::vec3(0.0f);
+        const uint8_t* positionData = nullptr; // positionLayout.stride bytes per vertex
+        const uint8_t* vertexData = nullptr;   // layout.stride bytes per vertex
+        const uint8_t* tangentData = nullptr;  // Snorm16x4 per vertex, nullptr: built without tangents
+        const uint8_t* indexData = nullptr;  // padded to 4 bytes
+        uint32_t indexSize = 4;
+        uint32_t vertexCount = 0;
+        uint32_t indexCount = 0;
+        std::vector<Submesh> submeshes;
+        std::vector<SubmeshLod> lods;
+        const Meshlet* meshlets = nullptr;
+        uint32_t meshletCount = 0;
+        std::vector<MeshMaterial> materials;
+        std::vector<MeshPage> pages;
+    };
+
+    ~MeshStreamer() { stop(); }
+
+    // returns immediately, except on Emscripten (no threads) where everything is loaded here
+    void start(const std::filesystem::path& meshPath, const VertexFormatOptions& options);
+    // waits for the thread: a cache that is being built is finished first
+    void stop();
+
+    bool isStarted() const { return started; }
+    bool isReady() const { return state.load(std::memory_order_acquire) == State::Ready; }
+    bool hasFailed() const { return state.load(std::memory_order_acquire) == State::Failed; }
+    // valid once ready
+    const Mesh& getMesh() const { return mesh; }
+    // pages whose vertices and indices are in memory, uploads of later pages would stall on the disk
+    uint32_t getLoadedPageCount() const { return loadedPages.load(std::memory_order_acquire); }
+
+private:
+    enum class State { Loading, Ready, Failed };
+
+    void run();
+    bool load();
+    void setMeshFromCache();
+
+    std::filesystem::path meshPath;
+    VertexFormatOptions options;
+    bool started = false;
+    std::thread thread;
+    std::atomic<State> state{ State::Loading };
+    std::atomic<uint32_t> loadedPages{ 0 };
+    std::atomic<bool> stopRequested{ false };
+
+    Mesh mesh;
+    MeshCache cache;
+    // fallback when the cache cannot be written (e.g. read-only asset folder)
+    MeshData meshData;
+    PackedVertices packed;
+};
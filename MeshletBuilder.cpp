@@ -0,0 +1,266 @@
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <glm/geometric.hpp>
+
+namespace {
+
+    // vertex -> triangles adjacency in CSR form
+    struct TriangleAdjacency {
+        std::vector<uint32_t> offsets; // vertexCount + 1
+        std::vector<uint32_t> triangles;
+
+        TriangleAdjacency(const uint32_t* indices, size_t indexCount, size_t vertexCount)
+            : offsets(vertexCount + 1, 0), triangles(indexCount) {
+            for (size_t i = 0; i < indexCount; ++i) offsets[indices[i] + 1]++;
+            for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] += offsets[v];
+
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indexCount; ++i) {
+                triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+    };
+
+    // index range split into meshlets: a full resolution submesh or one of its LODs
+    struct MeshletRange {
+        uint32_t* indexOffset;
+        uint32_t indexCount;
+        uint32_t* meshletOffset;
+        uint32_t* meshletCount;
+        uint32_t submeshIndex;
+        uint32_t lodLevel;
+    };
+
+    // meshlet being grown
+    struct MeshletState {
+        uint32_t id = 0;
+        std::vector<uint32_t> vertices;
+        uint32_t triangleCount = 0;
+        glm::vec3 positionSum = glm::vec3(0.0f);
+
+        glm::vec3 getCentroid() const {
+            return vertices.empty() ? glm::vec3(0.0f) : positionSum / float(vertices.size());
+        }
+    };
+}
+
+Meshlet MeshletBuilder::computeBounds(const MeshData& mesh, uint32_t indexOffset, uint32_t triangleCount) {
+    Meshlet meshlet{};
+    meshlet.indexOffset = indexOffset;
+    meshlet.triangleCount = triangleCount;
+
+    const uint32_t* indices = mesh.indices.data() + indexOffset;
+    const uint32_t indexCount = triangleCount * 3;
+
+    // sphere around the AABB center
+    glm::vec3 minPos(std::numeric_limits<float>::max());
+    glm::vec3 maxPos(-std::numeric_limits<float>::max());
+    for (uint32_t i = 0; i < indexCount; ++i) {
+        minPos = glm::min(minPos, mesh.vertices[indices[i]].position);
+        maxPos = glm::max(maxPos, mesh.vertices[indices[i]].position);
+    }
+    const glm::vec3 center = (minPos + maxPos) * 0.5f;
+    float radius = 0.0f;
+    for (uint32_t i = 0; i < indexCount; ++i) {
+        radius = std::max(radius, glm::length(mesh.vertices[indices[i]].position - center));
+    }
+
+    // normal cone: average face normal, cutoff from the widest deviation
+    std::vector<glm::vec3> normals;
+    normals.reserve(triangleCount);
+    glm::vec3 normalSum(0.0f);
+    for (uint32_t t = 0; t < triangleCount; ++t) {
+        const glm::vec3& a = mesh.vertices[indices[3 * t + 0]].position;
+        const glm::vec3& b = mesh.vertices[indices[3 * t + 1]].position;
+        const glm::vec3& c = mesh.vertices[indices[3 * t + 2]].position;
+        const glm::vec3 n = glm::cross(b - a, c - a);
+        const float length = glm::length(n);
+        if (length == 0.0f) continue; // degenerate triangles face nowhere
+        normals.push_back(n / length);
+        normalSum += normals.back();
+    }
+
+    glm::vec3 axis(0.0f, 0.0f, 1.0f);
+    float cutoff = 1.0f;
+    const float sumLength = glm::length(normalSum);
+    if (sumLength > 0.0f) {
+        axis = normalSum / sumLength;
+        float minDot = 1.0f;
+        for (const glm::vec3& n : normals) minDot = std::min(minDot, glm::dot(axis, n));
+        // cones wider than ~84 degrees are useless for culling
+        if (minDot > 0.1f) cutoff = std::sqrt(1.0f - minDot * minDot);
+    }
+
+    for (int c = 0; c < 3; ++c) {
+        meshlet.center[c] = center[c];
+        meshlet.coneAxis[c] = axis[c];
+    }
+    meshlet.radius = radius;
+    meshlet.coneCutoff = cutoff;
+    return meshlet;
+}
+
+void MeshletBuilder::build(MeshData& mesh) {
+    mesh.meshlets.clear();
+    if (mesh.indices.empty()) return;
+
+    const size_t triangleTotal = mesh.indices.size() / 3;
+    const TriangleAdjacency adjacency(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+
+    std::vector<uint32_t> newIndices;
+    newIndices.reserve(mesh.indices.size());
+    std::vector<char> emitted(triangleTotal, 0);
+    // triangles not emitted yet per vertex; candidates finishing off a vertex are preferred so no slivers remain
+    std::vector<uint32_t> liveTriangles(mesh.vertices.size());
+    for (size_t v = 0; v < mesh.vertices.size(); ++v) {
+        liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+    }
+    // id of the meshlet a vertex was last added to
+    std::vector<uint32_t> vertexMeshlet(mesh.vertices.size(), std::numeric_limits<uint32_t>::max());
+
+    MeshletState state;
+    uint32_t verticesTotal = 0;
+
+    // full resolution submeshes first, then their LODs
+    std::vector<MeshletRange> ranges;
+    for (uint32_t s = 0; s < mesh.submeshes.size(); ++s) {
+        Submesh& submesh = mesh.submeshes[s];
+        ranges.push_back({ &submesh.indexOffset, submesh.indexCount, &submesh.meshletOffset, &submesh.meshletCount, s, 0 });
+    }
+    for (uint32_t s = 0; s < mesh.submeshes.size(); ++s) {
+        const Submesh& submesh = mesh.submeshes[s];
+        for (uint32_t l = 0; l < submesh.lodCount; ++l) {
+            SubmeshLod& lod = mesh.lods[submesh.lodOffset + l];
+            ranges.push_back({ &lod.indexOffset, lod.indexCount, &lod.meshletOffset, &lod.meshletCount, s, l + 1 });
+        }
+    }
+
+    for (const MeshletRange& range : ranges) {
+        const uint32_t firstTriangle = *range.indexOffset / 3;
+        const uint32_t endTriangle = firstTriangle + range.indexCount / 3;
+        *range.indexOffset = static_cast<uint32_t>(newIndices.size());
+        *range.meshletOffset = static_cast<uint32_t>(mesh.meshlets.size());
+
+        auto newVertexCount = [&](uint32_t t) {
+            uint32_t count = 0;
+            for (int k = 0; k < 3; ++k) count += vertexMeshlet[mesh.indices[3 * t + k]] != state.id;
+            return count;
+        };
+        auto addTriangle = [&](uint32_t t) {
+            for (int k = 0; k < 3; ++k) {
+                uint32_t v = mesh.indices[3 * t + k];
+                newIndices.push_back(v);
+                liveTriangles[v]--;
+                if (vertexMeshlet[v] != state.id) {
+                    vertexMeshlet[v] = state.id;
+                    state.vertices.push_back(v);
+                    state.positionSum += mesh.vertices[v].position;
+                }
+            }
+            emitted[t] = 1;
+            state.triangleCount++;
+        };
+        // best unemitted neighbour of the given vertices: fewest new vertices, then the one finishing
+        // a vertex with the fewest remaining triangles, then closest to the centroid
+        auto findNext = [&](const uint32_t* vertices, size_t count, const glm::vec3& centroid) {
+            uint32_t best = std::numeric_limits<uint32_t>::max();
+            uint32_t bestExtra = 4;
+            uint32_t bestLive = std::numeric_limits<uint32_t>::max();
+            float bestDistance = std::numeric_limits<float>::max();
+            for (size_t i = 0; i < count; ++i) {
+                const uint32_t v = vertices[i];
+                for (uint32_t a = adjacency.offsets[v]; a < adjacency.offsets[v + 1]; ++a) {
+                    const uint32_t t = adjacency.triangles[a];
+                    if (t < firstTriangle || t >= endTriangle || emitted[t]) continue;
+
+                    const uint32_t extra = newVertexCount(t);
+                    if (state.vertices.size() + extra > MaxVertices || extra > bestExtra) continue;
+
+                    const uint32_t live = std::min({ liveTriangles[mesh.indices[3 * t + 0]],
+                        liveTriangles[mesh.indices[3 * t + 1]], liveTriangles[mesh.indices[3 * t + 2]] });
+                    if (extra == bestExtra && live > bestLive) continue;
+
+                    const glm::vec3 triCentroid = (mesh.vertices[mesh.indices[3 * t + 0]].position +
+                        mesh.vertices[mesh.indices[3 * t + 1]].position +
+                        mesh.vertices[mesh.indices[3 * t + 2]].position) / 3.0f;
+                    const glm::vec3 d = triCentroid - centroid;
+                    const float distance = glm::dot(d, d);
+                    if (extra < bestExtra || live < bestLive || distance < bestDistance) {
+                        best = t;
+                        bestExtra = extra;
+                        bestLive = live;
+                        bestDistance = distance;
+                    }
+                }
+            }
+            return best;
+        };
+
+        uint32_t scan = firstTriangle;
+        std::vector<uint32_t> previousVertices;
+        while (true) {
+            // continue next to the previous meshlet so no slivers are left behind,
+            // else at the next triangle in the (cache optimized) input order
+            const glm::vec3 previousCentroid = state.getCentroid();
+            previousVertices.swap(state.vertices);
+            state.id++;
+            state.vertices.clear();
+            state.triangleCount = 0;
+            state.positionSum = glm::vec3(0.0f);
+
+            uint32_t seed = findNext(previousVertices.data(), previousVertices.size(), previousCentroid);
+            if (seed == std::numeric_limits<uint32_t>::max()) {
+                while (scan < endTriangle && emitted[scan]) ++scan;
+                if (scan == endTriangle) break;
+                seed = scan;
+            }
+            const uint32_t indexOffset = static_cast<uint32_t>(newIndices.size());
+
+            uint32_t last = seed;
+            addTriangle(seed);
+            while (state.triangleCount < MaxTriangles) {
+                // neighbours of the last triangle first, the whole meshlet border if they are used up
+                const glm::vec3 centroid = state.getCentroid();
+                uint32_t next = findNext(&mesh.indices[3 * last], 3, centroid);
+                if (next == std::numeric_limits<uint32_t>::max()) {
+                    next = findNext(state.vertices.data(), state.vertices.size(), centroid);
+                }
+                if (next == std::numeric_limits<uint32_t>::max()) break;
+                addTriangle(next);
+                last = next;
+            }
+
+            Meshlet meshlet{};
+            meshlet.indexOffset = indexOffset;
+            meshlet.triangleCount = state.triangleCount;
+            meshlet.submeshIndex = range.submeshIndex;
+            meshlet.lodLevel = range.lodLevel;
+            mesh.meshlets.push_back(meshlet);
+            verticesTotal += static_cast<uint32_t>(state.vertices.size());
+        }
+        *range.meshletCount = static_cast<uint32_t>(mesh.meshlets.size()) - *range.meshletOffset;
+    }
+
+    // triangles outside every range are kept at the end, they are never drawn
+    for (size_t t = 0; t < triangleTotal; ++t) {
+        if (!emitted[t]) newIndices.insert(newIndices.end(), &mesh.indices[3 * t], &mesh.indices[3 * t] + 3);
+    }
+    mesh.indices.swap(newIndices);
+
+    for (Meshlet& meshlet : mesh.meshlets) {
+        Meshlet bounds = computeBounds(mesh, meshlet.indexOffset, meshlet.triangleCount);
+        bounds.submeshIndex = meshlet.submeshIndex;
+        bounds.lodLevel = meshlet.lodLevel;
+        meshlet = bounds;
+    }
+
+    if (!mesh.meshlets.empty()) {
+        std::cout << "MeshletBuilder: " << mesh.meshlets.size() << " meshlets, "
+            << float(verticesTotal) / mesh.meshlets.size() << " vertices / "
+            << float(triangleTotal) / mesh.meshlets.size() << " triangles on average" << std::endl;
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+
+#include "MeshData.h"
+
+// Splits every submesh and each of its LODs into meshlets for GPU cluster culling (see files/cull.wgsl).
+// Triangles are regrouped so each meshlet is a contiguous index range; submesh and LOD ranges stay intact.
+class MeshletBuilder
+{
+public:
+    static constexpr uint32_t MaxVertices = 64;
+    static constexpr uint32_t MaxTriangles = 124;
+
+    // rewrites mesh.indices in meshlet order and fills mesh.meshlets and the submesh / LOD meshlet ranges
+    static void build(MeshData& mesh);
+
+    // bounding sphere + normal cone of one index range
+    static Meshlet computeBounds(const MeshData& mesh, uint32_t indexOffset, uint32_t triangleCount);
+};
@@ -0,0 +1,270 @@
+#include "MipGenerator.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define MIP_GENERATOR_SSE2
+#  include <emmintrin.h>
+#endif
+
+namespace {
+
+    // source pixels per thread below which threads don't pay off
+    const size_t MinRangePixels = 65536;
+
+    const float KaiserRadius = 3.0f; // in destination pixels
+    const float KaiserAlpha = 4.0f;
+
+    // channels are filtered as floats in 0..255, linear (sRGB data goes through the tables)
+#ifdef MIP_GENERATOR_SSE2
+    struct Pixel {
+        __m128 v; // wrapped: std::vector<__m128> drops its alignment attribute
+    };
+
+    inline Pixel zero() { return { _mm_setzero_ps() }; }
+    inline Pixel setPixel(float r, float g, float b, float a) { return { _mm_setr_ps(r, g, b, a) }; }
+    inline Pixel madd(Pixel sum, Pixel p, float weight) { return { _mm_add_ps(sum.v, _mm_mul_ps(p.v, _mm_set1_ps(weight))) }; }
+    inline void getChannels(Pixel p, float channels[4]) { _mm_storeu_ps(channels, p.v); }
+
+    inline Pixel loadUnorm(const uint8_t* rgba) {
+        int32_t bits;
+        std::memcpy(&bits, rgba, 4);
+        const __m128i zeroBits = _mm_setzero_si128();
+        const __m128i bytes = _mm_cvtsi32_si128(bits);
+        return { _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zeroBits), zeroBits)) };
+    }
+
+    // rounds half up like the integer box filter
+    inline void storeUnorm(Pixel p, uint8_t* rgba) {
+        const __m128i rounded = _mm_cvttps_epi32(_mm_add_ps(p.v, _mm_set1_ps(0.5f)));
+        const __m128i words = _mm_packs_epi32(rounded, rounded);
+        const int32_t bits = _mm_cvtsi128_si32(_mm_packus_epi16(words, words)); // saturates to 0..255
+        std::memcpy(rgba, &bits, 4);
+    }
+#else
+    struct Pixel {
+        float c[4];
+    };
+
+    inline Pixel zero() { return { { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+    inline Pixel setPixel(float r, float g, float b, float a) { return { { r, g, b, a } }; }
+    inline Pixel madd(Pixel sum, Pixel p, float weight) {
+        for (int c = 0; c < 4; ++c) sum.c[c] += p.c[c] * weight;
+        return sum;
+    }
+    inline void getChannels(Pixel p, float channels[4]) { std::memcpy(channels, p.c, sizeof(p.c)); }
+
+    inline Pixel loadUnorm(const uint8_t* rgba) { return setPixel(rgba[0], rgba[1], rgba[2], rgba[3]); }
+
+    inline void storeUnorm(Pixel p, uint8_t* rgba) {
+        for (int c = 0; c < 4; ++c) rgba[c] = static_cast<uint8_t>(std::clamp(p.c[c] + 0.5f, 0.0f, 255.0f));
+    }
+#endif
+
+    struct SrgbTables {
+        float toLinear[256];            // sRGB byte -> linear 0..255
+        std::vector<uint8_t> fromLinear; // linear 0..65535 -> sRGB byte
+
+        SrgbTables() : fromLinear(65536) {
+            for (int i = 0; i < 256; ++i) {
+                const float c = i / 255.0f;
+                toLinear[i] = 255.0f * (c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f));
+            }
+            for (size_t i = 0; i < fromLinear.size(); ++i) {
+                const float l = i / 65535.0f;
+                const float c = l <= 0.0031308f ? 12.92f * l : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+                fromLinear[i] = static_cast<uint8_t>(std::lround(std::clamp(c, 0.0f, 1.0f) * 255.0f));
+            }
+        }
+    };
+
+    const SrgbTables& getSrgbTables() {
+        static const SrgbTables tables;
+        return tables;
+    }
+
+    inline Pixel loadSrgb(const uint8_t* rgba, const SrgbTables& tables) {
+        return setPixel(tables.toLinear[rgba[0]], tables.toLinear[rgba[1]], tables.toLinear[rgba[2]], rgba[3]);
+    }
+
+    inline void storeSrgb(Pixel p, uint8_t* rgba, const SrgbTables& tables) {
+        float channels[4];
+        getChannels(p, channels);
+        for (int c = 0; c < 3; ++c) {
+            const long index = std::clamp(std::lround(channels[c] * (65535.0f / 255.0f)), 0l, 65535l);
+            rgba[c] = tables.fromLinear[index];
+        }
+        rgba[3] = static_cast<uint8_t>(std::clamp(std::lround(channels[3]), 0l, 255l));
+    }
+
+    // 2x2 box filter of linear data, exact in 16 bit integers: 2 destination pixels per SSE2 step
+    void downsampleBoxRow(const uint8_t* row0, const uint8_t* row1, uint32_t srcWidth, uint8_t* out, uint32_t dstWidth) {
+        uint32_t x = 0;
+#ifdef MIP_GENERATOR_SSE2
+        const __m128i zeroBits = _mm_setzero_si128();
+        const __m128i two = _mm_set1_epi16(2);
+        for (; x + 2 <= dstWidth && 2 * x + 4 <= srcWidth; x += 2) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 8 * x));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 8 * x));
+            // source pixels 0 1 | 2 3 of both rows, 16 bits per channel
+            const __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(a, zeroBits), _mm_unpacklo_epi8(b, zeroBits));
+            const __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(a, zeroBits), _mm_unpackhi_epi8(b, zeroBits));
+            const __m128i sumLow = _mm_add_epi16(low, _mm_srli_si128(low, 8));
+            const __m128i sumHigh = _mm_add_epi16(high, _mm_srli_si128(high, 8));
+            const __m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sumLow, sumHigh), two), 2);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + 4 * x), _mm_packus_epi16(sum, sum));
+        }
+#endif
+        for (; x < dstWidth; ++x) {
+            const uint32_t x0 = std::min(2 * x, srcWidth - 1) * 4;
+            const uint32_t x1 = std::min(2 * x + 1, srcWidth - 1) * 4;
+            for (uint32_t c = 0; c < 4; ++c) {
+                out[4 * x + c] = static_cast<uint8_t>((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+            }
+        }
+    }
+
+    // per destination pixel: count source pixels (clamped to the image) and their normalized weights
+    struct FilterTaps {
+        uint32_t count = 0;
+        std::vector<uint32_t> indices;
+        std::vector<float> weights;
+    };
+
+    float besselI0(float x) {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; k < 20; ++k) {
+            const double t = x / (2.0 * k);
+            term *= t * t;
+            sum += term;
+        }
+        return static_cast<float>(sum);
+    }
+
+    // d in destination pixels
+    float kaiser(float d) {
+        const float t = d / KaiserRadius;
+        if (t * t >= 1.0f) return 0.0f;
+        const float x = 3.14159265f * d;
+        const float sinc = std::abs(x) < 1e-6f ? 1.0f : std::sin(x) / x;
+        return sinc * besselI0(KaiserAlpha * std::sqrt(1.0f - t * t)) / besselI0(KaiserAlpha);
+    }
+
+    FilterTaps getTaps(uint32_t srcSize, uint32_t dstSize, MipFilter filter) {
+        FilterTaps taps;
+        if (filter == MipFilter::Box) {
+            taps.count = 2;
+            for (uint32_t x = 0; x < dstSize; ++x) {
+                taps.indices.insert(taps.indices.end(), { std::min(2 * x, srcSize - 1), std::min(2 * x + 1, srcSize - 1) });
+                taps.weights.insert(taps.weights.end(), { 0.5f, 0.5f });
+            }
+            return taps;
+        }
+
+        // destination pixel x covers source [x, x + 1) * scale, the kernel is stretched to match
+        const float scale = static_cast<float>(srcSize) / static_cast<float>(dstSize);
+        const float radius = KaiserRadius * scale;
+        taps.count = static_cast<uint32_t>(std::ceil(2.0f * radius)) + 1;
+        for (uint32_t x = 0; x < dstSize; ++x) {
+            const float center = (x + 0.5f) * scale;
+            const int first = static_cast<int>(std::floor(center - radius - 0.5f)) + 1;
+            float sum = 0.0f;
+            const size_t begin = taps.weights.size();
+            for (uint32_t k = 0; k < taps.count; ++k) {
+                const int i = first + static_cast<int>(k);
+                const float weight = kaiser((i + 0.5f - center) / scale);
+                taps.indices.push_back(static_cast<uint32_t>(std::clamp(i, 0, static_cast<int>(srcSize) - 1)));
+                taps.weights.push_back(weight);
+                sum += weight;
+            }
+            for (size_t k = begin; k < taps.weights.size(); ++k) taps.weights[k] /= sum;
+        }
+        return taps;
+    }
+}
+
+uint32_t MipGenerator::getLevelCount(uint32_t width, uint32_t height) {
+    uint32_t levels = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size >>= 1) levels++;
+    return levels;
+}
+
+void MipGenerator::generate(const uint8_t* rgba, uint32_t width, uint32_t height, std::vector<std::vector<uint8_t>>& levels,
+                            const MipOptions& options) {
+    const uint32_t levelCount = getLevelCount(width, height);
+    levels.resize(levelCount);
+    levels[0].assign(rgba, rgba + size_t(width) * height * 4);
+
+    for (uint32_t level = 1; level < levelCount; ++level) {
+        levels[level].resize(size_t(getLevelSize(width, level)) * getLevelSize(height, level) * 4);
+        downsample(levels[level - 1].data(), getLevelSize(width, level - 1), getLevelSize(height, level - 1),
+                   levels[level].data(), options);
+    }
+}
+
+void MipGenerator::downsample(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, const MipOptions& options) {
+    const uint32_t dstWidth = getLevelSize(srcWidth, 1);
+    const uint32_t dstHeight = getLevelSize(srcHeight, 1);
+    const size_t minRows = std::max<size_t>(1, MinRangePixels / (size_t(srcWidth) * 2));
+
+    if (options.filter == MipFilter::Box && !options.srgb) {
+        Parallel::forRanges(dstHeight, minRows, [&](size_t begin, size_t end) {
+            for (size_t y = begin; y < end; ++y) {
+                const uint8_t* row0 = src + std::min<size_t>(2 * y, srcHeight - 1) * srcWidth * 4;
+                const uint8_t* row1 = src + std::min<size_t>(2 * y + 1, srcHeight - 1) * srcWidth * 4;
+                downsampleBoxRow(row0, row1, srcWidth, dst + y * dstWidth * 4, dstWidth);
+            }
+        });
+        return;
+    }
+
+    const FilterTaps columns = getTaps(srcWidth, dstWidth, options.filter);
+    const FilterTaps rows = getTaps(srcHeight, dstHeight, options.filter);
+    const SrgbTables& tables = getSrgbTables();
+    const bool srgb = options.srgb;
+
+    // separable: source rows are filtered horizontally once per thread into a ring of the last rows.count
+    // rows (the taps of one destination row are consecutive), then every destination row sums its taps
+    Parallel::forRanges(dstHeight, minRows, [&](size_t begin, size_t end) {
+        std::vector<Pixel> linearRow(srcWidth);
+        std::vector<Pixel> ring(size_t(rows.count) * dstWidth);
+        std::vector<uint32_t> ringRows(rows.count, UINT32_MAX);
+        auto getFilteredRow = [&](uint32_t y) -> const Pixel* {
+            const uint32_t slot = y % rows.count;
+            Pixel* filtered = ring.data() + size_t(slot) * dstWidth;
+            if (ringRows[slot] == y) return filtered;
+            ringRows[slot] = y;
+
+            const uint8_t* in = src + size_t(y) * srcWidth * 4;
+            for (uint32_t x = 0; x < srcWidth; ++x) {
+                linearRow[x] = srgb ? loadSrgb(in + 4 * x, tables) : loadUnorm(in + 4 * x);
+            }
+            for (uint32_t x = 0; x < dstWidth; ++x) {
+                const uint32_t* index = columns.indices.data() + size_t(x) * columns.count;
+                const float* weight = columns.weights.data() + size_t(x) * columns.count;
+                Pixel sum = zero();
+                for (uint32_t k = 0; k < columns.count; ++k) sum = madd(sum, linearRow[index[k]], weight[k]);
+                filtered[x] = sum;
+            }
+            return filtered;
+        };
+
+        std::vector<const Pixel*> tapRows(rows.count);
+        for (size_t y = begin; y < end; ++y) {
+            const uint32_t* index = rows.indices.data() + y * rows.count;
+            const float* weight = rows.weights.data() + y * rows.count;
+            for (uint32_t k = 0; k < rows.count; ++k) tapRows[k] = getFilteredRow(index[k]);
+
+            uint8_t* out = dst + y * dstWidth * 4;
+            for (uint32_t x = 0; x < dstWidth; ++x) {
+                Pixel sum = zero();
+                for (uint32_t k = 0; k < rows.count; ++k) sum = madd(sum, tapRows[k][x], weight[k]);
+                if (srgb) storeSrgb(sum, out + 4 * x, tables);
+                else storeUnorm(sum, out + 4 * x);
+            }
+        }
+    });
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+enum class MipFilter {
+    Box,    // 2x2 average, odd sizes repeat the last row / column
+    Kaiser  // Kaiser windowed sinc (radius 3 destination pixels, alpha 4): sharper, less aliasing, slower
+};
+
+struct MipOptions {
+    MipFilter filter = MipFilter::Box;
+    bool srgb = false; // color data: rgb filtered in linear space and encoded back, alpha stays linear
+};
+
+// Mip chains of RGBA8 images, every level filtered from the previous one. Rows of a level run in
+// parallel (Parallel::forRanges), one pixel per SSE2 register where available (scalar otherwise).
+class MipGenerator
+{
+public:
+    // down to 1x1
+    static uint32_t getLevelCount(uint32_t width, uint32_t height);
+    static uint32_t getLevelSize(uint32_t size, uint32_t level) { return size >> level > 0 ? size >> level : 1; }
+
+    // levels[0] is a copy of the image, then every level down to 1x1
+    static void generate(const uint8_t* rgba, uint32_t width, uint32_t height, std::vector<std::vector<uint8_t>>& levels,
+                         const MipOptions& options = MipOptions());
+
+    // one level: src (srcWidth x srcHeight) -> dst (getLevelSize(srcWidth, 1) x getLevelSize(srcHeight, 1))
+    static void downsample(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, const MipOptions& options);
+};
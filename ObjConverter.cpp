@@ -0,0 +1,678 @@
+#include "ObjConverter.h"
+#include "MeshCache.h"
+#include "ObjParser.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <queue>
+#include <vector>
+#include <glm/geometric.hpp>
+
+namespace {
+
+    // spill file records
+    struct PositionRecord {     // positions.bin, one per v line
+        float position[3];
+        float color[3];
+    };
+    struct CornerRecord {       // corners.bin, face corners in file order
+        int32_t v, vt, vn;
+        uint32_t faceSize;      // quads need the positions of their corners to be split
+        uint64_t corner;
+    };
+    struct RemapRecord {        // corner -> welded vertex
+        uint64_t corner;
+        uint32_t vertex;
+        uint32_t padding;
+    };
+    struct CornerPositionRecord { // for quad splitting and normal generation
+        uint64_t corner;
+        int32_t v;
+        float position[3];
+    };
+    struct NormalRecord {       // face normal contribution to position v
+        int32_t v;
+        float normal[3];
+    };
+    struct VertexRecord {       // welded vertex, attributes filled in by the joins
+        uint32_t vertex;
+        int32_t v, vt, vn;
+        float position[3];
+        float color[3];
+        float normal[3];
+        float uv[2];
+    };
+
+    // buffered sequential writer of fixed size records
+    template <typename T>
+    class RecordWriter
+    {
+    public:
+        bool open(const std::filesystem::path& path, size_t bufferBytes) {
+            out.open(path, std::ios::binary | std::ios::trunc);
+            capacity = std::max<size_t>(1, bufferBytes / sizeof(T));
+            buffer.clear();
+            buffer.reserve(capacity);
+            return out.is_open();
+        }
+        void push(const T& record) {
+            buffer.push_back(record);
+            if (buffer.size() == capacity) flush();
+        }
+        bool close() {
+            flush();
+            out.close();
+            std::vector<T>().swap(buffer);
+            return !out.fail();
+        }
+
+    private:
+        void flush() {
+            out.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size() * sizeof(T)));
+            buffer.clear();
+        }
+
+        std::ofstream out;
+        std::vector<T> buffer;
+        size_t capacity = 1;
+    };
+
+    // buffered sequential reader of fixed size records
+    template <typename T>
+    class RecordReader
+    {
+    public:
+        bool open(const std::filesystem::path& path, size_t bufferBytes) {
+            in.open(path, std::ios::binary);
+            buffer.resize(std::max<size_t>(1, bufferBytes / sizeof(T)));
+            count = position = 0;
+            return in.is_open();
+        }
+        // next record without consuming it, nullptr at the end
+        const T* peek() {
+            if (position == count) {
+                in.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size() * sizeof(T)));
+                count = static_cast<size_t>(in.gcount()) / sizeof(T);
+                position = 0;
+                if (count == 0) return nullptr;
+            }
+            return &buffer[position];
+        }
+        bool next(T& record) {
+            const T* r = peek();
+            if (!r) return false;
+            record = *r;
+            ++position;
+            return true;
+        }
+        void close() {
+            in.close();
+            std::vector<T>().swap(buffer);
+        }
+
+    private:
+        std::ifstream in;
+        std::vector<T> buffer;
+        size_t count = 0;
+        size_t position = 0;
+    };
+
+    template <typename T, typename Less>
+    bool mergeRuns(const std::vector<std::filesystem::path>& runs, const std::filesystem::path& output,
+                   size_t memoryBytes, Less less) {
+        const size_t bufferBytes = memoryBytes / (runs.size() + 1);
+        std::vector<RecordReader<T>> readers(runs.size());
+        for (size_t i = 0; i < runs.size(); ++i) {
+            if (!readers[i].open(runs[i], bufferBytes)) return false;
+        }
+        RecordWriter<T> writer;
+        if (!writer.open(output, bufferBytes)) return false;
+
+        // min-heap of the runs' current records
+        auto greater = [&](size_t a, size_t b) { return less(*readers[b].peek(), *readers[a].peek()); };
+        std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap(greater);
+        for (size_t i = 0; i < runs.size(); ++i) {
+            if (readers[i].peek()) heap.push(i);
+        }
+        T record;
+        while (!heap.empty()) {
+            const size_t i = heap.top();
+            heap.pop();
+            readers[i].next(record);
+            writer.push(record);
+            if (readers[i].peek()) heap.push(i);
+        }
+        for (RecordReader<T>& reader : readers) reader.close();
+        return writer.close();
+    }
+
+    // external merge sort of a file of T records: sorted runs of memoryBytes, then k-way merges.
+    // The input file is removed.
+    template <typename T, typename Less>
+    bool sortFile(const std::filesystem::path& input, const std::filesystem::path& output, size_t memoryBytes, Less less) {
+        std::vector<std::filesystem::path> runs;
+        {
+            std::ifstream in(input, std::ios::binary);
+            if (!in.is_open()) return false;
+            std::vector<T> run(std::max<size_t>(1, memoryBytes / sizeof(T)));
+            while (true) {
+                in.read(reinterpret_cast<char*>(run.data()), static_cast<std::streamsize>(run.size() * sizeof(T)));
+                const size_t count = static_cast<size_t>(in.gcount()) / sizeof(T);
+                if (count == 0) break;
+                std::sort(run.begin(), run.begin() + count, less);
+
+                std::filesystem::path runPath = input;
+                runPath += ".run" + std::to_string(runs.size());
+                std::ofstream out(runPath, std::ios::binary | std::ios::trunc);
+                out.write(reinterpret_cast<const char*>(run.data()), static_cast<std::streamsize>(count * sizeof(T)));
+                if (!out) return false;
+                runs.push_back(runPath);
+            }
+        }
+        std::error_code ec;
+        std::filesystem::remove(input, ec);
+        if (runs.empty()) return static_cast<bool>(std::ofstream(output, std::ios::binary | std::ios::trunc));
+
+        // enough fan-in to merge in one or two levels while every reader keeps a useful buffer
+        const size_t maxFanIn = std::clamp<size_t>(memoryBytes / (sizeof(T) << 12), 2, 256);
+        size_t level = 0;
+        while (runs.size() > 1) {
+            std::vector<std::filesystem::path> merged;
+            for (size_t first = 0; first < runs.size(); first += maxFanIn) {
+                const std::vector<std::filesystem::path> group(runs.begin() + first,
+                    runs.begin() + std::min(runs.size(), first + maxFanIn));
+                std::filesystem::path mergedPath = input;
+                mergedPath += ".merge" + std::to_string(level) + "_" + std::to_string(merged.size());
+                if (!mergeRuns<T>(group, mergedPath, memoryBytes, less)) return false;
+                for (const auto& run : group) std::filesystem::remove(run, ec);
+                merged.push_back(mergedPath);
+            }
+            runs.swap(merged);
+            ++level;
+        }
+        std::filesystem::rename(runs[0], output, ec);
+        return !ec;
+    }
+
+    // removes the spill directory however the conversion ends
+    struct TempDirectory {
+        std::filesystem::path path;
+        ~TempDirectory() {
+            std::error_code ec;
+            std::filesystem::remove_all(path, ec);
+        }
+    };
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+uint64_t ObjConverter::parseMemorySize(const std::string& text) {
+    size_t digits = 0;
+    while (digits < text.size() && text[digits] >= '0' && text[digits] <= '9') ++digits;
+    if (digits == 0 || digits > 15) return 0;
+    uint64_t value = std::stoull(text.substr(0, digits));
+
+    const std::string suffix = text.substr(digits);
+    if (suffix.empty() || suffix == "B") return value;
+    if (suffix == "K" || suffix == "k" || suffix == "KB") return value << 10;
+    if (suffix == "M" || suffix == "m" || suffix == "MB") return value << 20;
+    if (suffix == "G" || suffix == "g" || suffix == "GB") return value << 30;
+    return 0;
+}
+
+bool ObjConverter::needsConversion(const std::filesystem::path& meshPath, uint64_t maxMemory) {
+    std::string extension = meshPath.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    std::error_code ec;
+    const uint64_t size = std::filesystem::file_size(meshPath, ec);
+    return extension == ".obj" && !ec && size > maxMemory / InMemoryBytesPerObjByte;
+}
+
+bool ObjConverter::convert(const std::filesystem::path& objPath, const std::filesystem::path& cachePath,
+                           const VertexFormatOptions& options, uint64_t maxMemory) {
+    const auto start = std::chrono::steady_clock::now();
+    // parsed windows take a few times their text size, sorts get half the budget
+    const size_t windowBytes = static_cast<size_t>(std::clamp<uint64_t>(maxMemory / 8, 1 << 20, 256 << 20));
+    const size_t sortBytes = static_cast<size_t>(std::max<uint64_t>(maxMemory / 2, 1 << 20));
+    const size_t streamBytes = 1 << 20; // per sequential reader / writer
+
+    TempDirectory temp;
+    temp.path = cachePath;
+    temp.path += ".parts";
+    std::error_code ec;
+    std::filesystem::create_directories(temp.path, ec);
+    if (ec) {
+        std::cerr << "Could not create " << temp.path << std::endl;
+        return false;
+    }
+    auto spill = [&temp](const char* name) { return temp.path / name; };
+
+    // PASS 1: stream the OBJ, spill attributes and corners ------------------------------------
+    RecordWriter<PositionRecord> positions;
+    RecordWriter<float> texcoords;
+    RecordWriter<float> normals;
+    RecordWriter<CornerRecord> corners;
+    RecordWriter<uint8_t> faceSizes;
+    RecordWriter<int32_t> triangleMaterials;
+    if (!positions.open(spill("positions.bin"), streamBytes) || !texcoords.open(spill("texcoords.bin"), streamBytes) ||
+        !normals.open(spill("normals.bin"), streamBytes) || !corners.open(spill("corners.bin"), streamBytes) ||
+        !faceSizes.open(spill("faces.bin"), streamBytes) || !triangleMaterials.open(spill("materials.bin"), streamBytes)) {
+        std::cerr << "Could not create spill files in " << temp.path << std::endl;
+        return false;
+    }
+
+    uint64_t vertexCount = 0, normalCount = 0, texcoordCount = 0, cornerCount = 0, triangleCount = 0, quadCount = 0;
+    glm::vec3 boundsMin(std::numeric_limits<float>::max());
+    glm::vec3 boundsMax(-std::numeric_limits<float>::max());
+    bool hasColor = !options.dropConstantColor;
+    bool missingNormals = false;
+    std::vector<uint64_t> materialTriangles; // [materialId + 1]
+    std::vector<tinyobj::material_t> objMaterials;
+
+    const bool parsed = ObjParser::parseStreaming(objPath, windowBytes, objMaterials, [&](const ObjWindow& window) {
+        for (size_t i = 0; i < window.vertices.size() / 3; ++i) {
+            PositionRecord record;
+            std::memcpy(record.position, &window.vertices[3 * i], sizeof(record.position));
+            std::memcpy(record.color, &window.colors[3 * i], sizeof(record.color));
+            const glm::vec3 p(record.position[0], record.position[1], record.position[2]);
+            boundsMin = glm::min(boundsMin, p);
+            boundsMax = glm::max(boundsMax, p);
+            if (record.color[0] != 1.0f || record.color[1] != 1.0f || record.color[2] != 1.0f) hasColor = true;
+            positions.push(record);
+        }
+        for (float f : window.texcoords) texcoords.push(f);
+        for (float f : window.normals) normals.push(f);
+        vertexCount += window.vertices.size() / 3;
+        texcoordCount += window.texcoords.size() / 2;
+        normalCount += window.normals.size() / 3;
+
+        const tinyobj::index_t* idx = window.indices.data();
+        for (uint8_t faceSize : window.faceSizes) {
+            for (uint32_t c = 0; c < faceSize; ++c, ++idx) {
+                corners.push({ idx->vertex_index, idx->texcoord_index, idx->normal_index, faceSize, cornerCount++ });
+                if (idx->normal_index < 0) missingNormals = true;
+            }
+            faceSizes.push(faceSize);
+            if (faceSize == 4) ++quadCount;
+        }
+        triangleCount += window.materialIds.size();
+        for (int materialId : window.materialIds) {
+            triangleMaterials.push(materialId);
+            if (size_t(materialId + 1) >= materialTriangles.size()) materialTriangles.resize(materialId + 2, 0);
+            ++materialTriangles[materialId + 1];
+        }
+        return true;
+        });
+    const bool spilled = positions.close() & texcoords.close() & normals.close() & corners.close() & faceSizes.close() &
+        triangleMaterials.close();
+    if (!parsed || !spilled) {
+        std::cerr << "Could not read " << objPath << (parsed ? " (out of disk space?)" : "") << std::endl;
+        return false;
+    }
+    if (vertexCount == 0 || triangleCount == 0 || triangleCount * 3 > std::numeric_limits<uint32_t>::max()) {
+        std::cerr << objPath << ": " << triangleCount << " triangles, no geometry or too many indices" << std::endl;
+        return false;
+    }
+    std::cout << objPath.filename().string() << ": " << vertexCount << " positions, " << triangleCount
+        << " triangles read in " << secondsSince(start) << " s" << std::endl;
+
+    // PASS 2: weld identical corners ------------------------------------------------------------
+    if (!sortFile<CornerRecord>(spill("corners.bin"), spill("corners.sorted"), sortBytes,
+        [](const CornerRecord& a, const CornerRecord& b) {
+            if (a.v != b.v) return a.v < b.v;
+            if (a.vt != b.vt) return a.vt < b.vt;
+            return a.vn < b.vn;
+        })) return false;
+
+    // corners arrive in position order: the position join is a sequential read of positions.bin
+    const bool needCornerPositions = missingNormals || quadCount > 0;
+    uint32_t weldedCount = 0;
+    {
+        RecordReader<CornerRecord> sorted;
+        RecordReader<PositionRecord> positionReader;
+        RecordWriter<RemapRecord> remap;
+        RecordWriter<VertexRecord> vertices;
+        RecordWriter<CornerPositionRecord> cornerPositions;
+        if (!sorted.open(spill("corners.sorted"), streamBytes) || !positionReader.open(spill("positions.bin"), streamBytes) ||
+            !remap.open(spill("remap.bin"), streamBytes) || !vertices.open(spill("vertices.bin"), streamBytes) ||
+            (needCornerPositions && !cornerPositions.open(spill("cornerpositions.bin"), streamBytes))) return false;
+
+        CornerRecord corner;
+        CornerRecord previous{ -1, -1, -1, 0, 0 };
+        PositionRecord position{};
+        int64_t positionIndex = -1;
+        bool first = true;
+        while (sorted.next(corner)) {
+            if (corner.v < 0 || uint64_t(corner.v) >= vertexCount ||
+                (corner.vt >= 0 && uint64_t(corner.vt) >= texcoordCount) ||
+                (corner.vn >= 0 && uint64_t(corner.vn) >= normalCount)) {
+                std::cerr << objPath << ": face index out of range" << std::endl;
+                return false;
+            }
+            while (positionIndex < corner.v) {
+                positionReader.next(position);
+                ++positionIndex;
+            }
+            if (first || corner.v != previous.v || corner.vt != previous.vt || corner.vn != previous.vn) {
+                if (weldedCount == std::numeric_limits<uint32_t>::max()) return false;
+                VertexRecord vertex{};
+                vertex.vertex = weldedCount++;
+                vertex.v = corner.v;
+                vertex.vt = corner.vt;
+                vertex.vn = corner.vn;
+                std::memcpy(vertex.position, position.position, sizeof(vertex.position));
+                std::memcpy(vertex.color, position.color, sizeof(vertex.color));
+                vertices.push(vertex);
+                previous = corner;
+                first = false;
+            }
+            remap.push({ corner.corner, weldedCount - 1, 0 });
+            if (missingNormals || corner.faceSize == 4) {
+                CornerPositionRecord record{ corner.corner, corner.v, {} };
+                std::memcpy(record.position, position.position, sizeof(record.position));
+                cornerPositions.push(record);
+            }
+        }
+        sorted.close();
+        positionReader.close();
+        if (!remap.close() || !vertices.close() || (needCornerPositions && !cornerPositions.close())) return false;
+    }
+    std::filesystem::remove(spill("corners.sorted"), ec);
+    std::filesystem::remove(spill("positions.bin"), ec);
+    std::cout << "Welded into " << weldedCount << " vertices (" << secondsSince(start) << " s)" << std::endl;
+
+    // PASS 3: split quads along their shorter diagonal like the in-memory load, face normals -----------
+    if (needCornerPositions) {
+        auto byCorner = [](const CornerPositionRecord& a, const CornerPositionRecord& b) { return a.corner < b.corner; };
+        if (!sortFile<CornerPositionRecord>(spill("cornerpositions.bin"), spill("cornerpositions.sorted"), sortBytes, byCorner)) return false;
+        RecordReader<uint8_t> faces;
+        RecordReader<CornerPositionRecord> facePositions;
+        RecordWriter<uint8_t> diagonals; // per quad, 1 when split along 0-2
+        RecordWriter<NormalRecord> faceNormals;
+        if (!faces.open(spill("faces.bin"), streamBytes) || !facePositions.open(spill("cornerpositions.sorted"), streamBytes) ||
+            !diagonals.open(spill("diagonals.bin"), streamBytes) ||
+            (missingNormals && !faceNormals.open(spill("facenormals.bin"), streamBytes))) return false;
+        uint8_t faceSize;
+        CornerPositionRecord c[4];
+        while (faces.next(faceSize)) {
+            // without missing normals only the corners of quads were written
+            if (!missingNormals && faceSize != 4) continue;
+            for (uint32_t i = 0; i < faceSize; ++i) {
+                if (!facePositions.next(c[i])) return false;
+            }
+            uint8_t triangles[2][3] = { { 0, 1, 2 }, { 0, 2, 3 } };
+            if (faceSize == 4) {
+                const bool split02 = ObjParser::splitsQuadAlong02(c[0].position, c[1].position, c[2].position, c[3].position);
+                if (!split02) {
+                    triangles[0][2] = 3;
+                    triangles[1][0] = 1;
+                }
+                diagonals.push(split02 ? 1 : 0);
+            }
+            if (!missingNormals) continue;
+            for (uint32_t t = 0; t + 2 < faceSize; ++t) {
+                const float* p[3] = { c[triangles[t][0]].position, c[triangles[t][1]].position, c[triangles[t][2]].position };
+                const glm::vec3 p0(p[0][0], p[0][1], p[0][2]);
+                const glm::vec3 p1(p[1][0], p[1][1], p[1][2]);
+                const glm::vec3 p2(p[2][0], p[2][1], p[2][2]);
+                // length = twice the area: larger faces weigh more
+                const glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+                for (uint8_t k : triangles[t]) faceNormals.push({ c[k].v, { n.x, n.y, n.z } });
+            }
+        }
+        faces.close();
+        facePositions.close();
+        if (!diagonals.close() || (missingNormals && !faceNormals.close())) return false;
+        std::filesystem::remove(spill("cornerpositions.sorted"), ec);
+    }
+
+    // PASS 4: smooth normals for corners without vn ------------------------------------------------
+    if (missingNormals) {
+        if (!sortFile<NormalRecord>(spill("facenormals.bin"), spill("facenormals.sorted"), sortBytes,
+            [](const NormalRecord& a, const NormalRecord& b) { return a.v < b.v; })) return false;
+
+        // vertices.bin is in position order too: sum the contributions of each position into its vertices
+        RecordReader<NormalRecord> faceNormals;
+        RecordReader<VertexRecord> vertices;
+        RecordWriter<VertexRecord> output;
+        if (!faceNormals.open(spill("facenormals.sorted"), streamBytes) || !vertices.open(spill("vertices.bin"), streamBytes) ||
+            !output.open(spill("vertices.normals"), streamBytes)) return false;
+        VertexRecord vertex;
+        int32_t sumIndex = -1;
+        glm::vec3 sum(0.0f);
+        while (vertices.next(vertex)) {
+            if (vertex.vn < 0) {
+                while (sumIndex < vertex.v) {
+                    sum = glm::vec3(0.0f);
+                    sumIndex = faceNormals.peek() ? faceNormals.peek()->v : std::numeric_limits<int32_t>::max();
+                    NormalRecord record{};
+                    while (faceNormals.peek() && faceNormals.peek()->v == sumIndex) {
+                        faceNormals.next(record);
+                        sum += glm::vec3(record.normal[0], record.normal[1], record.normal[2]);
+                    }
+                }
+                const glm::vec3 n = sumIndex == vertex.v && glm::dot(sum, sum) > 0.0f ? glm::normalize(sum) : glm::vec3(0.0f, 1.0f, 0.0f);
+                std::memcpy(vertex.normal, &n, sizeof(vertex.normal));
+            }
+            output.push(vertex);
+        }
+        faceNormals.close();
+        vertices.close();
+        if (!output.close()) return false;
+        std::filesystem::remove(spill("facenormals.sorted"), ec);
+        std::filesystem::rename(spill("vertices.normals"), spill("vertices.bin"), ec);
+        if (ec) return false;
+        std::cout << "Generated normals (" << secondsSince(start) << " s)" << std::endl;
+    }
+
+    // PASS 5: join texcoords and normals, one sort + sequential read each ---------------------------
+    auto joinAttribute = [&](const char* attributeFile, uint32_t components, int32_t VertexRecord::* key, float* (*target)(VertexRecord&)) {
+        if (!sortFile<VertexRecord>(spill("vertices.bin"), spill("vertices.sorted"), sortBytes,
+            [key](const VertexRecord& a, const VertexRecord& b) { return a.*key < b.*key; })) return false;
+        RecordReader<VertexRecord> vertices;
+        RecordReader<float> values;
+        RecordWriter<VertexRecord> output;
+        if (!vertices.open(spill("vertices.sorted"), streamBytes) || !values.open(spill(attributeFile), streamBytes) ||
+            !output.open(spill("vertices.bin"), streamBytes)) return false;
+        VertexRecord vertex;
+        float value[3] = {};
+        int64_t valueIndex = -1;
+        while (vertices.next(vertex)) {
+            const int32_t index = vertex.*key;
+            if (index >= 0) {
+                while (valueIndex < index) {
+                    for (uint32_t c = 0; c < components; ++c) values.next(value[c]);
+                    ++valueIndex;
+                }
+                std::memcpy(target(vertex), value, components * sizeof(float));
+            }
+            output.push(vertex);
+        }
+        vertices.close();
+        values.close();
+        if (!output.close()) return false;
+        std::filesystem::remove(spill("vertices.sorted"), ec);
+        std::filesystem::remove(spill(attributeFile), ec);
+        return true;
+    };
+    if (!joinAttribute("texcoords.bin", 2, &VertexRecord::vt, [](VertexRecord& v) { return v.uv; }) ||
+        !joinAttribute("normals.bin", 3, &VertexRecord::vn, [](VertexRecord& v) { return v.normal; })) return false;
+    if (!sortFile<VertexRecord>(spill("vertices.bin"), spill("vertices.sorted"), sortBytes,
+        [](const VertexRecord& a, const VertexRecord& b) { return a.vertex < b.vertex; })) return false;
+    auto byCorner = [](const RemapRecord& a, const RemapRecord& b) { return a.corner < b.corner; };
+    if (!sortFile<RemapRecord>(spill("remap.bin"), spill("remap.sorted"), sortBytes, byCorner)) return false;
+
+    // OUTPUT ---------------------------------------------------------------------------------------
+    MeshSourceStamp source;
+    if (!MeshCache::getSourceStamp(objPath, source)) return false;
+    MeshCacheHeader header;
+    MeshCache::initHeader(header, source);
+
+    PackedVertices packed;
+    packed.positionLayout = VertexQuantization::makePositionLayout(options);
+    packed.layout = VertexQuantization::makeLayout(options, hasColor);
+    packed.formatBits = options.getBits();
+    packed.hasColor = hasColor;
+    packed.octahedralNormals = options.octahedralNormals;
+    if (options.quantizePositions) {
+        packed.positionOffset = boundsMin;
+        packed.positionScale = boundsMax - boundsMin;
+    }
+
+    // submeshes sorted by material like MeshImporter::getObjGeometry, one per material in use
+    std::vector<MeshMaterial> materials;
+    for (const tinyobj::material_t& material : objMaterials) materials.push_back(ObjParser::getMaterial(objPath, material));
+    materialTriangles.resize(materials.size() + 1, 0);
+    std::vector<Submesh> submeshes;
+    std::vector<uint64_t> materialCursor(materialTriangles.size(), 0); // next index of each material
+    uint64_t indexOffset = 0;
+    for (size_t m = 0; m < materialTriangles.size(); ++m) {
+        materialCursor[m] = indexOffset;
+        if (materialTriangles[m] == 0) continue;
+        Submesh submesh;
+        submesh.indexOffset = static_cast<uint32_t>(indexOffset);
+        submesh.indexCount = static_cast<uint32_t>(materialTriangles[m] * 3);
+        submesh.materialId = static_cast<int32_t>(m) - 1;
+        submeshes.push_back(submesh);
+        indexOffset += submesh.indexCount;
+    }
+
+    std::vector<MeshCacheMaterial> materialRecords;
+    std::string strings;
+    MeshCache::makeMaterialRecords(materials, materialRecords, strings);
+
+    header.positionLayout = packed.positionLayout;
+    header.layout = packed.layout;
+    header.formatBits = packed.formatBits;
+    header.vertexCount = weldedCount;
+    header.indexCount = static_cast<uint32_t>(triangleCount * 3);
+    header.indexSize = weldedCount <= 0xFFFF ? 2 : 4;
+    header.submeshCount = static_cast<uint32_t>(submeshes.size());
+    header.materialCount = static_cast<uint32_t>(materials.size());
+    header.stringBytes = strings.size();
+    header.pageCount = 1; // no LODs to stream first
+    const MeshPage page = { header.vertexCount, header.indexCount };
+    for (int c = 0; c < 3; ++c) {
+        header.boundsMin[c] = boundsMin[c];
+        header.boundsMax[c] = boundsMax[c];
+        header.positionOffset[c] = packed.positionOffset[c];
+        header.positionScale[c] = packed.positionScale[c];
+    }
+    MeshCache::layoutSections(header);
+
+    std::filesystem::path tempPath = cachePath;
+    tempPath += ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return false;
+        auto writeAt = [&out](uint64_t offset, const void* data, uint64_t bytes) {
+            out.seekp(static_cast<std::streamoff>(offset));
+            out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        };
+        writeAt(0, &header, sizeof(header));
+
+        // vertices in welded order, packed a batch at a time into both streams
+        {
+            RecordReader<VertexRecord> vertices;
+            if (!vertices.open(spill("vertices.sorted"), streamBytes)) return false;
+            MeshData batch;
+            std::vector<uint8_t> bytes;
+            const size_t batchSize = std::max<size_t>(1, streamBytes / (header.positionLayout.stride + header.layout.stride));
+            uint64_t positionStreamOffset = header.positionStreamOffset;
+            uint64_t offset = header.vertexOffset;
+            VertexRecord record;
+            bool more = true;
+            while (more) {
+                batch.vertices.clear();
+                while (batch.vertices.size() < batchSize && (more = vertices.next(record))) {
+                    VertexAttr v;
+                    v.position = glm::vec3(record.position[0], record.position[1], record.position[2]);
+                    v.color = glm::vec3(record.color[0], record.color[1], record.color[2]);
+                    v.normal = glm::vec3(record.normal[0], record.normal[1], record.normal[2]);
+                    v.uv = glm::vec2(record.uv[0], record.uv[1]);
+                    batch.vertices.push_back(v);
+                }
+                bytes.resize(batch.vertices.size() * header.positionLayout.stride);
+                VertexQuantization::packVertices(batch, packed, packed.positionLayout, 0, batch.vertices.size(), bytes.data());
+                writeAt(positionStreamOffset, bytes.data(), bytes.size());
+                positionStreamOffset += bytes.size();
+                bytes.resize(batch.vertices.size() * header.layout.stride);
+                VertexQuantization::packVertices(batch, packed, packed.layout, 0, batch.vertices.size(), bytes.data());
+                writeAt(offset, bytes.data(), bytes.size());
+                offset += bytes.size();
+            }
+            vertices.close();
+        }
+
+        // triangles in file order, appended to their material's range through small per material buffers
+        {
+            RecordReader<RemapRecord> remap;
+            RecordReader<uint8_t> faces;
+            RecordReader<uint8_t> diagonals;
+            RecordReader<int32_t> triangleMaterialIds;
+            if (!remap.open(spill("remap.sorted"), streamBytes) || !faces.open(spill("faces.bin"), streamBytes) ||
+                (quadCount > 0 && !diagonals.open(spill("diagonals.bin"), streamBytes)) ||
+                !triangleMaterialIds.open(spill("materials.bin"), streamBytes)) return false;
+            const size_t bufferBytes = std::max<size_t>(4096, std::min<size_t>(streamBytes, sortBytes / materialCursor.size()));
+            std::vector<std::vector<uint8_t>> pending(materialCursor.size());
+            auto flush = [&](size_t m) {
+                writeAt(header.indexOffset + materialCursor[m] * header.indexSize, pending[m].data(), pending[m].size());
+                materialCursor[m] += pending[m].size() / header.indexSize;
+                pending[m].clear();
+            };
+            RemapRecord corner[4];
+            uint8_t faceSize;
+            while (faces.next(faceSize)) {
+                for (uint32_t i = 0; i < faceSize; ++i) {
+                    if (!remap.next(corner[i])) return false;
+                }
+                uint8_t triangles[2][3] = { { 0, 1, 2 }, { 0, 2, 3 } };
+                uint8_t split02 = 1;
+                if (faceSize == 4 && !diagonals.next(split02)) return false;
+                if (!split02) {
+                    triangles[0][2] = 3;
+                    triangles[1][0] = 1;
+                }
+                for (uint32_t t = 0; t + 2 < faceSize; ++t) {
+                    int32_t materialId;
+                    if (!triangleMaterialIds.next(materialId)) return false;
+                    std::vector<uint8_t>& buffer = pending[materialId + 1];
+                    for (uint8_t k : triangles[t]) {
+                        const uint16_t index16 = static_cast<uint16_t>(corner[k].vertex);
+                        const uint8_t* index = header.indexSize == 2 ? reinterpret_cast<const uint8_t*>(&index16)
+                                                                     : reinterpret_cast<const uint8_t*>(&corner[k].vertex);
+                        buffer.insert(buffer.end(), index, index + header.indexSize);
+                    }
+                    if (buffer.size() >= bufferBytes) flush(materialId + 1);
+                }
+            }
+            for (size_t m = 0; m < pending.size(); ++m) flush(m);
+            remap.close();
+            faces.close();
+            if (quadCount > 0) diagonals.close();
+            triangleMaterialIds.close();
+        }
+
+        writeAt(header.submeshOffset, submeshes.data(), submeshes.size() * sizeof(Submesh));
+        writeAt(header.materialOffset, materialRecords.data(), materialRecords.size() * sizeof(MeshCacheMaterial));
+        writeAt(header.stringOffset, strings.data(), strings.size());
+        writeAt(header.pageOffset, &page, sizeof(page));
+        if (!out) return false;
+    }
+
+    std::filesystem::rename(tempPath, cachePath, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    std::cout << "Wrote " << cachePath << ": " << weldedCount << " vertices, " << triangleCount << " triangles, "
+        << submeshes.size() << " submeshes (no LODs, meshlets or pages) in " << secondsSince(start) << " s" << std::endl;
+    return true;
+}
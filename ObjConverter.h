@@ -0,0 +1,31 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <cstdint>
+
+#include "VertexQuantization.h"
+
+// Out-of-core OBJ -> binary mesh file (MeshCache format) for OBJs larger than RAM.
+// The OBJ is read in windows (ObjParser::parseStreaming), attributes and corners are spilled to
+// temporary files next to the output and welded / joined with external merge sorts, so the
+// working set stays around maxMemory whatever the file size.
+// Missing normals are area weighted face normal sums (no crease splitting) and vertices keep file
+// order: the optimizer, LOD, meshlet and page passes need the whole mesh in memory.
+class ObjConverter
+{
+public:
+    static constexpr uint64_t DefaultMaxMemory = 2ull << 30;
+    // the in-memory cook (MeshCooker) peaks at about 3x the OBJ text size
+    static constexpr uint64_t InMemoryBytesPerObjByte = 3;
+
+    // .obj too large for MeshCooker within maxMemory: convert it instead
+    static bool needsConversion(const std::filesystem::path& meshPath, uint64_t maxMemory);
+
+    // the cache has a single page and no LODs or meshlets, so the app draws it at full resolution without
+    // cluster culling, LOD selection or progressive streaming (MeshStreamer logs this when it maps one)
+    static bool convert(const std::filesystem::path& objPath, const std::filesystem::path& cachePath,
+                        const VertexFormatOptions& options, uint64_t maxMemory);
+
+    // "2G", "512M", "64K" or a plain byte count, 0 if malformed
+    static uint64_t parseMemorySize(const std::string& text);
+};
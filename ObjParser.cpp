@@ -0,0 +1,714 @@
+#include "ObjParser.h"
+#include "MappedFile.h"
+
+#include <thread>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace {
+
+    // per thread parse result
+    struct ObjChunk {
+        std::vector<float> vertices;
+        std::vector<float> colors;
+        std::vector<float> normals;
+        std::vector<float> texcoords;
+        std::vector<tinyobj::index_t> corners; // polygon corners, indices already zero based
+        std::vector<uint8_t> faceSizes;        // 3 or 4 corners per face
+        size_t triangleCount = 0;
+
+        // corners using negative (relative) indices, resolved once the chunk's base counts are known
+        struct RelativeCorner {
+            size_t corner;
+            uint8_t components; // bit 0: vertex, 1: texcoord, 2: normal
+        };
+        std::vector<RelativeCorner> relativeCorners;
+
+        // o/g, usemtl and mtllib lines: they depend on state of earlier chunks
+        struct Event {
+            enum Kind : uint8_t { Shape, UseMaterial, MaterialLibrary } kind;
+            size_t triangle; // chunk triangle count when the line was read
+            std::string name;
+        };
+        std::vector<Event> events;
+
+        bool ok = true;
+    };
+
+    inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+    inline bool isSpace(char c) { return c == ' ' || c == '\t'; }
+
+    // same grammar and arithmetic as tinyobj's tryParseDouble, so results are bit identical
+    bool tryParseDouble(const char* s, const char* s_end, double* result) {
+        if (s >= s_end) return false;
+
+        double mantissa = 0.0;
+        int exponent = 0;
+        char sign = '+';
+        char exp_sign = '+';
+        const char* curr = s;
+        int read = 0;
+        bool end_not_reached = false;
+        bool leading_decimal_dots = false;
+
+        if (*curr == '+' || *curr == '-') {
+            sign = *curr;
+            curr++;
+            if ((curr != s_end) && (*curr == '.')) leading_decimal_dots = true;
+        }
+        else if (isDigit(*curr)) {
+        }
+        else if (*curr == '.') {
+            leading_decimal_dots = true;
+        }
+        else {
+            return false;
+        }
+
+        // integer part
+        end_not_reached = (curr != s_end);
+        if (!leading_decimal_dots) {
+            while (end_not_reached && isDigit(*curr)) {
+                mantissa *= 10;
+                mantissa += static_cast<int>(*curr - '0');
+                curr++;
+                read++;
+                end_not_reached = (curr != s_end);
+            }
+            if (read == 0) return false;
+        }
+        if (!end_not_reached) goto assemble;
+
+        // decimal part
+        if (*curr == '.') {
+            curr++;
+            read = 1;
+            end_not_reached = (curr != s_end);
+            while (end_not_reached && isDigit(*curr)) {
+                static const double pow_lut[] = {
+                    1.0, 0.1, 0.01, 0.001, 0.0001, 0.00001, 0.000001, 0.0000001,
+                };
+                const int lut_entries = sizeof pow_lut / sizeof pow_lut[0];
+                mantissa += static_cast<int>(*curr - '0') *
+                    (read < lut_entries ? pow_lut[read] : std::pow(10.0, -read));
+                read++;
+                curr++;
+                end_not_reached = (curr != s_end);
+            }
+        }
+        else if (*curr == 'e' || *curr == 'E') {
+        }
+        else {
+            goto assemble;
+        }
+        if (!end_not_reached) goto assemble;
+
+        // exponent
+        if (*curr == 'e' || *curr == 'E') {
+            curr++;
+            end_not_reached = (curr != s_end);
+            if (end_not_reached && (*curr == '+' || *curr == '-')) {
+                exp_sign = *curr;
+                curr++;
+            }
+            else if (end_not_reached && isDigit(*curr)) {
+            }
+            else {
+                return false;
+            }
+
+            read = 0;
+            end_not_reached = (curr != s_end);
+            while (end_not_reached && isDigit(*curr)) {
+                if (exponent > (2147483647 / 10)) return false;
+                exponent *= 10;
+                exponent += static_cast<int>(*curr - '0');
+                curr++;
+                read++;
+                end_not_reached = (curr != s_end);
+            }
+            exponent *= (exp_sign == '+' ? 1 : -1);
+            if (read == 0) return false;
+        }
+
+    assemble:
+        *result = (sign == '+' ? 1 : -1) *
+            (exponent ? std::ldexp(mantissa * std::pow(5.0, exponent), exponent) : mantissa);
+        return true;
+    }
+
+    // cursor over one line; `end` excludes the line terminator
+    struct LineCursor {
+        const char* p;
+        const char* end;
+
+        void skipSpaces() {
+            while (p < end && isSpace(*p)) ++p;
+        }
+        // end of the current token, like strcspn(p, " \t\r")
+        const char* tokenEnd() const {
+            const char* e = p;
+            while (e < end && !isSpace(*e)) ++e;
+            return e;
+        }
+
+        // tinyobj parseReal: false (and value untouched) if the token is not a number
+        bool parseReal(float* out) {
+            skipSpaces();
+            const char* e = tokenEnd();
+            double val;
+            bool ret = tryParseDouble(p, e, &val);
+            if (ret) *out = static_cast<float>(val);
+            p = e;
+            return ret;
+        }
+        float parseReal(double defaultValue = 0.0) {
+            skipSpaces();
+            const char* e = tokenEnd();
+            double val = defaultValue;
+            tryParseDouble(p, e, &val);
+            p = e;
+            return static_cast<float>(val);
+        }
+
+        // atoi on the bounded line
+        int parseInt() const {
+            const char* c = p;
+            while (c < end && (isSpace(*c) || *c == '\v' || *c == '\f')) ++c;
+            bool negative = false;
+            if (c < end && (*c == '+' || *c == '-')) {
+                negative = *c == '-';
+                ++c;
+            }
+            int value = 0;
+            while (c < end && isDigit(*c)) {
+                value = value * 10 + (*c - '0');
+                ++c;
+            }
+            return negative ? -value : value;
+        }
+        // strcspn(p, "/ \t\r")
+        void skipIndexToken() {
+            while (p < end && *p != '/' && !isSpace(*p)) ++p;
+        }
+    };
+
+    // tinyobj fixIndex without the count: relative indices are flagged and resolved in the merge
+    bool fixIndex(int idx, int localCount, int* ret, bool allowZero, bool* relative) {
+        if (idx > 0) {
+            *ret = idx - 1;
+            return true;
+        }
+        if (idx == 0) {
+            *ret = -1;
+            return allowZero;
+        }
+        *ret = localCount + idx; // may still be negative: base of previous chunks is added later
+        *relative = true;
+        return true;
+    }
+
+    void parseChunk(const char* begin, const char* end, bool isFirstChunk, ObjChunk& chunk) {
+        const char* line = begin;
+
+        // skip UTF-8 BOM
+        if (isFirstChunk && end - line >= 3 &&
+            static_cast<unsigned char>(line[0]) == 0xEF &&
+            static_cast<unsigned char>(line[1]) == 0xBB &&
+            static_cast<unsigned char>(line[2]) == 0xBF) {
+            line += 3;
+        }
+
+        while (line < end) {
+            // '\n', '\r\n' and lone '\r' terminate a line, like tinyobj's safeGetline
+            const char* lineEnd = line;
+            while (lineEnd < end && *lineEnd != '\n' && *lineEnd != '\r') ++lineEnd;
+
+            LineCursor c{ line, lineEnd };
+            line = lineEnd + 1;
+
+            c.skipSpaces();
+            const ptrdiff_t length = c.end - c.p;
+            if (length < 2 || c.p[0] == '#') continue;
+
+            // vertex (optionally with color)
+            if (c.p[0] == 'v' && isSpace(c.p[1])) {
+                c.p += 2;
+                float x = c.parseReal();
+                float y = c.parseReal();
+                float z = c.parseReal();
+                float r = 1.0f, g = 1.0f, b = 1.0f;
+                if (c.parseReal(&r)) {
+                    if (c.parseReal(&g)) {
+                        if (!c.parseReal(&b)) {
+                            r = g = b = 1.0f; // xyz + 2 numbers is treated as xyz
+                        }
+                    }
+                    else {
+                        g = b = 1.0f; // xyzw: tinyobj keeps w in the red channel
+                    }
+                }
+                chunk.vertices.insert(chunk.vertices.end(), { x, y, z });
+                chunk.colors.insert(chunk.colors.end(), { r, g, b });
+                continue;
+            }
+
+            if (length >= 3 && c.p[0] == 'v' && c.p[1] == 'n' && isSpace(c.p[2])) {
+                c.p += 3;
+                float x = c.parseReal();
+                float y = c.parseReal();
+                float z = c.parseReal();
+                chunk.normals.insert(chunk.normals.end(), { x, y, z });
+                continue;
+            }
+
+            if (length >= 3 && c.p[0] == 'v' && c.p[1] == 't' && isSpace(c.p[2])) {
+                c.p += 3;
+                float u = c.parseReal();
+                float v = c.parseReal();
+                chunk.texcoords.insert(chunk.texcoords.end(), { u, v });
+                continue;
+            }
+
+            // face
+            if (c.p[0] == 'f' && isSpace(c.p[1])) {
+                c.p += 2;
+                c.skipSpaces();
+
+                const int vCount = static_cast<int>(chunk.vertices.size() / 3);
+                const int vnCount = static_cast<int>(chunk.normals.size() / 3);
+                const int vtCount = static_cast<int>(chunk.texcoords.size() / 2);
+
+                const size_t firstCorner = chunk.corners.size();
+                while (c.p < c.end && *c.p != '#') {
+                    tinyobj::index_t idx;
+                    idx.vertex_index = idx.normal_index = idx.texcoord_index = -1;
+                    bool relV = false, relVt = false, relVn = false;
+
+                    // i, i/j, i//k, i/j/k
+                    if (!fixIndex(c.parseInt(), vCount, &idx.vertex_index, false, &relV)) {
+                        chunk.ok = false;
+                        return;
+                    }
+                    c.skipIndexToken();
+                    if (c.p < c.end && *c.p == '/') {
+                        ++c.p;
+                        if (c.p < c.end && *c.p == '/') {
+                            ++c.p;
+                            if (!fixIndex(c.parseInt(), vnCount, &idx.normal_index, true, &relVn)) {
+                                chunk.ok = false;
+                                return;
+                            }
+                            c.skipIndexToken();
+                        }
+                        else {
+                            if (!fixIndex(c.parseInt(), vtCount, &idx.texcoord_index, true, &relVt)) {
+                                chunk.ok = false;
+                                return;
+                            }
+                            c.skipIndexToken();
+                            if (c.p < c.end && *c.p == '/') {
+                                ++c.p;
+                                if (!fixIndex(c.parseInt(), vnCount, &idx.normal_index, true, &relVn)) {
+                                    chunk.ok = false;
+                                    return;
+                                }
+                                c.skipIndexToken();
+                            }
+                        }
+                    }
+
+                    if (relV || relVt || relVn) {
+                        chunk.relativeCorners.push_back({ chunk.corners.size(),
+                            static_cast<uint8_t>((relV ? 1 : 0) | (relVt ? 2 : 0) | (relVn ? 4 : 0)) });
+                    }
+                    chunk.corners.push_back(idx);
+                    c.skipSpaces();
+                }
+
+                const size_t cornerCount = chunk.corners.size() - firstCorner;
+                if (cornerCount < 3) {
+                    // degenerate face: tinyobj drops it
+                    while (!chunk.relativeCorners.empty() && chunk.relativeCorners.back().corner >= firstCorner) {
+                        chunk.relativeCorners.pop_back();
+                    }
+                    chunk.corners.resize(firstCorner);
+                    continue;
+                }
+                if (cornerCount > 4) {
+                    // n-gons need tinyobj's ear clipping
+                    chunk.ok = false;
+                    return;
+                }
+                chunk.faceSizes.push_back(static_cast<uint8_t>(cornerCount));
+                chunk.triangleCount += cornerCount - 2;
+                continue;
+            }
+
+            // shape / material state, applied in file order by the merge
+            const char* keywordEnd = c.tokenEnd();
+            const std::string keyword(c.p, keywordEnd);
+            if (keyword == "o" || keyword == "g" || keyword == "usemtl" || keyword == "mtllib") {
+                c.p = keywordEnd;
+                c.skipSpaces();
+                // usemtl takes one token like tinyobj, mtllib a list of file names
+                const char* nameEnd = c.end;
+                while (nameEnd > c.p && isSpace(nameEnd[-1])) --nameEnd;
+                if (keyword == "usemtl") nameEnd = c.tokenEnd();
+
+                ObjChunk::Event event;
+                event.kind = keyword == "usemtl" ? ObjChunk::Event::UseMaterial :
+                    keyword == "mtllib" ? ObjChunk::Event::MaterialLibrary : ObjChunk::Event::Shape;
+                event.triangle = chunk.triangleCount;
+                event.name.assign(c.p, nameEnd);
+                chunk.events.push_back(std::move(event));
+            }
+            // s, l, p ... do not change the triangle list
+        }
+    }
+
+    // runs task(i) for i in [0, count) on separate threads (task 0 on the calling thread)
+    void runParallel(size_t count, const std::function<void(size_t)>& task) {
+#ifdef __EMSCRIPTEN__
+        for (size_t i = 0; i < count; ++i) task(i);
+#else
+        std::vector<std::thread> threads;
+        threads.reserve(count);
+        for (size_t i = 1; i < count; ++i) {
+            threads.emplace_back(task, i);
+        }
+        if (count > 0) task(0);
+        for (std::thread& thread : threads) thread.join();
+#endif
+    }
+
+    // chunk boundaries for threadCount threads, moved forward to the start of the next line
+    std::vector<size_t> getChunkBounds(const char* data, size_t size, unsigned threadCount) {
+        if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+#ifdef __EMSCRIPTEN__
+        threadCount = 1;
+#endif
+        // tiny files are not worth the thread start up
+        const size_t minChunkSize = 1 << 20;
+        const size_t chunkCount = std::max<size_t>(1, std::min<size_t>(threadCount, size / minChunkSize));
+
+        std::vector<size_t> bounds(chunkCount + 1, size);
+        bounds[0] = 0;
+        for (size_t i = 1; i < chunkCount; ++i) {
+            size_t b = std::max(bounds[i - 1], size * i / chunkCount);
+            while (b < size && data[b] != '\n' && data[b] != '\r') ++b;
+            bounds[i] = b < size ? b + 1 : size;
+        }
+        return bounds;
+    }
+
+    // writes the chunk's faces as triangles, positions: xyz of every vertex of the file
+    void triangulate(const ObjChunk& chunk, const float* positions, tinyobj::index_t* out) {
+        const tinyobj::index_t* corner = chunk.corners.data();
+        for (uint8_t faceSize : chunk.faceSizes) {
+            if (faceSize == 3) {
+                out[0] = corner[0];
+                out[1] = corner[1];
+                out[2] = corner[2];
+                out += 3;
+            }
+            else {
+                if (ObjParser::splitsQuadAlong02(positions + 3 * size_t(corner[0].vertex_index),
+                                                 positions + 3 * size_t(corner[1].vertex_index),
+                                                 positions + 3 * size_t(corner[2].vertex_index),
+                                                 positions + 3 * size_t(corner[3].vertex_index))) {
+                    out[0] = corner[0]; out[1] = corner[1]; out[2] = corner[2];
+                    out[3] = corner[0]; out[4] = corner[2]; out[5] = corner[3];
+                }
+                else {
+                    out[0] = corner[0]; out[1] = corner[1]; out[2] = corner[3];
+                    out[3] = corner[1]; out[4] = corner[2]; out[5] = corner[3];
+                }
+                out += 6;
+            }
+            corner += faceSize;
+        }
+    }
+
+    // mtllib: several file names are allowed, the first one that loads wins
+    void loadMaterialLibrary(const std::filesystem::path& objPath, const std::string& names,
+                             std::map<std::string, int>& materialMap, std::vector<tinyobj::material_t>& materials) {
+        std::istringstream stream(names);
+        std::string name;
+        while (stream >> name) {
+            std::ifstream mtl(objPath.parent_path() / name);
+            if (!mtl.is_open()) continue;
+            std::string warning, error;
+            tinyobj::LoadMtl(&materialMap, &materials, &mtl, &warning, &error);
+            break;
+        }
+    }
+}
+
+bool ObjParser::parse(const std::filesystem::path& path, ObjGeometry& geometry, unsigned threadCount) {
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    const char* data = reinterpret_cast<const char*>(file.data());
+    const size_t size = file.size();
+
+    const std::vector<size_t> bounds = getChunkBounds(data, size, threadCount);
+    const size_t chunkCount = bounds.size() - 1;
+
+    std::vector<ObjChunk> chunks(chunkCount);
+    runParallel(chunkCount, [&](size_t i) {
+        parseChunk(data + bounds[i], data + bounds[i + 1], i == 0, chunks[i]);
+        });
+
+    // MERGE -----------------------------------------------------------------------
+    struct ChunkBase {
+        size_t v = 0, vn = 0, vt = 0, triangles = 0;
+    };
+    std::vector<ChunkBase> bases(chunkCount + 1);
+    for (size_t i = 0; i < chunkCount; ++i) {
+        if (!chunks[i].ok) return false;
+        bases[i + 1].v = bases[i].v + chunks[i].vertices.size() / 3;
+        bases[i + 1].vn = bases[i].vn + chunks[i].normals.size() / 3;
+        bases[i + 1].vt = bases[i].vt + chunks[i].texcoords.size() / 2;
+        bases[i + 1].triangles = bases[i].triangles + chunks[i].triangleCount;
+    }
+    const ChunkBase& total = bases[chunkCount];
+    if (total.v > size_t(INT32_MAX) || total.vn > size_t(INT32_MAX) || total.vt > size_t(INT32_MAX)) return false;
+
+    tinyobj::attrib_t& attrib = geometry.attrib;
+    attrib = tinyobj::attrib_t();
+    attrib.vertices.resize(total.v * 3);
+    attrib.colors.resize(total.v * 3);
+    attrib.normals.resize(total.vn * 3);
+    attrib.texcoords.resize(total.vt * 2);
+    geometry.indices.resize(total.triangles * 3);
+
+    // copy attributes first: quad splitting needs every position
+    runParallel(chunkCount, [&](size_t i) {
+        ObjChunk& chunk = chunks[i];
+        std::copy(chunk.vertices.begin(), chunk.vertices.end(), attrib.vertices.begin() + bases[i].v * 3);
+        std::copy(chunk.colors.begin(), chunk.colors.end(), attrib.colors.begin() + bases[i].v * 3);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), attrib.normals.begin() + bases[i].vn * 3);
+        std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), attrib.texcoords.begin() + bases[i].vt * 2);
+        std::vector<float>().swap(chunk.vertices);
+        std::vector<float>().swap(chunk.colors);
+        std::vector<float>().swap(chunk.normals);
+        std::vector<float>().swap(chunk.texcoords);
+        });
+
+    std::vector<char> chunkValid(chunkCount, 1);
+    runParallel(chunkCount, [&](size_t i) {
+        ObjChunk& chunk = chunks[i];
+
+        for (const ObjChunk::RelativeCorner& rel : chunk.relativeCorners) {
+            tinyobj::index_t& idx = chunk.corners[rel.corner];
+            if (rel.components & 1) idx.vertex_index += static_cast<int>(bases[i].v);
+            if (rel.components & 2) idx.texcoord_index += static_cast<int>(bases[i].vt);
+            if (rel.components & 4) idx.normal_index += static_cast<int>(bases[i].vn);
+            if (idx.vertex_index < 0 || ((rel.components & 2) && idx.texcoord_index < 0) ||
+                ((rel.components & 4) && idx.normal_index < 0)) {
+                chunkValid[i] = 0; // relative index before the first element
+                return;
+            }
+        }
+        for (const tinyobj::index_t& idx : chunk.corners) {
+            if (idx.vertex_index < 0 || size_t(idx.vertex_index) >= total.v ||
+                idx.normal_index >= int(total.vn) || idx.texcoord_index >= int(total.vt)) {
+                chunkValid[i] = 0;
+                return;
+            }
+        }
+
+        triangulate(chunk, attrib.vertices.data(), geometry.indices.data() + bases[i].triangles * 3);
+        std::vector<tinyobj::index_t>().swap(chunk.corners);
+        });
+
+    for (char valid : chunkValid) {
+        if (!valid) return false;
+    }
+
+    // shapes and materials, sequentially in file order
+    geometry.materials.clear();
+    geometry.materialIds.assign(total.triangles, -1);
+    geometry.shapeOffsets.assign(1, 0);
+    std::map<std::string, int> materialMap;
+    int materialId = -1;
+    size_t materialStart = 0;
+    for (size_t i = 0; i < chunkCount; ++i) {
+        for (const ObjChunk::Event& event : chunks[i].events) {
+            const size_t triangle = bases[i].triangles + event.triangle;
+            switch (event.kind) {
+            case ObjChunk::Event::Shape:
+                // like tinyobj, a shape without faces is merged into the next one
+                if (triangle > geometry.shapeOffsets.back()) geometry.shapeOffsets.push_back(triangle);
+                break;
+            case ObjChunk::Event::UseMaterial: {
+                std::fill(geometry.materialIds.begin() + materialStart, geometry.materialIds.begin() + triangle, materialId);
+                auto it = materialMap.find(event.name);
+                materialId = it != materialMap.end() ? it->second : -1;
+                materialStart = triangle;
+                break;
+            }
+            case ObjChunk::Event::MaterialLibrary:
+                loadMaterialLibrary(path, event.name, materialMap, geometry.materials);
+                break;
+            }
+        }
+    }
+    std::fill(geometry.materialIds.begin() + materialStart, geometry.materialIds.end(), materialId);
+    return true;
+}
+
+bool ObjParser::parseStreaming(const std::filesystem::path& path, size_t windowBytes,
+                               std::vector<tinyobj::material_t>& materials,
+                               const std::function<bool(const ObjWindow&)>& consume, unsigned threadCount) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    materials.clear();
+    std::map<std::string, int> materialMap;
+    int materialId = -1;
+    size_t vertexCount = 0, normalCount = 0, texcoordCount = 0; // file-wide, before the current window
+
+    std::vector<char> buffer(std::max<size_t>(windowBytes, 1 << 16));
+    size_t carry = 0; // unfinished last line of the previous read, at the start of buffer
+    bool firstWindow = true;
+    bool endOfFile = false;
+    ObjWindow window;
+    while (!endOfFile) {
+        file.read(buffer.data() + carry, static_cast<std::streamsize>(buffer.size() - carry));
+        const size_t size = carry + static_cast<size_t>(file.gcount());
+        endOfFile = size < buffer.size();
+        if (file.bad()) return false;
+
+        // parse up to the last line end, the rest goes into the next window
+        size_t cut = size;
+        if (!endOfFile) {
+            while (cut > 0 && buffer[cut - 1] != '\n' && buffer[cut - 1] != '\r') --cut;
+            if (cut == 0) {
+                // a single line longer than the window
+                carry = size;
+                buffer.resize(buffer.size() * 2);
+                continue;
+            }
+        }
+
+        const char* data = buffer.data();
+        const std::vector<size_t> bounds = getChunkBounds(data, cut, threadCount);
+        const size_t chunkCount = bounds.size() - 1;
+        std::vector<ObjChunk> chunks(chunkCount);
+        runParallel(chunkCount, [&](size_t i) {
+            parseChunk(data + bounds[i], data + bounds[i + 1], firstWindow && i == 0, chunks[i]);
+            });
+
+        window.vertices.clear();
+        window.colors.clear();
+        window.normals.clear();
+        window.texcoords.clear();
+        window.indices.clear();
+        window.faceSizes.clear();
+        window.materialIds.clear();
+        window.vertexBase = vertexCount;
+        window.normalBase = normalCount;
+        window.texcoordBase = texcoordCount;
+
+        for (ObjChunk& chunk : chunks) {
+            if (!chunk.ok) return false;
+            // file-wide index of the chunk's first elements
+            const size_t v = vertexCount + window.vertices.size() / 3;
+            const size_t vn = normalCount + window.normals.size() / 3;
+            const size_t vt = texcoordCount + window.texcoords.size() / 2;
+            if (v + chunk.vertices.size() / 3 > size_t(INT32_MAX) || vn + chunk.normals.size() / 3 > size_t(INT32_MAX) ||
+                vt + chunk.texcoords.size() / 2 > size_t(INT32_MAX)) return false;
+
+            for (const ObjChunk::RelativeCorner& rel : chunk.relativeCorners) {
+                tinyobj::index_t& idx = chunk.corners[rel.corner];
+                if (rel.components & 1) idx.vertex_index += static_cast<int>(v);
+                if (rel.components & 2) idx.texcoord_index += static_cast<int>(vt);
+                if (rel.components & 4) idx.normal_index += static_cast<int>(vn);
+                if (idx.vertex_index < 0 || ((rel.components & 2) && idx.texcoord_index < 0) ||
+                    ((rel.components & 4) && idx.normal_index < 0)) return false;
+            }
+            window.vertices.insert(window.vertices.end(), chunk.vertices.begin(), chunk.vertices.end());
+            window.colors.insert(window.colors.end(), chunk.colors.begin(), chunk.colors.end());
+            window.normals.insert(window.normals.end(), chunk.normals.begin(), chunk.normals.end());
+            window.texcoords.insert(window.texcoords.end(), chunk.texcoords.begin(), chunk.texcoords.end());
+        }
+
+        for (const ObjChunk& chunk : chunks) {
+            const size_t firstTriangle = window.materialIds.size();
+            window.indices.insert(window.indices.end(), chunk.corners.begin(), chunk.corners.end());
+            window.faceSizes.insert(window.faceSizes.end(), chunk.faceSizes.begin(), chunk.faceSizes.end());
+
+            // materials in file order, carried over from earlier windows
+            size_t materialStart = firstTriangle;
+            window.materialIds.resize(firstTriangle + chunk.triangleCount, -1);
+            for (const ObjChunk::Event& event : chunk.events) {
+                const size_t triangle = firstTriangle + event.triangle;
+                if (event.kind == ObjChunk::Event::UseMaterial) {
+                    std::fill(window.materialIds.begin() + materialStart, window.materialIds.begin() + triangle, materialId);
+                    auto it = materialMap.find(event.name);
+                    materialId = it != materialMap.end() ? it->second : -1;
+                    materialStart = triangle;
+                }
+                else if (event.kind == ObjChunk::Event::MaterialLibrary) {
+                    loadMaterialLibrary(path, event.name, materialMap, materials);
+                }
+            }
+            std::fill(window.materialIds.begin() + materialStart, window.materialIds.end(), materialId);
+        }
+
+        vertexCount += window.vertices.size() / 3;
+        normalCount += window.normals.size() / 3;
+        texcoordCount += window.texcoords.size() / 2;
+        if (!consume(window)) return false;
+
+        carry = size - cut;
+        std::memmove(buffer.data(), buffer.data() + cut, carry);
+        firstWindow = false;
+    }
+    return true;
+}
+
+bool ObjParser::splitsQuadAlong02(const float* v0, const float* v1, const float* v2, const float* v3) {
+    float e02x = v2[0] - v0[0], e02y = v2[1] - v0[1], e02z = v2[2] - v0[2];
+    float e13x = v3[0] - v1[0], e13y = v3[1] - v1[1], e13z = v3[2] - v1[2];
+    float sqr02 = e02x * e02x + e02y * e02y + e02z * e02z;
+    float sqr13 = e13x * e13x + e13y * e13y + e13z * e13z;
+    return sqr02 < sqr13;
+}
+
+// mtl texture name -> path usable from the working directory (empty stays empty)
+static std::string resolveTexturePath(const std::filesystem::path& objPath, const std::string& texname)
+{
+    if (texname.empty()) return texname;
+    std::string name = texname;
+    std::replace(name.begin(), name.end(), '\\', '/'); // exporters on Windows write backslashes
+    return (objPath.parent_path() / name).lexically_normal().string();
+}
+
+MeshMaterial ObjParser::getMaterial(const std::filesystem::path& objPath, const tinyobj::material_t& material)
+{
+    MeshMaterial m;
+    m.name = material.name;
+    m.diffuse = { material.diffuse[0], material.diffuse[1], material.diffuse[2] };
+    m.metallic = material.metallic;
+    // map_Pr / Pr when present, else derived from the Phong exponent
+    m.roughness = material.roughness > 0.0f ? material.roughness
+        : std::sqrt(2.0f / (std::max(material.shininess, 0.0f) + 2.0f));
+    m.diffuseTexture = resolveTexturePath(objPath, material.diffuse_texname);
+    // many exporters put tangent space normal maps into map_Bump
+    m.normalTexture = resolveTexturePath(objPath,
+        !material.normal_texname.empty() ? material.normal_texname : material.bump_texname);
+    m.roughnessTexture = resolveTexturePath(objPath, material.roughness_texname);
+    m.metallicTexture = resolveTexturePath(objPath, material.metallic_texname);
+    return m;
+}
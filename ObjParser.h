@@ -0,0 +1,59 @@
+#pragma once
+#include <filesystem>
+#include <functional>
+#include <vector>
+
+#include "tiny_obj_loader.h"
+#include "MeshData.h"
+
+// Geometry of a whole OBJ file in tinyobj's representation
+struct ObjGeometry {
+    tinyobj::attrib_t attrib; // vertices, colors, normals, texcoords (same contents tinyobj produces)
+    std::vector<tinyobj::index_t> indices; // triangulated corners of every shape, in file order
+    std::vector<int> materialIds;          // per triangle, index into materials or -1
+    std::vector<size_t> shapeOffsets;      // first triangle of every shape (o / g)
+    std::vector<tinyobj::material_t> materials; // from the mtllib files next to the OBJ
+};
+
+// Part of an OBJ read by ObjParser::parseStreaming: the elements defined since the previous window
+// and its faces. Corner indices are file-wide and zero based. Faces are not triangulated: the split of a
+// quad depends on positions that may have been read in earlier windows (see ObjParser::splitsQuadAlong02).
+struct ObjWindow {
+    std::vector<float> vertices;  // xyz per v record
+    std::vector<float> colors;    // rgb per v record
+    std::vector<float> normals;
+    std::vector<float> texcoords;
+    size_t vertexBase = 0;        // file-wide index of the first v / vn / vt record above
+    size_t normalBase = 0;
+    size_t texcoordBase = 0;
+    std::vector<tinyobj::index_t> indices; // face corners, may reference elements of earlier windows
+    std::vector<uint8_t> faceSizes;        // 3 or 4 corners per face
+    std::vector<int> materialIds;          // per triangle, 2 per quad
+};
+
+// Multithreaded OBJ parser: memory-maps the file, splits it at line boundaries
+// and parses v/vn/vt/f records of each chunk on its own thread, then merges the chunks.
+// o/g/usemtl/mtllib lines are recorded per chunk and resolved in file order during the merge.
+// Produces exactly what tinyobj::ObjReader does for the same file (bit identical floats,
+// same quad split). Returns false on parse errors and for files it does not handle
+// (polygons with more than 4 vertices), so callers can fall back to tinyobj.
+class ObjParser
+{
+public:
+    // threadCount 0: one thread per hardware thread
+    static bool parse(const std::filesystem::path& path, ObjGeometry& geometry, unsigned threadCount = 0);
+
+    // MTL material -> MeshMaterial, texture paths made usable from the working directory
+    static MeshMaterial getMaterial(const std::filesystem::path& objPath, const tinyobj::material_t& material);
+
+    // Bounded memory variant for files that do not fit in RAM: reads windowBytes of the file at a
+    // time (cut at a line end), parses each window like parse() and hands it to consume, which
+    // returns false to stop. materials: from the mtllib files.
+    static bool parseStreaming(const std::filesystem::path& path, size_t windowBytes,
+                               std::vector<tinyobj::material_t>& materials,
+                               const std::function<bool(const ObjWindow&)>& consume, unsigned threadCount = 0);
+
+    // tinyobj splits a quad along its shorter diagonal: true for 0-2 (triangles 012, 023), false for
+    // 1-3 (triangles 013, 123)
+    static bool splitsQuadAlong02(const float* p0, const float* p1, const float* p2, const float* p3);
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+// Data parallel loops on short lived std::threads: [0, count) is split into one contiguous
+// range per hardware thread, the first range runs on the calling thread.
+class Parallel
+{
+public:
+    static unsigned getThreadCount() {
+#ifdef __EMSCRIPTEN__
+        return 1;
+#else
+        return std::max(1u, std::thread::hardware_concurrency());
+#endif
+    }
+
+    // task(begin, end) for every range; ranges shorter than minRange are not worth a thread
+    static void forRanges(size_t count, size_t minRange, const std::function<void(size_t, size_t)>& task) {
+        const size_t rangeCount = std::max<size_t>(1,
+            std::min<size_t>(getThreadCount(), count / std::max<size_t>(minRange, 1)));
+        if (rangeCount == 1) {
+            if (count > 0) task(0, count);
+            return;
+        }
+        const size_t rangeSize = (count + rangeCount - 1) / rangeCount;
+
+        std::vector<std::thread> threads;
+        threads.reserve(rangeCount - 1);
+        for (size_t r = 1; r < rangeCount; ++r) {
+            const size_t begin = std::min(count, r * rangeSize);
+            const size_t end = std::min(count, begin + rangeSize);
+            threads.emplace_back(task, begin, end);
+        }
+        task(0, std::min(count, rangeSize));
+        for (std::thread& thread : threads) thread.join();
+    }
+};
@@ -0,0 +1,73 @@
+#include "ProgressiveMesh.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+void ProgressiveMesh::build(MeshData& mesh) {
+    mesh.pages.clear();
+    if (mesh.indices.empty()) return;
+
+    uint32_t pageCount = 1;
+    size_t coveredIndices = 0;
+    for (const Submesh& submesh : mesh.submeshes) {
+        pageCount = std::max(pageCount, submesh.lodCount + 1);
+        coveredIndices += submesh.indexCount;
+        for (uint32_t l = 0; l < submesh.lodCount; ++l) coveredIndices += mesh.lods[submesh.lodOffset + l].indexCount;
+    }
+    // indices outside of every submesh / LOD would be lost by the regrouping
+    if (coveredIndices != mesh.indices.size()) {
+        std::cerr << "ProgressiveMesh: index ranges do not cover the mesh, kept as one page" << std::endl;
+        return;
+    }
+
+    // copies a submesh / LOD range to the end of the new index buffer, its meshlets move along
+    std::vector<uint32_t> indices;
+    indices.reserve(mesh.indices.size());
+    auto append = [&](uint32_t& indexOffset, uint32_t indexCount, uint32_t meshletOffset, uint32_t meshletCount) {
+        const uint32_t newOffset = static_cast<uint32_t>(indices.size());
+        indices.insert(indices.end(), mesh.indices.begin() + indexOffset, mesh.indices.begin() + indexOffset + indexCount);
+        for (uint32_t m = meshletOffset; m < meshletOffset + meshletCount; ++m) {
+            mesh.meshlets[m].indexOffset = mesh.meshlets[m].indexOffset - indexOffset + newOffset;
+        }
+        indexOffset = newOffset;
+    };
+
+    std::vector<uint32_t> pageEnds(pageCount);
+    for (uint32_t page = 0; page < pageCount; ++page) {
+        for (Submesh& submesh : mesh.submeshes) {
+            if (page > submesh.lodCount) continue; // already at full resolution
+            const uint32_t level = submesh.lodCount - page;
+            if (level == 0) {
+                append(submesh.indexOffset, submesh.indexCount, submesh.meshletOffset, submesh.meshletCount);
+            }
+            else {
+                SubmeshLod& lod = mesh.lods[submesh.lodOffset + level - 1];
+                append(lod.indexOffset, lod.indexCount, lod.meshletOffset, lod.meshletCount);
+            }
+        }
+        pageEnds[page] = static_cast<uint32_t>(indices.size());
+    }
+    mesh.indices.swap(indices);
+
+    // first-use order over the pages: the vertices of every page follow those of the previous ones
+    MeshOptimizer::optimizeVertexFetch(mesh);
+
+    uint32_t vertexEnd = 0;
+    size_t i = 0;
+    for (uint32_t page = 0; page < pageCount; ++page) {
+        for (; i < pageEnds[page]; ++i) vertexEnd = std::max(vertexEnd, mesh.indices[i] + 1);
+        mesh.pages.push_back({ vertexEnd, pageEnds[page] });
+    }
+
+    std::cout << "ProgressiveMesh: " << pageCount << " pages, first page " << mesh.pages[0].vertexCount << " / "
+              << mesh.vertices.size() << " vertices, " << mesh.pages[0].indexCount << " / " << mesh.indices.size()
+              << " indices" << std::endl;
+}
+
+uint32_t ProgressiveMesh::getFinestLevel(const Submesh& submesh, uint32_t residentPages) {
+    // page p holds level lodCount - p
+    if (residentPages == 0) return submesh.lodCount;
+    return residentPages > submesh.lodCount ? 0 : submesh.lodCount + 1 - residentPages;
+}
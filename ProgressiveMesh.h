@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+
+#include "MeshData.h"
+
+// Progressive layout for a fast first frame: the index buffer is regrouped into pages, page p holding
+// every submesh at LOD level lodCount - p (coarsest first, full resolution last), and vertices are
+// renumbered in order of first use across the pages. Every page then only adds to the end of the
+// vertex and index buffers, so the mesh can be drawn as soon as page 0 is uploaded and refined as
+// the later pages come in.
+class ProgressiveMesh
+{
+public:
+    // after MeshletBuilder::build: moves the index ranges of submeshes, LODs and meshlets, renumbers
+    // the vertices (MeshOptimizer::optimizeVertexFetch over the new order) and fills mesh.pages
+    static void build(MeshData& mesh);
+
+    // finest level of the submesh that can be drawn with the first residentPages pages uploaded
+    static uint32_t getFinestLevel(const Submesh& submesh, uint32_t residentPages);
+};
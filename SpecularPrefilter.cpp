@@ -0,0 +1,197 @@
+#include "SpecularPrefilter.h"
+#include "FileManagement.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace wgpu;
+
+bool SpecularPrefilter::initialize(Device targetDevice) {
+    device = targetDevice;
+    ShaderModule module = FileManagement::loadShaderModule("../files/prefilter.wgsl", device);
+    if (!module) {
+        std::cerr << "Prefilter shader module creation failed!" << std::endl;
+        return false;
+    }
+
+    std::vector<BindGroupLayoutEntry> layoutEntries(4, Default);
+    // 0. PrefilterParams
+    layoutEntries[0].binding = 0;
+    layoutEntries[0].visibility = ShaderStage::Compute;
+    layoutEntries[0].buffer.type = BufferBindingType::Uniform;
+    layoutEntries[0].buffer.minBindingSize = sizeof(PrefilterParams);
+    // 1. environment, all of its mips
+    layoutEntries[1].binding = 1;
+    layoutEntries[1].visibility = ShaderStage::Compute;
+    layoutEntries[1].texture.sampleType = TextureSampleType::Float;
+    layoutEntries[1].texture.viewDimension = TextureViewDimension::Cube;
+    // 2. its sampler
+    layoutEntries[2].binding = 2;
+    layoutEntries[2].visibility = ShaderStage::Compute;
+    layoutEntries[2].sampler.type = SamplerBindingType::Filtering;
+    // 3. the level written
+    layoutEntries[3].binding = 3;
+    layoutEntries[3].visibility = ShaderStage::Compute;
+    layoutEntries[3].storageTexture.access = StorageTextureAccess::WriteOnly;
+    layoutEntries[3].storageTexture.format = TextureFormat::RGBA16Float;
+    layoutEntries[3].storageTexture.viewDimension = TextureViewDimension::_2DArray;
+
+    BindGroupLayoutDescriptor layoutDesc{};
+    layoutDesc.entryCount = (uint32_t)layoutEntries.size();
+    layoutDesc.entries = layoutEntries.data();
+    bindGroupLayout = device.createBindGroupLayout(layoutDesc);
+
+    PipelineLayoutDescriptor pipelineLayoutDesc{};
+    pipelineLayoutDesc.bindGroupLayoutCount = 1;
+    pipelineLayoutDesc.bindGroupLayouts = (WGPUBindGroupLayout*)&bindGroupLayout;
+    PipelineLayout pipelineLayout = device.createPipelineLayout(pipelineLayoutDesc);
+
+    ComputePipelineDescriptor pipelineDesc;
+    pipelineDesc.label = "Prefilter Pipeline";
+    pipelineDesc.layout = pipelineLayout;
+    pipelineDesc.compute.module = module;
+    pipelineDesc.compute.entryPoint = "cs_prefilter";
+    pipelineDesc.compute.constantCount = 0;
+    pipelineDesc.compute.constants = nullptr;
+    pipeline = device.createComputePipeline(pipelineDesc);
+
+    pipelineLayout.release();
+    module.release();
+
+    SamplerDescriptor samplerDesc;
+    samplerDesc.addressModeU = AddressMode::ClampToEdge;
+    samplerDesc.addressModeV = AddressMode::ClampToEdge;
+    samplerDesc.addressModeW = AddressMode::ClampToEdge;
+    samplerDesc.magFilter = FilterMode::Linear;
+    samplerDesc.minFilter = FilterMode::Linear;
+    samplerDesc.mipmapFilter = MipmapFilterMode::Linear;
+    samplerDesc.lodMinClamp = 0.0f;
+    samplerDesc.lodMaxClamp = 32.0f;
+    samplerDesc.compare = CompareFunction::Undefined;
+    samplerDesc.maxAnisotropy = 1;
+    sampler = device.createSampler(samplerDesc);
+    return true;
+}
+
+void SpecularPrefilter::release() {
+    if (!pipeline) return;
+    sampler.release();
+    pipeline.release();
+    bindGroupLayout.release();
+    pipeline = nullptr;
+}
+
+Texture SpecularPrefilter::generate(Queue queue, TextureView environment) {
+    if (!pipeline) return nullptr;
+
+    TextureDescriptor textureDesc;
+    textureDesc.label = "Prefiltered specular environment";
+    textureDesc.dimension = TextureDimension::_2D;
+    textureDesc.format = TextureFormat::RGBA16Float;
+    textureDesc.mipLevelCount = LevelCount;
+    textureDesc.sampleCount = 1;
+    textureDesc.size = { FaceSize, FaceSize, 6 };
+    textureDesc.usage = TextureUsage::TextureBinding | TextureUsage::StorageBinding | TextureUsage::CopySrc;
+    textureDesc.viewFormatCount = 0;
+    textureDesc.viewFormats = nullptr;
+    Texture texture = device.createTexture(textureDesc);
+
+    // the parameters of every level in one uniform buffer
+    SupportedLimits limits;
+    device.getLimits(&limits);
+    const uint64_t alignment = limits.limits.minUniformBufferOffsetAlignment;
+    const uint64_t stride = (sizeof(PrefilterParams) + alignment - 1) / alignment * alignment;
+    std::vector<uint8_t> paramData(LevelCount * stride, 0);
+    for (uint32_t level = 0; level < LevelCount; ++level) {
+        PrefilterParams params{};
+        params.roughness = float(level) / float(LevelCount - 1);
+        params.sampleCount = SampleCount;
+        std::memcpy(paramData.data() + level * stride, &params, sizeof(params));
+    }
+    BufferDescriptor paramBufferDesc;
+    paramBufferDesc.label = "Prefilter Params";
+    paramBufferDesc.usage = BufferUsage::CopyDst | BufferUsage::Uniform;
+    paramBufferDesc.size = paramData.size();
+    paramBufferDesc.mappedAtCreation = false;
+    Buffer paramBuffer = device.createBuffer(paramBufferDesc);
+    queue.writeBuffer(paramBuffer, 0, paramData.data(), paramData.size());
+
+    CommandEncoderDescriptor encoderDesc = {};
+    encoderDesc.label = "prefilter encoder";
+    CommandEncoder encoder = device.createCommandEncoder(encoderDesc);
+    ComputePassDescriptor computePassDesc;
+    computePassDesc.timestampWrites = nullptr;
+    ComputePassEncoder computePass = encoder.beginComputePass(computePassDesc);
+    computePass.setPipeline(pipeline);
+
+    // levels only read the environment: independent dispatches
+    std::vector<TextureView> views(LevelCount);
+    std::vector<BindGroup> bindGroups(LevelCount);
+    for (uint32_t level = 0; level < LevelCount; ++level) {
+        TextureViewDescriptor viewDesc;
+        viewDesc.aspect = TextureAspect::All;
+        viewDesc.baseArrayLayer = 0;
+        viewDesc.arrayLayerCount = 6;
+        viewDesc.baseMipLevel = level;
+        viewDesc.mipLevelCount = 1;
+        viewDesc.dimension = TextureViewDimension::_2DArray;
+        viewDesc.format = TextureFormat::RGBA16Float;
+        views[level] = texture.createView(viewDesc);
+
+        std::vector<BindGroupEntry> entries(4);
+        entries[0].binding = 0;
+        entries[0].buffer = paramBuffer;
+        entries[0].offset = level * stride;
+        entries[0].size = sizeof(PrefilterParams);
+        entries[1].binding = 1;
+        entries[1].textureView = environment;
+        entries[2].binding = 2;
+        entries[2].sampler = sampler;
+        entries[3].binding = 3;
+        entries[3].textureView = views[level];
+
+        BindGroupDescriptor bindGroupDesc{};
+        bindGroupDesc.layout = bindGroupLayout;
+        bindGroupDesc.entryCount = (uint32_t)entries.size();
+        bindGroupDesc.entries = entries.data();
+        bindGroups[level] = device.createBindGroup(bindGroupDesc);
+
+        // @workgroup_size(8, 8): one workgroup per 8x8 texels, z: faces
+        const uint32_t size = std::max(1u, FaceSize >> level);
+        computePass.setBindGroup(0, bindGroups[level], 0, nullptr);
+        computePass.dispatchWorkgroups((size + 7) / 8, (size + 7) / 8, 6);
+    }
+    computePass.end();
+    computePass.release();
+
+    CommandBufferDescriptor cmdBufferDescriptor = {};
+    cmdBufferDescriptor.label = "Prefilter";
+    CommandBuffer command = encoder.finish(cmdBufferDescriptor);
+    encoder.release();
+    queue.submit(1, &command);
+    command.release();
+
+    for (BindGroup& bindGroup : bindGroups) bindGroup.release();
+    for (TextureView& view : views) view.release();
+    paramBuffer.release();
+    return texture;
+}
+
+std::filesystem::path SpecularPrefilter::getCachePath(const std::filesystem::path& source, uint64_t sourceHash, uint32_t environmentSize) {
+    const uint64_t prime = 0x9E3779B97F4A7C15ull;
+    uint64_t key = sourceHash;
+    for (uint64_t setting : { uint64_t(environmentSize), uint64_t(FaceSize), uint64_t(LevelCount), uint64_t(SampleCount), uint64_t(Version) }) {
+        key = (key ^ setting) * prime;
+    }
+    std::ostringstream name;
+    name << ".ggx-" << std::hex << std::setw(16) << std::setfill('0') << key << ".ktx2";
+
+    std::filesystem::path cachePath = source;
+    if (!cachePath.has_filename()) cachePath = cachePath.parent_path(); // "folder/"
+    cachePath += name.str();
+    return cachePath;
+}
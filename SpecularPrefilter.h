@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+
+#include <webgpu/webgpu.hpp>
+
+// Specular IBL (files/prefilter.wgsl): level l of an RGBA16Float cube holds the environment convolved
+// with the GGX lobe of roughness l / (LevelCount - 1), so the shading pass gets the reflection of any
+// roughness from one trilinear textureSampleLevel. Importance sampled, SampleCount points per texel,
+// each read from the environment mip matching its pdf. EnvironmentMap::prefilterSpecular is the CPU
+// reference. The result only depends on the environment: the app writes it to getCachePath once.
+class SpecularPrefilter
+{
+public:
+    static constexpr uint32_t FaceSize = 128;
+    static constexpr uint32_t LevelCount = 6; // roughness 0, 0.2 .. 1, down to 4x4 faces
+    static constexpr uint32_t SampleCount = 128;
+
+    bool initialize(wgpu::Device device);
+    void release();
+    bool isInitialized() const { return bool(pipeline); }
+
+    // every level from environment (cube view of a float or unorm texture with its mips), submitted right away.
+    // The texture has CopySrc usage for GpuReadback
+    wgpu::Texture generate(wgpu::Queue queue, wgpu::TextureView environment);
+
+    // <source>.ggx-<key>.ktx2, the key hashes the source contents (TextureCooker::hashSource), the face
+    // size it was converted to (HDR panoramas, 0 otherwise) and the settings above
+    static std::filesystem::path getCachePath(const std::filesystem::path& source, uint64_t sourceHash, uint32_t environmentSize);
+
+private:
+    // prefilter.wgsl PrefilterParams, one per level at the uniform offset alignment
+    struct PrefilterParams {
+        float roughness;
+        uint32_t sampleCount;
+        uint32_t padding[2];
+    };
+
+    // bump when the filtering changes: old cache files are then ignored
+    static constexpr uint32_t Version = 2; // 2: 8-bit environments are sampled as sRGB
+
+    wgpu::Device device;
+    wgpu::BindGroupLayout bindGroupLayout;
+    wgpu::ComputePipeline pipeline;
+    wgpu::Sampler sampler; // trilinear, the sample lod picks the environment mip
+};
@@ -0,0 +1,193 @@
+#include "SphericalHarmonics.h"
+#include "EnvironmentMap.h"
+#include "Parallel.h"
+
+#include <cmath>
+#include <vector>
+#include <glm/gtc/packing.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define SPHERICAL_HARMONICS_SSE2
+#  include <xmmintrin.h>
+#endif
+
+namespace {
+    const float Pi = 3.14159265358979f;
+
+    // rows per thread below which threads don't pay off
+    const size_t MinRangeRows = 16;
+
+    // per row: 9 rgb sums, then the weight
+    const size_t RowSums = 28;
+
+    const float Y0 = 0.282095f;  // 1 / (2 sqrt(pi))
+    const float Y1 = 0.488603f;  // sqrt(3 / (4 pi))
+    const float Y2 = 1.092548f;  // sqrt(15 / (4 pi))
+    const float Y20 = 0.315392f; // sqrt(5 / (16 pi))
+    const float Y22 = 0.546274f; // sqrt(15 / (16 pi))
+
+    // direction(u, v) = u * uAxis + v * vAxis + center, see EnvironmentMap::getFaceDirection
+    struct FaceAxes {
+        glm::vec3 uAxis, vAxis, center;
+    };
+
+    FaceAxes getFaceAxes(uint32_t face) {
+        const glm::vec3 center = EnvironmentMap::getFaceDirection(face, 0.0f, 0.0f);
+        return { EnvironmentMap::getFaceDirection(face, 1.0f, 0.0f) - center, EnvironmentMap::getFaceDirection(face, 0.0f, 1.0f) - center, center };
+    }
+
+    // one row of float rgba texels into sums[RowSums]
+    void projectRow(const FaceAxes& axes, const float* rgba, uint32_t faceSize, float v, double* sums) {
+        const float texelArea = 4.0f / (float(faceSize) * faceSize); // (2 / size)^2
+        const glm::vec3 rowCenter = axes.center + v * axes.vAxis;
+        float rowSums[RowSums] = {};
+        uint32_t x = 0;
+
+#ifdef SPHERICAL_HARMONICS_SSE2
+        __m128 acc[RowSums];
+        for (__m128& a : acc) a = _mm_setzero_ps();
+        const __m128 step = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+        const __m128 scale = _mm_set1_ps(2.0f / faceSize);
+        const __m128 offset = _mm_set1_ps(1.0f / faceSize - 1.0f); // texel centers
+        const __m128 one = _mm_set1_ps(1.0f);
+        for (; x + 4 <= faceSize; x += 4) {
+            const __m128 u = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_set1_ps(float(x)), step), scale), offset);
+            __m128 dx = _mm_add_ps(_mm_set1_ps(rowCenter.x), _mm_mul_ps(u, _mm_set1_ps(axes.uAxis.x)));
+            __m128 dy = _mm_add_ps(_mm_set1_ps(rowCenter.y), _mm_mul_ps(u, _mm_set1_ps(axes.uAxis.y)));
+            __m128 dz = _mm_add_ps(_mm_set1_ps(rowCenter.z), _mm_mul_ps(u, _mm_set1_ps(axes.uAxis.z)));
+            const __m128 r2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            const __m128 invLength = _mm_div_ps(one, _mm_sqrt_ps(r2));
+            const __m128 weight = _mm_mul_ps(_mm_set1_ps(texelArea), _mm_mul_ps(invLength, _mm_mul_ps(invLength, invLength)));
+            dx = _mm_mul_ps(dx, invLength);
+            dy = _mm_mul_ps(dy, invLength);
+            dz = _mm_mul_ps(dz, invLength);
+
+            __m128 r = _mm_loadu_ps(rgba + 4 * x);
+            __m128 g = _mm_loadu_ps(rgba + 4 * x + 4);
+            __m128 b = _mm_loadu_ps(rgba + 4 * x + 8);
+            __m128 a = _mm_loadu_ps(rgba + 4 * x + 12);
+            _MM_TRANSPOSE4_PS(r, g, b, a);
+            r = _mm_mul_ps(r, weight);
+            g = _mm_mul_ps(g, weight);
+            b = _mm_mul_ps(b, weight);
+
+            const __m128 basis[9] = {
+                _mm_set1_ps(Y0),
+                _mm_mul_ps(_mm_set1_ps(Y1), dy),
+                _mm_mul_ps(_mm_set1_ps(Y1), dz),
+                _mm_mul_ps(_mm_set1_ps(Y1), dx),
+                _mm_mul_ps(_mm_set1_ps(Y2), _mm_mul_ps(dx, dy)),
+                _mm_mul_ps(_mm_set1_ps(Y2), _mm_mul_ps(dy, dz)),
+                _mm_mul_ps(_mm_set1_ps(Y20), _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(3.0f), _mm_mul_ps(dz, dz)), one)),
+                _mm_mul_ps(_mm_set1_ps(Y2), _mm_mul_ps(dx, dz)),
+                _mm_mul_ps(_mm_set1_ps(Y22), _mm_sub_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy))),
+            };
+            for (int k = 0; k < 9; ++k) {
+                acc[3 * k + 0] = _mm_add_ps(acc[3 * k + 0], _mm_mul_ps(basis[k], r));
+                acc[3 * k + 1] = _mm_add_ps(acc[3 * k + 1], _mm_mul_ps(basis[k], g));
+                acc[3 * k + 2] = _mm_add_ps(acc[3 * k + 2], _mm_mul_ps(basis[k], b));
+            }
+            acc[27] = _mm_add_ps(acc[27], weight);
+        }
+        for (size_t i = 0; i < RowSums; ++i) {
+            float lanes[4];
+            _mm_storeu_ps(lanes, acc[i]);
+            rowSums[i] = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        }
+#endif
+
+        for (; x < faceSize; ++x) {
+            const float u = 2.0f * (x + 0.5f) / faceSize - 1.0f;
+            const glm::vec3 d = rowCenter + u * axes.uAxis;
+            const float invLength = 1.0f / std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+            const float weight = texelArea * invLength * invLength * invLength;
+            float basis[9];
+            SphericalHarmonics::getBasis(d * invLength, basis);
+            for (int k = 0; k < 9; ++k) {
+                for (int c = 0; c < 3; ++c) rowSums[3 * k + c] += basis[k] * rgba[4 * x + c] * weight;
+            }
+            rowSums[27] += weight;
+        }
+        for (size_t i = 0; i < RowSums; ++i) sums[i] = rowSums[i];
+    }
+
+    // loadRow(y, scratch) returns row y as float rgba, converted into scratch if need be. Row sums are kept
+    // apart and added up in order: the result does not depend on the thread count
+    template <typename LoadRow>
+    void projectRows(uint32_t face, uint32_t faceSize, ShProjection& projection, const LoadRow& loadRow) {
+        const FaceAxes axes = getFaceAxes(face);
+        std::vector<double> sums(size_t(faceSize) * RowSums);
+        Parallel::forRanges(faceSize, MinRangeRows, [&](size_t begin, size_t end) {
+            std::vector<float> scratch;
+            for (size_t y = begin; y < end; ++y) {
+                const float v = 2.0f * (y + 0.5f) / faceSize - 1.0f;
+                projectRow(axes, loadRow(y, scratch), faceSize, v, sums.data() + y * RowSums);
+            }
+        });
+        for (uint32_t y = 0; y < faceSize; ++y) {
+            const double* row = sums.data() + size_t(y) * RowSums;
+            for (int k = 0; k < 9; ++k) projection.sums[k] += glm::dvec3(row[3 * k], row[3 * k + 1], row[3 * k + 2]);
+            projection.weight += row[27];
+        }
+    }
+}
+
+void SphericalHarmonics::getBasis(const glm::vec3& d, float basis[9]) {
+    basis[0] = Y0;
+    basis[1] = Y1 * d.y;
+    basis[2] = Y1 * d.z;
+    basis[3] = Y1 * d.x;
+    basis[4] = Y2 * d.x * d.y;
+    basis[5] = Y2 * d.y * d.z;
+    basis[6] = Y20 * (3.0f * d.z * d.z - 1.0f);
+    basis[7] = Y2 * d.x * d.z;
+    basis[8] = Y22 * (d.x * d.x - d.y * d.y);
+}
+
+void SphericalHarmonics::projectFace(uint32_t face, const float* rgba, uint32_t faceSize, ShProjection& projection) {
+    projectRows(face, faceSize, projection, [&](size_t y, std::vector<float>&) {
+        return rgba + y * faceSize * 4;
+    });
+}
+
+void SphericalHarmonics::projectFace(uint32_t face, const uint8_t* rgba, uint32_t faceSize, ShProjection& projection) {
+    float linear[256];
+    for (int i = 0; i < 256; ++i) {
+        const float c = i / 255.0f;
+        linear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+    projectRows(face, faceSize, projection, [&](size_t y, std::vector<float>& scratch) {
+        scratch.resize(size_t(faceSize) * 4);
+        const uint8_t* in = rgba + y * faceSize * 4;
+        for (size_t i = 0; i < scratch.size(); ++i) scratch[i] = linear[in[i]]; // alpha is never read
+        return static_cast<const float*>(scratch.data());
+    });
+}
+
+void SphericalHarmonics::projectFace(uint32_t face, const uint16_t* halfRgba, uint32_t faceSize, ShProjection& projection) {
+    projectRows(face, faceSize, projection, [&](size_t y, std::vector<float>& scratch) {
+        scratch.resize(size_t(faceSize) * 4);
+        const uint16_t* in = halfRgba + y * faceSize * 4;
+        for (size_t i = 0; i < scratch.size(); ++i) scratch[i] = glm::unpackHalf1x16(in[i]);
+        return static_cast<const float*>(scratch.data());
+    });
+}
+
+void SphericalHarmonics::getCoefficients(const ShProjection& projection, glm::vec3 coefficients[9]) {
+    const double scale = projection.weight > 0.0 ? 4.0 * Pi / projection.weight : 0.0;
+    for (int k = 0; k < 9; ++k) coefficients[k] = glm::vec3(projection.sums[k] * scale);
+}
+
+void SphericalHarmonics::convolveIrradiance(glm::vec3 coefficients[9]) {
+    // clamped cosine lobe per band (pi, 2 pi / 3, pi / 4), divided by pi
+    const float bands[3] = { 1.0f, 2.0f / 3.0f, 0.25f };
+    for (int k = 0; k < 9; ++k) coefficients[k] *= bands[k == 0 ? 0 : k < 4 ? 1 : 2];
+}
+
+glm::vec3 SphericalHarmonics::evaluate(const glm::vec3 coefficients[9], const glm::vec3& direction) {
+    float basis[9];
+    getBasis(direction, basis);
+    glm::vec3 result(0.0f);
+    for (int k = 0; k < 9; ++k) result += coefficients[k] * basis[k];
+    return result;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <glm/vec3.hpp>
+#include <glm/ext/vector_double3.hpp>
+
+// solid angle weighted sums of radiance times the 9 basis functions, over any set of cube faces
+struct ShProjection {
+    glm::dvec3 sums[9] = {};
+    double weight = 0.0; // solid angle covered, 4 pi once all 6 faces are in
+};
+
+// Diffuse environment lighting as 9 spherical harmonics coefficients (bands 0..2) per color channel,
+// projected straight from the cube faces: texel solid angles 4 / (size^2 (1 + u^2 + v^2)^1.5), faces in
+// EnvironmentMap::getFaceDirection order. Rows run in parallel (Parallel::forRanges), 4 texels per SSE
+// step where available (scalar otherwise). GpuShProjector is the compute shader variant.
+class SphericalHarmonics
+{
+public:
+    static constexpr uint32_t CoefficientCount = 9;
+
+    // the basis functions at a unit direction
+    static void getBasis(const glm::vec3& direction, float basis[9]);
+
+    // adds one face of faceSize^2 texels: float rgba (radiance), rgba8 (sRGB encoded, decoded like the
+    // RGBA8UnormSrgb cubemaps sample) or float16 rgba (the RGBA16Float cubemaps of HDR environments)
+    static void projectFace(uint32_t face, const float* rgba, uint32_t faceSize, ShProjection& projection);
+    static void projectFace(uint32_t face, const uint8_t* rgba, uint32_t faceSize, ShProjection& projection);
+    static void projectFace(uint32_t face, const uint16_t* halfRgba, uint32_t faceSize, ShProjection& projection);
+
+    // radiance coefficients, the sums rescaled so the weights add up to the full sphere
+    static void getCoefficients(const ShProjection& projection, glm::vec3 coefficients[9]);
+    // radiance -> irradiance / pi (cosine lobe convolution, Ramamoorthi & Hanrahan): evaluated at the
+    // normal, times the albedo, this is the lambertian reflection of the environment
+    static void convolveIrradiance(glm::vec3 coefficients[9]);
+    static glm::vec3 evaluate(const glm::vec3 coefficients[9], const glm::vec3& direction);
+};
@@ -0,0 +1,256 @@
+#include "TextureCooker.h"
+#include "BlockCompression.h"
+#include "EnvironmentMap.h"
+#include "Ktx2.h"
+#include "MappedFile.h"
+#include "MipGenerator.h"
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <vector>
+#include <glm/gtc/packing.hpp>
+
+const char* const TextureCooker::CubeFaceNames[6] = {
+    "posx.png",
+    "negx.png",
+    "posy.png",
+    "negy.png",
+    "posz.png",
+    "negz.png",
+};
+
+// one face of every level, RGBA8 -> vkFormat in place
+static void encodeLevels(uint32_t vkFormat, uint32_t width, uint32_t height, std::vector<std::vector<uint8_t>>& levels) {
+    BcFormat format;
+    switch (vkFormat) {
+    case Ktx2::FormatBC1Unorm: case Ktx2::FormatBC1Srgb: format = BcFormat::BC1; break;
+    case Ktx2::FormatBC3Unorm: case Ktx2::FormatBC3Srgb: format = BcFormat::BC3; break;
+    case Ktx2::FormatBC5Unorm: format = BcFormat::BC5; break;
+    case Ktx2::FormatBC7Unorm: case Ktx2::FormatBC7Srgb: format = BcFormat::BC7; break;
+    default: return;
+    }
+    for (uint32_t level = 0; level < levels.size(); ++level) {
+        const uint32_t levelWidth = std::max(1u, width >> level);
+        const uint32_t levelHeight = std::max(1u, height >> level);
+        std::vector<uint8_t> blocks(BlockCompression::getImageBytes(format, levelWidth, levelHeight));
+        BlockCompression::encode(format, levels[level].data(), levelWidth, levelHeight, blocks.data());
+        levels[level] = std::move(blocks);
+    }
+}
+
+bool TextureCooker::parseFormat(const std::string& name, CookFormat& format) {
+    const std::pair<const char*, CookFormat> names[] = {
+        { "auto", CookFormat::Auto }, { "rgba8", CookFormat::RGBA8 }, { "bc1", CookFormat::BC1 },
+        { "bc3", CookFormat::BC3 }, { "bc5", CookFormat::BC5 }, { "bc7", CookFormat::BC7 },
+    };
+    for (const auto& candidate : names) {
+        if (name == candidate.first) {
+            format = candidate.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TextureCooker::parseColorSpace(const std::string& name, CookColorSpace& colorSpace) {
+    if (name == "auto") colorSpace = CookColorSpace::Auto;
+    else if (name == "srgb") colorSpace = CookColorSpace::Srgb;
+    else if (name == "linear") colorSpace = CookColorSpace::Linear;
+    else return false;
+    return true;
+}
+
+bool TextureCooker::parseMipFilter(const std::string& name, MipFilter& filter) {
+    if (name == "box") filter = MipFilter::Box;
+    else if (name == "kaiser") filter = MipFilter::Kaiser;
+    else return false;
+    return true;
+}
+
+uint32_t TextureCooker::chooseVkFormat(const std::filesystem::path& source, CookFormat format, uint32_t width, uint32_t height,
+                                       bool srgb) {
+    // WebGPU wants block compressed textures of whole blocks
+    if (format == CookFormat::RGBA8 || width % 4 != 0 || height % 4 != 0) return srgb ? Ktx2::FormatRGBA8Srgb : Ktx2::FormatRGBA8Unorm;
+    if (format == CookFormat::Auto) {
+        std::string name = source.filename().string();
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        format = name.find("normal") != std::string::npos ? CookFormat::BC5 : CookFormat::BC7;
+    }
+    // the srgb variants only record how the mips were filtered: Application samples a texture as sRGB when
+    // it is used as color (getObjTexture's srgb), whatever the file says. BC5 has none
+    switch (format) {
+    case CookFormat::BC1: return srgb ? Ktx2::FormatBC1Srgb : Ktx2::FormatBC1Unorm;
+    case CookFormat::BC3: return srgb ? Ktx2::FormatBC3Srgb : Ktx2::FormatBC3Unorm;
+    case CookFormat::BC5: return Ktx2::FormatBC5Unorm;
+    default: return srgb ? Ktx2::FormatBC7Srgb : Ktx2::FormatBC7Unorm;
+    }
+}
+
+bool TextureCooker::isSrgb(const std::filesystem::path& source, CookColorSpace colorSpace) {
+    if (colorSpace != CookColorSpace::Auto) return colorSpace == CookColorSpace::Srgb;
+    std::string name = source.filename().string();
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    for (const char* dataMap : { "normal", "rough", "metal", "occlusion", "_ao", "_orm" }) {
+        if (name.find(dataMap) != std::string::npos) return false;
+    }
+    return true;
+}
+
+std::filesystem::path TextureCooker::getCookedPath(const std::filesystem::path& source) {
+    std::filesystem::path cookedPath = source;
+    if (!cookedPath.has_filename()) cookedPath = cookedPath.parent_path(); // "folder/"
+    cookedPath += ".ktx2";
+    return cookedPath;
+}
+
+bool TextureCooker::isCubemapFolder(const std::filesystem::path& folder) {
+    std::error_code ec;
+    return std::filesystem::is_directory(folder, ec) && std::filesystem::is_regular_file(folder / CubeFaceNames[0], ec);
+}
+
+bool TextureCooker::isEnvironment(const std::filesystem::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".hdr";
+}
+
+bool TextureCooker::isCookedUpToDate(const std::filesystem::path& source) {
+    std::error_code ec;
+    const auto cookedTime = std::filesystem::last_write_time(getCookedPath(source), ec);
+    if (ec) return false;
+
+    std::vector<std::filesystem::path> inputs;
+    if (std::filesystem::is_directory(source, ec)) {
+        for (const char* face : CubeFaceNames) inputs.push_back(source / face);
+    }
+    else {
+        inputs.push_back(source);
+    }
+    // a missing source keeps the cooked file usable
+    for (const std::filesystem::path& input : inputs) {
+        const auto sourceTime = std::filesystem::last_write_time(input, ec);
+        if (!ec && sourceTime > cookedTime) return false;
+    }
+    return true;
+}
+
+bool TextureCooker::hashSource(const std::filesystem::path& source, uint64_t& hash) {
+    std::error_code ec;
+    std::vector<std::filesystem::path> inputs;
+    if (std::filesystem::is_directory(source, ec)) {
+        for (const char* face : CubeFaceNames) inputs.push_back(source / face);
+    }
+    else {
+        inputs.push_back(source);
+    }
+    hash = 0;
+    for (const std::filesystem::path& input : inputs) {
+        MappedFile file;
+        if (!file.open(input)) return false;
+        hash = (hash ^ MappedFile::hashBytes(file.data(), file.size())) * 0x9E3779B97F4A7C15ull;
+    }
+    return true;
+}
+
+bool TextureCooker::cookTexture(const std::filesystem::path& imagePath, const TextureCookOptions& options) {
+    int width, height, channels;
+    unsigned char* data = stbi_load(imagePath.string().c_str(), &width, &height, &channels, 4); // 4 rgba
+    if (!data) {
+        std::cerr << "Could not load texture " << imagePath << std::endl;
+        return false;
+    }
+
+    Ktx2Texture texture;
+    texture.width = static_cast<uint32_t>(width);
+    texture.height = static_cast<uint32_t>(height);
+    MipOptions mipOptions;
+    mipOptions.filter = options.mipFilter;
+    mipOptions.srgb = isSrgb(imagePath, options.colorSpace);
+    texture.vkFormat = chooseVkFormat(imagePath, options.format, texture.width, texture.height, mipOptions.srgb);
+    MipGenerator::generate(data, texture.width, texture.height, texture.levels, mipOptions);
+    stbi_image_free(data);
+    encodeLevels(texture.vkFormat, texture.width, texture.height, texture.levels);
+
+    return Ktx2::write(getCookedPath(imagePath), texture);
+}
+
+bool TextureCooker::cookCubemap(const std::filesystem::path& folder, const TextureCookOptions& options) {
+    Ktx2Texture texture;
+    texture.faceCount = 6;
+    MipOptions mipOptions;
+    mipOptions.filter = options.mipFilter;
+    mipOptions.srgb = options.colorSpace != CookColorSpace::Linear;
+
+    for (uint32_t face = 0; face < 6; ++face) {
+        const std::filesystem::path facePath = folder / CubeFaceNames[face];
+        int width, height, channels;
+        unsigned char* data = stbi_load(facePath.string().c_str(), &width, &height, &channels, 4); // 4 rgba
+        if (!data) {
+            std::cerr << "Could not load cube texture " << facePath << std::endl;
+            return false;
+        }
+        if (face == 0) {
+            texture.width = static_cast<uint32_t>(width);
+            texture.height = static_cast<uint32_t>(height);
+            texture.vkFormat = chooseVkFormat(folder, options.format, texture.width, texture.height, mipOptions.srgb);
+        }
+        if (width != height || static_cast<uint32_t>(width) != texture.width || static_cast<uint32_t>(height) != texture.height) {
+            std::cerr << "Cube faces must be square and of one size: " << facePath << std::endl;
+            stbi_image_free(data);
+            return false;
+        }
+
+        // faces of a level back to back
+        std::vector<std::vector<uint8_t>> levels;
+        MipGenerator::generate(data, texture.width, texture.height, levels, mipOptions);
+        stbi_image_free(data);
+        encodeLevels(texture.vkFormat, texture.width, texture.height, levels);
+        texture.levels.resize(levels.size());
+        for (size_t level = 0; level < levels.size(); ++level) {
+            texture.levels[level].insert(texture.levels[level].end(), levels[level].begin(), levels[level].end());
+        }
+    }
+
+    return Ktx2::write(getCookedPath(folder), texture);
+}
+
+bool TextureCooker::convertEnvironment(const std::filesystem::path& hdrPath, uint32_t faceSize, Ktx2Texture& texture,
+                                       std::vector<float>* radiance) {
+    int width, height, channels;
+    float* data = stbi_loadf(hdrPath.string().c_str(), &width, &height, &channels, 4); // 4 rgba, linear
+    if (!data) {
+        std::cerr << "Could not load environment " << hdrPath << std::endl;
+        return false;
+    }
+    // clamped before filtering so every level fits float16 (NaN and negatives -> 0)
+    const size_t valueCount = size_t(width) * height * 4;
+    for (size_t i = 0; i < valueCount; ++i) {
+        data[i] = data[i] > MaxRadiance ? MaxRadiance : data[i] >= 0.0f ? data[i] : 0.0f;
+    }
+
+    std::vector<float> faces;
+    EnvironmentMap::equirectToCubemap(data, static_cast<uint32_t>(width), static_cast<uint32_t>(height), faceSize, faces);
+    stbi_image_free(data);
+    std::vector<std::vector<float>> levels;
+    EnvironmentMap::generateMips(std::move(faces), faceSize, levels);
+    if (radiance) *radiance = levels[0];
+
+    texture.vkFormat = Ktx2::FormatRGBA16Float;
+    texture.width = faceSize;
+    texture.height = faceSize;
+    texture.faceCount = 6;
+    texture.levels.resize(levels.size());
+    for (size_t level = 0; level < levels.size(); ++level) {
+        texture.levels[level].resize(levels[level].size() * sizeof(uint16_t));
+        uint16_t* halves = reinterpret_cast<uint16_t*>(texture.levels[level].data());
+        for (size_t i = 0; i < levels[level].size(); ++i) halves[i] = glm::packHalf1x16(levels[level][i]);
+    }
+    return true;
+}
+
+bool TextureCooker::cookEnvironment(const std::filesystem::path& hdrPath, uint32_t faceSize) {
+    Ktx2Texture texture;
+    return convertEnvironment(hdrPath, faceSize, texture) && Ktx2::write(getCookedPath(hdrPath), texture);
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "MipGenerator.h"
+
+// pixel format of cooked textures
+enum class CookFormat {
+    Auto,  // BC5 for normal maps (file name contains "normal"), BC7 otherwise
+    RGBA8,
+    BC1,
+    BC3,
+    BC5,
+    BC7
+};
+
+// color space the mips of cooked textures are filtered in, stored as the unorm / srgb vkFormat
+enum class CookColorSpace {
+    Auto,  // sRGB, except data maps (file name contains "normal", "rough", "metal", "occlusion", "_ao" or "_orm")
+    Srgb,
+    Linear
+};
+
+struct TextureCookOptions {
+    CookFormat format = CookFormat::Auto;
+    CookColorSpace colorSpace = CookColorSpace::Auto;
+    MipFilter mipFilter = MipFilter::Kaiser; // Application::mipFilter
+};
+
+struct Ktx2Texture;
+
+// Images -> KTX2 files with their full mip chain (MipGenerator), block compressed by default
+// (BlockCompression), loaded by the app instead of decoding the source on every launch. Cooked files sit
+// next to the source: wahoo.bmp -> wahoo.bmp.ktx2, a cubemap folder of posx.png .. negz.png -> <folder>.ktx2.
+// HDR equirectangular panoramas (.hdr) become RGBA16Float cubemaps: sky.hdr -> sky.hdr.ktx2.
+class TextureCooker
+{
+public:
+    // "auto", "rgba8", "bc1", "bc3", "bc5", "bc7"
+    static bool parseFormat(const std::string& name, CookFormat& format);
+    // "auto", "srgb", "linear"
+    static bool parseColorSpace(const std::string& name, CookColorSpace& colorSpace);
+    // "box", "kaiser"
+    static bool parseMipFilter(const std::string& name, MipFilter& filter);
+    // the KTX2 vkFormat an image of this size is cooked to: BC needs a level 0 of whole 4x4 blocks
+    static uint32_t chooseVkFormat(const std::filesystem::path& source, CookFormat format, uint32_t width, uint32_t height,
+                                   bool srgb = false);
+    // whether an image holds color, filtered in linear light and encoded back to sRGB
+    static bool isSrgb(const std::filesystem::path& source, CookColorSpace colorSpace);
+
+    // cube face files in layer order
+    static const char* const CubeFaceNames[6];
+    // face size of HDR environment cubemaps
+    static constexpr uint32_t DefaultEnvironmentSize = 512;
+    // HDR radiance is clamped to the largest finite float16: an unclipped sun would turn into +inf
+    static constexpr float MaxRadiance = 65504.0f;
+
+    static std::filesystem::path getCookedPath(const std::filesystem::path& source);
+    static bool isCubemapFolder(const std::filesystem::path& folder);
+    static bool isEnvironment(const std::filesystem::path& path); // .hdr
+    // the cooked file exists and is not older than the source (every face of a cubemap)
+    static bool isCookedUpToDate(const std::filesystem::path& source);
+    // contents of the source (every face of a cubemap, in layer order): keys caches derived from it
+    static bool hashSource(const std::filesystem::path& source, uint64_t& hash);
+
+    static bool cookTexture(const std::filesystem::path& imagePath, const TextureCookOptions& options = TextureCookOptions());
+    // faces are color: Auto is sRGB whatever the folder name
+    static bool cookCubemap(const std::filesystem::path& folder, const TextureCookOptions& options = TextureCookOptions());
+    // equirectangular panorama (stbi_loadf) -> 6 faces of faceSize with mips, bilinear (EnvironmentMap).
+    // radiance: level 0 as float rgba too, before the float16 rounding
+    static bool convertEnvironment(const std::filesystem::path& hdrPath, uint32_t faceSize, Ktx2Texture& texture,
+                                   std::vector<float>* radiance = nullptr);
+    static bool cookEnvironment(const std::filesystem::path& hdrPath, uint32_t faceSize = DefaultEnvironmentSize);
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+#include "VertexAttr.h"
+
+// attribute formats a vertex blob can be stored in (mirrors the wgpu::VertexFormat we map them to)
+enum class VertexElementFormat : uint32_t {
+    Float32x2 = 0,
+    Float32x3 = 1,
+    Unorm16x4 = 2, // quantized position (w unused)
+    Snorm16x2 = 3, // octahedral normal
+    Float16x2 = 4, // half float uv
+    Unorm8x4 = 5,  // color (a unused)
+    Snorm16x4 = 6, // tangent + bitangent sign
+};
+
+struct VertexElement {
+    uint32_t location = 0; // shader @location
+    VertexElementFormat format = VertexElementFormat::Float32x3;
+    uint32_t offset = 0;
+};
+
+// POD description of an interleaved vertex buffer, stored as is in binary mesh files
+struct VertexLayoutDesc {
+    static constexpr uint32_t MaxElements = 8;
+
+    uint32_t stride = 0;
+    uint32_t elementCount = 0;
+    VertexElement elements[MaxElements] = {};
+};
+
+// layout of the full float VertexAttr
+inline VertexLayoutDesc getVertexAttrLayout() {
+    VertexLayoutDesc layout;
+    layout.stride = sizeof(VertexAttr);
+    layout.elementCount = 4;
+    layout.elements[0] = { 0, VertexElementFormat::Float32x3, offsetof(VertexAttr, position) };
+    layout.elements[1] = { 1, VertexElementFormat::Float32x3, offsetof(VertexAttr, color) };
+    layout.elements[2] = { 2, VertexElementFormat::Float32x3, offsetof(VertexAttr, normal) };
+    layout.elements[3] = { 3, VertexElementFormat::Float32x2, offsetof(VertexAttr, uv) };
+    return layout;
+}
+
+inline bool operator==(const VertexLayoutDesc& a, const VertexLayoutDesc& b) {
+    if (a.stride != b.stride || a.elementCount != b.elementCount) return false;
+    for (uint32_t i = 0; i < a.elementCount; ++i) {
+        if (a.elements[i].location != b.elements[i].location ||
+            a.elements[i].format != b.elements[i].format ||
+            a.elements[i].offset != b.elements[i].offset) return false;
+    }
+    return true;
+}
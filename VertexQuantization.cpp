@@ -0,0 +1,178 @@
+#include "VertexQuantization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <glm/geometric.hpp>
+#include <glm/gtc/packing.hpp>
+
+uint32_t VertexQuantization::getFormatSize(VertexElementFormat format) {
+    switch (format) {
+    case VertexElementFormat::Float32x2: return 8;
+    case VertexElementFormat::Float32x3: return 12;
+    case VertexElementFormat::Unorm16x4: return 8;
+    case VertexElementFormat::Snorm16x2: return 4;
+    case VertexElementFormat::Float16x2: return 4;
+    case VertexElementFormat::Unorm8x4: return 4;
+    case VertexElementFormat::Snorm16x4: return 8;
+    }
+    return 0;
+}
+
+static uint16_t toUnorm16(float v) {
+    return static_cast<uint16_t>(std::lround(std::clamp(v, 0.0f, 1.0f) * 65535.0f));
+}
+static int16_t toSnorm16(float v) {
+    return static_cast<int16_t>(std::lround(std::clamp(v, -1.0f, 1.0f) * 32767.0f));
+}
+static uint8_t toUnorm8(float v) {
+    return static_cast<uint8_t>(std::lround(std::clamp(v, 0.0f, 1.0f) * 255.0f));
+}
+
+VertexLayoutDesc VertexQuantization::makePositionLayout(const VertexFormatOptions& options) {
+    const VertexElementFormat format = options.quantizePositions ? VertexElementFormat::Unorm16x4 : VertexElementFormat::Float32x3;
+    VertexLayoutDesc layout;
+    layout.elementCount = 1;
+    layout.elements[0] = { 0, format, 0 };
+    layout.stride = getFormatSize(format);
+    return layout;
+}
+
+VertexLayoutDesc VertexQuantization::makeLayout(const VertexFormatOptions& options, bool hasColor) {
+    VertexLayoutDesc layout;
+    auto add = [&layout](uint32_t location, VertexElementFormat format) {
+        layout.elements[layout.elementCount++] = { location, format, layout.stride };
+        layout.stride += getFormatSize(format);
+    };
+
+    // same shader locations as VertexAttr: 1 color, 2 normal, 3 uv (0 position is in its own stream)
+    if (hasColor) add(1, options.unormColors ? VertexElementFormat::Unorm8x4 : VertexElementFormat::Float32x3);
+    add(2, options.octahedralNormals ? VertexElementFormat::Snorm16x2 : VertexElementFormat::Float32x3);
+    add(3, options.halfUvs ? VertexElementFormat::Float16x2 : VertexElementFormat::Float32x2);
+    return layout;
+}
+
+glm::vec2 VertexQuantization::encodeOctahedral(const glm::vec3& n) {
+    const float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    if (l1 == 0.0f) return glm::vec2(0.0f);
+    glm::vec2 e = glm::vec2(n.x, n.y) / l1;
+    if (n.z < 0.0f) {
+        // fold the lower hemisphere over the diagonals
+        e = glm::vec2((1.0f - std::abs(e.y)) * (e.x >= 0.0f ? 1.0f : -1.0f),
+                      (1.0f - std::abs(e.x)) * (e.y >= 0.0f ? 1.0f : -1.0f));
+    }
+    return e;
+}
+
+glm::vec3 VertexQuantization::decodeOctahedral(const glm::vec2& e) {
+    glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+    const float t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return glm::normalize(n);
+}
+
+void VertexQuantization::pack(const MeshData& mesh, const VertexFormatOptions& options, PackedVertices& packed) {
+    prepare(mesh, options, packed);
+    packed.positions.resize(mesh.vertices.size() * packed.positionLayout.stride);
+    packVertices(mesh, packed, packed.positionLayout, 0, mesh.vertices.size(), packed.positions.data());
+    packed.data.resize(mesh.vertices.size() * packed.layout.stride);
+    packVertices(mesh, packed, packed.layout, 0, mesh.vertices.size(), packed.data.data());
+}
+
+void VertexQuantization::prepare(const MeshData& mesh, const VertexFormatOptions& options, PackedVertices& packed) {
+    bool hasColor = true;
+    if (options.dropConstantColor) {
+        hasColor = std::any_of(mesh.vertices.begin(), mesh.vertices.end(),
+            [](const VertexAttr& v) { return v.color != glm::vec3(1.0f); });
+    }
+
+    packed.positionLayout = makePositionLayout(options);
+    packed.layout = makeLayout(options, hasColor);
+    packed.formatBits = options.getBits();
+    packed.hasColor = hasColor;
+    packed.octahedralNormals = options.octahedralNormals;
+    packed.positions.clear();
+    packed.data.clear();
+
+    if (options.quantizePositions) {
+        // flat axes keep a scale of 0: every vertex decodes to the offset
+        const glm::vec3 extent = mesh.boundsMax - mesh.boundsMin;
+        packed.positionOffset = mesh.boundsMin;
+        packed.positionScale = extent;
+    }
+    else {
+        packed.positionOffset = glm::vec3(0.0f);
+        packed.positionScale = glm::vec3(1.0f);
+    }
+
+    // separate stream, only for meshes that went through MeshNormals::generateTangents
+    packed.tangents.clear();
+    if (options.tangents && mesh.tangents.size() == mesh.vertices.size()) {
+        packed.tangents.resize(mesh.tangents.size() * getFormatSize(VertexElementFormat::Snorm16x4));
+        for (size_t i = 0; i < mesh.tangents.size(); ++i) {
+            const glm::vec4& t = mesh.tangents[i];
+            const int16_t q[4] = { toSnorm16(t.x), toSnorm16(t.y), toSnorm16(t.z), toSnorm16(t.w) };
+            std::memcpy(packed.tangents.data() + i * sizeof(q), q, sizeof(q));
+        }
+    }
+}
+
+void VertexQuantization::packVertices(const MeshData& mesh, const PackedVertices& packed, const VertexLayoutDesc& layout,
+                                      size_t first, size_t count, uint8_t* dst) {
+    const glm::vec3 invExtent(
+        packed.positionScale.x > 0.0f ? 1.0f / packed.positionScale.x : 0.0f,
+        packed.positionScale.y > 0.0f ? 1.0f / packed.positionScale.y : 0.0f,
+        packed.positionScale.z > 0.0f ? 1.0f / packed.positionScale.z : 0.0f);
+
+    for (size_t i = 0; i < count; ++i) {
+        const VertexAttr& v = mesh.vertices[first + i];
+        uint8_t* out = dst + i * layout.stride;
+
+        for (uint32_t e = 0; e < layout.elementCount; ++e) {
+            const VertexElement& element = layout.elements[e];
+            uint8_t* attr = out + element.offset;
+
+            switch (element.location) {
+            case 0: // position
+                if (element.format == VertexElementFormat::Unorm16x4) {
+                    const glm::vec3 t = (v.position - packed.positionOffset) * invExtent;
+                    const uint16_t q[4] = { toUnorm16(t.x), toUnorm16(t.y), toUnorm16(t.z), 65535 };
+                    std::memcpy(attr, q, sizeof(q));
+                }
+                else {
+                    std::memcpy(attr, &v.position, sizeof(v.position));
+                }
+                break;
+            case 1: // color
+                if (element.format == VertexElementFormat::Unorm8x4) {
+                    const uint8_t q[4] = { toUnorm8(v.color.r), toUnorm8(v.color.g), toUnorm8(v.color.b), 255 };
+                    std::memcpy(attr, q, sizeof(q));
+                }
+                else {
+                    std::memcpy(attr, &v.color, sizeof(v.color));
+                }
+                break;
+            case 2: // normal
+                if (element.format == VertexElementFormat::Snorm16x2) {
+                    const glm::vec2 oct = encodeOctahedral(v.normal);
+                    const int16_t q[2] = { toSnorm16(oct.x), toSnorm16(oct.y) };
+                    std::memcpy(attr, q, sizeof(q));
+                }
+                else {
+                    std::memcpy(attr, &v.normal, sizeof(v.normal));
+                }
+                break;
+            case 3: // uv
+                if (element.format == VertexElementFormat::Float16x2) {
+                    const uint16_t q[2] = { glm::packHalf1x16(v.uv.x), glm::packHalf1x16(v.uv.y) };
+                    std::memcpy(attr, q, sizeof(q));
+                }
+                else {
+                    std::memcpy(attr, &v.uv, sizeof(v.uv));
+                }
+                break;
+            }
+        }
+    }
+}
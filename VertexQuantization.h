@@ -0,0 +1,62 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include "MeshData.h"
+#include "VertexLayout.h"
+
+// which compact encodings to use instead of the 44-byte float VertexAttr
+struct VertexFormatOptions {
+    bool quantizePositions = true; // 3x unorm16 relative to the mesh AABB
+    bool octahedralNormals = true; // 2x snorm16
+    bool halfUvs = true;           // 2x float16
+    bool unormColors = true;       // 4x unorm8
+    bool dropConstantColor = true; // no color attribute when every vertex is white
+    bool tangents = true;          // MikkTSpace tangents as a separate snorm16x4 stream
+
+    static VertexFormatOptions full() { return { false, false, false, false, false, true }; }
+    // stored in binary mesh files to detect caches built with other options
+    uint32_t getBits() const {
+        return (quantizePositions ? 1u : 0u) | (octahedralNormals ? 2u : 0u) |
+            (halfUvs ? 4u : 0u) | (unormColors ? 8u : 0u) | (dropConstantColor ? 16u : 0u) | (tangents ? 32u : 0u);
+    }
+};
+
+// vertices in a (possibly) compact layout, split in two streams: positions alone (vertex buffer slot 0,
+// all a depth-only pass fetches) and the other attributes interleaved (slot 1)
+struct PackedVertices {
+    VertexLayoutDesc positionLayout;
+    VertexLayoutDesc layout;
+    uint32_t formatBits = 0; // VertexFormatOptions::getBits()
+    bool hasColor = true;
+    bool octahedralNormals = false;
+    std::vector<uint8_t> positions; // positionLayout.stride bytes per vertex
+    std::vector<uint8_t> data;      // layout.stride bytes per vertex
+    std::vector<uint8_t> tangents; // Snorm16x4 per vertex, empty: no tangent stream
+    // stored position -> object space: offset + scale * stored
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+    glm::vec3 positionScale = glm::vec3(1.0f);
+};
+
+class VertexQuantization
+{
+public:
+    // position stream: location 0 only
+    static VertexLayoutDesc makePositionLayout(const VertexFormatOptions& options);
+    // attribute stream: color (if any), normal, uv
+    static VertexLayoutDesc makeLayout(const VertexFormatOptions& options, bool hasColor);
+    static uint32_t getFormatSize(VertexElementFormat format);
+    static void pack(const MeshData& mesh, const VertexFormatOptions& options, PackedVertices& packed);
+    // everything but packed.positions / data: layouts and position dequantization (+ the tangent stream)
+    static void prepare(const MeshData& mesh, const VertexFormatOptions& options, PackedVertices& packed);
+    // encodes vertices [first, first + count) in layout (packed.positionLayout or packed.layout) to dst
+    // (count * stride bytes), lets callers pack chunk by chunk straight into a mapped buffer or file
+    static void packVertices(const MeshData& mesh, const PackedVertices& packed, const VertexLayoutDesc& layout,
+                             size_t first, size_t count, uint8_t* dst);
+
+    // unit vector <-> [-1, 1]^2, matches decodeOctahedral in shader0.wgsl
+    static glm::vec2 encodeOctahedral(const glm::vec3& n);
+    static glm::vec3 decodeOctahedral(const glm::vec2& e);
+};
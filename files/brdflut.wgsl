@@ -0,0 +1,57 @@
+// Split sum BRDF table (BrdfLut): one invocation per texel, x: NdotV, y: roughness (texel centers). The
+// GGX specular integral over a white environment is F0 * scale + bias; both are importance sampled with
+// Hammersley points, Schlick-GGX geometry with k = alpha / 2. EnvironmentMap::integrateBrdf is the CPU fallback.
+
+const PI: f32 = 3.141592653589793;
+
+// BrdfLut::Size / SampleCount
+override SIZE: u32 = 128u;
+override SAMPLE_COUNT: u32 = 1024u;
+
+@group(0) @binding(0) var<storage, read_write> table: array<u32>; // pack2x16float(scale, bias), rows of roughness
+
+fn hammersley(i: u32, n: u32) -> vec2f {
+    return vec2f(f32(i) / f32(n), f32(reverseBits(i)) * 2.3283064365386963e-10);
+}
+
+// prefilter.wgsl importanceSampleGgx
+fn importanceSampleGgx(xi: vec2f, n: vec3f, a: f32) -> vec3f {
+    let phi = 2.0 * PI * xi.x;
+    let cosTheta = sqrt((1.0 - xi.y) / (1.0 + (a * a - 1.0) * xi.y));
+    let sinTheta = sqrt(1.0 - cosTheta * cosTheta);
+    let up = select(vec3f(1.0, 0.0, 0.0), vec3f(0.0, 0.0, 1.0), abs(n.z) < 0.999);
+    let tangentX = normalize(cross(up, n));
+    let tangentY = cross(n, tangentX);
+    return normalize(tangentX * (cos(phi) * sinTheta) + tangentY * (sin(phi) * sinTheta) + n * cosTheta);
+}
+
+@compute @workgroup_size(8, 8, 1)
+fn cs_integrate(@builtin(global_invocation_id) id: vec3u) {
+    if (any(id.xy >= vec2u(SIZE))) {
+        return;
+    }
+    let nv = (f32(id.x) + 0.5) / f32(SIZE);
+    let roughness = (f32(id.y) + 0.5) / f32(SIZE);
+    let a = roughness * roughness;
+    let k = a * 0.5;
+    let v = vec3f(sqrt(1.0 - nv * nv), 0.0, nv);
+
+    var scale = 0.0;
+    var bias = 0.0;
+    for (var i = 0u; i < SAMPLE_COUNT; i++) {
+        let h = importanceSampleGgx(hammersley(i, SAMPLE_COUNT), vec3f(0.0, 0.0, 1.0), a);
+        let vh = dot(v, h);
+        let l = 2.0 * vh * h - v;
+        let nl = l.z;
+        if (nl <= 0.0) {
+            continue;
+        }
+        let g = nv / (nv * (1.0 - k) + k) * nl / (nl * (1.0 - k) + k);
+        // BRDF * nl / pdf with pdf = D nh / (4 vh)
+        let gVis = g * max(vh, 0.0) / (max(h.z, 0.0) * nv + 0.0001);
+        let fc = pow(1.0 - max(vh, 0.0), 5.0);
+        scale += (1.0 - fc) * gVis;
+        bias += fc * gVis;
+    }
+    table[id.y * SIZE + id.x] = pack2x16float(vec2f(scale, bias) / f32(SAMPLE_COUNT));
+}
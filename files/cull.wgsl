@@ -0,0 +1,106 @@
+// GPU cluster culling: one invocation per meshlet of every LOD. Visible meshlets of the selected LOD
+// append their triangles to the compacted index buffer of their submesh and bump the indexCount of
+// its DrawIndexedIndirect args.
+
+// source index buffer holds u16 pairs instead of u32 indices
+override INDEX_U16: bool = false;
+
+struct Uniforms {
+    projMatrix: mat4x4f,
+    viewMatrix: mat4x4f,
+    modelMatrix: mat4x4f,
+    modelInvTranspose: mat4x4f,
+    time: f32,
+    cameraPos : vec3f,
+    positionOffset : vec3f,
+    positionScale : vec3f
+}
+
+// same layout as Meshlet in MeshData.h
+struct Meshlet {
+    center: vec3f,
+    radius: f32,
+    coneAxis: vec3f,
+    coneCutoff: f32,
+    indexOffset: u32,
+    triangleCount: u32,
+    submeshIndex: u32,
+    lodLevel: u32
+}
+
+// wgpu DrawIndexedIndirect arguments, one per submesh
+struct DrawArgs {
+    indexCount: atomic<u32>,
+    instanceCount: u32,
+    firstIndex: u32,
+    baseVertex: i32,
+    firstInstance: u32
+}
+
+@group(0) @binding(0) var<uniform> u_Uniforms: Uniforms;
+@group(0) @binding(1) var<storage, read> meshlets: array<Meshlet>;
+@group(0) @binding(2) var<storage, read> sourceIndices: array<u32>;
+@group(0) @binding(3) var<storage, read_write> culledIndices: array<u32>;
+@group(0) @binding(4) var<storage, read_write> drawArgs: array<DrawArgs>;
+@group(0) @binding(5) var<storage, read> lodSelection: array<u32>; // LOD level per submesh
+
+fn loadIndex(i: u32) -> u32 {
+    if (INDEX_U16) {
+        let word = sourceIndices[i / 2u];
+        return select(word & 0xFFFFu, word >> 16u, (i & 1u) == 1u);
+    }
+    return sourceIndices[i];
+}
+
+// sphere vs the 6 clip planes of the view-projection (Gribb/Hartmann), depth in [0, 1]
+fn isInFrustum(center: vec3f, radius: f32) -> bool {
+    let m = transpose(u_Uniforms.projMatrix * u_Uniforms.viewMatrix);
+    let p = vec4f(center, 1.0);
+    var planes = array<vec4f, 6>(
+        m[3] + m[0], m[3] - m[0],
+        m[3] + m[1], m[3] - m[1],
+        m[2], m[3] - m[2]
+    );
+    for (var i = 0; i < 6; i++) {
+        let plane = planes[i] / length(planes[i].xyz);
+        if (dot(plane, p) < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+@compute @workgroup_size(64)
+fn cs_cull(@builtin(global_invocation_id) id: vec3u) {
+    if (id.x >= arrayLength(&meshlets)) {
+        return;
+    }
+    let meshlet = meshlets[id.x];
+    if (meshlet.lodLevel != lodSelection[meshlet.submeshIndex]) {
+        return;
+    }
+
+    // bounds to world space
+    let model = u_Uniforms.modelMatrix;
+    let center = (model * vec4f(meshlet.center, 1.0)).xyz;
+    let scale = max(length(model[0].xyz), max(length(model[1].xyz), length(model[2].xyz)));
+    let radius = meshlet.radius * scale;
+
+    if (!isInFrustum(center, radius)) {
+        return;
+    }
+
+    // all triangles face away from the camera
+    let axis = normalize((u_Uniforms.modelInvTranspose * vec4f(meshlet.coneAxis, 0.0)).xyz);
+    let toCenter = center - u_Uniforms.cameraPos;
+    if (dot(toCenter, axis) >= meshlet.coneCutoff * length(toCenter) + radius) {
+        return;
+    }
+
+    let indexCount = meshlet.triangleCount * 3u;
+    let args = &drawArgs[meshlet.submeshIndex];
+    let dst = (*args).firstIndex + atomicAdd(&(*args).indexCount, indexCount);
+    for (var i = 0u; i < indexCount; i++) {
+        culledIndices[dst + i] = loadIndex(meshlet.indexOffset + i);
+    }
+}
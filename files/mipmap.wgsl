@@ -0,0 +1,85 @@
+// GPU mip chains (GpuMipGenerator): every dispatch writes up to 3 levels below src. One 8x8 workgroup
+// per 16x16 texel tile of src and one z per array layer (cube faces); levels 2 and 3 are filtered from
+// the workgroup memory of the level before, unquantized. 2x2 box filter like MipGenerator: odd sizes
+// repeat the last row / column.
+
+// GpuMipGenerator::MipParams
+struct MipParams {
+    levelCount: u32, // levels written by this dispatch, 1..3 (the others are bound to a dummy)
+    srgb: u32        // rgb holds sRGB encoded color: filtered in linear space
+}
+
+@group(0) @binding(0) var<uniform> u_Params: MipParams;
+@group(0) @binding(1) var src: texture_2d_array<f32>;
+@group(0) @binding(2) var dst1: texture_storage_2d_array<rgba8unorm, write>;
+@group(0) @binding(3) var dst2: texture_storage_2d_array<rgba8unorm, write>;
+@group(0) @binding(4) var dst3: texture_storage_2d_array<rgba8unorm, write>;
+
+var<workgroup> tile1: array<array<vec4f, 8>, 8>;
+var<workgroup> tile2: array<array<vec4f, 4>, 4>;
+
+fn toLinear(c: vec4f) -> vec4f {
+    if (u_Params.srgb == 0u) {
+        return c;
+    }
+    let rgb = select(pow((c.rgb + 0.055) / 1.055, vec3f(2.4)), c.rgb / 12.92, c.rgb <= vec3f(0.04045));
+    return vec4f(rgb, c.a);
+}
+
+fn fromLinear(c: vec4f) -> vec4f {
+    if (u_Params.srgb == 0u) {
+        return c;
+    }
+    let rgb = select(1.055 * pow(c.rgb, vec3f(1.0 / 2.4)) - 0.055, c.rgb * 12.92, c.rgb <= vec3f(0.0031308));
+    return vec4f(rgb, c.a);
+}
+
+fn loadLinear(p: vec2u, layer: u32) -> vec4f {
+    return toLinear(textureLoad(src, p, layer, 0));
+}
+
+@compute @workgroup_size(8, 8, 1)
+fn cs_mips(@builtin(workgroup_id) group: vec3u, @builtin(local_invocation_id) local: vec3u) {
+    let layer = group.z;
+
+    // level 1: one texel per invocation, 2x2 of src
+    let size1 = textureDimensions(dst1);
+    let p1 = group.xy * 8u + local.xy;
+    var c1 = vec4f(0.0);
+    if (all(p1 < size1)) {
+        let last = textureDimensions(src) - 1u;
+        let a = min(2u * p1, last);
+        let b = min(2u * p1 + 1u, last);
+        c1 = 0.25 * (loadLinear(a, layer) + loadLinear(vec2u(b.x, a.y), layer) +
+                     loadLinear(vec2u(a.x, b.y), layer) + loadLinear(b, layer));
+        textureStore(dst1, p1, layer, fromLinear(c1));
+    }
+    tile1[local.y][local.x] = c1;
+    workgroupBarrier();
+
+    // level 2: the first 4x4 invocations, from tile1 (the clamped texels stay inside the tile)
+    let size2 = max(size1 / 2u, vec2u(1u));
+    let p2 = group.xy * 4u + local.xy;
+    let in2 = all(local.xy < vec2u(4u));
+    var c2 = vec4f(0.0);
+    if (u_Params.levelCount >= 2u && in2 && all(p2 < size2)) {
+        let a = min(2u * p2, size1 - 1u) - group.xy * 8u;
+        let b = min(2u * p2 + 1u, size1 - 1u) - group.xy * 8u;
+        c2 = 0.25 * (tile1[a.y][a.x] + tile1[a.y][b.x] + tile1[b.y][a.x] + tile1[b.y][b.x]);
+        textureStore(dst2, p2, layer, fromLinear(c2));
+    }
+    if (in2) {
+        tile2[local.y][local.x] = c2;
+    }
+    workgroupBarrier();
+
+    // level 3: the first 2x2 invocations, from tile2
+    let size3 = max(size2 / 2u, vec2u(1u));
+    let p3 = group.xy * 2u + local.xy;
+    if (u_Params.levelCount >= 3u && all(local.xy < vec2u(2u)) && all(p3 < size3)) {
+        let a = min(2u * p3, size2 - 1u) - group.xy * 4u;
+        let b = min(2u * p3 + 1u, size2 - 1u) - group.xy * 4u;
+        let c3 = 0.25 * (tile2[a.y][a.x] + tile2[a.y][b.x] + tile2[b.y][a.x] + tile2[b.y][b.x]);
+        textureStore(dst3, p3, layer, fromLinear(c3));
+    }
+}
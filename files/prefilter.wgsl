@@ -0,0 +1,86 @@
+// GGX prefiltered specular environment (SpecularPrefilter): one dispatch per level of the output cube,
+// one invocation per texel and z per face. The lobe is taken around N = V = R (split sum), importance
+// sampled with Hammersley points; every sample reads the environment mip whose texels cover the solid
+// angle of the sample (filtered importance sampling). EnvironmentMap::prefilterSpecular is the CPU reference.
+
+const PI: f32 = 3.141592653589793;
+
+// SpecularPrefilter::PrefilterParams
+struct PrefilterParams {
+    roughness: f32,   // level / (levelCount - 1), GGX alpha = roughness^2 as in shader0.wgsl
+    sampleCount: u32
+}
+
+@group(0) @binding(0) var<uniform> u_Params: PrefilterParams;
+@group(0) @binding(1) var environment: texture_cube<f32>;
+@group(0) @binding(2) var environmentSampler: sampler;
+@group(0) @binding(3) var dst: texture_storage_2d_array<rgba16float, write>;
+
+// EnvironmentMap::getFaceDirection
+fn faceDirection(face: u32, u: f32, v: f32) -> vec3f {
+    switch face {
+        case 0u: { return vec3f(1.0, -v, -u); }
+        case 1u: { return vec3f(-1.0, -v, u); }
+        case 2u: { return vec3f(u, 1.0, v); }
+        case 3u: { return vec3f(u, -1.0, -v); }
+        case 4u: { return vec3f(u, -v, 1.0); }
+        default: { return vec3f(-u, -v, -1.0); }
+    }
+}
+
+fn hammersley(i: u32, n: u32) -> vec2f {
+    return vec2f(f32(i) / f32(n), f32(reverseBits(i)) * 2.3283064365386963e-10);
+}
+
+// half vector around n, distributed like D(h) (h . n)
+fn importanceSampleGgx(xi: vec2f, n: vec3f, a: f32) -> vec3f {
+    let phi = 2.0 * PI * xi.x;
+    let cosTheta = sqrt((1.0 - xi.y) / (1.0 + (a * a - 1.0) * xi.y));
+    let sinTheta = sqrt(1.0 - cosTheta * cosTheta);
+    let up = select(vec3f(1.0, 0.0, 0.0), vec3f(0.0, 0.0, 1.0), abs(n.z) < 0.999);
+    let tangentX = normalize(cross(up, n));
+    let tangentY = cross(n, tangentX);
+    return normalize(tangentX * (cos(phi) * sinTheta) + tangentY * (sin(phi) * sinTheta) + n * cosTheta);
+}
+
+@compute @workgroup_size(8, 8, 1)
+fn cs_prefilter(@builtin(global_invocation_id) id: vec3u) {
+    let size = textureDimensions(dst);
+    if (any(id.xy >= size)) {
+        return;
+    }
+    let uv = 2.0 * (vec2f(id.xy) + 0.5) / vec2f(size) - 1.0;
+    let n = normalize(faceDirection(id.z, uv.x, uv.y));
+
+    // roughness 0 is the mirror: the environment itself, from the mip of the output size
+    let environmentSize = f32(textureDimensions(environment).x);
+    if (u_Params.roughness == 0.0) {
+        let mirrorLod = max(log2(environmentSize / f32(size.x)), 0.0);
+        textureStore(dst, id.xy, id.z, vec4f(textureSampleLevel(environment, environmentSampler, n, mirrorLod).rgb, 1.0));
+        return;
+    }
+
+    let a = u_Params.roughness * u_Params.roughness;
+    let a2 = a * a;
+    let texelSolidAngle = 4.0 * PI / (6.0 * environmentSize * environmentSize);
+    let maxLod = f32(textureNumLevels(environment) - 1u);
+
+    var color = vec3f(0.0);
+    var weight = 0.0;
+    for (var i = 0u; i < u_Params.sampleCount; i++) {
+        let h = importanceSampleGgx(hammersley(i, u_Params.sampleCount), n, a);
+        let nh = dot(n, h);
+        let l = 2.0 * nh * h - n;
+        let nl = dot(n, l);
+        if (nl > 0.0) {
+            // pdf = D nh / (4 vh) with v = n: D / 4
+            let d = nh * nh * (a2 - 1.0) + 1.0;
+            let pdf = a2 / (PI * d * d) * 0.25;
+            let sampleSolidAngle = 1.0 / (f32(u_Params.sampleCount) * pdf + 0.0001);
+            let lod = clamp(0.5 * log2(sampleSolidAngle / texelSolidAngle) + 1.0, 0.0, maxLod);
+            color += textureSampleLevel(environment, environmentSampler, l, lod).rgb * nl;
+            weight += nl;
+        }
+    }
+    textureStore(dst, id.xy, id.z, vec4f(color / max(weight, 0.0001), 1.0));
+}
@@ -11,18 +11,46 @@ fn rotateX(angle: f32) -> mat4x4<f32> {
     );
 }
 
+// set by the app from the vertex layout of the loaded mesh
+override OCT_NORMALS: bool = false; // normal.xy holds an octahedral encoded normal (snorm16x2)
+override SPECULAR_MAX_LOD: f32 = 5.0; // cubemapTexture level of roughness 1 (SpecularPrefilter::LevelCount - 1)
+
+// position may be quantized (unorm16, dequantized with positionOffset / positionScale),
+// uv may be float16: both still arrive here as f32
+// tangent: xyz, w bitangent sign (snorm16x4, MeshNormals::generateTangents), all 0 for meshes without
 struct VertexInput {
     @location(0) position: vec3f,
     @location(1) color: vec3f,
     @location(2) normal: vec3f,
-    @location(3) uv : vec2f
+    @location(3) uv : vec2f,
+    @location(4) tangent : vec4f,
+    @builtin(instance_index) instance: u32
+};
+// meshes without vertex colors don't store them at all
+struct VertexInputNoColor {
+    @location(0) position: vec3f,
+    @location(2) normal: vec3f,
+    @location(3) uv : vec2f,
+    @location(4) tangent : vec4f,
+    @builtin(instance_index) instance: u32
+};
+// depth prepass: the position stream only
+struct PositionInput {
+    @location(0) position: vec3f,
+    @builtin(instance_index) instance: u32
+};
+// @invariant: the prepass and the shading pass compute bit identical depths (depthCompare Equal)
+struct DepthOutput {
+    @builtin(position) @invariant position: vec4f
 };
 struct VertexOutput {
-    @builtin(position) position: vec4f,
+    @builtin(position) @invariant position: vec4f,
     @location(0) color: vec3f,
     @location(1) normal: vec3f,
     @location(2) uv: vec2f,
-    @location(3) worldPos: vec3f
+    @location(3) worldPos: vec3f,
+    @location(4) @interpolate(flat) materialIndex: u32,
+    @location(5) tangent: vec4f // world space xyz, w bitangent sign
 };
 struct Uniforms {
     // PADDING: match order, type, and memory layout
@@ -33,25 +61,95 @@ struct Uniforms {
     modelMatrix: mat4x4f,
     modelInvTranspose: mat4x4f,
     time: f32,
-    cameraPos : vec3f
+    cameraPos : vec3f,
+    positionOffset : vec3f,
+    positionScale : vec3f,
+    shIrradiance : array<vec4f, 9> // rgb: spherical harmonics of the environment's irradiance / PI
+}
+
+// Application::MaterialUniforms
+struct Material {
+    baseColor: vec4f,
+    roughness: f32,
+    metallic: f32,
+    // ormTexture channel of each map, NO_CHANNEL: the map is missing (of the bound texture: u_Material's)
+    occlusionChannel: u32,
+    roughnessChannel: u32,
+    metallicChannel: u32
+}
+const NO_CHANNEL: u32 = 4u;
+
+// Application::InstanceData, one per drawn instance
+struct Instance {
+    modelMatrix: mat4x4f,
+    modelInvTranspose: mat4x4f,
+    materialIndex: u32
 }
+const NO_INSTANCE_MATERIAL: u32 = 0xffffffffu; // use the submesh material (u_Material)
 
 @group(0) @binding(0) var<uniform> u_Uniforms: Uniforms;
-@group(0) @binding(1) var objTexture: texture_2d<f32>;
 @group(0) @binding(2) var textureSampler : sampler;
-@group(0) @binding(3) var cubemapTexture : texture_cube<f32>;
+@group(0) @binding(3) var cubemapTexture : texture_cube<f32>; // GGX prefiltered: level = roughness * SPECULAR_MAX_LOD
+@group(0) @binding(4) var<storage, read> instances: array<Instance>;
+@group(0) @binding(5) var<storage, read> instanceMaterials: array<Material>;
+@group(0) @binding(6) var brdfLut : texture_2d<f32>; // BrdfLut: (NdotV, roughness) -> scale, bias of F0
+
+// set once per material, missing maps are bound as 1x1 white / flat normal textures
+@group(1) @binding(0) var<uniform> u_Material: Material;
+@group(1) @binding(1) var diffuseTexture: texture_2d<f32>;
+@group(1) @binding(2) var normalTexture: texture_2d<f32>;
+@group(1) @binding(3) var ormTexture: texture_2d<f32>; // occlusion, roughness, metallic: packed, or one map (R8Unorm: r)
+
+// inverse of VertexQuantization::encodeOctahedral
+fn decodeOctahedral(e: vec2f) -> vec3f {
+    var n = vec3f(e.x, e.y, 1.0 - abs(e.x) - abs(e.y));
+    let t = max(-n.z, 0.0);
+    n.x += select(t, -t, n.x >= 0.0);
+    n.y += select(t, -t, n.y >= 0.0);
+    return normalize(n);
+}
+
+fn dequantizePosition(storedPosition: vec3f) -> vec3f {
+    return u_Uniforms.positionOffset + u_Uniforms.positionScale * storedPosition;
+}
+
+// shared by both passes so they rasterize the same depths
+fn clipPosition(position: vec3f, instance: u32) -> vec4f {
+    var mvp : mat4x4<f32> = u_Uniforms.projMatrix * u_Uniforms.viewMatrix * instances[instance].modelMatrix;
+    return mvp * vec4f(position, 1.0);
+}
+
+fn transformVertex(storedPosition: vec3f, color: vec3f, storedNormal: vec3f, uv: vec2f, tangent: vec4f, instance: u32) -> VertexOutput {
+    var o : VertexOutput;
+    let position = dequantizePosition(storedPosition);
+    var normal = storedNormal;
+    if (OCT_NORMALS) {
+        normal = decodeOctahedral(storedNormal.xy);
+    }
+    o.position = clipPosition(position, instance);
+    o.color = color;
+    o.normal = normalize((instances[instance].modelInvTranspose * vec4(normal, 0.0)).xyz);
+    o.tangent = vec4f((instances[instance].modelMatrix * vec4(tangent.xyz, 0.0)).xyz, tangent.w);
+    o.uv = uv;
+    o.worldPos = (instances[instance].modelMatrix * vec4(position, 1.0)).xyz;
+    o.materialIndex = instances[instance].materialIndex;
+    return o;
+}
 
 @vertex
 fn vs_main(in: VertexInput) -> VertexOutput {
-    var o : VertexOutput;
-    o.position = vec4f(in.position, 1.0);
-    
-    var mvp : mat4x4<f32> = u_Uniforms.projMatrix * u_Uniforms.viewMatrix * u_Uniforms.modelMatrix;
-    o.position = mvp * o.position;
-    o.color = in.color;
-    o.normal = normalize((u_Uniforms.modelInvTranspose * vec4(in.normal, 0.0)).xyz);
-    o.uv = in.uv;
-    o.worldPos = (u_Uniforms.modelMatrix * vec4(in.position, 1.0)).xyz;
+    return transformVertex(in.position, in.color, in.normal, in.uv, in.tangent, in.instance);
+}
+
+@vertex
+fn vs_main_nocolor(in: VertexInputNoColor) -> VertexOutput {
+    return transformVertex(in.position, vec3f(1.0), in.normal, in.uv, in.tangent, in.instance);
+}
+
+@vertex
+fn vs_depth(in: PositionInput) -> DepthOutput {
+    var o : DepthOutput;
+    o.position = clipPosition(dequantizePosition(in.position), in.instance);
     return o;
 }
 
@@ -83,14 +181,12 @@ fn geometricOcclusion(wo: vec3f, wi: vec3f, nor: vec3f, roughness: f32) -> f32 {
     // Lo(p, wo) = integral { f(p, wi, wo) * Li(p, wi) * ndotwi } dwi -> approximate with sums
     // where f = (k_d * f_lambert) + (k_s * f_cooktorrance)
     //         = (k_d * c / PI) + (k_s * DFG / (4 * wo dot n * wi dot n))
-fn computeLo(worldPos : vec3f, nor: vec3f, wo: vec3f, baseCol : vec3f, lightPos : vec3f) -> vec3f {
+fn computeLo(worldPos : vec3f, nor: vec3f, wo: vec3f, baseCol : vec3f, lightPos : vec3f,
+             roughness : f32, metallicness : f32) -> vec3f {
 
     // temp
     let attenuation : f32 = 1. /  dot(lightPos - worldPos, lightPos - worldPos); // TODO temp
     let lightCol : vec3f = vec3f(1., 1., 1.);
-    let roughness : f32 = 0.5;
-    let metallicness : f32 = 0.5;
-    let ambientOcclusion : f32= 1.0;
 
     let wi : vec3f = normalize(lightPos - worldPos);
     // half vector
@@ -118,11 +214,45 @@ fn computeLo(worldPos : vec3f, nor: vec3f, wo: vec3f, baseCol : vec3f, lightPos
     // 3. combine them all 0-2
     let f : vec3f = k_d * f_lambert + k_s * f_cooktorrance;
     var Lo : vec3f = f * Li * cosTheta;
-
-    Lo += 0.03 * ambientOcclusion * baseCol;  // TODO
     return Lo;
 }
 
+// irradiance / PI arriving at the normal: the 9 term polynomial of SphericalHarmonics::evaluate
+fn evaluateIrradiance(nor: vec3f) -> vec3f {
+    let c = u_Uniforms.shIrradiance;
+    var E : vec3f = 0.282095 * c[0].rgb;
+    E += 0.488603 * (c[1].rgb * nor.y + c[2].rgb * nor.z + c[3].rgb * nor.x);
+    E += 1.092548 * (c[4].rgb * (nor.x * nor.y) + c[5].rgb * (nor.y * nor.z) + c[7].rgb * (nor.x * nor.z));
+    E += 0.315392 * (3.0 * nor.z * nor.z - 1.0) * c[6].rgb;
+    E += 0.546274 * (nor.x * nor.x - nor.y * nor.y) * c[8].rgb;
+    return max(E, vec3f(0.0));
+}
+
+// image based lighting, once per pixel: diffuse from the irradiance polynomial, specular (split sum)
+// from the environment prefiltered for this roughness times the integrated BRDF, one fetch each
+fn computeIbl(nor: vec3f, wo: vec3f, baseCol: vec3f, roughness: f32, metallicness: f32, ambientOcclusion: f32) -> vec3f {
+    let NdotV : f32 = max(dot(nor, wo), 0.0);
+    let R : vec3f = reflect(-wo, nor);
+    let prefiltered : vec3f = textureSampleLevel(cubemapTexture, textureSampler, R, roughness * SPECULAR_MAX_LOD).rgb;
+    let F0 : vec3f = mix(vec3f(0.04), baseCol, metallicness);
+    let scaleBias : vec2f = textureSampleLevel(brdfLut, textureSampler, vec2f(NdotV, roughness), 0.0).rg;
+    let specular : vec3f = prefiltered * (F0 * scaleBias.x + scaleBias.y);
+    // fresnel over the whole lobe: rough surfaces reflect less at grazing angles
+    let Fr : vec3f = max(vec3f(1.0 - roughness), F0) - F0;
+    let F : vec3f = F0 + Fr * pow(1.0 - NdotV, 5.0);
+    let k_d : vec3f = (1.0 - F) * (1.0 - metallicness);
+    let diffuse : vec3f = k_d * baseCol * evaluateIrradiance(nor);
+    return (diffuse + specular) * ambientOcclusion;
+}
+
+// swizzle: the channel a map sits in, 1 for missing maps
+fn ormChannel(orm: vec4f, channel: u32) -> f32 {
+    if (channel >= NO_CHANNEL) {
+        return 1.0;
+    }
+    return orm[channel];
+}
+
 fn gammaCorrect(rgb: vec3<f32>) -> vec3f {
     let sRGB: vec3<f32> = rgb / (rgb + 1.0);
 
@@ -130,36 +260,57 @@ fn gammaCorrect(rgb: vec3<f32>) -> vec3f {
     return gCorrected;
 }
 
-@fragment
-fn fs_main(in: VertexOutput) -> @location(0) vec4f {
-    // simple shading
-    let lightDirection = vec3f(1.0, 1.0, 1.0) * 0.6;//0.5, 0., 0.1);
-    let shading = max(dot(lightDirection, in.normal), 0.);
-    var color = vec3(0.5) * shading + vec3(0.5, 0.5, 0.1);
+// tangent frame of the vertex tangents, from screen space derivatives for meshes without them
+fn perturbNormal(nor: vec3f, tangent: vec4f, worldPos: vec3f, uv: vec2f, tangentNormal: vec3f) -> vec3f {
+    // derivatives before any branch: they need uniform control flow
+    let dp1 = dpdx(worldPos);
+    let dp2 = dpdy(worldPos);
+    let duv1 = dpdx(uv);
+    let duv2 = dpdy(uv);
+    let dp2perp = cross(dp2, nor);
+    let dp1perp = cross(nor, dp1);
+    let T = dp2perp * duv1.x + dp1perp * duv2.x;
+    let B = dp2perp * duv1.y + dp1perp * duv2.y;
+    let invmax = inverseSqrt(max(max(dot(T, T), dot(B, B)), 1e-20));
+    var frame = mat3x3f(T * invmax, B * invmax, nor);
 
-    // texturing
-    let texelUV = vec2i(in.uv * vec2f(textureDimensions(objTexture))); // 0-1 -> 0-texture size
-    color = textureSample(objTexture, textureSampler, in.uv).rgb;
+    // MikkTSpace: re-orthogonalized per pixel, bitangent = sign * cross(normal, tangent)
+    let t = tangent.xyz - nor * dot(nor, tangent.xyz);
+    if (dot(t, t) > 1e-12) {
+        let vertexT = normalize(t);
+        frame = mat3x3f(vertexT, cross(nor, vertexT) * select(1.0, -1.0, tangent.w < 0.0), nor);
+    }
+    return normalize(frame * tangentNormal);
+}
 
-    // flat
-    color = vec3f(0., 0.5, 0.5);
-    
+@fragment
+fn fs_main(in: VertexOutput) -> @location(0) vec4f {
+    // material: the instance's one if it has one
+    var material = u_Material;
+    if (in.materialIndex != NO_INSTANCE_MATERIAL) {
+        material = instanceMaterials[in.materialIndex];
+    }
+    let diffuse = textureSample(diffuseTexture, textureSampler, in.uv);
+    let color : vec3f = material.baseColor.rgb * diffuse.rgb * in.color;
+    let orm = textureSample(ormTexture, textureSampler, in.uv);
+    let roughness : f32 = clamp(material.roughness * ormChannel(orm, u_Material.roughnessChannel), 0.04, 1.0);
+    let metallic : f32 = material.metallic * ormChannel(orm, u_Material.metallicChannel);
+    let occlusion : f32 = ormChannel(orm, u_Material.occlusionChannel);
+    // z rebuilt from xy: cooked normal maps are two channel (BC5), as are RG8Unorm ones
+    let normalXY = textureSample(normalTexture, textureSampler, in.uv).xy * 2.0 - 1.0;
+    let tangentNormal = vec3f(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)));
+    let nor : vec3f = perturbNormal(normalize(in.normal), in.tangent, in.worldPos, in.uv, tangentNormal);
 
     // pbr
-    //let lightPos : vec3f = vec3f(1, 1, 1); // 
     let lightPos : vec3f = vec3f(0, 1, 1);     
     let lightPos2 : vec3f = vec3f(0, -1, 2);
 
     let wo : vec3f = normalize(u_Uniforms.cameraPos - in.worldPos);
-    var test : vec3f = computeLo(in.worldPos, in.normal, wo, color, lightPos);
+    var Lo : vec3f = computeLo(in.worldPos, nor, wo, color, lightPos, roughness, metallic);
+    Lo += computeLo(in.worldPos, nor, wo, color, lightPos2, roughness, metallic);
 
-    test += computeLo(in.worldPos, in.normal, wo, color, lightPos2);
-    
-    test = gammaCorrect(test);
-
-    // check spherical image map
-    let reflectedDir = -reflect(wo, in.normal);
-    let ibl_sample = textureSample(cubemapTexture, textureSampler, reflectedDir).rgb;
+    // environment lighting
+    Lo += computeIbl(nor, wo, color, roughness, metallic, occlusion);
 
-	return vec4f(ibl_sample,  1.0);
-}   
\ No newline at end of file
+	return vec4f(gammaCorrect(Lo), 1.0);
+}
@@ -0,0 +1,73 @@
+// Spherical harmonics projection of a cubemap (GpuShProjector): one 8x8 workgroup per 64x64 texel tile of a
+// face (z: faces), every invocation sums an 8x8 texel block, the workgroup adds up its 64 sums in workgroup
+// memory and writes one set per tile, which the CPU adds up. Basis and texel solid angles as in
+// SphericalHarmonics::projectFace.
+
+@group(0) @binding(0) var environment: texture_2d_array<f32>; // level 0
+@group(0) @binding(1) var<storage, read_write> tileSums: array<vec4f>; // 9 per tile: rgb sums, w of the first: weight
+
+var<workgroup> sums: array<array<vec4f, 9>, 64>;
+
+// EnvironmentMap::getFaceDirection
+fn faceDirection(face: u32, u: f32, v: f32) -> vec3f {
+    switch face {
+        case 0u: { return vec3f(1.0, -v, -u); }
+        case 1u: { return vec3f(-1.0, -v, u); }
+        case 2u: { return vec3f(u, 1.0, v); }
+        case 3u: { return vec3f(u, -1.0, -v); }
+        case 4u: { return vec3f(u, -v, 1.0); }
+        default: { return vec3f(-u, -v, -1.0); }
+    }
+}
+
+@compute @workgroup_size(8, 8, 1)
+fn cs_project(@builtin(workgroup_id) group: vec3u, @builtin(num_workgroups) groupCount: vec3u,
+              @builtin(local_invocation_id) local: vec3u, @builtin(local_invocation_index) index: u32) {
+    let size = textureDimensions(environment).x;
+    let texelArea = 4.0 / (f32(size) * f32(size));
+
+    var c: array<vec4f, 9>;
+    let origin = group.xy * 64u + local.xy * 8u;
+    for (var y = 0u; y < 8u; y++) {
+        for (var x = 0u; x < 8u; x++) {
+            let p = origin + vec2u(x, y);
+            if (any(p >= vec2u(size))) {
+                continue;
+            }
+            let uv = 2.0 * (vec2f(p) + 0.5) / f32(size) - 1.0;
+            let r2 = 1.0 + dot(uv, uv);
+            let weight = texelArea / (r2 * sqrt(r2));
+            let d = faceDirection(group.z, uv.x, uv.y) * inverseSqrt(r2);
+            let L = textureLoad(environment, p, group.z, 0).rgb * weight;
+
+            c[0] += vec4f(0.282095 * L, weight);
+            c[1] += vec4f(0.488603 * d.y * L, 0.0);
+            c[2] += vec4f(0.488603 * d.z * L, 0.0);
+            c[3] += vec4f(0.488603 * d.x * L, 0.0);
+            c[4] += vec4f(1.092548 * d.x * d.y * L, 0.0);
+            c[5] += vec4f(1.092548 * d.y * d.z * L, 0.0);
+            c[6] += vec4f(0.315392 * (3.0 * d.z * d.z - 1.0) * L, 0.0);
+            c[7] += vec4f(1.092548 * d.x * d.z * L, 0.0);
+            c[8] += vec4f(0.546274 * (d.x * d.x - d.y * d.y) * L, 0.0);
+        }
+    }
+
+    // tree reduction of the 64 invocation sums
+    sums[index] = c;
+    workgroupBarrier();
+    for (var stride = 32u; stride > 0u; stride >>= 1u) {
+        if (index < stride) {
+            for (var k = 0u; k < 9u; k++) {
+                sums[index][k] += sums[index + stride][k];
+            }
+        }
+        workgroupBarrier();
+    }
+
+    if (index == 0u) {
+        let tile = (group.z * groupCount.y + group.y) * groupCount.x + group.x;
+        for (var k = 0u; k < 9u; k++) {
+            tileSums[tile * 9u + k] = sums[0][k];
+        }
+    }
+}